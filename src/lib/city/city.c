@@ -1,22 +1,235 @@
 #include "city.h"
+#include "../commons/id_index/id_index.h"
 #include "../shapes/circle/circle.h"
 #include "../shapes/line/line.h"
 #include "../shapes/rectangle/rectangle.h"
 #include "../shapes/text/text.h"
+#include "../shapes/text_style/text_style.h"
+#include "../svg_writer/svg_writer.h"
 #include "../visibility/geometry.h"
 #include "../visibility/visibility.h"
+#include <fcntl.h>
 #include <float.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Side length of the spatial index grid cells
+#define CITY_INDEX_CELL_SIZE 64.0
+
+// Bytes of markup in the longest SVG element, numbers and strings excluded
+#define FRAGMENT_MARKUP_SIZE 128
+// SVG elements up to this size are formatted on the stack
+#define FRAGMENT_STACK_SIZE 2048
+
+// Snapshot format: a SnapshotHeader, shape_count SnapshotRecords in shapes
+// list order, then strings_size bytes of NUL-terminated strings that records
+// refer to by offset
+#define SNAPSHOT_MAGIC "TEDCITY"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+#define SNAPSHOT_NO_STRING UINT32_MAX
+#define SNAPSHOT_STRING_SLOTS 64
 
 typedef struct {
-  List shapes_list;
-  Stack cleanup_stack;
-  List svg_list;
-  int next_id; // Next available unique ID for shapes
+  char magic[8];         // SNAPSHOT_MAGIC
+  uint32_t version;      // SNAPSHOT_VERSION
+  uint32_t byte_order;   // SNAPSHOT_BYTE_ORDER as stored by the writer
+  int32_t next_id;       // Next free shape id
+  uint32_t shape_count;  // Records after the header
+  uint64_t strings_size; // Bytes in the string table
+} SnapshotHeader;
+
+// One shape. The meaning of values and strings depends on the type:
+//   circle     x, y, radius           border, fill
+//   rectangle  x, y, width, height    border, fill
+//   line       x1, y1, x2, y2         color
+//   text       x, y                   border, fill, text    letter = anchor
+//   text style                        font family           letter = weight
+typedef struct {
+  int32_t type;         // ShapeType
+  int32_t id;           // Shape id (unused for text styles)
+  double values[4];     // Geometry
+  uint32_t strings[3];  // String table offsets, or SNAPSHOT_NO_STRING
+  int32_t size;         // Font size of text styles
+  char letter;          // Text anchor or font weight
+  uint8_t barrier;      // 1 for lines marked as barriers
+  uint8_t padding[6];   // Always zero
+} SnapshotRecord;
+
+// Records are read in place from the mapping, so their layout is fixed
+typedef char snapshot_record_size_check[sizeof(SnapshotRecord) == 64 ? 1 : -1];
+typedef char snapshot_header_size_check[sizeof(SnapshotHeader) == 32 ? 1 : -1];
+
+// String table being written, with a hash set of offsets so each distinct
+// string is stored once
+typedef struct {
+  char *bytes;
+  size_t size;
+  size_t capacity;
+  uint32_t *slots; // Offset + 1 of a stored string, 0 when empty
+  size_t slot_count;
+  size_t used_slots;
+} SnapshotStrings;
+
+typedef struct {
+  Sequence shapes_list;
+  Stack cleanup_stack;        // Shapes added from outside the shape store
+  Sequence svg_list;
+  ShapeStore shape_store;     // Owns the shapes created for the city
+  int next_id;                // Next available unique ID for shapes
+  SpatialIndex shape_index;   // Spatial index over all drawable shapes
+  SpatialIndex barrier_index; // Spatial index over barrier lines
+  IdIndex id_index;           // Shapes by id, in shapes list order
+  double bbox_min_x;          // Cached bounding box of all shapes
+  double bbox_min_y;          //
+  double bbox_max_x;          //
+  double bbox_max_y;          //
+  bool bbox_dirty;            // Cached bounding box must be recomputed
+  unsigned barrier_version;   // Bumped whenever a barrier comes or goes
 } CityImpl;
 
+// Context for adapting id index visits to shape visits
+typedef struct {
+  CityShapeVisitFunc visit;
+  void *user_data;
+} IdRangeVisit;
+
+/**
+ * Gets the id of a shape, or -1 for shapes without id (e.g. text styles).
+ */
+static int shape_id(Shape shape) {
+  switch (shape_get_type(shape)) {
+  case CIRCLE:
+    return circle_get_id((Circle)shape_get_shape(shape));
+  case RECTANGLE:
+    return rectangle_get_id((Rectangle)shape_get_shape(shape));
+  case LINE:
+    return line_get_id((Line)shape_get_shape(shape));
+  case TEXT:
+    return text_get_id((Text)shape_get_shape(shape));
+  default:
+    return -1;
+  }
+}
+
+/**
+ * Computes the bounding box of a shape. Returns false for shapes without
+ * geometry (e.g. text styles).
+ */
+static bool shape_bounds(Shape shape, double *x1, double *y1, double *x2,
+                         double *y2) {
+  ShapeType type = shape_get_type(shape);
+
+  if (type == CIRCLE) {
+    Circle c = (Circle)shape_get_shape(shape);
+    double x = circle_get_x(c);
+    double y = circle_get_y(c);
+    double r = circle_get_radius(c);
+    *x1 = x - r;
+    *y1 = y - r;
+    *x2 = x + r;
+    *y2 = y + r;
+  } else if (type == RECTANGLE) {
+    Rectangle r = (Rectangle)shape_get_shape(shape);
+    *x1 = rectangle_get_x(r);
+    *y1 = rectangle_get_y(r);
+    *x2 = *x1 + rectangle_get_width(r);
+    *y2 = *y1 + rectangle_get_height(r);
+  } else if (type == LINE) {
+    Line l = (Line)shape_get_shape(shape);
+    double lx1 = line_get_x1(l);
+    double ly1 = line_get_y1(l);
+    double lx2 = line_get_x2(l);
+    double ly2 = line_get_y2(l);
+    *x1 = lx1 < lx2 ? lx1 : lx2;
+    *y1 = ly1 < ly2 ? ly1 : ly2;
+    *x2 = lx1 > lx2 ? lx1 : lx2;
+    *y2 = ly1 > ly2 ? ly1 : ly2;
+  } else if (type == TEXT) {
+    Text t = (Text)shape_get_shape(shape);
+    double x = text_get_x(t);
+    double y = text_get_y(t);
+    const char *content = text_get_text(t);
+    double width = 10.0 * strlen(content);
+    char anchor = text_get_anchor(t);
+
+    if (anchor == 'i' || anchor == 'I') {
+      *x1 = x;
+      *x2 = x + width;
+    } else if (anchor == 'm' || anchor == 'M') {
+      *x1 = x - width / 2.0;
+      *x2 = x + width / 2.0;
+    } else { // 'f' or 'F'
+      *x1 = x - width;
+      *x2 = x;
+    }
+    *y1 = y; // Approximation
+    *y2 = y; // Approximation
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Checks whether a shape is a line marked as barrier.
+ */
+static bool shape_is_barrier(Shape shape) {
+  return shape_get_type(shape) == LINE &&
+         line_is_barrier((Line)shape_get_shape(shape));
+}
+
+/**
+ * Checks whether a shape was allocated from the city's shape store or one of
+ * its children.
+ */
+static bool in_shape_store(CityImpl *impl, Shape shape) {
+  return impl->shape_store != NULL &&
+         shape_store_get_owner(shape_get_store(shape)) == impl->shape_store;
+}
+
+/**
+ * Grows the cached bounding box to include a box.
+ */
+static void extend_bounding_box(CityImpl *impl, double x1, double y1,
+                                double x2, double y2) {
+  if (x1 < impl->bbox_min_x)
+    impl->bbox_min_x = x1;
+  if (y1 < impl->bbox_min_y)
+    impl->bbox_min_y = y1;
+  if (x2 > impl->bbox_max_x)
+    impl->bbox_max_x = x2;
+  if (y2 > impl->bbox_max_y)
+    impl->bbox_max_y = y2;
+}
+
+/**
+ * Recomputes the cached bounding box from every shape in svg_list.
+ */
+static void recompute_bounding_box(CityImpl *impl) {
+  impl->bbox_min_x = DBL_MAX;
+  impl->bbox_min_y = DBL_MAX;
+  impl->bbox_max_x = -DBL_MAX;
+  impl->bbox_max_y = -DBL_MAX;
+
+  SequenceCursor cursor = sequence_cursor(impl->svg_list);
+  void *item;
+  while (sequence_cursor_next(&cursor, &item)) {
+    double x1, y1, x2, y2;
+    if (item && shape_bounds((Shape)item, &x1, &y1, &x2, &y2)) {
+      extend_bounding_box(impl, x1, y1, x2, y2);
+    }
+  }
+
+  impl->bbox_dirty = false;
+}
+
 City city_create(void) {
   CityImpl *city = malloc(sizeof(CityImpl));
   if (city == NULL) {
@@ -24,10 +237,20 @@ City city_create(void) {
     return NULL;
   }
 
-  city->shapes_list = list_create();
+  city->shapes_list = sequence_create();
   city->cleanup_stack = stack_create();
-  city->svg_list = list_create();
+  city->svg_list = sequence_create();
+  city->shape_store = shape_store_create();
   city->next_id = 1; // Start IDs from 1
+  city->shape_index = spatial_index_create(CITY_INDEX_CELL_SIZE);
+  city->barrier_index = spatial_index_create(CITY_INDEX_CELL_SIZE);
+  city->id_index = id_index_create();
+  city->bbox_min_x = DBL_MAX;
+  city->bbox_min_y = DBL_MAX;
+  city->bbox_max_x = -DBL_MAX;
+  city->bbox_max_y = -DBL_MAX;
+  city->bbox_dirty = false;
+  city->barrier_version = 0;
 
   return (City)city;
 }
@@ -35,14 +258,28 @@ City city_create(void) {
 void city_destroy(City city) {
   CityImpl *impl = (CityImpl *)city;
 
-  list_destroy(impl->shapes_list);
-  list_destroy(impl->svg_list);
+  // Shapes of the store are freed with it; only their fragments live on the
+  // heap. Removed shapes already had theirs dropped.
+  SequenceCursor cursor = sequence_cursor(impl->shapes_list);
+  void *item;
+  while (sequence_cursor_next(&cursor, &item)) {
+    if (in_shape_store(impl, (Shape)item)) {
+      shape_fragment_clear(shape_get_fragment((Shape)item));
+    }
+  }
+
+  sequence_destroy(impl->shapes_list);
+  sequence_destroy(impl->svg_list);
+  spatial_index_destroy(impl->shape_index);
+  spatial_index_destroy(impl->barrier_index);
+  id_index_destroy(impl->id_index);
 
   while (!stack_is_empty(impl->cleanup_stack)) {
     Shape shape = stack_pop(impl->cleanup_stack);
     shape_destroy(shape);
   }
   stack_destroy(impl->cleanup_stack);
+  shape_store_destroy(impl->shape_store);
 
   free(city);
 }
@@ -50,9 +287,25 @@ void city_destroy(City city) {
 void city_add_shape(City city, Shape shape) {
   CityImpl *impl = (CityImpl *)city;
 
-  list_insert_back(impl->shapes_list, shape);
-  stack_push(impl->cleanup_stack, shape);
-  list_insert_back(impl->svg_list, shape);
+  sequence_append(impl->shapes_list, shape);
+  if (!in_shape_store(impl, shape)) {
+    stack_push(impl->cleanup_stack, shape);
+  }
+  sequence_append(impl->svg_list, shape);
+
+  if (shape_get_type(shape) != TEXT_STYLE) {
+    id_index_insert(impl->id_index, shape_id(shape), shape);
+  }
+
+  double x1, y1, x2, y2;
+  if (shape_bounds(shape, &x1, &y1, &x2, &y2)) {
+    extend_bounding_box(impl, x1, y1, x2, y2);
+    spatial_index_insert(impl->shape_index, shape, x1, y1, x2, y2);
+    if (shape_is_barrier(shape)) {
+      spatial_index_insert(impl->barrier_index, shape, x1, y1, x2, y2);
+      impl->barrier_version++;
+    }
+  }
 }
 
 void city_get_bounding_box(City city, double *min_x, double *min_y,
@@ -65,98 +318,27 @@ void city_get_bounding_box(City city, double *min_x, double *min_y,
     return;
   }
   CityImpl *impl = (CityImpl *)city;
-  List svg_list = impl->svg_list;
-  *min_x = DBL_MAX;
-  *min_y = DBL_MAX;
-  *max_x = -DBL_MAX;
-  *max_y = -DBL_MAX;
-
-  int size = list_size(svg_list);
-  if (size == 0) {
-    *min_x = 0;
-    *min_y = 0;
-    *max_x = 1000;
-    *max_y = 1000;
-    return;
-  }
-
-  for (int i = 0; i < size; i++) {
-    Shape shape = list_get(svg_list, i);
-    if (!shape)
-      continue;
-
-    ShapeType type = shape_get_type(shape);
-    double x1 = 0, y1 = 0, x2 = 0, y2 = 0;
-
-    if (type == CIRCLE) {
-      Circle c = (Circle)shape_get_shape(shape);
-      double x = circle_get_x(c);
-      double y = circle_get_y(c);
-      double r = circle_get_radius(c);
-      x1 = x - r;
-      y1 = y - r;
-      x2 = x + r;
-      y2 = y + r;
-    } else if (type == RECTANGLE) {
-      Rectangle r = (Rectangle)shape_get_shape(shape);
-      x1 = rectangle_get_x(r);
-      y1 = rectangle_get_y(r);
-      x2 = x1 + rectangle_get_width(r);
-      y2 = y1 + rectangle_get_height(r);
-    } else if (type == LINE) {
-      Line l = (Line)shape_get_shape(shape);
-      double lx1 = line_get_x1(l);
-      double ly1 = line_get_y1(l);
-      double lx2 = line_get_x2(l);
-      double ly2 = line_get_y2(l);
-      x1 = lx1 < lx2 ? lx1 : lx2;
-      y1 = ly1 < ly2 ? ly1 : ly2;
-      x2 = lx1 > lx2 ? lx1 : lx2;
-      y2 = ly1 > ly2 ? ly1 : ly2;
-    } else if (type == TEXT) {
-      Text t = (Text)shape_get_shape(shape);
-      double x = text_get_x(t);
-      double y = text_get_y(t);
-      const char *content = text_get_text(t);
-      double width = 10.0 * strlen(content);
-      char anchor = text_get_anchor(t);
-
-      if (anchor == 'i' || anchor == 'I') {
-        x1 = x;
-        x2 = x + width;
-      } else if (anchor == 'm' || anchor == 'M') {
-        x1 = x - width / 2.0;
-        x2 = x + width / 2.0;
-      } else { // 'f' or 'F'
-        x1 = x - width;
-        x2 = x;
-      }
-      y1 = y; // Approximation
-      y2 = y; // Approximation
-    } else {
-      continue;
-    }
 
-    if (x1 < *min_x)
-      *min_x = x1;
-    if (y1 < *min_y)
-      *min_y = y1;
-    if (x2 > *max_x)
-      *max_x = x2;
-    if (y2 > *max_y)
-      *max_y = y2;
+  if (impl->bbox_dirty) {
+    recompute_bounding_box(impl);
   }
 
-  // Fallback if no valid shapes were found (all NULL or continue)
-  if (*min_x == DBL_MAX || *max_x == -DBL_MAX) {
+  // Fallback if no shape with geometry is in the city
+  if (impl->bbox_min_x == DBL_MAX || impl->bbox_max_x == -DBL_MAX) {
     *min_x = 0;
     *min_y = 0;
     *max_x = 1000;
     *max_y = 1000;
+    return;
   }
+
+  *min_x = impl->bbox_min_x;
+  *min_y = impl->bbox_min_y;
+  *max_x = impl->bbox_max_x;
+  *max_y = impl->bbox_max_y;
 }
 
-List city_get_shapes_list(City city) {
+Sequence city_get_shapes_list(City city) {
   CityImpl *impl = (CityImpl *)city;
   return impl->shapes_list;
 }
@@ -166,6 +348,275 @@ Stack city_get_cleanup_stack(City city) {
   return impl->cleanup_stack;
 }
 
+ShapeStore city_get_shape_store(City city) {
+  if (!city) {
+    return NULL;
+  }
+  CityImpl *impl = (CityImpl *)city;
+  return impl->shape_store;
+}
+
+// ============================================================================
+// SVG Output
+// ============================================================================
+
+/**
+ * Maps a text anchor letter to its SVG text-anchor value.
+ */
+static const char *svg_text_anchor(char anchor) {
+  if (anchor == 'm' || anchor == 'M') {
+    return "middle";
+  }
+  if (anchor == 'e' || anchor == 'E') {
+    return "end";
+  }
+  return "start";
+}
+
+/**
+ * Copies a string to out and returns the end of the copy.
+ */
+static char *append_text(char *out, const char *text) {
+  size_t length = strlen(text);
+  memcpy(out, text, length);
+  return out + length;
+}
+
+/**
+ * Formats a number like "%.2f" into out and returns the end of the text.
+ */
+static char *append_number(char *out, double value) {
+  return out + svg_format_number(out, value);
+}
+
+/**
+ * Upper bound on the bytes format_shape_svg() writes for a shape.
+ */
+static size_t fragment_bound(Shape shape) {
+  size_t strings = 0;
+  switch (shape_get_type(shape)) {
+  case CIRCLE: {
+    Circle circle = (Circle)shape_get_shape(shape);
+    strings = strlen(circle_get_fill_color(circle)) +
+              strlen(circle_get_border_color(circle));
+    break;
+  }
+  case RECTANGLE: {
+    Rectangle rectangle = (Rectangle)shape_get_shape(shape);
+    strings = strlen(rectangle_get_fill_color(rectangle)) +
+              strlen(rectangle_get_border_color(rectangle));
+    break;
+  }
+  case LINE:
+    strings = strlen(line_get_color((Line)shape_get_shape(shape)));
+    break;
+  case TEXT: {
+    Text text = (Text)shape_get_shape(shape);
+    strings = strlen(text_get_fill_color(text)) +
+              strlen(text_get_border_color(text)) +
+              strlen(text_get_text(text));
+    break;
+  }
+  default:
+    break;
+  }
+  return FRAGMENT_MARKUP_SIZE + 4 * SVG_NUMBER_SIZE + strings;
+}
+
+/**
+ * Formats one shape as an unindented SVG element into out, which must hold
+ * fragment_bound() bytes, and returns the end of the element. Text styles
+ * write nothing.
+ */
+static char *format_shape_svg(Shape shape, char *out) {
+  switch (shape_get_type(shape)) {
+  case CIRCLE: {
+    Circle circle = (Circle)shape_get_shape(shape);
+    out = append_text(out, "<circle cx='");
+    out = append_number(out, circle_get_x(circle));
+    out = append_text(out, "' cy='");
+    out = append_number(out, circle_get_y(circle));
+    out = append_text(out, "' r='");
+    out = append_number(out, circle_get_radius(circle));
+    out = append_text(out, "' fill='");
+    out = append_text(out, circle_get_fill_color(circle));
+    out = append_text(out, "' stroke='");
+    out = append_text(out, circle_get_border_color(circle));
+    return append_text(out, "'/>\n");
+  }
+  case RECTANGLE: {
+    Rectangle rectangle = (Rectangle)shape_get_shape(shape);
+    out = append_text(out, "<rect x='");
+    out = append_number(out, rectangle_get_x(rectangle));
+    out = append_text(out, "' y='");
+    out = append_number(out, rectangle_get_y(rectangle));
+    out = append_text(out, "' width='");
+    out = append_number(out, rectangle_get_width(rectangle));
+    out = append_text(out, "' height='");
+    out = append_number(out, rectangle_get_height(rectangle));
+    out = append_text(out, "' fill='");
+    out = append_text(out, rectangle_get_fill_color(rectangle));
+    out = append_text(out, "' stroke='");
+    out = append_text(out, rectangle_get_border_color(rectangle));
+    return append_text(out, "'/>\n");
+  }
+  case LINE: {
+    Line line = (Line)shape_get_shape(shape);
+    out = append_text(out, "<line x1='");
+    out = append_number(out, line_get_x1(line));
+    out = append_text(out, "' y1='");
+    out = append_number(out, line_get_y1(line));
+    out = append_text(out, "' x2='");
+    out = append_number(out, line_get_x2(line));
+    out = append_text(out, "' y2='");
+    out = append_number(out, line_get_y2(line));
+    out = append_text(out, "' stroke='");
+    out = append_text(out, line_get_color(line));
+    return append_text(out, "'/>\n");
+  }
+  case TEXT: {
+    Text text = (Text)shape_get_shape(shape);
+    out = append_text(out, "<text x='");
+    out = append_number(out, text_get_x(text));
+    out = append_text(out, "' y='");
+    out = append_number(out, text_get_y(text));
+    out = append_text(out, "' fill='");
+    out = append_text(out, text_get_fill_color(text));
+    out = append_text(out, "' stroke='");
+    out = append_text(out, text_get_border_color(text));
+    out = append_text(out, "' text-anchor='");
+    out = append_text(out, svg_text_anchor(text_get_anchor(text)));
+    out = append_text(out, "'>");
+    out = append_text(out, text_get_text(text));
+    return append_text(out, "</text>\n");
+  }
+  default:
+    return out;
+  }
+}
+
+/**
+ * Formats a shape into its fragment cache. Returns false if out of memory.
+ */
+static bool cache_shape_fragment(Shape shape, ShapeFragment *fragment) {
+  char stack_buffer[FRAGMENT_STACK_SIZE];
+  size_t bound = fragment_bound(shape);
+  char *buffer = bound <= sizeof(stack_buffer) ? stack_buffer : malloc(bound);
+  char *bytes = NULL;
+  size_t length = 0;
+  if (buffer != NULL) {
+    length = (size_t)(format_shape_svg(shape, buffer) - buffer);
+    bytes = malloc(length);
+    if (bytes != NULL) {
+      memcpy(bytes, buffer, length);
+    }
+  }
+  if (buffer != stack_buffer) {
+    free(buffer);
+  }
+  if (bytes == NULL) {
+    printf("Error: Failed to allocate memory for an SVG fragment\n");
+    return false;
+  }
+
+  fragment->bytes = bytes;
+  fragment->length = length;
+  return true;
+}
+
+/**
+ * Writes one shape as an SVG element, formatting it only if its cached
+ * fragment was dropped since the last file. Text styles write nothing.
+ */
+static void write_shape_svg(SvgWriter writer, Shape shape,
+                            const char *indent) {
+  ShapeFragment *fragment = shape_get_fragment(shape);
+  if (fragment == NULL) {
+    return;
+  }
+  if (fragment->bytes == NULL && !cache_shape_fragment(shape, fragment)) {
+    return;
+  }
+
+  svg_writer_write_string(writer, indent);
+  svg_writer_write(writer, fragment->bytes, fragment->length);
+}
+
+/**
+ * Writes every shape of the city in svg_list order.
+ */
+static void write_city_shapes(SvgWriter writer, CityImpl *impl,
+                              const char *indent) {
+  int svg_list_size = sequence_size(impl->svg_list);
+  for (int i = 0; i < svg_list_size; i++) {
+    Shape shape = sequence_get(impl->svg_list, i);
+    if (shape != NULL) {
+      write_shape_svg(writer, shape, indent);
+    }
+  }
+}
+
+/**
+ * Writes the XML declaration and an svg tag whose view box frames the given
+ * bounds with a 20 unit margin.
+ */
+static void write_svg_header(SvgWriter writer, double min_x, double min_y,
+                             double max_x, double max_y) {
+  double margin = 20.0;
+  svg_writer_write_string(writer,
+                          "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                          "<svg xmlns=\"http://www.w3.org/2000/svg\" "
+                          "viewBox=\"");
+  svg_writer_write_number(writer, min_x - margin);
+  svg_writer_write_string(writer, " ");
+  svg_writer_write_number(writer, min_y - margin);
+  svg_writer_write_string(writer, " ");
+  svg_writer_write_number(writer, (max_x - min_x) + 2 * margin);
+  svg_writer_write_string(writer, " ");
+  svg_writer_write_number(writer, (max_y - min_y) + 2 * margin);
+  svg_writer_write_string(writer, "\">\n");
+}
+
+/**
+ * Writes a visibility polygon, if it has vertices, and a marker on its
+ * source.
+ */
+static void write_visibility_svg(SvgWriter writer, VisibilityPolygon poly,
+                                 double source_x, double source_y) {
+  int vertex_count = visibility_polygon_get_vertex_count(poly);
+  const double *xy = visibility_polygon_get_coords(poly);
+
+  if (vertex_count > 0 && xy != NULL) {
+    svg_writer_write_string(writer, "  <polygon points=\"");
+    for (int i = 0; i < vertex_count; i++) {
+      svg_writer_write_number(writer, xy[2 * i]);
+      svg_writer_write_string(writer, ",");
+      svg_writer_write_number(writer, xy[2 * i + 1]);
+      svg_writer_write_string(writer, " ");
+    }
+    svg_writer_write_string(writer,
+                            "\" fill=\"yellow\" fill-opacity=\"0.3\" "
+                            "stroke=\"orange\" stroke-width=\"2\"/>\n");
+  }
+
+  svg_writer_write_string(writer, "  <circle cx='");
+  svg_writer_write_number(writer, source_x);
+  svg_writer_write_string(writer, "' cy='");
+  svg_writer_write_number(writer, source_y);
+  svg_writer_write_string(writer, "' r='5' fill='red' stroke='darkred' "
+                                  "stroke-width='2'/>\n");
+}
+
+/**
+ * Closes the svg tag and the file, reporting a failed write.
+ */
+static void close_svg(SvgWriter writer, const char *path) {
+  svg_writer_write_string(writer, "</svg>\n");
+  if (!svg_writer_close(writer)) {
+    printf("Error: Failed to write file: %s\n", path);
+  }
+}
+
 void city_generate_svg(City city, const char *output_path, FileData file_data,
                        const char *command_suffix) {
   CityImpl *impl = (CityImpl *)city;
@@ -210,84 +661,19 @@ void city_generate_svg(City city, const char *output_path, FileData file_data,
     return;
   }
 
-  FILE *file = fopen(output_path_with_file, "w");
-  if (file == NULL) {
+  SvgWriter writer = svg_writer_create(output_path_with_file);
+  if (writer == NULL) {
     printf("Error: Failed to open file: %s\n", output_path_with_file);
     free(output_path_with_file);
     free(file_name);
     return;
   }
 
-  fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-
   double min_x, min_y, max_x, max_y;
   city_get_bounding_box(city, &min_x, &min_y, &max_x, &max_y);
-
-  double margin = 20.0;
-  double vb_x = min_x - margin;
-  double vb_y = min_y - margin;
-  double vb_w = (max_x - min_x) + 2 * margin;
-  double vb_h = (max_y - min_y) + 2 * margin;
-
-  fprintf(file,
-          "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"%.2f %.2f %.2f "
-          "%.2f\">\n",
-          vb_x, vb_y, vb_w, vb_h);
-
-  // Iterate over list using index-based access
-  int svg_list_size = list_size(impl->svg_list);
-  for (int i = 0; i < svg_list_size; i++) {
-    Shape shape = list_get(impl->svg_list, i);
-    if (shape != NULL) {
-      ShapeType type = shape_get_type(shape);
-      if (type == CIRCLE) {
-        Circle circle = (Circle)shape_get_shape(shape);
-        fprintf(
-            file,
-            "<circle cx='%.2f' cy='%.2f' r='%.2f' fill='%s' stroke='%s'/>\n",
-            circle_get_x(circle), circle_get_y(circle),
-            circle_get_radius(circle), circle_get_fill_color(circle),
-            circle_get_border_color(circle));
-      } else if (type == RECTANGLE) {
-        Rectangle rectangle = (Rectangle)shape_get_shape(shape);
-        fprintf(file,
-                "<rect x='%.2f' y='%.2f' width='%.2f' height='%.2f' fill='%s' "
-                "stroke='%s'/>\n",
-                rectangle_get_x(rectangle), rectangle_get_y(rectangle),
-                rectangle_get_width(rectangle), rectangle_get_height(rectangle),
-                rectangle_get_fill_color(rectangle),
-                rectangle_get_border_color(rectangle));
-      } else if (type == LINE) {
-        Line line = (Line)shape_get_shape(shape);
-        fprintf(file,
-                "<line x1='%.2f' y1='%.2f' x2='%.2f' y2='%.2f' stroke='%s'/>\n",
-                line_get_x1(line), line_get_y1(line), line_get_x2(line),
-                line_get_y2(line), line_get_color(line));
-      } else if (type == TEXT) {
-        Text text = (Text)shape_get_shape(shape);
-        char anchor = text_get_anchor(text);
-        const char *text_anchor = "start"; // default
-
-        // Map anchor character to SVG text-anchor value
-        if (anchor == 'm' || anchor == 'M') {
-          text_anchor = "middle";
-        } else if (anchor == 'e' || anchor == 'E') {
-          text_anchor = "end";
-        } else if (anchor == 's' || anchor == 'S') {
-          text_anchor = "start";
-        }
-
-        fprintf(file,
-                "<text x='%.2f' y='%.2f' fill='%s' stroke='%s' "
-                "text-anchor='%s'>%s</text>\n",
-                text_get_x(text), text_get_y(text), text_get_fill_color(text),
-                text_get_border_color(text), text_anchor, text_get_text(text));
-      }
-    }
-  }
-
-  fprintf(file, "</svg>\n");
-  fclose(file);
+  write_svg_header(writer, min_x, min_y, max_x, max_y);
+  write_city_shapes(writer, impl, "");
+  close_svg(writer, output_path_with_file);
   free(output_path_with_file);
   free(file_name);
 }
@@ -297,7 +683,8 @@ void city_generate_svg_with_visibility(City city, const char *output_path,
                                        FileData qry_file_data,
                                        const char *command_suffix,
                                        void *visibility_polygon,
-                                       double source_x, double source_y) {
+                                       double source_x, double source_y,
+                                       SvgQueue svg_queue) {
   CityImpl *impl = (CityImpl *)city;
 
   // Extract geo file name (without extension)
@@ -350,8 +737,8 @@ void city_generate_svg_with_visibility(City city, const char *output_path,
     return;
   }
 
-  FILE *file = fopen(output_path_with_file, "w");
-  if (file == NULL) {
+  SvgWriter writer = svg_writer_create_queued(svg_queue, output_path_with_file);
+  if (writer == NULL) {
     printf("Error: Failed to open file: %s\n", output_path_with_file);
     free(output_path_with_file);
     free(geo_name);
@@ -359,8 +746,6 @@ void city_generate_svg_with_visibility(City city, const char *output_path,
     return;
   }
 
-  fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-
   double min_x, min_y, max_x, max_y;
   city_get_bounding_box(city, &min_x, &min_y, &max_x, &max_y);
 
@@ -374,123 +759,40 @@ void city_generate_svg_with_visibility(City city, const char *output_path,
   if (source_y > max_y)
     max_y = source_y;
 
-  double margin = 20.0;
-  double vb_x = min_x - margin;
-  double vb_y = min_y - margin;
-  double vb_w = (max_x - min_x) + 2 * margin;
-  double vb_h = (max_y - min_y) + 2 * margin;
-
-  fprintf(file,
-          "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"%.2f %.2f %.2f "
-          "%.2f\">\n",
-          vb_x, vb_y, vb_w, vb_h);
+  write_svg_header(writer, min_x, min_y, max_x, max_y);
 
   // Draw visibility polygon if provided
   if (visibility_polygon != NULL) {
-    VisibilityPolygon poly = (VisibilityPolygon)visibility_polygon;
-    int vertex_count = visibility_polygon_get_vertex_count(poly);
-    Point *vertices = visibility_polygon_get_vertices(poly);
-
-    if (vertex_count > 0 && vertices != NULL) {
-      fprintf(file, "  <polygon points=\"");
-      for (int i = 0; i < vertex_count; i++) {
-        double x = geometry_point_get_x(vertices[i]);
-        double y = geometry_point_get_y(vertices[i]);
-        fprintf(file, "%.2f,%.2f ", x, y);
-      }
-      fprintf(file, "\" fill=\"yellow\" fill-opacity=\"0.3\" stroke=\"orange\" "
-                    "stroke-width=\"2\"/>\n");
-    }
-
-    // Draw source point marker
-    fprintf(file,
-            "  <circle cx='%.2f' cy='%.2f' r='5' fill='red' stroke='darkred' "
-            "stroke-width='2'/>\n",
-            source_x, source_y);
-  }
-
-  // Iterate over list using index-based access
-  int svg_list_size = list_size(impl->svg_list);
-  for (int i = 0; i < svg_list_size; i++) {
-    Shape shape = list_get(impl->svg_list, i);
-    if (shape != NULL) {
-      ShapeType type = shape_get_type(shape);
-      if (type == CIRCLE) {
-        Circle circle = (Circle)shape_get_shape(shape);
-        fprintf(
-            file,
-            "  <circle cx='%.2f' cy='%.2f' r='%.2f' fill='%s' stroke='%s'/>\n",
-            circle_get_x(circle), circle_get_y(circle),
-            circle_get_radius(circle), circle_get_fill_color(circle),
-            circle_get_border_color(circle));
-      } else if (type == RECTANGLE) {
-        Rectangle rectangle = (Rectangle)shape_get_shape(shape);
-        fprintf(
-            file,
-            "  <rect x='%.2f' y='%.2f' width='%.2f' height='%.2f' fill='%s' "
-            "stroke='%s'/>\n",
-            rectangle_get_x(rectangle), rectangle_get_y(rectangle),
-            rectangle_get_width(rectangle), rectangle_get_height(rectangle),
-            rectangle_get_fill_color(rectangle),
-            rectangle_get_border_color(rectangle));
-      } else if (type == LINE) {
-        Line line = (Line)shape_get_shape(shape);
-        fprintf(
-            file,
-            "  <line x1='%.2f' y1='%.2f' x2='%.2f' y2='%.2f' stroke='%s'/>\n",
-            line_get_x1(line), line_get_y1(line), line_get_x2(line),
-            line_get_y2(line), line_get_color(line));
-      } else if (type == TEXT) {
-        Text text = (Text)shape_get_shape(shape);
-        char anchor = text_get_anchor(text);
-        const char *text_anchor = "start"; // default
-
-        // Map anchor character to SVG text-anchor value
-        if (anchor == 'm' || anchor == 'M') {
-          text_anchor = "middle";
-        } else if (anchor == 'e' || anchor == 'E') {
-          text_anchor = "end";
-        } else if (anchor == 's' || anchor == 'S') {
-          text_anchor = "start";
-        }
-
-        fprintf(file,
-                "  <text x='%.2f' y='%.2f' fill='%s' stroke='%s' "
-                "text-anchor='%s'>%s</text>\n",
-                text_get_x(text), text_get_y(text), text_get_fill_color(text),
-                text_get_border_color(text), text_anchor, text_get_text(text));
-      }
-    }
+    write_visibility_svg(writer, (VisibilityPolygon)visibility_polygon,
+                         source_x, source_y);
   }
 
-  fprintf(file, "</svg>\n");
-  fclose(file);
+  write_city_shapes(writer, impl, "  ");
+  close_svg(writer, output_path_with_file);
   free(output_path_with_file);
   free(geo_name);
   free(qry_name);
 }
 
-List city_get_barriers(City city) {
+/**
+ * Appends a visited barrier to the output list.
+ */
+static void collect_barrier(void *item, void *user_data) {
+  sequence_append((Sequence)user_data, item);
+}
+
+Sequence city_get_barriers(City city) {
   if (!city) {
     return NULL;
   }
 
   CityImpl *impl = (CityImpl *)city;
-  List barriers = list_create();
+  Sequence barriers = sequence_create();
   if (!barriers) {
     return NULL;
   }
 
-  int shape_count = list_size(impl->shapes_list);
-  for (int i = 0; i < shape_count; i++) {
-    Shape shape = list_get(impl->shapes_list, i);
-    if (shape && shape_get_type(shape) == LINE) {
-      Line line = (Line)shape_get_shape(shape);
-      if (line_is_barrier(line)) {
-        list_insert_back(barriers, shape);
-      }
-    }
-  }
+  spatial_index_foreach(impl->barrier_index, collect_barrier, barriers);
 
   return barriers;
 }
@@ -503,17 +805,84 @@ bool city_remove_shape(City city, Shape shape) {
   CityImpl *impl = (CityImpl *)city;
 
   // Remove from shapes_list
-  bool removed_from_list = list_remove(impl->shapes_list, shape);
+  bool removed_from_list = sequence_remove(impl->shapes_list, shape);
 
   // Remove from svg_list
-  list_remove(impl->svg_list, shape);
+  sequence_remove(impl->svg_list, shape);
+  shape_fragment_clear(shape_get_fragment(shape));
+
+  if (removed_from_list && shape_get_type(shape) != TEXT_STYLE) {
+    id_index_remove(impl->id_index, shape_id(shape), shape);
+  }
+
+  double x1, y1, x2, y2;
+  if (removed_from_list && shape_bounds(shape, &x1, &y1, &x2, &y2)) {
+    // Only shapes touching the box edge can shrink it
+    if (x1 <= impl->bbox_min_x || y1 <= impl->bbox_min_y ||
+        x2 >= impl->bbox_max_x || y2 >= impl->bbox_max_y) {
+      impl->bbox_dirty = true;
+    }
+    spatial_index_remove(impl->shape_index, shape, x1, y1, x2, y2);
+    if (spatial_index_remove(impl->barrier_index, shape, x1, y1, x2, y2)) {
+      impl->barrier_version++;
+    }
+  }
 
   // Note: We don't remove from cleanup_stack as it's used for final cleanup
-  // The shape will still be freed when city is destroyed
+  // The shape will still be freed when city is destroyed, with the shape
+  // store or through the cleanup stack
 
   return removed_from_list;
 }
 
+void city_mark_barrier(City city, Shape shape) {
+  if (!city || !shape || shape_get_type(shape) != LINE) {
+    return;
+  }
+
+  CityImpl *impl = (CityImpl *)city;
+  Line line = (Line)shape_get_shape(shape);
+  if (line_is_barrier(line)) {
+    return;
+  }
+
+  line_set_barrier(line, true);
+  double x1, y1, x2, y2;
+  shape_bounds(shape, &x1, &y1, &x2, &y2);
+  spatial_index_insert(impl->barrier_index, shape, x1, y1, x2, y2);
+  impl->barrier_version++;
+}
+
+unsigned city_get_barrier_version(City city) {
+  if (!city) {
+    return 0;
+  }
+  return ((CityImpl *)city)->barrier_version;
+}
+
+void city_query_box(City city, double min_x, double min_y, double max_x,
+                    double max_y, SpatialIndexVisitFunc visit,
+                    void *user_data) {
+  if (!city) {
+    return;
+  }
+
+  CityImpl *impl = (CityImpl *)city;
+  spatial_index_query_box(impl->shape_index, min_x, min_y, max_x, max_y,
+                          visit, user_data);
+}
+
+void city_query_radius(City city, double x, double y, double radius,
+                       SpatialIndexVisitFunc visit, void *user_data) {
+  if (!city) {
+    return;
+  }
+
+  CityImpl *impl = (CityImpl *)city;
+  spatial_index_query_radius(impl->shape_index, x, y, radius, visit,
+                             user_data);
+}
+
 int city_get_next_id(City city) {
   if (!city) {
     return -1;
@@ -529,40 +898,28 @@ Shape city_get_shape_by_id(City city, int id) {
   }
 
   CityImpl *impl = (CityImpl *)city;
-  int shape_count = list_size(impl->shapes_list);
-
-  for (int i = 0; i < shape_count; i++) {
-    Shape shape = list_get(impl->shapes_list, i);
-    if (!shape) {
-      continue;
-    }
+  return id_index_get(impl->id_index, id);
+}
 
-    ShapeType type = shape_get_type(shape);
-    int shape_id = -1;
-
-    switch (type) {
-    case CIRCLE:
-      shape_id = circle_get_id((Circle)shape_get_shape(shape));
-      break;
-    case RECTANGLE:
-      shape_id = rectangle_get_id((Rectangle)shape_get_shape(shape));
-      break;
-    case LINE:
-      shape_id = line_get_id((Line)shape_get_shape(shape));
-      break;
-    case TEXT:
-      shape_id = text_get_id((Text)shape_get_shape(shape));
-      break;
-    default:
-      continue;
-    }
+/**
+ * Forwards an id index visit to a city shape visitor.
+ */
+static void visit_id_range_shape(int id, void *item, void *user_data) {
+  IdRangeVisit *range_visit = (IdRangeVisit *)user_data;
+  range_visit->visit(id, (Shape)item, range_visit->user_data);
+}
 
-    if (shape_id == id) {
-      return shape;
-    }
+void city_foreach_shape_in_id_range(City city, int start_id, int end_id,
+                                    CityShapeVisitFunc visit,
+                                    void *user_data) {
+  if (!city || !visit) {
+    return;
   }
 
-  return NULL;
+  CityImpl *impl = (CityImpl *)city;
+  IdRangeVisit range_visit = {visit, user_data};
+  id_index_foreach_in_range(impl->id_index, start_id, end_id,
+                            visit_id_range_shape, &range_visit);
 }
 
 void city_update_max_id(City city, int id) {
@@ -578,7 +935,7 @@ void city_update_max_id(City city, int id) {
 
 void city_generate_qry_svg(City city, const char *output_path,
                            FileData geo_file_data, FileData qry_file_data,
-                           List accumulated_polygons) {
+                           Sequence accumulated_polygons) {
   CityImpl *impl = (CityImpl *)city;
 
   // Extract geo file name (without extension)
@@ -630,8 +987,8 @@ void city_generate_qry_svg(City city, const char *output_path,
     return;
   }
 
-  FILE *file = fopen(output_path_with_file, "w");
-  if (file == NULL) {
+  SvgWriter writer = svg_writer_create(output_path_with_file);
+  if (writer == NULL) {
     printf("Error: Failed to open file: %s\n", output_path_with_file);
     free(output_path_with_file);
     free(geo_name);
@@ -639,31 +996,19 @@ void city_generate_qry_svg(City city, const char *output_path,
     return;
   }
 
-  fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-
   double min_x, min_y, max_x, max_y;
   city_get_bounding_box(city, &min_x, &min_y, &max_x, &max_y);
-
-  double margin = 20.0;
-  double vb_x = min_x - margin;
-  double vb_y = min_y - margin;
-  double vb_w = (max_x - min_x) + 2 * margin;
-  double vb_h = (max_y - min_y) + 2 * margin;
-
-  fprintf(file,
-          "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"%.2f %.2f %.2f "
-          "%.2f\">\n",
-          vb_x, vb_y, vb_w, vb_h);
+  write_svg_header(writer, min_x, min_y, max_x, max_y);
 
   // Draw accumulated visibility polygons
   if (accumulated_polygons != NULL) {
-    int poly_count = list_size(accumulated_polygons);
+    int poly_count = sequence_size(accumulated_polygons);
     for (int i = 0; i < poly_count; i++) {
       // Each item is a struct with: polygon, source_x, source_y
       // We need to cast it properly - the struct is defined in qry_handler
       // For now, we access it as three consecutive doubles after the polygon
       // ptr
-      void *data_ptr = list_get(accumulated_polygons, i);
+      void *data_ptr = sequence_get(accumulated_polygons, i);
       if (data_ptr == NULL)
         continue;
 
@@ -671,87 +1016,381 @@ void city_generate_qry_svg(City city, const char *output_path,
       // double source_y
       VisibilityPolygon poly = *((VisibilityPolygon *)data_ptr);
       double *coords = (double *)((char *)data_ptr + sizeof(VisibilityPolygon));
-      double source_x = coords[0];
-      double source_y = coords[1];
-
-      int vertex_count = visibility_polygon_get_vertex_count(poly);
-      Point *vertices = visibility_polygon_get_vertices(poly);
-
-      if (vertex_count > 0 && vertices != NULL) {
-        fprintf(file, "  <polygon points=\"");
-        for (int j = 0; j < vertex_count; j++) {
-          double x = geometry_point_get_x(vertices[j]);
-          double y = geometry_point_get_y(vertices[j]);
-          fprintf(file, "%.2f,%.2f ", x, y);
-        }
-        fprintf(file,
-                "\" fill=\"yellow\" fill-opacity=\"0.3\" stroke=\"orange\" "
-                "stroke-width=\"2\"/>\n");
-      }
+      write_visibility_svg(writer, poly, coords[0], coords[1]);
+    }
+  }
+
+  write_city_shapes(writer, impl, "");
+  close_svg(writer, output_path_with_file);
+  free(output_path_with_file);
+  free(geo_name);
+  free(qry_name);
+}
 
-      // Draw source point marker
-      fprintf(file,
-              "  <circle cx='%.2f' cy='%.2f' r='5' fill='red' stroke='darkred' "
-              "stroke-width='2'/>\n",
-              source_x, source_y);
+// ============================================================================
+// Snapshots
+// ============================================================================
+
+/**
+ * FNV-1a hash of a string.
+ */
+static uint32_t hash_string(const char *text) {
+  uint32_t hash = 2166136261u;
+  for (; *text != '\0'; text++) {
+    hash = (hash ^ (uint8_t)*text) * 16777619u;
+  }
+  return hash;
+}
+
+/**
+ * Doubles the hash set of a string table and rehashes its strings.
+ */
+static bool grow_snapshot_slots(SnapshotStrings *strings) {
+  size_t slot_count = strings->slot_count * 2;
+  uint32_t *slots = calloc(slot_count, sizeof(uint32_t));
+  if (slots == NULL) {
+    return false;
+  }
+
+  for (size_t i = 0; i < strings->slot_count; i++) {
+    uint32_t entry = strings->slots[i];
+    if (entry == 0) {
+      continue;
     }
+    size_t slot = hash_string(strings->bytes + entry - 1) & (slot_count - 1);
+    while (slots[slot] != 0) {
+      slot = (slot + 1) & (slot_count - 1);
+    }
+    slots[slot] = entry;
   }
 
-  // Iterate over list using index-based access
-  int svg_list_size = list_size(impl->svg_list);
-  for (int i = 0; i < svg_list_size; i++) {
-    Shape shape = list_get(impl->svg_list, i);
+  free(strings->slots);
+  strings->slots = slots;
+  strings->slot_count = slot_count;
+  return true;
+}
+
+/**
+ * Stores a string in the table unless an equal one is already there, and
+ * gives its offset. Returns false when out of memory or past 4 GB.
+ */
+static bool intern_snapshot_string(SnapshotStrings *strings, const char *text,
+                                   uint32_t *offset) {
+  if (text == NULL) {
+    *offset = SNAPSHOT_NO_STRING;
+    return true;
+  }
+
+  if ((strings->used_slots + 1) * 2 > strings->slot_count &&
+      !grow_snapshot_slots(strings)) {
+    return false;
+  }
+
+  size_t slot = hash_string(text) & (strings->slot_count - 1);
+  while (strings->slots[slot] != 0) {
+    const char *stored = strings->bytes + strings->slots[slot] - 1;
+    if (strcmp(stored, text) == 0) {
+      *offset = strings->slots[slot] - 1;
+      return true;
+    }
+    slot = (slot + 1) & (strings->slot_count - 1);
+  }
+
+  size_t length = strlen(text) + 1;
+  if (strings->size + length >= SNAPSHOT_NO_STRING) {
+    return false;
+  }
+  if (strings->size + length > strings->capacity) {
+    size_t capacity = strings->capacity * 2;
+    while (capacity < strings->size + length) {
+      capacity *= 2;
+    }
+    char *bytes = realloc(strings->bytes, capacity);
+    if (bytes == NULL) {
+      return false;
+    }
+    strings->bytes = bytes;
+    strings->capacity = capacity;
+  }
+
+  memcpy(strings->bytes + strings->size, text, length);
+  *offset = (uint32_t)strings->size;
+  strings->slots[slot] = *offset + 1;
+  strings->used_slots++;
+  strings->size += length;
+  return true;
+}
+
+/**
+ * Fills the record of a shape, storing its strings in the table.
+ */
+static bool fill_snapshot_record(Shape shape, SnapshotRecord *record,
+                                 SnapshotStrings *strings) {
+  const char *texts[3] = {NULL, NULL, NULL};
+
+  memset(record, 0, sizeof(SnapshotRecord));
+  record->type = shape_get_type(shape);
+  record->id = shape_id(shape);
+
+  switch (shape_get_type(shape)) {
+  case CIRCLE: {
+    Circle circle = (Circle)shape_get_shape(shape);
+    record->values[0] = circle_get_x(circle);
+    record->values[1] = circle_get_y(circle);
+    record->values[2] = circle_get_radius(circle);
+    texts[0] = circle_get_border_color(circle);
+    texts[1] = circle_get_fill_color(circle);
+    break;
+  }
+  case RECTANGLE: {
+    Rectangle rectangle = (Rectangle)shape_get_shape(shape);
+    record->values[0] = rectangle_get_x(rectangle);
+    record->values[1] = rectangle_get_y(rectangle);
+    record->values[2] = rectangle_get_width(rectangle);
+    record->values[3] = rectangle_get_height(rectangle);
+    texts[0] = rectangle_get_border_color(rectangle);
+    texts[1] = rectangle_get_fill_color(rectangle);
+    break;
+  }
+  case LINE: {
+    Line line = (Line)shape_get_shape(shape);
+    record->values[0] = line_get_x1(line);
+    record->values[1] = line_get_y1(line);
+    record->values[2] = line_get_x2(line);
+    record->values[3] = line_get_y2(line);
+    record->barrier = line_is_barrier(line) ? 1 : 0;
+    texts[0] = line_get_color(line);
+    break;
+  }
+  case TEXT: {
+    Text text = (Text)shape_get_shape(shape);
+    record->values[0] = text_get_x(text);
+    record->values[1] = text_get_y(text);
+    record->letter = text_get_anchor(text);
+    texts[0] = text_get_border_color(text);
+    texts[1] = text_get_fill_color(text);
+    texts[2] = text_get_text(text);
+    break;
+  }
+  case TEXT_STYLE: {
+    TextStyle style = (TextStyle)shape_get_shape(shape);
+    record->letter = text_style_get_font_weight(style);
+    record->size = text_style_get_font_size(style);
+    texts[0] = text_style_get_font_family(style);
+    break;
+  }
+  default:
+    return false;
+  }
+
+  for (int i = 0; i < 3; i++) {
+    if (!intern_snapshot_string(strings, texts[i], &record->strings[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool city_save_snapshot(City city, const char *path) {
+  if (!city || !path) {
+    return false;
+  }
+
+  CityImpl *impl = (CityImpl *)city;
+  int shape_count = sequence_size(impl->shapes_list);
+
+  SnapshotStrings strings;
+  strings.size = 0;
+  strings.capacity = 1024;
+  strings.slot_count = SNAPSHOT_STRING_SLOTS;
+  strings.used_slots = 0;
+  strings.bytes = malloc(strings.capacity);
+  strings.slots = calloc(strings.slot_count, sizeof(uint32_t));
+  SnapshotRecord *records =
+      malloc((shape_count > 0 ? shape_count : 1) * sizeof(SnapshotRecord));
+  if (strings.bytes == NULL || strings.slots == NULL || records == NULL) {
+    printf("Error: Failed to allocate memory for city snapshot\n");
+    free(strings.bytes);
+    free(strings.slots);
+    free(records);
+    return false;
+  }
+
+  // Shapes that failed to parse are kept as NULL entries; they draw nothing
+  // and are left out
+  uint32_t record_count = 0;
+  bool ok = true;
+  for (int i = 0; ok && i < shape_count; i++) {
+    Shape shape = sequence_get(impl->shapes_list, i);
     if (shape != NULL) {
-      ShapeType type = shape_get_type(shape);
-      if (type == CIRCLE) {
-        Circle circle = (Circle)shape_get_shape(shape);
-        fprintf(
-            file,
-            "<circle cx='%.2f' cy='%.2f' r='%.2f' fill='%s' stroke='%s'/>\n",
-            circle_get_x(circle), circle_get_y(circle),
-            circle_get_radius(circle), circle_get_fill_color(circle),
-            circle_get_border_color(circle));
-      } else if (type == RECTANGLE) {
-        Rectangle rectangle = (Rectangle)shape_get_shape(shape);
-        fprintf(file,
-                "<rect x='%.2f' y='%.2f' width='%.2f' height='%.2f' fill='%s' "
-                "stroke='%s'/>\n",
-                rectangle_get_x(rectangle), rectangle_get_y(rectangle),
-                rectangle_get_width(rectangle), rectangle_get_height(rectangle),
-                rectangle_get_fill_color(rectangle),
-                rectangle_get_border_color(rectangle));
-      } else if (type == LINE) {
-        Line line = (Line)shape_get_shape(shape);
-        fprintf(file,
-                "<line x1='%.2f' y1='%.2f' x2='%.2f' y2='%.2f' stroke='%s'/>\n",
-                line_get_x1(line), line_get_y1(line), line_get_x2(line),
-                line_get_y2(line), line_get_color(line));
-      } else if (type == TEXT) {
-        Text text = (Text)shape_get_shape(shape);
-        char anchor = text_get_anchor(text);
-        const char *text_anchor = "start"; // default
-
-        // Map anchor character to SVG text-anchor value
-        if (anchor == 'm' || anchor == 'M') {
-          text_anchor = "middle";
-        } else if (anchor == 'e' || anchor == 'E') {
-          text_anchor = "end";
-        } else if (anchor == 's' || anchor == 'S') {
-          text_anchor = "start";
-        }
-
-        fprintf(file,
-                "<text x='%.2f' y='%.2f' fill='%s' stroke='%s' "
-                "text-anchor='%s'>%s</text>\n",
-                text_get_x(text), text_get_y(text), text_get_fill_color(text),
-                text_get_border_color(text), text_anchor, text_get_text(text));
+      ok = fill_snapshot_record(shape, &records[record_count++], &strings);
+    }
+  }
+
+  SnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  header.version = SNAPSHOT_VERSION;
+  header.byte_order = SNAPSHOT_BYTE_ORDER;
+  header.next_id = impl->next_id;
+  header.shape_count = record_count;
+  header.strings_size = strings.size;
+
+  FILE *file = ok ? fopen(path, "wb") : NULL;
+  if (file != NULL) {
+    ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+         fwrite(records, sizeof(SnapshotRecord), record_count, file) ==
+             record_count &&
+         fwrite(strings.bytes, 1, strings.size, file) == strings.size;
+    ok = fclose(file) == 0 && ok;
+  } else {
+    ok = false;
+  }
+
+  free(strings.bytes);
+  free(strings.slots);
+  free(records);
+  return ok;
+}
+
+/**
+ * Resolves a string table offset, or NULL for SNAPSHOT_NO_STRING.
+ */
+static const char *snapshot_string(const char *table, uint32_t offset) {
+  return offset == SNAPSHOT_NO_STRING ? NULL : table + offset;
+}
+
+/**
+ * Creates the shape of a record in a store. The strings are copied by the
+ * shape.
+ */
+static Shape shape_from_snapshot_record(ShapeStore store,
+                                        const SnapshotRecord *record,
+                                        const char *table) {
+  const char *first = snapshot_string(table, record->strings[0]);
+  const char *second = snapshot_string(table, record->strings[1]);
+  const char *third = snapshot_string(table, record->strings[2]);
+  const double *v = record->values;
+
+  switch (record->type) {
+  case CIRCLE:
+    return circle_create_in(store, record->id, v[0], v[1], v[2], first,
+                            second);
+  case RECTANGLE:
+    return rectangle_create_in(store, record->id, v[0], v[1], v[2], v[3],
+                               first, second);
+  case LINE: {
+    Shape shape =
+        line_create_in(store, record->id, v[0], v[1], v[2], v[3], first);
+    if (shape != NULL && record->barrier) {
+      line_set_barrier((Line)shape_get_shape(shape), true);
+    }
+    return shape;
+  }
+  case TEXT:
+    return text_create_in(store, record->id, v[0], v[1], first, second,
+                          record->letter, third);
+  case TEXT_STYLE:
+    return text_style_create_in(store, first, record->letter, record->size);
+  default:
+    return NULL;
+  }
+}
+
+/**
+ * Checks that a mapped file is a complete snapshot whose string offsets all
+ * point at terminated strings inside the table.
+ */
+static bool snapshot_is_valid(const char *data, size_t size) {
+  if (size < sizeof(SnapshotHeader)) {
+    return false;
+  }
+
+  const SnapshotHeader *header = (const SnapshotHeader *)data;
+  if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+      header->version != SNAPSHOT_VERSION ||
+      header->byte_order != SNAPSHOT_BYTE_ORDER) {
+    return false;
+  }
+
+  uint64_t records_size =
+      (uint64_t)header->shape_count * sizeof(SnapshotRecord);
+  if (size != sizeof(SnapshotHeader) + records_size + header->strings_size) {
+    return false;
+  }
+
+  // The table must end with a terminator so no string runs past it
+  const char *table = data + sizeof(SnapshotHeader) + records_size;
+  if (header->strings_size > 0 && table[header->strings_size - 1] != '\0') {
+    return false;
+  }
+
+  const SnapshotRecord *records =
+      (const SnapshotRecord *)(data + sizeof(SnapshotHeader));
+  for (uint32_t i = 0; i < header->shape_count; i++) {
+    for (int k = 0; k < 3; k++) {
+      uint32_t offset = records[i].strings[k];
+      if (offset != SNAPSHOT_NO_STRING && offset >= header->strings_size) {
+        return false;
       }
     }
   }
+  return true;
+}
 
-  fprintf(file, "</svg>\n");
-  fclose(file);
-  free(output_path_with_file);
-  free(geo_name);
-  free(qry_name);
+City city_load_snapshot(const char *path) {
+  if (!path) {
+    return NULL;
+  }
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+    close(fd);
+    return NULL;
+  }
+
+  size_t size = (size_t)info.st_size;
+  void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return NULL;
+  }
+
+  const char *data = (const char *)mapping;
+  if (!snapshot_is_valid(data, size)) {
+    printf("Error: Invalid city snapshot: %s\n", path);
+    munmap(mapping, size);
+    return NULL;
+  }
+
+  City city = city_create();
+  if (city == NULL) {
+    munmap(mapping, size);
+    return NULL;
+  }
+
+  const SnapshotHeader *header = (const SnapshotHeader *)data;
+  const SnapshotRecord *records =
+      (const SnapshotRecord *)(data + sizeof(SnapshotHeader));
+  const char *table = (const char *)(records + header->shape_count);
+  for (uint32_t i = 0; i < header->shape_count; i++) {
+    Shape shape = shape_from_snapshot_record(city_get_shape_store(city),
+                                             &records[i], table);
+    if (shape == NULL) {
+      printf("Error: Failed to restore shape %u from city snapshot\n", i);
+      city_destroy(city);
+      munmap(mapping, size);
+      return NULL;
+    }
+    city_add_shape(city, shape);
+  }
+  ((CityImpl *)city)->next_id = header->next_id;
+
+  munmap(mapping, size);
+  return city;
 }
@@ -10,16 +10,26 @@
 #ifndef CITY_H
 #define CITY_H
 
-#include "../commons/list/list.h"
+#include "../commons/sequence/sequence.h"
+#include "../commons/spatial_index/spatial_index.h"
 #include "../commons/stack/stack.h"
 #include "../file_reader/file_reader.h"
 #include "../shapes/shapes.h"
+#include "../svg_writer/svg_writer.h"
 
 /**
  * @brief Opaque pointer type for city instances
  */
 typedef void *City;
 
+/**
+ * Callback function type for visiting shapes by id.
+ * @param id Shape id
+ * @param shape Shape with that id
+ * @param user_data User-provided context
+ */
+typedef void (*CityShapeVisitFunc)(int id, Shape shape, void *user_data);
+
 /**
  * @brief Creates a new empty city
  * @return City instance or NULL on error
@@ -42,17 +52,28 @@ void city_add_shape(City city, Shape shape);
 /**
  * @brief Gets the shapes list from the city
  * @param city City instance
- * @return List containing all shapes
+ * @return Sequence containing all shapes
  */
-List city_get_shapes_list(City city);
+Sequence city_get_shapes_list(City city);
 
 /**
  * @brief Gets the cleanup stack from the city
  * @param city City instance
- * @return Stack containing shapes to free
+ * @return Stack containing the shapes to free that did not come from the
+ * city's shape store
  */
 Stack city_get_cleanup_stack(City city);
 
+/**
+ * @brief Gets the store the city's own shapes are allocated from
+ *
+ * Shapes created in it, or in a child of it (see shape_store_create_child()),
+ * are freed wholesale by city_destroy() and must only be added to this city.
+ * @param city City instance
+ * @return ShapeStore instance, or NULL if city is NULL
+ */
+ShapeStore city_get_shape_store(City city);
+
 /**
  * @brief Generates an SVG file with all shapes in the city
  * @param city City instance
@@ -74,6 +95,9 @@ void city_generate_svg(City city, const char *output_path, FileData file_data,
  * module)
  * @param source_x X coordinate of the visibility source point
  * @param source_y Y coordinate of the visibility source point
+ * @param svg_queue Queue whose thread writes the file, or NULL to write it
+ * before returning. Either way the SVG reflects the city at the time of the
+ * call.
  *
  * Output file follows pattern: geoName-qryName-sfx.svg
  */
@@ -82,14 +106,15 @@ void city_generate_svg_with_visibility(City city, const char *output_path,
                                        FileData qry_file_data,
                                        const char *command_suffix,
                                        void *visibility_polygon,
-                                       double source_x, double source_y);
+                                       double source_x, double source_y,
+                                       SvgQueue svg_queue);
 
 /**
  * @brief Gets all barrier segments from the city
  * @param city City instance
- * @return List of Line shapes marked as barriers
+ * @return Sequence of Line shapes marked as barriers
  */
-List city_get_barriers(City city);
+Sequence city_get_barriers(City city);
 
 /**
  * @brief Removes a shape from the city by reference
@@ -99,6 +124,50 @@ List city_get_barriers(City city);
  */
 bool city_remove_shape(City city, Shape shape);
 
+/**
+ * @brief Marks a line already in the city as a barrier
+ * @param city City instance
+ * @param shape Line shape to mark (other shape types are ignored)
+ */
+void city_mark_barrier(City city, Shape shape);
+
+/**
+ * @brief Gets the version of the city's barriers
+ *
+ * The version changes every time a barrier is added, marked or removed, so
+ * anything computed from the barriers can tell whether it is still current.
+ * @param city City instance
+ * @return Barrier version (0 for NULL)
+ */
+unsigned city_get_barrier_version(City city);
+
+/**
+ * @brief Visits the shapes whose bounding box intersects a box
+ * @param city City instance
+ * @param min_x Minimum X of the query box
+ * @param min_y Minimum Y of the query box
+ * @param max_x Maximum X of the query box
+ * @param max_y Maximum Y of the query box
+ * @param visit Callback called once per shape, in shapes list order
+ * @param user_data User-provided context passed to the callback
+ */
+void city_query_box(City city, double min_x, double min_y, double max_x,
+                    double max_y, SpatialIndexVisitFunc visit,
+                    void *user_data);
+
+/**
+ * @brief Visits the shapes whose bounding box lies within a distance of a
+ * point
+ * @param city City instance
+ * @param x Query point X coordinate
+ * @param y Query point Y coordinate
+ * @param radius Maximum distance from the point to the shape bounding box
+ * @param visit Callback called once per shape, in shapes list order
+ * @param user_data User-provided context passed to the callback
+ */
+void city_query_radius(City city, double x, double y, double radius,
+                       SpatialIndexVisitFunc visit, void *user_data);
+
 /**
  * @brief Gets the next available unique ID for shapes
  * @param city City instance
@@ -110,10 +179,26 @@ int city_get_next_id(City city);
  * @brief Gets a shape by ID
  * @param city City instance
  * @param id Shape ID to find
- * @return Shape with given ID or NULL if not found
+ * @return Shape with given ID or NULL if not found (when several shapes share
+ * the ID, the first one in the shapes list)
  */
 Shape city_get_shape_by_id(City city, int id);
 
+/**
+ * @brief Visits, in ascending ID order, the shape of every ID in a range
+ * @param city City instance
+ * @param start_id First ID of the range (inclusive)
+ * @param end_id Last ID of the range (inclusive)
+ * @param visit Callback called once per existing ID with the shape
+ * city_get_shape_by_id would return
+ * @param user_data User-provided context passed to the callback
+ *
+ * Only IDs present in the city are visited. The city may be modified from
+ * the callback.
+ */
+void city_foreach_shape_in_id_range(City city, int start_id, int end_id,
+                                    CityShapeVisitFunc visit, void *user_data);
+
 /**
  * @brief Updates the maximum ID tracked by the city
  * @param city City instance
@@ -138,13 +223,38 @@ void city_get_bounding_box(City city, double *min_x, double *min_y,
  * @param output_path Directory path for output
  * @param geo_file_data File data containing geo file name
  * @param qry_file_data File data containing qry file name
- * @param accumulated_polygons List of visibility polygons (each item is a
+ * @param accumulated_polygons Sequence of visibility polygons (each item is a
  * VisPolygonData) for bombs with suffix "-", can be NULL
  *
  * The output file follows the pattern: geoName-qryName.svg
  */
 void city_generate_qry_svg(City city, const char *output_path,
                            FileData geo_file_data, FileData qry_file_data,
-                           List accumulated_polygons);
+                           Sequence accumulated_polygons);
+
+/**
+ * @brief Writes a binary snapshot of the city to a file
+ *
+ * The snapshot holds every shape in list order, with its id, geometry,
+ * colors, text, barrier flag and text style, plus the next free id. It is
+ * laid out as a fixed header, one fixed-size record per shape and a table of
+ * deduplicated strings, so it can be read straight from a memory mapping.
+ * Snapshots use the byte order of the machine that wrote them.
+ * @param city City instance
+ * @param path Path of the snapshot file (overwritten if it exists)
+ * @return true on success, false on error
+ */
+bool city_save_snapshot(City city, const char *path);
+
+/**
+ * @brief Creates a city from a snapshot written by city_save_snapshot()
+ *
+ * The file is mapped and its records are turned back into shapes in order,
+ * which rebuilds the spatial, barrier and id indexes as well.
+ * @param path Path of the snapshot file
+ * @return City instance, or NULL if the file is missing or not a valid
+ * snapshot
+ */
+City city_load_snapshot(const char *path);
 
 #endif // CITY_H
@@ -0,0 +1,390 @@
+/**
+ * @file city.spec.c
+ * @brief Unit tests for city module
+ *
+ * Unit tests for the city snapshot functions defined in city.h
+ */
+
+#include "./city.h"
+#include "../shapes/circle/circle.h"
+#include "../shapes/line/line.h"
+#include "../shapes/rectangle/rectangle.h"
+#include "../shapes/text/text.h"
+#include "../shapes/text_style/text_style.h"
+#include "../file_reader/file_reader.h"
+#include "../test_framework/test_framework.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SNAPSHOT_PATH "/tmp/test_city_snapshot.bin"
+#define SVG_GEO_PATH "/tmp/test_city_svg.geo"
+#define SVG_PATH "/tmp/test_city_svg.svg"
+
+// ============================================================================
+// Test Helpers
+// ============================================================================
+
+// Counts the barriers of a city
+static int count_barriers(City city) {
+  Sequence barriers = city_get_barriers(city);
+  int count = sequence_size(barriers);
+  sequence_destroy(barriers);
+  return count;
+}
+
+// Gets the size of a file in bytes
+static long file_size(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    return -1;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fclose(file);
+  return size;
+}
+
+// Writes raw bytes to a file
+static bool write_bytes(const char *path, const void *bytes, size_t size) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    return false;
+  }
+  bool ok = fwrite(bytes, 1, size, file) == size;
+  fclose(file);
+  return ok;
+}
+
+// Reads a whole file into a NUL-terminated buffer
+static char *read_file(const char *path) {
+  long size = file_size(path);
+  FILE *file = fopen(path, "rb");
+  if (file == NULL || size < 0) {
+    return NULL;
+  }
+  char *bytes = malloc((size_t)size + 1);
+  if (bytes != NULL) {
+    bytes[fread(bytes, 1, (size_t)size, file)] = '\0';
+  }
+  fclose(file);
+  return bytes;
+}
+
+// ============================================================================
+// Tests for city_generate_svg()
+// ============================================================================
+
+/**
+ * Test: repainted and removed shapes should show up changed in the next file
+ */
+bool test_city_generate_svg_after_changes(void) {
+  const char geo[] = "c 1 10 20 5 red blue\n";
+  ASSERT_TRUE(write_bytes(SVG_GEO_PATH, geo, sizeof(geo) - 1));
+  FileData file_data = file_data_create(SVG_GEO_PATH);
+  ASSERT_NOT_NULL(file_data);
+
+  City city = city_create();
+  Shape circle = circle_create(1, 10.0, 20.0, 5.0, "red", "blue");
+  Shape line = line_create(2, 0.0, 0.0, 1.5, 2.25, "black");
+  city_add_shape(city, circle);
+  city_add_shape(city, line);
+  city_add_shape(city, text_create(3, 7.0, 9.0, "black", "white", 'e', "Rua"));
+
+  city_generate_svg(city, "/tmp", file_data, NULL);
+  char *first = read_file(SVG_PATH);
+  ASSERT_NOT_NULL(first);
+  ASSERT_NOT_NULL(strstr(first, "<circle cx='10.00' cy='20.00' r='5.00' "
+                                "fill='blue' stroke='red'/>\n"));
+  ASSERT_NOT_NULL(strstr(first, "<line x1='0.00' y1='0.00' x2='1.50' "
+                                "y2='2.25' stroke='black'/>\n"));
+  ASSERT_NOT_NULL(strstr(first, "<text x='7.00' y='9.00' fill='white' "
+                                "stroke='black' text-anchor='end'>Rua</text>"));
+
+  circle_set_colors(shape_get_shape(circle), "green");
+  city_remove_shape(city, line);
+  city_generate_svg(city, "/tmp", file_data, NULL);
+  char *second = read_file(SVG_PATH);
+  ASSERT_NOT_NULL(second);
+  ASSERT_NOT_NULL(strstr(second, "fill='green' stroke='green'/>"));
+  ASSERT_NULL(strstr(second, "fill='blue'"));
+  ASSERT_NULL(strstr(second, "<line"));
+  ASSERT_NOT_NULL(strstr(second, ">Rua</text>"));
+
+  free(first);
+  free(second);
+  city_destroy(city);
+  file_data_destroy(file_data);
+  remove(SVG_GEO_PATH);
+  remove(SVG_PATH);
+  return true;
+}
+
+// ============================================================================
+// Tests for city_get_shape_store()
+// ============================================================================
+
+/**
+ * Test: only shapes from outside the city's store should wait on the cleanup
+ * stack, and store shapes should survive rendering and removal
+ */
+bool test_city_shape_store_owns_its_shapes(void) {
+  const char geo[] = "c 1 10 20 5 red blue\n";
+  ASSERT_TRUE(write_bytes(SVG_GEO_PATH, geo, sizeof(geo) - 1));
+  FileData file_data = file_data_create(SVG_GEO_PATH);
+  ASSERT_NOT_NULL(file_data);
+
+  City city = city_create();
+  ShapeStore store = city_get_shape_store(city);
+  ASSERT_NOT_NULL(store);
+  ASSERT_NULL(city_get_shape_store(NULL));
+
+  Shape pooled = circle_create_in(store, 1, 10.0, 20.0, 5.0, "red", "blue");
+  Shape removed = line_create_in(store, 2, 0.0, 0.0, 1.0, 1.0, "red");
+  city_add_shape(city, pooled);
+  city_add_shape(city, removed);
+  city_add_shape(city, line_create(3, 0.0, 0.0, 2.0, 2.0, "black"));
+  ASSERT_EQUAL(stack_size(city_get_cleanup_stack(city)), 1);
+
+  // Cached fragments of store shapes are freed with the city
+  city_generate_svg(city, "/tmp", file_data, NULL);
+  city_remove_shape(city, removed);
+  city_generate_svg(city, "/tmp", file_data, NULL);
+
+  // Shapes loaded from a snapshot come from the new city's store
+  ASSERT_TRUE(city_save_snapshot(city, SNAPSHOT_PATH));
+  City other = city_load_snapshot(SNAPSHOT_PATH);
+  ASSERT_NOT_NULL(other);
+  Shape loaded = sequence_get(city_get_shapes_list(other), 0);
+  ASSERT_TRUE(shape_get_store(loaded) == city_get_shape_store(other));
+  ASSERT_EQUAL(stack_size(city_get_cleanup_stack(other)), 0);
+
+  city_destroy(other);
+  city_destroy(city);
+  file_data_destroy(file_data);
+  remove(SVG_GEO_PATH);
+  remove(SVG_PATH);
+  remove(SNAPSHOT_PATH);
+  return true;
+}
+
+// ============================================================================
+// Tests for city_get_barrier_version()
+// ============================================================================
+
+/**
+ * Test: the version should change with the barriers and only with them
+ */
+bool test_city_barrier_version(void) {
+  City city = city_create();
+  unsigned version = city_get_barrier_version(city);
+
+  // Shapes that are not barriers leave it alone
+  Shape line = line_create(1, 0.0, 0.0, 10.0, 0.0, "black");
+  Shape circle = circle_create(2, 5.0, 5.0, 1.0, "red", "blue");
+  city_add_shape(city, line);
+  city_add_shape(city, circle);
+  city_remove_shape(city, circle);
+  ASSERT_EQUAL(city_get_barrier_version(city), version);
+
+  city_mark_barrier(city, line);
+  unsigned marked = city_get_barrier_version(city);
+  ASSERT_TRUE(marked != version);
+  city_mark_barrier(city, line);
+  ASSERT_EQUAL(city_get_barrier_version(city), marked);
+
+  Shape wall = line_create(3, 0.0, 5.0, 10.0, 5.0, "black");
+  line_set_barrier(shape_get_shape(wall), true);
+  city_add_shape(city, wall);
+  unsigned added = city_get_barrier_version(city);
+  ASSERT_TRUE(added != marked);
+
+  city_remove_shape(city, wall);
+  ASSERT_TRUE(city_get_barrier_version(city) != added);
+  ASSERT_EQUAL(count_barriers(city), 1);
+  ASSERT_EQUAL(city_get_barrier_version(NULL), 0);
+
+  city_destroy(city);
+  return true;
+}
+
+// ============================================================================
+// Tests for city_save_snapshot() / city_load_snapshot()
+// ============================================================================
+
+/**
+ * Test: a loaded snapshot should have the same shapes, in the same order
+ */
+bool test_city_snapshot_round_trip(void) {
+  City city = city_create();
+  Shape removed = circle_create(9, 0.0, 0.0, 1.0, "gray", "gray");
+  Shape barrier = line_create(3, 1.5, 2.5, 30.25, 2.5, "black");
+  city_add_shape(city, text_style_create("sans", 'b', 12));
+  city_add_shape(city, circle_create(1, 10.0, 20.0, 5.5, "red", "#00ff00"));
+  city_add_shape(city, removed);
+  city_add_shape(city, rectangle_create(2, -4.0, 8.0, 16.0, 2.0, "red", "blue"));
+  city_add_shape(city, barrier);
+  city_add_shape(city, text_create(4, 7.0, 9.0, "black", "white", 'm',
+                                   "rua  com espacos"));
+  city_mark_barrier(city, barrier);
+  city_remove_shape(city, removed);
+  city_update_max_id(city, 50);
+
+  ASSERT_TRUE(city_save_snapshot(city, SNAPSHOT_PATH));
+  City loaded = city_load_snapshot(SNAPSHOT_PATH);
+  ASSERT_NOT_NULL(loaded);
+
+  Sequence shapes = city_get_shapes_list(loaded);
+  ASSERT_EQUAL(sequence_size(shapes), 5);
+  ASSERT_EQUAL(shape_get_type(sequence_get(shapes, 0)), TEXT_STYLE);
+  TextStyle style = shape_get_shape(sequence_get(shapes, 0));
+  ASSERT_STR_EQUAL(text_style_get_font_family(style), "sans");
+  ASSERT_EQUAL(text_style_get_font_weight(style), 'b');
+  ASSERT_EQUAL(text_style_get_font_size(style), 12);
+
+  Circle circle = shape_get_shape(city_get_shape_by_id(loaded, 1));
+  ASSERT_EQUAL(circle_get_x(circle), 10.0);
+  ASSERT_EQUAL(circle_get_radius(circle), 5.5);
+  ASSERT_STR_EQUAL(circle_get_fill_color(circle), "#00ff00");
+  ASSERT_NULL(city_get_shape_by_id(loaded, 9));
+
+  Rectangle rectangle = shape_get_shape(city_get_shape_by_id(loaded, 2));
+  ASSERT_EQUAL(rectangle_get_x(rectangle), -4.0);
+  ASSERT_EQUAL(rectangle_get_height(rectangle), 2.0);
+  ASSERT_STR_EQUAL(rectangle_get_border_color(rectangle), "red");
+
+  Line line = shape_get_shape(city_get_shape_by_id(loaded, 3));
+  ASSERT_EQUAL(line_get_x2(line), 30.25);
+  ASSERT_TRUE(line_is_barrier(line));
+  ASSERT_EQUAL(count_barriers(loaded), 1);
+
+  Text text = shape_get_shape(city_get_shape_by_id(loaded, 4));
+  ASSERT_EQUAL(text_get_anchor(text), 'm');
+  ASSERT_STR_EQUAL(text_get_text(text), "rua  com espacos");
+
+  double a[4], b[4];
+  city_get_bounding_box(city, &a[0], &a[1], &a[2], &a[3]);
+  city_get_bounding_box(loaded, &b[0], &b[1], &b[2], &b[3]);
+  for (int i = 0; i < 4; i++) {
+    ASSERT_EQUAL(a[i], b[i]);
+  }
+  ASSERT_EQUAL(city_get_next_id(loaded), 51);
+
+  city_destroy(loaded);
+  city_destroy(city);
+  remove(SNAPSHOT_PATH);
+  return true;
+}
+
+/**
+ * Test: repeated strings should be stored once
+ */
+bool test_city_snapshot_shares_strings(void) {
+  City city = city_create();
+  for (int i = 0; i < 100; i++) {
+    city_add_shape(city, circle_create(i, i, i, 1.0, "red", "blue"));
+  }
+
+  ASSERT_TRUE(city_save_snapshot(city, SNAPSHOT_PATH));
+  // Header, one 64-byte record per shape, then "red" and "blue" once
+  ASSERT_EQUAL(file_size(SNAPSHOT_PATH), 32 + 100 * 64 + 4 + 5);
+
+  City loaded = city_load_snapshot(SNAPSHOT_PATH);
+  ASSERT_NOT_NULL(loaded);
+  ASSERT_EQUAL(sequence_size(city_get_shapes_list(loaded)), 100);
+
+  city_destroy(loaded);
+  city_destroy(city);
+  remove(SNAPSHOT_PATH);
+  return true;
+}
+
+/**
+ * Test: an empty city should round-trip
+ */
+bool test_city_snapshot_empty(void) {
+  City city = city_create();
+
+  ASSERT_TRUE(city_save_snapshot(city, SNAPSHOT_PATH));
+  City loaded = city_load_snapshot(SNAPSHOT_PATH);
+  ASSERT_NOT_NULL(loaded);
+  ASSERT_EQUAL(sequence_size(city_get_shapes_list(loaded)), 0);
+  ASSERT_EQUAL(city_get_next_id(loaded), 1);
+
+  city_destroy(loaded);
+  city_destroy(city);
+  remove(SNAPSHOT_PATH);
+  return true;
+}
+
+/**
+ * Test: missing, truncated and foreign files should be rejected
+ */
+bool test_city_snapshot_invalid(void) {
+  ASSERT_NULL(city_load_snapshot("/tmp/nonexistent_snapshot_12345.bin"));
+  ASSERT_FALSE(city_save_snapshot(NULL, SNAPSHOT_PATH));
+
+  const char garbage[] = "c 1 10 20 5 red blue\n";
+  ASSERT_TRUE(write_bytes(SNAPSHOT_PATH, garbage, sizeof(garbage)));
+  ASSERT_NULL(city_load_snapshot(SNAPSHOT_PATH));
+
+  // A valid snapshot cut short by one byte
+  City city = city_create();
+  city_add_shape(city, line_create(1, 0.0, 0.0, 1.0, 1.0, "black"));
+  ASSERT_TRUE(city_save_snapshot(city, SNAPSHOT_PATH));
+  city_destroy(city);
+
+  long size = file_size(SNAPSHOT_PATH);
+  char *bytes = malloc(size);
+  ASSERT_NOT_NULL(bytes);
+  FILE *file = fopen(SNAPSHOT_PATH, "rb");
+  ASSERT_NOT_NULL(file);
+  ASSERT_EQUAL(fread(bytes, 1, size, file), (size_t)size);
+  fclose(file);
+
+  ASSERT_TRUE(write_bytes(SNAPSHOT_PATH, bytes, size - 1));
+  ASSERT_NULL(city_load_snapshot(SNAPSHOT_PATH));
+
+  // A string offset pointing past the table
+  bytes[32 + 48] = 0x7f;
+  ASSERT_TRUE(write_bytes(SNAPSHOT_PATH, bytes, size));
+  ASSERT_NULL(city_load_snapshot(SNAPSHOT_PATH));
+
+  free(bytes);
+  remove(SNAPSHOT_PATH);
+  return true;
+}
+
+// ============================================================================
+// Main Test Runner
+// ============================================================================
+
+int main(void) {
+  test_framework_init();
+
+  test_print_section("Testing city_generate_svg()");
+  test_register("test_city_generate_svg_after_changes",
+                test_city_generate_svg_after_changes);
+
+  test_print_section("Testing city_get_shape_store()");
+  test_register("test_city_shape_store_owns_its_shapes",
+                test_city_shape_store_owns_its_shapes);
+
+  test_print_section("Testing city_get_barrier_version()");
+  test_register("test_city_barrier_version", test_city_barrier_version);
+
+  test_print_section("Testing city_save_snapshot() / city_load_snapshot()");
+  test_register("test_city_snapshot_round_trip",
+                test_city_snapshot_round_trip);
+  test_register("test_city_snapshot_shares_strings",
+                test_city_snapshot_shares_strings);
+  test_register("test_city_snapshot_empty", test_city_snapshot_empty);
+  test_register("test_city_snapshot_invalid", test_city_snapshot_invalid);
+
+  int result = test_run_all();
+
+  test_framework_cleanup();
+
+  return result;
+}
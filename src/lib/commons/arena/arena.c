@@ -0,0 +1,180 @@
+#include "arena.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Size of the first block when arena_create() is given 0
+#define DEFAULT_BLOCK_SIZE (64 * 1024)
+
+// Block of memory handed out front to back. Blocks are allocated with their
+// bytes right after the header.
+typedef struct ArenaBlock {
+  struct ArenaBlock *next; // Older (smaller) block
+  size_t capacity;         // Bytes after the header
+  size_t used;             // Bytes handed out so far
+} ArenaBlock;
+
+// Internal arena structure. The newest block is always the largest.
+typedef struct {
+  ArenaBlock *head;  // Block allocations come from (NULL before first use)
+  size_t block_size; // Size of the first block
+  void *last;        // Most recent allocation, while it can be reclaimed
+  size_t last_used;  // Used bytes of the head block before that allocation
+} ArenaImpl;
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+/**
+ * Gets the first byte of a block.
+ */
+static unsigned char *block_bytes(ArenaBlock *block) {
+  return (unsigned char *)(block + 1);
+}
+
+/**
+ * Gets the offset of the first aligned byte at or after the used part of a
+ * block.
+ */
+static size_t aligned_offset(ArenaBlock *block) {
+  uintptr_t start = (uintptr_t)block_bytes(block);
+  uintptr_t next = start + block->used;
+  uintptr_t aligned =
+      (next + ARENA_ALIGNMENT - 1) & ~(uintptr_t)(ARENA_ALIGNMENT - 1);
+  return (size_t)(aligned - start);
+}
+
+/**
+ * Pushes a new block able to hold size bytes, at least twice as large as the
+ * current one.
+ */
+static ArenaBlock *push_block(ArenaImpl *impl, size_t size) {
+  size_t capacity = impl->block_size;
+  if (impl->head != NULL && impl->head->capacity * 2 > capacity) {
+    capacity = impl->head->capacity * 2;
+  }
+  if (size + ARENA_ALIGNMENT > capacity) {
+    capacity = size + ARENA_ALIGNMENT;
+  }
+
+  ArenaBlock *block = malloc(sizeof(ArenaBlock) + capacity);
+  if (block == NULL) {
+    printf("Error: Failed to allocate memory for arena block\n");
+    return NULL;
+  }
+
+  block->next = impl->head;
+  block->capacity = capacity;
+  block->used = 0;
+  impl->head = block;
+  return block;
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+Arena arena_create(size_t block_size) {
+  ArenaImpl *impl = malloc(sizeof(ArenaImpl));
+  if (impl == NULL) {
+    printf("Error: Failed to allocate memory for Arena\n");
+    return NULL;
+  }
+
+  impl->head = NULL;
+  impl->block_size = block_size > 0 ? block_size : DEFAULT_BLOCK_SIZE;
+  impl->last = NULL;
+  impl->last_used = 0;
+
+  return (Arena)impl;
+}
+
+void *arena_alloc(Arena arena, size_t size) {
+  if (arena == NULL) {
+    return NULL;
+  }
+
+  ArenaImpl *impl = (ArenaImpl *)arena;
+  ArenaBlock *block = impl->head;
+  size_t offset = 0;
+  if (block != NULL) {
+    offset = aligned_offset(block);
+  }
+  if (block == NULL || offset > block->capacity ||
+      size > block->capacity - offset) {
+    block = push_block(impl, size);
+    if (block == NULL) {
+      return NULL;
+    }
+    offset = aligned_offset(block);
+  }
+
+  void *ptr = block_bytes(block) + offset;
+  impl->last = ptr;
+  impl->last_used = block->used;
+  block->used = offset + size;
+  return ptr;
+}
+
+void arena_release(Arena arena, void *ptr) {
+  if (arena == NULL || ptr == NULL) {
+    return;
+  }
+
+  ArenaImpl *impl = (ArenaImpl *)arena;
+  if (ptr == impl->last) {
+    impl->head->used = impl->last_used;
+    impl->last = NULL;
+  }
+}
+
+void arena_reset(Arena arena) {
+  if (arena == NULL) {
+    return;
+  }
+
+  ArenaImpl *impl = (ArenaImpl *)arena;
+  if (impl->head == NULL) {
+    return;
+  }
+
+  ArenaBlock *block = impl->head->next;
+  while (block != NULL) {
+    ArenaBlock *next = block->next;
+    free(block);
+    block = next;
+  }
+
+  impl->head->next = NULL;
+  impl->head->used = 0;
+  impl->last = NULL;
+}
+
+size_t arena_get_capacity(Arena arena) {
+  if (arena == NULL) {
+    return 0;
+  }
+
+  size_t capacity = 0;
+  for (ArenaBlock *block = ((ArenaImpl *)arena)->head; block != NULL;
+       block = block->next) {
+    capacity += block->capacity;
+  }
+  return capacity;
+}
+
+void arena_destroy(Arena arena) {
+  if (arena == NULL) {
+    return;
+  }
+
+  ArenaImpl *impl = (ArenaImpl *)arena;
+  ArenaBlock *block = impl->head;
+  while (block != NULL) {
+    ArenaBlock *next = block->next;
+    free(block);
+    block = next;
+  }
+  free(impl);
+}
@@ -0,0 +1,72 @@
+/**
+ * @file arena.h
+ * @brief Bump allocator for short-lived scratch memory
+ *
+ * An arena hands out memory by advancing a pointer inside large blocks and
+ * takes it all back at once with arena_reset(). After a reset only the largest
+ * block is kept, so a workload that repeats with the same shape settles on one
+ * block and stops calling malloc() altogether.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/**
+ * @brief Opaque pointer type for arena instances
+ */
+typedef void *Arena;
+
+/**
+ * @brief Alignment of every pointer returned by arena_alloc()
+ */
+#define ARENA_ALIGNMENT 16
+
+/**
+ * @brief Creates an empty arena
+ * @param block_size Size of the first block, allocated on first use (0 picks
+ * a default)
+ * @return Arena instance or NULL on error
+ */
+Arena arena_create(size_t block_size);
+
+/**
+ * @brief Allocates memory that lives until the next arena_reset()
+ * @param arena Arena instance
+ * @param size Bytes to allocate
+ * @return Memory aligned to ARENA_ALIGNMENT, or NULL on error
+ */
+void *arena_alloc(Arena arena, size_t size);
+
+/**
+ * @brief Gives back an allocation
+ *
+ * Only the most recent allocation is actually reclaimed, so scratch buffers
+ * allocated and released in stack order reuse the same bytes. Anything else
+ * is kept until the next arena_reset().
+ * @param arena Arena instance
+ * @param ptr Pointer returned by arena_alloc() (NULL is ignored)
+ */
+void arena_release(Arena arena, void *ptr);
+
+/**
+ * @brief Frees every allocation at once, keeping the largest block
+ * @param arena Arena instance
+ */
+void arena_reset(Arena arena);
+
+/**
+ * @brief Gets the bytes held by the arena's blocks
+ * @param arena Arena instance
+ * @return Total block capacity
+ */
+size_t arena_get_capacity(Arena arena);
+
+/**
+ * @brief Frees the arena and all of its blocks
+ * @param arena Arena instance to destroy
+ */
+void arena_destroy(Arena arena);
+
+#endif // ARENA_H
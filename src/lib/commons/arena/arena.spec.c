@@ -0,0 +1,147 @@
+/**
+ * @file arena.spec.c
+ * @brief Unit tests for arena module
+ *
+ * Unit tests for the bump allocator functions defined in arena.h
+ */
+
+#include "./arena.h"
+#include "../../test_framework/test_framework.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SMALL_BLOCK 256
+#define ROUND_COUNT 5
+
+// ============================================================================
+// Test Helpers
+// ============================================================================
+
+// Allocates the same mix of sizes every round and fills every allocation
+static bool fill_round(Arena arena) {
+  for (int i = 1; i <= 100; i++) {
+    size_t size = (size_t)(i * 7 % 61) + 1;
+    unsigned char *bytes = arena_alloc(arena, size);
+    if (bytes == NULL) {
+      return false;
+    }
+    memset(bytes, i, size);
+  }
+  return true;
+}
+
+// ============================================================================
+// Tests for arena_alloc()
+// ============================================================================
+
+/**
+ * Test: allocations should be aligned, distinct and keep their contents
+ */
+bool test_arena_alloc_aligned(void) {
+  Arena arena = arena_create(SMALL_BLOCK);
+  ASSERT_NOT_NULL(arena);
+
+  unsigned char *blocks[50];
+  for (int i = 0; i < 50; i++) {
+    blocks[i] = arena_alloc(arena, (size_t)i + 1);
+    ASSERT_NOT_NULL(blocks[i]);
+    ASSERT_EQUAL((uintptr_t)blocks[i] % ARENA_ALIGNMENT, 0);
+    memset(blocks[i], i, (size_t)i + 1);
+  }
+  for (int i = 0; i < 50; i++) {
+    ASSERT_EQUAL(blocks[i][0], i);
+    ASSERT_EQUAL(blocks[i][i], i);
+  }
+
+  arena_destroy(arena);
+  return true;
+}
+
+/**
+ * Test: requests larger than a block should get a block of their own
+ */
+bool test_arena_alloc_large(void) {
+  Arena arena = arena_create(SMALL_BLOCK);
+  ASSERT_NOT_NULL(arena);
+
+  unsigned char *big = arena_alloc(arena, SMALL_BLOCK * 10);
+  ASSERT_NOT_NULL(big);
+  memset(big, 0xab, SMALL_BLOCK * 10);
+  ASSERT_TRUE(arena_get_capacity(arena) >= SMALL_BLOCK * 10);
+
+  ASSERT_NULL(arena_alloc(NULL, 8));
+  arena_destroy(arena);
+  return true;
+}
+
+// ============================================================================
+// Tests for arena_release() / arena_reset()
+// ============================================================================
+
+/**
+ * Test: releasing the latest allocation should hand out the same bytes again
+ */
+bool test_arena_release_latest(void) {
+  Arena arena = arena_create(SMALL_BLOCK);
+  ASSERT_NOT_NULL(arena);
+
+  void *first = arena_alloc(arena, 32);
+  void *second = arena_alloc(arena, 32);
+  arena_release(arena, second);
+  void *third = arena_alloc(arena, 32);
+  ASSERT_TRUE(third == second);
+
+  // Older allocations stay put until the next reset
+  arena_release(arena, first);
+  void *fourth = arena_alloc(arena, 32);
+  ASSERT_TRUE(fourth != first);
+
+  arena_destroy(arena);
+  return true;
+}
+
+/**
+ * Test: repeating the same work after resets should stop growing the arena
+ */
+bool test_arena_reset_reaches_steady_state(void) {
+  Arena arena = arena_create(SMALL_BLOCK);
+  ASSERT_NOT_NULL(arena);
+
+  size_t capacities[ROUND_COUNT];
+  for (int round = 0; round < ROUND_COUNT; round++) {
+    ASSERT_TRUE(fill_round(arena));
+    arena_reset(arena);
+    capacities[round] = arena_get_capacity(arena);
+  }
+  ASSERT_TRUE(capacities[ROUND_COUNT - 1] >= 100);
+  ASSERT_EQUAL(capacities[ROUND_COUNT - 2], capacities[ROUND_COUNT - 1]);
+  ASSERT_EQUAL(capacities[ROUND_COUNT - 3], capacities[ROUND_COUNT - 1]);
+
+  arena_destroy(arena);
+  return true;
+}
+
+// ============================================================================
+// Main Test Runner
+// ============================================================================
+
+int main(void) {
+  test_framework_init();
+
+  test_print_section("Testing arena_alloc()");
+  test_register("test_arena_alloc_aligned", test_arena_alloc_aligned);
+  test_register("test_arena_alloc_large", test_arena_alloc_large);
+
+  test_print_section("Testing arena_release() / arena_reset()");
+  test_register("test_arena_release_latest", test_arena_release_latest);
+  test_register("test_arena_reset_reaches_steady_state",
+                test_arena_reset_reaches_steady_state);
+
+  int result = test_run_all();
+
+  test_framework_cleanup();
+
+  return result;
+}
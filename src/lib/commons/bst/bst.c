@@ -2,12 +2,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+// Node colors for red-black balancing
+typedef enum { RB_RED, RB_BLACK } RBColor;
+
 // Internal node structure
 typedef struct BSTNodeImpl {
   void *data;                 // Pointer to the stored element (e.g., Segment)
   struct BSTNodeImpl *left;   // Left child
   struct BSTNodeImpl *right;  // Right child
   struct BSTNodeImpl *parent; // Parent node (for efficient deletion)
+  RBColor color;              // Red-black color (NULL children are black)
 } BSTNodeImpl;
 
 // Internal BST structure
@@ -16,17 +20,33 @@ typedef struct {
   BSTCompareFunc compare; // Comparison function
   void *context;          // Context for comparison (e.g., source point)
   int size;               // Number of elements
+  BSTAllocFunc alloc;     // Allocates the tree, nodes and rekey buffers
+  BSTFreeFunc release;    // Releases what alloc returned
+  void *allocator;        // State passed to alloc and release
 } BSTImpl;
 
 // ============================================================================
 // Private Helper Functions
 // ============================================================================
 
+/**
+ * Default allocator: the C heap.
+ */
+static void *heap_alloc(void *allocator, size_t size) {
+  (void)allocator;
+  return malloc(size);
+}
+
+static void heap_free(void *allocator, void *ptr) {
+  (void)allocator;
+  free(ptr);
+}
+
 /**
  * Creates a new BST node.
  */
-static BSTNodeImpl *create_node(void *data) {
-  BSTNodeImpl *node = malloc(sizeof(BSTNodeImpl));
+static BSTNodeImpl *create_node(BSTImpl *tree, void *data) {
+  BSTNodeImpl *node = tree->alloc(tree->allocator, sizeof(BSTNodeImpl));
   if (node == NULL) {
     return NULL;
   }
@@ -35,10 +55,18 @@ static BSTNodeImpl *create_node(void *data) {
   node->left = NULL;
   node->right = NULL;
   node->parent = NULL;
+  node->color = RB_RED;
 
   return node;
 }
 
+/**
+ * Returns the color of a node, treating NULL leaves as black.
+ */
+static RBColor color_of(BSTNodeImpl *node) {
+  return node == NULL ? RB_BLACK : node->color;
+}
+
 /**
  * Finds the minimum node in a subtree.
  */
@@ -86,22 +114,283 @@ static void transplant(BSTImpl *tree, BSTNodeImpl *u, BSTNodeImpl *v) {
   }
 }
 
+/**
+ * Rotates the subtree rooted at x to the left (x's right child takes its
+ * place). In-order sequence is preserved.
+ */
+static void rotate_left(BSTImpl *tree, BSTNodeImpl *x) {
+  BSTNodeImpl *y = x->right;
+
+  x->right = y->left;
+  if (y->left != NULL) {
+    y->left->parent = x;
+  }
+
+  y->parent = x->parent;
+  if (x->parent == NULL) {
+    tree->root = y;
+  } else if (x == x->parent->left) {
+    x->parent->left = y;
+  } else {
+    x->parent->right = y;
+  }
+
+  y->left = x;
+  x->parent = y;
+}
+
+/**
+ * Rotates the subtree rooted at x to the right (x's left child takes its
+ * place). In-order sequence is preserved.
+ */
+static void rotate_right(BSTImpl *tree, BSTNodeImpl *x) {
+  BSTNodeImpl *y = x->left;
+
+  x->left = y->right;
+  if (y->right != NULL) {
+    y->right->parent = x;
+  }
+
+  y->parent = x->parent;
+  if (x->parent == NULL) {
+    tree->root = y;
+  } else if (x == x->parent->right) {
+    x->parent->right = y;
+  } else {
+    x->parent->left = y;
+  }
+
+  y->right = x;
+  x->parent = y;
+}
+
+/**
+ * Restores the red-black properties after inserting node z.
+ */
+static void insert_fixup(BSTImpl *tree, BSTNodeImpl *z) {
+  while (z->parent != NULL && z->parent->color == RB_RED) {
+    BSTNodeImpl *parent = z->parent;
+    BSTNodeImpl *grandparent = parent->parent;
+
+    if (parent == grandparent->left) {
+      BSTNodeImpl *uncle = grandparent->right;
+      if (color_of(uncle) == RB_RED) {
+        parent->color = RB_BLACK;
+        uncle->color = RB_BLACK;
+        grandparent->color = RB_RED;
+        z = grandparent;
+      } else {
+        if (z == parent->right) {
+          z = parent;
+          rotate_left(tree, z);
+          parent = z->parent;
+        }
+        parent->color = RB_BLACK;
+        grandparent->color = RB_RED;
+        rotate_right(tree, grandparent);
+      }
+    } else {
+      BSTNodeImpl *uncle = grandparent->left;
+      if (color_of(uncle) == RB_RED) {
+        parent->color = RB_BLACK;
+        uncle->color = RB_BLACK;
+        grandparent->color = RB_RED;
+        z = grandparent;
+      } else {
+        if (z == parent->left) {
+          z = parent;
+          rotate_right(tree, z);
+          parent = z->parent;
+        }
+        parent->color = RB_BLACK;
+        grandparent->color = RB_RED;
+        rotate_left(tree, grandparent);
+      }
+    }
+  }
+
+  tree->root->color = RB_BLACK;
+}
+
+/**
+ * Restores the red-black properties after a black node was removed.
+ * x is the node that took the removed position (may be NULL), and
+ * x_parent is its parent (needed because NULL leaves carry no parent).
+ */
+static void remove_fixup(BSTImpl *tree, BSTNodeImpl *x,
+                         BSTNodeImpl *x_parent) {
+  while (x != tree->root && color_of(x) == RB_BLACK) {
+    if (x == x_parent->left) {
+      BSTNodeImpl *w = x_parent->right;
+      if (color_of(w) == RB_RED) {
+        w->color = RB_BLACK;
+        x_parent->color = RB_RED;
+        rotate_left(tree, x_parent);
+        w = x_parent->right;
+      }
+      if (color_of(w->left) == RB_BLACK && color_of(w->right) == RB_BLACK) {
+        w->color = RB_RED;
+        x = x_parent;
+        x_parent = x->parent;
+      } else {
+        if (color_of(w->right) == RB_BLACK) {
+          w->left->color = RB_BLACK;
+          w->color = RB_RED;
+          rotate_right(tree, w);
+          w = x_parent->right;
+        }
+        w->color = x_parent->color;
+        x_parent->color = RB_BLACK;
+        if (w->right != NULL) {
+          w->right->color = RB_BLACK;
+        }
+        rotate_left(tree, x_parent);
+        x = tree->root;
+        x_parent = NULL;
+      }
+    } else {
+      BSTNodeImpl *w = x_parent->left;
+      if (color_of(w) == RB_RED) {
+        w->color = RB_BLACK;
+        x_parent->color = RB_RED;
+        rotate_right(tree, x_parent);
+        w = x_parent->left;
+      }
+      if (color_of(w->left) == RB_BLACK && color_of(w->right) == RB_BLACK) {
+        w->color = RB_RED;
+        x = x_parent;
+        x_parent = x->parent;
+      } else {
+        if (color_of(w->left) == RB_BLACK) {
+          w->right->color = RB_BLACK;
+          w->color = RB_RED;
+          rotate_left(tree, w);
+          w = x_parent->left;
+        }
+        w->color = x_parent->color;
+        x_parent->color = RB_BLACK;
+        if (w->left != NULL) {
+          w->left->color = RB_BLACK;
+        }
+        rotate_right(tree, x_parent);
+        x = tree->root;
+        x_parent = NULL;
+      }
+    }
+  }
+
+  if (x != NULL) {
+    x->color = RB_BLACK;
+  }
+}
+
+/**
+ * Computes the height of a subtree (number of nodes on the longest path).
+ */
+static int subtree_height(BSTNodeImpl *node) {
+  if (node == NULL) {
+    return 0;
+  }
+
+  int left_height = subtree_height(node->left);
+  int right_height = subtree_height(node->right);
+
+  return 1 + (left_height > right_height ? left_height : right_height);
+}
+
+/**
+ * Fills an array with the nodes of a subtree in in-order sequence.
+ */
+static void collect_nodes(BSTNodeImpl *node, BSTNodeImpl **nodes, int *count) {
+  if (node == NULL) {
+    return;
+  }
+
+  collect_nodes(node->left, nodes, count);
+  nodes[(*count)++] = node;
+  collect_nodes(node->right, nodes, count);
+}
+
+/**
+ * Stable merge sort of node pointers using the tree comparator.
+ */
+static void sort_nodes(BSTImpl *tree, BSTNodeImpl **nodes, BSTNodeImpl **temp,
+                       int left, int right) {
+  if (right - left < 1) {
+    return;
+  }
+
+  int mid = left + (right - left) / 2;
+  sort_nodes(tree, nodes, temp, left, mid);
+  sort_nodes(tree, nodes, temp, mid + 1, right);
+
+  // Already ordered halves need no merge
+  if (tree->compare(nodes[mid]->data, nodes[mid + 1]->data, tree->context) <=
+      0) {
+    return;
+  }
+
+  int i = left, j = mid + 1, k = left;
+  while (i <= mid && j <= right) {
+    if (tree->compare(nodes[i]->data, nodes[j]->data, tree->context) <= 0) {
+      temp[k++] = nodes[i++];
+    } else {
+      temp[k++] = nodes[j++];
+    }
+  }
+  while (i <= mid) {
+    temp[k++] = nodes[i++];
+  }
+  while (j <= right) {
+    temp[k++] = nodes[j++];
+  }
+  for (k = left; k <= right; k++) {
+    nodes[k] = temp[k];
+  }
+}
+
+/**
+ * Links a sorted node array into a balanced subtree. Nodes on the deepest
+ * level are colored red and all others black, which gives every path the
+ * same black height.
+ */
+static BSTNodeImpl *build_balanced(BSTNodeImpl **nodes, int left, int right,
+                                   BSTNodeImpl *parent, int depth,
+                                   int deepest) {
+  if (left > right) {
+    return NULL;
+  }
+
+  int mid = left + (right - left) / 2;
+  BSTNodeImpl *node = nodes[mid];
+
+  node->parent = parent;
+  node->color = (depth == deepest && depth > 0) ? RB_RED : RB_BLACK;
+  node->left =
+      build_balanced(nodes, left, mid - 1, node, depth + 1, deepest);
+  node->right =
+      build_balanced(nodes, mid + 1, right, node, depth + 1, deepest);
+
+  return node;
+}
+
 /**
  * Recursively clears a subtree.
  */
-static void clear_subtree(BSTNodeImpl *node, BSTDestroyFunc destroy_func) {
+static void clear_subtree(BSTImpl *tree, BSTNodeImpl *node,
+                          BSTDestroyFunc destroy_func) {
   if (node == NULL) {
     return;
   }
 
-  clear_subtree(node->left, destroy_func);
-  clear_subtree(node->right, destroy_func);
+  clear_subtree(tree, node->left, destroy_func);
+  clear_subtree(tree, node->right, destroy_func);
 
   if (destroy_func != NULL && node->data != NULL) {
     destroy_func(node->data);
   }
 
-  free(node);
+  tree->release(tree->allocator, node);
 }
 
 // ============================================================================
@@ -109,11 +398,18 @@ static void clear_subtree(BSTNodeImpl *node, BSTDestroyFunc destroy_func) {
 // ============================================================================
 
 BST bst_create(BSTCompareFunc compare_func, void *context) {
-  if (compare_func == NULL) {
+  return bst_create_with_allocator(compare_func, context, heap_alloc, heap_free,
+                                   NULL);
+}
+
+BST bst_create_with_allocator(BSTCompareFunc compare_func, void *context,
+                              BSTAllocFunc alloc_func, BSTFreeFunc free_func,
+                              void *allocator) {
+  if (compare_func == NULL || alloc_func == NULL || free_func == NULL) {
     return NULL;
   }
 
-  BSTImpl *tree = malloc(sizeof(BSTImpl));
+  BSTImpl *tree = alloc_func(allocator, sizeof(BSTImpl));
   if (tree == NULL) {
     return NULL;
   }
@@ -122,6 +418,9 @@ BST bst_create(BSTCompareFunc compare_func, void *context) {
   tree->compare = compare_func;
   tree->context = context;
   tree->size = 0;
+  tree->alloc = alloc_func;
+  tree->release = free_func;
+  tree->allocator = allocator;
 
   return (BST)tree;
 }
@@ -132,13 +431,14 @@ BSTNode bst_insert(BST tree, void *data) {
   }
 
   BSTImpl *impl = (BSTImpl *)tree;
-  BSTNodeImpl *new_node = create_node(data);
+  BSTNodeImpl *new_node = create_node(impl, data);
   if (new_node == NULL) {
     return NULL;
   }
 
   // Empty tree case
   if (impl->root == NULL) {
+    new_node->color = RB_BLACK;
     impl->root = new_node;
     impl->size++;
     return (BSTNode)new_node;
@@ -147,10 +447,11 @@ BSTNode bst_insert(BST tree, void *data) {
   // Find insertion point
   BSTNodeImpl *current = impl->root;
   BSTNodeImpl *parent = NULL;
+  int cmp = 0;
 
   while (current != NULL) {
     parent = current;
-    int cmp = impl->compare(data, current->data, impl->context);
+    cmp = impl->compare(data, current->data, impl->context);
 
     if (cmp < 0) {
       current = current->left;
@@ -159,9 +460,8 @@ BSTNode bst_insert(BST tree, void *data) {
     }
   }
 
-  // Insert as child of parent
+  // Insert as child of parent (reusing the last comparison)
   new_node->parent = parent;
-  int cmp = impl->compare(data, parent->data, impl->context);
 
   if (cmp < 0) {
     parent->left = new_node;
@@ -169,6 +469,8 @@ BSTNode bst_insert(BST tree, void *data) {
     parent->right = new_node;
   }
 
+  insert_fixup(impl, new_node);
+
   impl->size++;
   return (BSTNode)new_node;
 }
@@ -181,32 +483,53 @@ void bst_remove_node(BST tree, BSTNode node) {
   BSTImpl *impl = (BSTImpl *)tree;
   BSTNodeImpl *z = (BSTNodeImpl *)node;
 
+  // x takes the position vacated in the tree; its parent is tracked
+  // separately because x may be a NULL leaf
+  BSTNodeImpl *x = NULL;
+  BSTNodeImpl *x_parent = NULL;
+  RBColor removed_color = z->color;
+
   // Case 1: Node has no left child
   if (z->left == NULL) {
+    x = z->right;
+    x_parent = z->parent;
     transplant(impl, z, z->right);
   }
   // Case 2: Node has no right child
   else if (z->right == NULL) {
+    x = z->left;
+    x_parent = z->parent;
     transplant(impl, z, z->left);
   }
   // Case 3: Node has two children
   else {
-    // Find successor (minimum in right subtree)
+    // Find successor (minimum in right subtree). The successor node itself
+    // is moved into z's place, so handles held by callers stay valid.
     BSTNodeImpl *y = find_min_node_internal(z->right);
+    removed_color = y->color;
+    x = y->right;
 
     // If successor is not the immediate right child
     if (y->parent != z) {
+      x_parent = y->parent;
       transplant(impl, y, y->right);
       y->right = z->right;
       y->right->parent = y;
+    } else {
+      x_parent = y;
     }
 
     transplant(impl, z, y);
     y->left = z->left;
     y->left->parent = y;
+    y->color = z->color;
+  }
+
+  if (removed_color == RB_BLACK) {
+    remove_fixup(impl, x, x_parent);
   }
 
-  free(z);
+  impl->release(impl->allocator, z);
   impl->size--;
 }
 
@@ -261,6 +584,88 @@ void *bst_node_get_data(BSTNode node) {
   return impl->data;
 }
 
+void bst_node_swap_data(BSTNode a, BSTNode b) {
+  if (a == NULL || b == NULL) {
+    return;
+  }
+
+  BSTNodeImpl *impl_a = (BSTNodeImpl *)a;
+  BSTNodeImpl *impl_b = (BSTNodeImpl *)b;
+  void *data = impl_a->data;
+  impl_a->data = impl_b->data;
+  impl_b->data = data;
+}
+
+BSTNode bst_node_next(BSTNode node) {
+  if (node == NULL) {
+    return NULL;
+  }
+
+  BSTNodeImpl *current = (BSTNodeImpl *)node;
+  if (current->right != NULL) {
+    return (BSTNode)find_min_node_internal(current->right);
+  }
+
+  BSTNodeImpl *parent = current->parent;
+  while (parent != NULL && current == parent->right) {
+    current = parent;
+    parent = parent->parent;
+  }
+
+  return (BSTNode)parent;
+}
+
+BSTNode bst_node_prev(BSTNode node) {
+  if (node == NULL) {
+    return NULL;
+  }
+
+  BSTNodeImpl *current = (BSTNodeImpl *)node;
+  if (current->left != NULL) {
+    return (BSTNode)find_max_node_internal(current->left);
+  }
+
+  BSTNodeImpl *parent = current->parent;
+  while (parent != NULL && current == parent->left) {
+    current = parent;
+    parent = parent->parent;
+  }
+
+  return (BSTNode)parent;
+}
+
+bool bst_rekey(BST tree) {
+  if (tree == NULL) {
+    return false;
+  }
+
+  BSTImpl *impl = (BSTImpl *)tree;
+  if (impl->size < 2) {
+    return true;
+  }
+
+  BSTNodeImpl **nodes =
+      impl->alloc(impl->allocator, sizeof(BSTNodeImpl *) * impl->size * 2);
+  if (nodes == NULL) {
+    return false;
+  }
+
+  int count = 0;
+  collect_nodes(impl->root, nodes, &count);
+  sort_nodes(impl, nodes, nodes + count, 0, count - 1);
+
+  // Height of a tree built by splitting at the middle is floor(log2(n)) + 1
+  int deepest = 0;
+  while ((2 << deepest) <= count) {
+    deepest++;
+  }
+
+  impl->root = build_balanced(nodes, 0, count - 1, NULL, 0, deepest);
+
+  impl->release(impl->allocator, nodes);
+  return true;
+}
+
 bool bst_is_empty(BST tree) {
   if (tree == NULL) {
     return true;
@@ -279,13 +684,22 @@ int bst_size(BST tree) {
   return impl->size;
 }
 
+int bst_height(BST tree) {
+  if (tree == NULL) {
+    return 0;
+  }
+
+  BSTImpl *impl = (BSTImpl *)tree;
+  return subtree_height(impl->root);
+}
+
 void bst_clear(BST tree, BSTDestroyFunc destroy_func) {
   if (tree == NULL) {
     return;
   }
 
   BSTImpl *impl = (BSTImpl *)tree;
-  clear_subtree(impl->root, destroy_func);
+  clear_subtree(impl, impl->root, destroy_func);
   impl->root = NULL;
   impl->size = 0;
 }
@@ -296,7 +710,8 @@ void bst_destroy(BST tree, BSTDestroyFunc destroy_func) {
   }
 
   bst_clear(tree, destroy_func);
-  free(tree);
+  BSTImpl *impl = (BSTImpl *)tree;
+  impl->release(impl->allocator, impl);
 }
 
 // Helper for in-order traversal
@@ -2,8 +2,11 @@
 #define BST_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 // Opaque pointer definitions
+// The tree is kept balanced as a red-black tree, so insertions and removals
+// are O(log n) even when elements arrive in sorted order.
 typedef void *BST;
 typedef void *BSTNode;
 
@@ -22,6 +25,21 @@ typedef int (*BSTCompareFunc)(void *a, void *b, void *context);
  */
 typedef void (*BSTDestroyFunc)(void *data);
 
+/**
+ * Allocation function type for BST memory.
+ * @param allocator Allocator state given to bst_create_with_allocator()
+ * @param size Bytes to allocate
+ * @return Allocated memory, or NULL on failure
+ */
+typedef void *(*BSTAllocFunc)(void *allocator, size_t size);
+
+/**
+ * Release function type for BST memory.
+ * @param allocator Allocator state given to bst_create_with_allocator()
+ * @param ptr Memory obtained from the matching BSTAllocFunc
+ */
+typedef void (*BSTFreeFunc)(void *allocator, void *ptr);
+
 /**
  * Creates a new BST instance.
  * @param compare_func Comparison function for ordering elements
@@ -32,7 +50,23 @@ typedef void (*BSTDestroyFunc)(void *data);
 BST bst_create(BSTCompareFunc compare_func, void *context);
 
 /**
- * Inserts an element into the BST.
+ * Creates a new BST instance whose tree, nodes and temporary buffers come from
+ * a caller-provided allocator instead of malloc/free (e.g., an arena that is
+ * reset as a whole, so the tree need not be destroyed).
+ * @param compare_func Comparison function for ordering elements
+ * @param context Additional context passed to comparison function
+ * @param alloc_func Allocation function
+ * @param free_func Release function
+ * @param allocator State passed to both functions
+ * @return Pointer to the new BST object, or NULL on allocation failure
+ */
+BST bst_create_with_allocator(BSTCompareFunc compare_func, void *context,
+                              BSTAllocFunc alloc_func, BSTFreeFunc free_func,
+                              void *allocator);
+
+/**
+ * Inserts an element into the BST and rebalances it.
+ * This is O(log n) operation.
  * @param tree BST handle
  * @param data Element to insert
  * @return Pointer to the created node (can be used as helper for fast
@@ -42,7 +76,8 @@ BSTNode bst_insert(BST tree, void *data);
 
 /**
  * Removes an element from the BST using direct node reference.
- * This is O(log n) operation when using the helper pointer.
+ * This is O(log n) operation when using the helper pointer. Handles of the
+ * other nodes remain valid after the removal.
  * @param tree BST handle
  * @param node Node to remove (obtained from bst_insert)
  */
@@ -80,6 +115,40 @@ BSTNode bst_find_min_node(BST tree);
  */
 void *bst_node_get_data(BSTNode node);
 
+/**
+ * Gets the in-order successor of a node.
+ * @param node Node handle
+ * @return Next node in order, or NULL if node is the maximum or NULL
+ */
+BSTNode bst_node_next(BSTNode node);
+
+/**
+ * Gets the in-order predecessor of a node.
+ * @param node Node handle
+ * @return Previous node in order, or NULL if node is the minimum or NULL
+ */
+BSTNode bst_node_prev(BSTNode node);
+
+/**
+ * Exchanges the elements held by two nodes, for when two neighbours swap
+ * places in the ordering (e.g., keys that move with the comparison context
+ * cross each other). The tree is not re-checked, so the caller must keep it
+ * ordered. Each node handle then holds the other element.
+ * @param a First node handle
+ * @param b Second node handle
+ */
+void bst_node_swap_data(BSTNode a, BSTNode b);
+
+/**
+ * Re-sorts the tree after the ordering of its elements changed (e.g., the
+ * comparison context moved so that keys compare differently). The nodes are
+ * relinked into a balanced tree, so node handles remain valid.
+ * This is O(n log n), or O(n) when the elements are still in order.
+ * @param tree BST handle
+ * @return true on success, false on allocation failure
+ */
+bool bst_rekey(BST tree);
+
 /**
  * Checks if the BST is empty.
  * @param tree BST handle
@@ -94,6 +163,14 @@ bool bst_is_empty(BST tree);
  */
 int bst_size(BST tree);
 
+/**
+ * Gets the height of the BST (number of nodes on the longest root-to-leaf
+ * path). For a red-black tree this never exceeds 2 * log2(n + 1).
+ * @param tree BST handle
+ * @return Height of the tree, or 0 if tree is empty
+ */
+int bst_height(BST tree);
+
 /**
  * Clears all elements from the BST.
  * @param tree BST handle
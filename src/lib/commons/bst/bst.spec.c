@@ -198,6 +198,263 @@ bool test_bst_node_get_data() {
   return true;
 }
 
+bool test_bst_node_next_prev() {
+  BST tree = bst_create(compare_ints, NULL);
+  int values[] = {50, 30, 70, 20, 40, 60, 80};
+  BSTNode nodes[7];
+
+  for (int i = 0; i < 7; i++) {
+    nodes[i] = bst_insert(tree, &values[i]);
+  }
+
+  // Walk forward from the minimum
+  int expected[] = {20, 30, 40, 50, 60, 70, 80};
+  BSTNode node = bst_find_min_node(tree);
+  for (int i = 0; i < 7; i++) {
+    ASSERT_NOT_NULL(node);
+    ASSERT_EQUAL(*(int *)bst_node_get_data(node), expected[i]);
+    node = bst_node_next(node);
+  }
+  ASSERT_NULL(node);
+
+  // Neighbours of 50
+  ASSERT_EQUAL(*(int *)bst_node_get_data(bst_node_prev(nodes[0])), 40);
+  ASSERT_EQUAL(*(int *)bst_node_get_data(bst_node_next(nodes[0])), 60);
+  ASSERT_NULL(bst_node_prev(nodes[3]));
+  ASSERT_NULL(bst_node_next(NULL));
+
+  bst_destroy(tree, NULL);
+  return true;
+}
+
+// Comparison that orders by value or by negated value depending on context
+int compare_ints_signed(void *a, void *b, void *context) {
+  int sign = *(int *)context;
+  return sign * compare_ints(a, b, NULL);
+}
+
+bool test_bst_rekey_reorders_and_keeps_handles() {
+  int sign = 1;
+  BST tree = bst_create(compare_ints_signed, &sign);
+  int values[] = {5, 1, 9, 3, 7, 2, 8};
+  BSTNode nodes[7];
+
+  for (int i = 0; i < 7; i++) {
+    nodes[i] = bst_insert(tree, &values[i]);
+  }
+  ASSERT_EQUAL(*(int *)bst_find_min(tree), 1);
+
+  // Flip the ordering and rebuild
+  sign = -1;
+  ASSERT_TRUE(bst_rekey(tree));
+  ASSERT_EQUAL(*(int *)bst_find_min(tree), 9);
+  ASSERT_EQUAL(bst_size(tree), 7);
+  ASSERT_TRUE(bst_height(tree) <= 3);
+
+  // Handles still reference their elements and can be removed
+  bst_remove_node(tree, nodes[2]); // Remove 9
+  ASSERT_EQUAL(*(int *)bst_find_min(tree), 8);
+  ASSERT_EQUAL(*(int *)bst_node_get_data(nodes[0]), 5);
+
+  bst_destroy(tree, NULL);
+  return true;
+}
+
+bool test_bst_node_swap_data_follows_crossing() {
+  int sign = 1;
+  BST tree = bst_create(compare_ints_signed, &sign);
+  int values[] = {1, 2, 3};
+  BSTNode nodes[3];
+
+  for (int i = 0; i < 3; i++) {
+    nodes[i] = bst_insert(tree, &values[i]);
+  }
+
+  // 2 and 3 trade places, as if their keys crossed
+  values[1] = 3;
+  values[2] = 2;
+  bst_node_swap_data(nodes[1], nodes[2]);
+  ASSERT_EQUAL(bst_node_get_data(nodes[1]), &values[2]);
+  ASSERT_EQUAL(bst_node_get_data(nodes[2]), &values[1]);
+
+  // The in-order walk still comes out sorted
+  BSTNode node = bst_find_min_node(tree);
+  for (int expected = 1; expected <= 3; expected++) {
+    ASSERT_NOT_NULL(node);
+    ASSERT_EQUAL(*(int *)bst_node_get_data(node), expected);
+    node = bst_node_next(node);
+  }
+  ASSERT_NULL(node);
+
+  bst_node_swap_data(nodes[0], NULL);
+  ASSERT_EQUAL(bst_node_get_data(nodes[0]), &values[0]);
+
+  bst_destroy(tree, NULL);
+  return true;
+}
+
+// ============================================================================
+// Balancing Stress Tests
+// ============================================================================
+
+#define STRESS_COUNT 4096
+
+// Upper bound for a red-black tree height: 2 * log2(n + 1)
+static int max_balanced_height(int n) {
+  int log2_n = 0;
+  while ((1 << log2_n) < n + 1) {
+    log2_n++;
+  }
+  return 2 * log2_n;
+}
+
+// Collects in-order values to verify ordering after rotations
+typedef struct {
+  int values[STRESS_COUNT];
+  int count;
+} InorderCollector;
+
+static void collect_inorder(void *data, void *user_data) {
+  InorderCollector *collector = (InorderCollector *)user_data;
+  collector->values[collector->count++] = *(int *)data;
+}
+
+bool test_bst_height_sorted_ascending() {
+  BST tree = bst_create(compare_ints, NULL);
+  static int values[STRESS_COUNT];
+
+  for (int i = 0; i < STRESS_COUNT; i++) {
+    values[i] = i;
+    bst_insert(tree, &values[i]);
+    ASSERT_TRUE(bst_height(tree) <= max_balanced_height(i + 1));
+  }
+
+  ASSERT_EQUAL(bst_size(tree), STRESS_COUNT);
+  ASSERT_EQUAL(*(int *)bst_find_min(tree), 0);
+
+  bst_destroy(tree, NULL);
+  return true;
+}
+
+bool test_bst_height_sorted_descending() {
+  BST tree = bst_create(compare_ints, NULL);
+  static int values[STRESS_COUNT];
+
+  for (int i = 0; i < STRESS_COUNT; i++) {
+    values[i] = STRESS_COUNT - i;
+    bst_insert(tree, &values[i]);
+  }
+
+  ASSERT_TRUE(bst_height(tree) <= max_balanced_height(STRESS_COUNT));
+  ASSERT_EQUAL(*(int *)bst_find_min(tree), 1);
+
+  bst_destroy(tree, NULL);
+  return true;
+}
+
+bool test_bst_height_after_node_removals() {
+  BST tree = bst_create(compare_ints, NULL);
+  static int values[STRESS_COUNT];
+  static BSTNode nodes[STRESS_COUNT];
+
+  for (int i = 0; i < STRESS_COUNT; i++) {
+    values[i] = i;
+    nodes[i] = bst_insert(tree, &values[i]);
+  }
+
+  // Remove every other element through its node handle, in sorted order
+  for (int i = 0; i < STRESS_COUNT; i += 2) {
+    bst_remove_node(tree, nodes[i]);
+  }
+
+  int remaining = STRESS_COUNT / 2;
+  ASSERT_EQUAL(bst_size(tree), remaining);
+  ASSERT_TRUE(bst_height(tree) <= max_balanced_height(remaining));
+
+  // Remaining handles must still point to the right elements
+  for (int i = 1; i < STRESS_COUNT; i += 2) {
+    ASSERT_EQUAL(*(int *)bst_node_get_data(nodes[i]), i);
+  }
+
+  static InorderCollector collector;
+  collector.count = 0;
+  bst_foreach(tree, collect_inorder, &collector);
+  ASSERT_EQUAL(collector.count, remaining);
+  for (int i = 0; i < remaining; i++) {
+    ASSERT_EQUAL(collector.values[i], 2 * i + 1);
+  }
+
+  bst_destroy(tree, NULL);
+  return true;
+}
+
+bool test_bst_remove_min_repeatedly() {
+  BST tree = bst_create(compare_ints, NULL);
+  static int values[STRESS_COUNT];
+
+  for (int i = 0; i < STRESS_COUNT; i++) {
+    values[i] = i;
+    bst_insert(tree, &values[i]);
+  }
+
+  for (int i = 0; i < STRESS_COUNT; i++) {
+    BSTNode min_node = bst_find_min_node(tree);
+    ASSERT_NOT_NULL(min_node);
+    ASSERT_EQUAL(*(int *)bst_node_get_data(min_node), i);
+    bst_remove_node(tree, min_node);
+    ASSERT_TRUE(bst_height(tree) <= max_balanced_height(bst_size(tree)));
+  }
+
+  ASSERT_TRUE(bst_is_empty(tree));
+  ASSERT_EQUAL(bst_height(tree), 0);
+
+  bst_destroy(tree, NULL);
+  return true;
+}
+
+// Allocator that counts what the tree takes from it and gives back
+typedef struct {
+  int allocations;
+  int releases;
+} CountingAllocator;
+
+static void *counting_alloc(void *allocator, size_t size) {
+  ((CountingAllocator *)allocator)->allocations++;
+  return malloc(size);
+}
+
+static void counting_free(void *allocator, void *ptr) {
+  ((CountingAllocator *)allocator)->releases++;
+  free(ptr);
+}
+
+bool test_bst_custom_allocator() {
+  CountingAllocator counter = {0, 0};
+  ASSERT_NULL(bst_create_with_allocator(compare_ints, NULL, NULL,
+                                        counting_free, &counter));
+
+  BST tree = bst_create_with_allocator(compare_ints, NULL, counting_alloc,
+                                       counting_free, &counter);
+  ASSERT_NOT_NULL(tree);
+  static int values[100];
+  static BSTNode nodes[100];
+  for (int i = 0; i < 100; i++) {
+    values[i] = i;
+    nodes[i] = bst_insert(tree, &values[i]);
+  }
+  // The tree plus one node per element
+  ASSERT_EQUAL(counter.allocations, 101);
+
+  bst_remove_node(tree, nodes[50]);
+  ASSERT_EQUAL(counter.releases, 1);
+  ASSERT_TRUE(bst_rekey(tree));
+  ASSERT_EQUAL(counter.allocations, counter.releases + 100);
+
+  bst_destroy(tree, NULL);
+  ASSERT_EQUAL(counter.allocations, counter.releases);
+  return true;
+}
+
 // ============================================================================
 // Test Runner
 // ============================================================================
@@ -229,6 +486,30 @@ int main() {
   test_print_section("Testing bst_node_get_data()");
   test_register("test_bst_node_get_data", test_bst_node_get_data);
 
+  test_print_section("Testing bst_node_next() / bst_node_prev()");
+  test_register("test_bst_node_next_prev", test_bst_node_next_prev);
+
+  test_print_section("Testing bst_node_swap_data()");
+  test_register("test_bst_node_swap_data_follows_crossing",
+                test_bst_node_swap_data_follows_crossing);
+
+  test_print_section("Testing bst_rekey()");
+  test_register("test_bst_rekey_reorders_and_keeps_handles",
+                test_bst_rekey_reorders_and_keeps_handles);
+
+  test_print_section("Testing bst_height() balancing");
+  test_register("test_bst_height_sorted_ascending",
+                test_bst_height_sorted_ascending);
+  test_register("test_bst_height_sorted_descending",
+                test_bst_height_sorted_descending);
+  test_register("test_bst_height_after_node_removals",
+                test_bst_height_after_node_removals);
+  test_register("test_bst_remove_min_repeatedly",
+                test_bst_remove_min_repeatedly);
+
+  test_print_section("Testing bst_create_with_allocator()");
+  test_register("test_bst_custom_allocator", test_bst_custom_allocator);
+
   // Run all tests
   int result = test_run_all();
 
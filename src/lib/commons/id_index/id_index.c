@@ -0,0 +1,298 @@
+#include "id_index.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define INITIAL_SLOT_CAPACITY 64
+#define INITIAL_ITEM_CAPACITY 1
+
+// Hash table slot: every item sharing an id, in insertion order. Slots are
+// never freed once used, so an id whose items were all removed keeps its slot
+// (with count 0) and probing sequences stay intact.
+typedef struct {
+  bool used;    // Slot holds an id
+  int id;       // Slot id
+  void **items; // Items with this id
+  int count;    // Number of items
+  int capacity; // Allocated item slots
+} IdSlot;
+
+// Internal id index structure
+typedef struct {
+  IdSlot *slots; // Open-addressing slot table
+  int capacity;  // Table size (power of two)
+  int used;      // Used slots
+  int live_ids;  // Slots with at least one item
+  int size;      // Number of items
+} IdIndexImpl;
+
+// Match collected by a range visit
+typedef struct {
+  int id;
+  void *item;
+} IdMatch;
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+/**
+ * Hashes an id (Fibonacci hashing).
+ */
+static unsigned int hash_id(int id) {
+  unsigned int h = (unsigned int)id * 2654435761u;
+  return h ^ (h >> 16);
+}
+
+/**
+ * Finds the slot for an id (either the slot itself or an empty slot).
+ */
+static IdSlot *find_slot(IdSlot *slots, int capacity, int id) {
+  unsigned int mask = (unsigned int)capacity - 1;
+  unsigned int i = hash_id(id) & mask;
+  while (slots[i].used && slots[i].id != id) {
+    i = (i + 1) & mask;
+  }
+  return &slots[i];
+}
+
+/**
+ * Rebuilds the slot table with a new size, dropping slots left without items.
+ */
+static bool rebuild_slots(IdIndexImpl *impl, int new_capacity) {
+  IdSlot *new_slots = calloc(new_capacity, sizeof(IdSlot));
+  if (new_slots == NULL) {
+    printf("Error: Failed to allocate memory for id index slots\n");
+    return false;
+  }
+
+  int used = 0;
+  for (int i = 0; i < impl->capacity; i++) {
+    IdSlot *slot = &impl->slots[i];
+    if (!slot->used) {
+      continue;
+    }
+    if (slot->count == 0) {
+      free(slot->items);
+      continue;
+    }
+    *find_slot(new_slots, new_capacity, slot->id) = *slot;
+    used++;
+  }
+
+  free(impl->slots);
+  impl->slots = new_slots;
+  impl->capacity = new_capacity;
+  impl->used = used;
+  return true;
+}
+
+/**
+ * Gets the live slot for an id, or NULL when no item uses it.
+ */
+static IdSlot *get_live_slot(IdIndexImpl *impl, int id) {
+  IdSlot *slot = find_slot(impl->slots, impl->capacity, id);
+  return slot->used && slot->count > 0 ? slot : NULL;
+}
+
+/**
+ * Orders matches by id.
+ */
+static int compare_match_id(const void *a, const void *b) {
+  const IdMatch *ma = (const IdMatch *)a;
+  const IdMatch *mb = (const IdMatch *)b;
+  if (ma->id < mb->id) {
+    return -1;
+  }
+  return ma->id > mb->id ? 1 : 0;
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+IdIndex id_index_create(void) {
+  IdIndexImpl *impl = malloc(sizeof(IdIndexImpl));
+  if (impl == NULL) {
+    printf("Error: Failed to allocate memory for id index\n");
+    return NULL;
+  }
+
+  impl->slots = calloc(INITIAL_SLOT_CAPACITY, sizeof(IdSlot));
+  if (impl->slots == NULL) {
+    printf("Error: Failed to allocate memory for id index slots\n");
+    free(impl);
+    return NULL;
+  }
+
+  impl->capacity = INITIAL_SLOT_CAPACITY;
+  impl->used = 0;
+  impl->live_ids = 0;
+  impl->size = 0;
+
+  return impl;
+}
+
+void id_index_destroy(IdIndex index) {
+  if (index == NULL) {
+    return;
+  }
+
+  IdIndexImpl *impl = (IdIndexImpl *)index;
+  for (int i = 0; i < impl->capacity; i++) {
+    if (impl->slots[i].used) {
+      free(impl->slots[i].items);
+    }
+  }
+  free(impl->slots);
+  free(impl);
+}
+
+bool id_index_insert(IdIndex index, int id, void *item) {
+  if (index == NULL) {
+    return false;
+  }
+
+  IdIndexImpl *impl = (IdIndexImpl *)index;
+
+  IdSlot *slot = find_slot(impl->slots, impl->capacity, id);
+  if (!slot->used) {
+    if ((impl->used + 1) * 10 > impl->capacity * 7) {
+      // Mostly dead slots are just swept out, so ids coming and going do not
+      // grow the table past what the live ones need
+      int new_capacity = (impl->live_ids + 1) * 2 <= impl->capacity
+                             ? impl->capacity
+                             : impl->capacity * 2;
+      if (!rebuild_slots(impl, new_capacity)) {
+        return false;
+      }
+      slot = find_slot(impl->slots, impl->capacity, id);
+    }
+    slot->used = true;
+    slot->id = id;
+    slot->items = NULL;
+    slot->count = 0;
+    slot->capacity = 0;
+    impl->used++;
+  }
+
+  if (slot->count == slot->capacity) {
+    int new_capacity =
+        slot->capacity == 0 ? INITIAL_ITEM_CAPACITY : slot->capacity * 2;
+    void **grown = realloc(slot->items, new_capacity * sizeof(void *));
+    if (grown == NULL) {
+      printf("Error: Failed to allocate memory for id index items\n");
+      return false;
+    }
+    slot->items = grown;
+    slot->capacity = new_capacity;
+  }
+
+  if (slot->count == 0) {
+    impl->live_ids++;
+  }
+  slot->items[slot->count++] = item;
+  impl->size++;
+  return true;
+}
+
+bool id_index_remove(IdIndex index, int id, void *item) {
+  if (index == NULL) {
+    return false;
+  }
+
+  IdIndexImpl *impl = (IdIndexImpl *)index;
+  IdSlot *slot = get_live_slot(impl, id);
+  if (slot == NULL) {
+    return false;
+  }
+
+  for (int i = 0; i < slot->count; i++) {
+    if (slot->items[i] == item) {
+      for (int j = i + 1; j < slot->count; j++) {
+        slot->items[j - 1] = slot->items[j];
+      }
+      slot->count--;
+      if (slot->count == 0) {
+        impl->live_ids--;
+      }
+      impl->size--;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void *id_index_get(IdIndex index, int id) {
+  if (index == NULL) {
+    return NULL;
+  }
+
+  IdSlot *slot = get_live_slot((IdIndexImpl *)index, id);
+  return slot != NULL ? slot->items[0] : NULL;
+}
+
+void id_index_foreach_in_range(IdIndex index, int start_id, int end_id,
+                               IdIndexVisitFunc visit, void *user_data) {
+  if (index == NULL || visit == NULL || start_id > end_id) {
+    return;
+  }
+
+  IdIndexImpl *impl = (IdIndexImpl *)index;
+  if (impl->live_ids == 0) {
+    return;
+  }
+
+  IdMatch *matches = malloc(impl->live_ids * sizeof(IdMatch));
+  if (matches == NULL) {
+    printf("Error: Failed to allocate memory for id index range\n");
+    return;
+  }
+
+  int count = 0;
+  long long range = (long long)end_id - start_id + 1;
+  if (range <= impl->live_ids) {
+    // Short range: probe every id in order
+    for (long long id = start_id; id <= end_id; id++) {
+      IdSlot *slot = get_live_slot(impl, (int)id);
+      if (slot != NULL) {
+        matches[count].id = (int)id;
+        matches[count].item = slot->items[0];
+        count++;
+      }
+    }
+  } else {
+    // Long range: scan the table and sort the ids found
+    for (int i = 0; i < impl->capacity; i++) {
+      IdSlot *slot = &impl->slots[i];
+      if (slot->used && slot->count > 0 && slot->id >= start_id &&
+          slot->id <= end_id) {
+        matches[count].id = slot->id;
+        matches[count].item = slot->items[0];
+        count++;
+      }
+    }
+    qsort(matches, count, sizeof(IdMatch), compare_match_id);
+  }
+
+  for (int i = 0; i < count; i++) {
+    visit(matches[i].id, matches[i].item, user_data);
+  }
+  free(matches);
+}
+
+int id_index_size(IdIndex index) {
+  if (index == NULL) {
+    return 0;
+  }
+
+  IdIndexImpl *impl = (IdIndexImpl *)index;
+  return impl->size;
+}
+
+int id_index_get_capacity(IdIndex index) {
+  if (index == NULL) {
+    return 0;
+  }
+  return ((IdIndexImpl *)index)->capacity;
+}
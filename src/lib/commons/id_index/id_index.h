@@ -0,0 +1,96 @@
+/**
+ * @file id_index.h
+ * @brief Integer id index ADT
+ *
+ * This module maps integer ids to items using an open-addressing hash table.
+ * Several items may share an id; they are kept in insertion order and lookups
+ * return the earliest one still present. Range visits only touch the ids that
+ * actually exist in the range.
+ */
+
+#ifndef ID_INDEX_H
+#define ID_INDEX_H
+
+#include <stdbool.h>
+
+/**
+ * @brief Opaque pointer type for id index instances
+ */
+typedef void *IdIndex;
+
+/**
+ * Callback function type for visiting indexed items.
+ * @param id Id of the item
+ * @param item Stored item
+ * @param user_data User-provided context
+ */
+typedef void (*IdIndexVisitFunc)(int id, void *item, void *user_data);
+
+/**
+ * @brief Creates a new empty id index
+ * @return Pointer to new id index or NULL on error
+ */
+IdIndex id_index_create(void);
+
+/**
+ * @brief Destroys an id index and frees all memory (items are not freed)
+ * @param index Id index instance to destroy
+ */
+void id_index_destroy(IdIndex index);
+
+/**
+ * @brief Adds an item under an id (after any items already using that id)
+ * @param index Id index instance
+ * @param id Item id
+ * @param item Item to add
+ * @return true if successful, false otherwise
+ */
+bool id_index_insert(IdIndex index, int id, void *item);
+
+/**
+ * @brief Removes an item from an id
+ * @param index Id index instance
+ * @param id Item id
+ * @param item Item to remove
+ * @return true if the item was found and removed, false otherwise
+ */
+bool id_index_remove(IdIndex index, int id, void *item);
+
+/**
+ * @brief Gets the earliest inserted item with an id
+ * @param index Id index instance
+ * @param id Id to look up
+ * @return Item or NULL if no item uses the id
+ */
+void *id_index_get(IdIndex index, int id);
+
+/**
+ * @brief Visits, in ascending id order, the earliest inserted item of every
+ * id in [start_id, end_id]
+ * @param index Id index instance
+ * @param start_id First id of the range (inclusive)
+ * @param end_id Last id of the range (inclusive)
+ * @param visit Callback called once per existing id
+ * @param user_data User-provided context passed to the callback
+ *
+ * Matches are collected before the first callback, so the callback may modify
+ * the index.
+ */
+void id_index_foreach_in_range(IdIndex index, int start_id, int end_id,
+                               IdIndexVisitFunc visit, void *user_data);
+
+/**
+ * @brief Gets the number of items in the index
+ * @param index Id index instance
+ * @return Number of items
+ */
+int id_index_size(IdIndex index);
+
+/**
+ * @brief Gets the number of slots in the index's hash table
+ * @param index Id index instance
+ * @return Slot count (0 for NULL)
+ */
+int id_index_get_capacity(IdIndex index);
+
+#endif // ID_INDEX_H
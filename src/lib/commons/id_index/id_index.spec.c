@@ -0,0 +1,272 @@
+/**
+ * @file id_index.spec.c
+ * @brief Unit tests for id index module
+ *
+ * Unit tests for the id index ADT functions defined in id_index.h
+ */
+
+#include "./id_index.h"
+#include "../../test_framework/test_framework.h"
+
+#include <stdlib.h>
+
+#define MANY_COUNT 1000
+#define CHURN_LIVE 10
+#define CHURN_ROUNDS 200000
+
+// ============================================================================
+// Test Helpers
+// ============================================================================
+
+// Records visited ids and items in visit order
+typedef struct {
+  int ids[MANY_COUNT];
+  void *items[MANY_COUNT];
+  int count;
+} Visited;
+
+static void record_visit(int id, void *item, void *user_data) {
+  Visited *visited = (Visited *)user_data;
+  if (visited->count < MANY_COUNT) {
+    visited->ids[visited->count] = id;
+    visited->items[visited->count] = item;
+  }
+  visited->count++;
+}
+
+// ============================================================================
+// Tests for id_index_create()
+// ============================================================================
+
+/**
+ * Test: id_index_create should return an empty index
+ */
+bool test_id_index_create_basic(void) {
+  IdIndex index = id_index_create();
+
+  ASSERT_NOT_NULL(index);
+  ASSERT_EQUAL(id_index_size(index), 0);
+  ASSERT_NULL(id_index_get(index, 1));
+
+  id_index_destroy(index);
+  return true;
+}
+
+// ============================================================================
+// Tests for id_index_insert() / id_index_get()
+// ============================================================================
+
+/**
+ * Test: inserted items should be found by id
+ */
+bool test_id_index_insert_and_get(void) {
+  IdIndex index = id_index_create();
+  int a = 1, b = 2, c = 3;
+
+  ASSERT_TRUE(id_index_insert(index, 10, &a));
+  ASSERT_TRUE(id_index_insert(index, -4, &b));
+  ASSERT_TRUE(id_index_insert(index, 0, &c));
+
+  ASSERT_EQUAL(id_index_get(index, 10), &a);
+  ASSERT_EQUAL(id_index_get(index, -4), &b);
+  ASSERT_EQUAL(id_index_get(index, 0), &c);
+  ASSERT_NULL(id_index_get(index, 11));
+  ASSERT_EQUAL(id_index_size(index), 3);
+
+  id_index_destroy(index);
+  return true;
+}
+
+/**
+ * Test: with duplicate ids the earliest remaining item should win
+ */
+bool test_id_index_duplicate_ids(void) {
+  IdIndex index = id_index_create();
+  int a = 1, b = 2, c = 3;
+
+  ASSERT_TRUE(id_index_insert(index, 7, &a));
+  ASSERT_TRUE(id_index_insert(index, 7, &b));
+  ASSERT_TRUE(id_index_insert(index, 7, &c));
+  ASSERT_EQUAL(id_index_get(index, 7), &a);
+
+  ASSERT_TRUE(id_index_remove(index, 7, &a));
+  ASSERT_EQUAL(id_index_get(index, 7), &b);
+
+  ASSERT_TRUE(id_index_remove(index, 7, &c));
+  ASSERT_EQUAL(id_index_get(index, 7), &b);
+  ASSERT_EQUAL(id_index_size(index), 1);
+
+  id_index_destroy(index);
+  return true;
+}
+
+// ============================================================================
+// Tests for id_index_remove()
+// ============================================================================
+
+/**
+ * Test: removing should only succeed for present items
+ */
+bool test_id_index_remove(void) {
+  IdIndex index = id_index_create();
+  int a = 1, b = 2;
+
+  ASSERT_TRUE(id_index_insert(index, 5, &a));
+  ASSERT_FALSE(id_index_remove(index, 5, &b));
+  ASSERT_FALSE(id_index_remove(index, 6, &a));
+  ASSERT_TRUE(id_index_remove(index, 5, &a));
+  ASSERT_FALSE(id_index_remove(index, 5, &a));
+  ASSERT_NULL(id_index_get(index, 5));
+  ASSERT_EQUAL(id_index_size(index), 0);
+
+  // The id can be reused after removal
+  ASSERT_TRUE(id_index_insert(index, 5, &b));
+  ASSERT_EQUAL(id_index_get(index, 5), &b);
+
+  id_index_destroy(index);
+  return true;
+}
+
+/**
+ * Test: the table should grow and keep every item reachable
+ */
+bool test_id_index_many_items(void) {
+  IdIndex index = id_index_create();
+  int values[MANY_COUNT];
+
+  for (int i = 0; i < MANY_COUNT; i++) {
+    values[i] = i;
+    ASSERT_TRUE(id_index_insert(index, i * 3, &values[i]));
+  }
+  for (int i = 0; i < MANY_COUNT; i += 2) {
+    ASSERT_TRUE(id_index_remove(index, i * 3, &values[i]));
+  }
+
+  ASSERT_EQUAL(id_index_size(index), MANY_COUNT / 2);
+  for (int i = 0; i < MANY_COUNT; i++) {
+    if (i % 2 == 0) {
+      ASSERT_NULL(id_index_get(index, i * 3));
+    } else {
+      ASSERT_EQUAL(id_index_get(index, i * 3), &values[i]);
+    }
+  }
+
+  id_index_destroy(index);
+  return true;
+}
+
+/**
+ * Test: ids that keep coming and going should not grow the table past what
+ * the live ones need
+ */
+bool test_id_index_churn_stays_bounded(void) {
+  IdIndex index = id_index_create();
+  int values[CHURN_LIVE];
+
+  for (int i = 0; i < CHURN_LIVE; i++) {
+    values[i] = i;
+    ASSERT_TRUE(id_index_insert(index, i, &values[i]));
+  }
+  for (int id = CHURN_LIVE; id < CHURN_ROUNDS + CHURN_LIVE; id++) {
+    int *value = &values[id % CHURN_LIVE];
+    ASSERT_TRUE(id_index_remove(index, id - CHURN_LIVE, value));
+    ASSERT_TRUE(id_index_insert(index, id, value));
+  }
+
+  ASSERT_EQUAL(id_index_size(index), CHURN_LIVE);
+  ASSERT_TRUE(id_index_get_capacity(index) <= 64);
+  int last = CHURN_ROUNDS + CHURN_LIVE - 1;
+  ASSERT_EQUAL(id_index_get(index, last), &values[last % CHURN_LIVE]);
+  ASSERT_NULL(id_index_get(index, CHURN_ROUNDS - 1));
+
+  id_index_destroy(index);
+  return true;
+}
+
+// ============================================================================
+// Tests for id_index_foreach_in_range()
+// ============================================================================
+
+/**
+ * Test: short ranges should visit existing ids in ascending order
+ */
+bool test_id_index_range_short(void) {
+  IdIndex index = id_index_create();
+  int values[MANY_COUNT];
+
+  for (int i = MANY_COUNT - 1; i >= 0; i--) {
+    values[i] = i;
+    ASSERT_TRUE(id_index_insert(index, i * 2, &values[i]));
+  }
+
+  Visited visited = {{0}, {NULL}, 0};
+  id_index_foreach_in_range(index, 9, 15, record_visit, &visited);
+  ASSERT_EQUAL(visited.count, 3);
+  ASSERT_EQUAL(visited.ids[0], 10);
+  ASSERT_EQUAL(visited.ids[1], 12);
+  ASSERT_EQUAL(visited.ids[2], 14);
+  ASSERT_EQUAL(visited.items[0], &values[5]);
+
+  id_index_destroy(index);
+  return true;
+}
+
+/**
+ * Test: huge ranges should only touch existing ids, in ascending order
+ */
+bool test_id_index_range_long(void) {
+  IdIndex index = id_index_create();
+  int a = 1, b = 2, c = 3, d = 4;
+
+  ASSERT_TRUE(id_index_insert(index, 500000, &a));
+  ASSERT_TRUE(id_index_insert(index, -20, &b));
+  ASSERT_TRUE(id_index_insert(index, 3, &c));
+  ASSERT_TRUE(id_index_insert(index, 3, &d));
+
+  Visited visited = {{0}, {NULL}, 0};
+  id_index_foreach_in_range(index, -2147483647 - 1, 2147483647, record_visit,
+                            &visited);
+  ASSERT_EQUAL(visited.count, 3);
+  ASSERT_EQUAL(visited.ids[0], -20);
+  ASSERT_EQUAL(visited.ids[1], 3);
+  ASSERT_EQUAL(visited.ids[2], 500000);
+  ASSERT_EQUAL(visited.items[1], &c);
+
+  visited.count = 0;
+  id_index_foreach_in_range(index, 10, 5, record_visit, &visited);
+  ASSERT_EQUAL(visited.count, 0);
+
+  id_index_destroy(index);
+  return true;
+}
+
+// ============================================================================
+// Main Test Runner
+// ============================================================================
+
+int main(void) {
+  test_framework_init();
+
+  test_print_section("Testing id_index_create()");
+  test_register("test_id_index_create_basic", test_id_index_create_basic);
+
+  test_print_section("Testing id_index_insert() / id_index_get()");
+  test_register("test_id_index_insert_and_get", test_id_index_insert_and_get);
+  test_register("test_id_index_duplicate_ids", test_id_index_duplicate_ids);
+
+  test_print_section("Testing id_index_remove()");
+  test_register("test_id_index_remove", test_id_index_remove);
+  test_register("test_id_index_many_items", test_id_index_many_items);
+  test_register("test_id_index_churn_stays_bounded",
+                test_id_index_churn_stays_bounded);
+
+  test_print_section("Testing id_index_foreach_in_range()");
+  test_register("test_id_index_range_short", test_id_index_range_short);
+  test_register("test_id_index_range_long", test_id_index_range_long);
+
+  int result = test_run_all();
+
+  test_framework_cleanup();
+
+  return result;
+}
@@ -0,0 +1,143 @@
+#include "sequence.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_CAPACITY 8
+
+typedef struct {
+  void **items;
+  int size;
+  int capacity;
+} SequenceImpl;
+
+Sequence sequence_create(void) {
+  SequenceImpl *sequence = malloc(sizeof(SequenceImpl));
+  if (sequence == NULL) {
+    printf("Error: Failed to allocate memory for Sequence\n");
+    return NULL;
+  }
+
+  sequence->items = NULL;
+  sequence->size = 0;
+  sequence->capacity = 0;
+
+  return (Sequence)sequence;
+}
+
+void sequence_destroy(Sequence sequence) {
+  if (sequence == NULL) {
+    return;
+  }
+
+  SequenceImpl *impl = (SequenceImpl *)sequence;
+  free(impl->items);
+  free(impl);
+}
+
+bool sequence_append(Sequence sequence, void *data) {
+  if (sequence == NULL) {
+    return false;
+  }
+
+  SequenceImpl *impl = (SequenceImpl *)sequence;
+
+  if (impl->size == impl->capacity) {
+    int new_capacity =
+        impl->capacity == 0 ? INITIAL_CAPACITY : impl->capacity * 2;
+    void **items = realloc(impl->items, new_capacity * sizeof(void *));
+    if (items == NULL) {
+      printf("Error: Failed to allocate memory for Sequence items\n");
+      return false;
+    }
+    impl->items = items;
+    impl->capacity = new_capacity;
+  }
+
+  impl->items[impl->size++] = data;
+  return true;
+}
+
+bool sequence_remove(Sequence sequence, void *data) {
+  if (sequence == NULL) {
+    return false;
+  }
+
+  SequenceImpl *impl = (SequenceImpl *)sequence;
+
+  for (int i = 0; i < impl->size; i++) {
+    if (impl->items[i] == data) {
+      memmove(&impl->items[i], &impl->items[i + 1],
+              (impl->size - i - 1) * sizeof(void *));
+      impl->size--;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void *sequence_get(Sequence sequence, int index) {
+  if (sequence == NULL) {
+    return NULL;
+  }
+
+  SequenceImpl *impl = (SequenceImpl *)sequence;
+  if (index < 0 || index >= impl->size) {
+    return NULL;
+  }
+
+  return impl->items[index];
+}
+
+void *sequence_get_last(Sequence sequence) {
+  if (sequence == NULL) {
+    return NULL;
+  }
+
+  SequenceImpl *impl = (SequenceImpl *)sequence;
+  if (impl->size == 0) {
+    return NULL;
+  }
+
+  return impl->items[impl->size - 1];
+}
+
+int sequence_size(Sequence sequence) {
+  if (sequence == NULL) {
+    return 0;
+  }
+
+  return ((SequenceImpl *)sequence)->size;
+}
+
+bool sequence_is_empty(Sequence sequence) {
+  return sequence_size(sequence) == 0;
+}
+
+void sequence_clear(Sequence sequence) {
+  if (sequence == NULL) {
+    return;
+  }
+
+  ((SequenceImpl *)sequence)->size = 0;
+}
+
+SequenceCursor sequence_cursor(Sequence sequence) {
+  SequenceCursor cursor = {sequence, 0};
+  return cursor;
+}
+
+bool sequence_cursor_next(SequenceCursor *cursor, void **data) {
+  if (cursor == NULL || cursor->sequence == NULL) {
+    return false;
+  }
+
+  SequenceImpl *impl = (SequenceImpl *)cursor->sequence;
+  if (cursor->index >= impl->size) {
+    return false;
+  }
+
+  *data = impl->items[cursor->index++];
+  return true;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file sequence.h
+ * @brief Sequence ADT implementation
+ *
+ * This module provides an abstract data type for an ordered sequence backed
+ * by a contiguous dynamic array. Indexed access is O(1) and appending is
+ * amortized O(1); removing an element shifts the ones after it. Elements are
+ * opaque pointers (void*) owned by the caller.
+ */
+
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+#include <stdbool.h>
+
+/**
+ * @brief Opaque pointer type for sequence instances
+ */
+typedef void *Sequence;
+
+/**
+ * @brief Forward cursor over a sequence
+ *
+ * Obtained from sequence_cursor() and advanced with sequence_cursor_next().
+ * The sequence must not be modified while a cursor is in use.
+ */
+typedef struct {
+  Sequence sequence; /**< Sequence being traversed */
+  int index;         /**< Index of the next element */
+} SequenceCursor;
+
+/**
+ * @brief Creates a new empty sequence instance
+ * @return Pointer to new sequence or NULL on error
+ */
+Sequence sequence_create(void);
+
+/**
+ * @brief Destroys a sequence instance and frees all memory (elements are not
+ * freed)
+ * @param sequence Sequence instance to destroy
+ */
+void sequence_destroy(Sequence sequence);
+
+/**
+ * @brief Adds an element to the end of the sequence
+ * @param sequence Sequence instance
+ * @param data Pointer to data to append
+ * @return true if successful, false otherwise
+ */
+bool sequence_append(Sequence sequence, void *data);
+
+/**
+ * @brief Removes the first occurrence of an element, keeping the order of the
+ * remaining ones
+ * @param sequence Sequence instance
+ * @param data Pointer to data to remove
+ * @return true if element was found and removed, false otherwise
+ */
+bool sequence_remove(Sequence sequence, void *data);
+
+/**
+ * @brief Gets the element at the specified index
+ * @param sequence Sequence instance
+ * @param index Zero-based index of element to retrieve
+ * @return Pointer to element at index or NULL if index is out of bounds
+ */
+void *sequence_get(Sequence sequence, int index);
+
+/**
+ * @brief Gets the last element in the sequence
+ * @param sequence Sequence instance
+ * @return Pointer to last element or NULL if sequence is empty
+ */
+void *sequence_get_last(Sequence sequence);
+
+/**
+ * @brief Gets the number of elements in the sequence
+ * @param sequence Sequence instance
+ * @return Number of elements
+ */
+int sequence_size(Sequence sequence);
+
+/**
+ * @brief Checks if the sequence is empty
+ * @param sequence Sequence instance
+ * @return true if sequence is empty, false otherwise
+ */
+bool sequence_is_empty(Sequence sequence);
+
+/**
+ * @brief Removes all elements from the sequence (keeps its capacity)
+ * @param sequence Sequence instance
+ */
+void sequence_clear(Sequence sequence);
+
+/**
+ * @brief Creates a cursor positioned before the first element
+ * @param sequence Sequence instance
+ * @return Cursor over the sequence
+ */
+SequenceCursor sequence_cursor(Sequence sequence);
+
+/**
+ * @brief Advances a cursor
+ * @param cursor Cursor to advance
+ * @param data Pointer to store the next element
+ * @return true if an element was read, false at the end of the sequence
+ */
+bool sequence_cursor_next(SequenceCursor *cursor, void **data);
+
+#endif // SEQUENCE_H
@@ -0,0 +1,217 @@
+/**
+ * @file sequence.spec.c
+ * @brief Unit tests for sequence module
+ *
+ * Unit tests for the sequence ADT functions defined in sequence.h
+ */
+
+#include "./sequence.h"
+#include "../../test_framework/test_framework.h"
+
+#include <stdlib.h>
+
+#define MANY_COUNT 1000
+
+// ============================================================================
+// Tests for sequence_create()
+// ============================================================================
+
+/**
+ * Test: sequence_create should return an empty sequence
+ */
+bool test_sequence_create_basic(void) {
+  Sequence sequence = sequence_create();
+
+  ASSERT_NOT_NULL(sequence);
+  ASSERT_TRUE(sequence_is_empty(sequence));
+  ASSERT_EQUAL(sequence_size(sequence), 0);
+  ASSERT_NULL(sequence_get_last(sequence));
+
+  sequence_destroy(sequence);
+  return true;
+}
+
+// ============================================================================
+// Tests for sequence_append() / sequence_get()
+// ============================================================================
+
+/**
+ * Test: appended elements should keep their order
+ */
+bool test_sequence_append_and_get(void) {
+  Sequence sequence = sequence_create();
+  int a = 1, b = 2, c = 3;
+
+  ASSERT_TRUE(sequence_append(sequence, &a));
+  ASSERT_TRUE(sequence_append(sequence, &b));
+  ASSERT_TRUE(sequence_append(sequence, &c));
+
+  ASSERT_EQUAL(sequence_size(sequence), 3);
+  ASSERT_EQUAL(sequence_get(sequence, 0), &a);
+  ASSERT_EQUAL(sequence_get(sequence, 1), &b);
+  ASSERT_EQUAL(sequence_get(sequence, 2), &c);
+  ASSERT_EQUAL(sequence_get_last(sequence), &c);
+
+  sequence_destroy(sequence);
+  return true;
+}
+
+/**
+ * Test: sequence_get should return NULL out of bounds
+ */
+bool test_sequence_get_out_of_bounds(void) {
+  Sequence sequence = sequence_create();
+  int a = 1;
+
+  sequence_append(sequence, &a);
+  ASSERT_NULL(sequence_get(sequence, -1));
+  ASSERT_NULL(sequence_get(sequence, 1));
+
+  sequence_destroy(sequence);
+  return true;
+}
+
+/**
+ * Test: the sequence should grow past its initial capacity
+ */
+bool test_sequence_append_many(void) {
+  Sequence sequence = sequence_create();
+  int values[MANY_COUNT];
+
+  for (int i = 0; i < MANY_COUNT; i++) {
+    values[i] = i;
+    ASSERT_TRUE(sequence_append(sequence, &values[i]));
+  }
+
+  ASSERT_EQUAL(sequence_size(sequence), MANY_COUNT);
+  for (int i = 0; i < MANY_COUNT; i++) {
+    ASSERT_EQUAL(sequence_get(sequence, i), &values[i]);
+  }
+
+  sequence_destroy(sequence);
+  return true;
+}
+
+// ============================================================================
+// Tests for sequence_remove() / sequence_clear()
+// ============================================================================
+
+/**
+ * Test: removing should keep the order of the remaining elements
+ */
+bool test_sequence_remove_keeps_order(void) {
+  Sequence sequence = sequence_create();
+  int a = 1, b = 2, c = 3, d = 4;
+
+  sequence_append(sequence, &a);
+  sequence_append(sequence, &b);
+  sequence_append(sequence, &c);
+  sequence_append(sequence, &d);
+
+  ASSERT_TRUE(sequence_remove(sequence, &b));
+  ASSERT_TRUE(sequence_remove(sequence, &d));
+  ASSERT_FALSE(sequence_remove(sequence, &b));
+
+  ASSERT_EQUAL(sequence_size(sequence), 2);
+  ASSERT_EQUAL(sequence_get(sequence, 0), &a);
+  ASSERT_EQUAL(sequence_get(sequence, 1), &c);
+  ASSERT_EQUAL(sequence_get_last(sequence), &c);
+
+  sequence_destroy(sequence);
+  return true;
+}
+
+/**
+ * Test: clearing should empty the sequence and allow reuse
+ */
+bool test_sequence_clear(void) {
+  Sequence sequence = sequence_create();
+  int a = 1, b = 2;
+
+  sequence_append(sequence, &a);
+  sequence_append(sequence, &b);
+  sequence_clear(sequence);
+  ASSERT_TRUE(sequence_is_empty(sequence));
+
+  sequence_append(sequence, &b);
+  ASSERT_EQUAL(sequence_size(sequence), 1);
+  ASSERT_EQUAL(sequence_get(sequence, 0), &b);
+
+  sequence_destroy(sequence);
+  return true;
+}
+
+// ============================================================================
+// Tests for sequence_cursor()
+// ============================================================================
+
+/**
+ * Test: a cursor should visit every element in order
+ */
+bool test_sequence_cursor(void) {
+  Sequence sequence = sequence_create();
+  int values[5] = {10, 20, 30, 40, 50};
+
+  for (int i = 0; i < 5; i++) {
+    sequence_append(sequence, &values[i]);
+  }
+
+  SequenceCursor cursor = sequence_cursor(sequence);
+  void *item;
+  int visited = 0;
+  while (sequence_cursor_next(&cursor, &item)) {
+    ASSERT_EQUAL(item, &values[visited]);
+    visited++;
+  }
+  ASSERT_EQUAL(visited, 5);
+  ASSERT_FALSE(sequence_cursor_next(&cursor, &item));
+
+  sequence_destroy(sequence);
+  return true;
+}
+
+/**
+ * Test: a cursor over an empty sequence should yield nothing
+ */
+bool test_sequence_cursor_empty(void) {
+  Sequence sequence = sequence_create();
+
+  SequenceCursor cursor = sequence_cursor(sequence);
+  void *item;
+  ASSERT_FALSE(sequence_cursor_next(&cursor, &item));
+
+  sequence_destroy(sequence);
+  return true;
+}
+
+// ============================================================================
+// Main Test Runner
+// ============================================================================
+
+int main(void) {
+  test_framework_init();
+
+  test_print_section("Testing sequence_create()");
+  test_register("test_sequence_create_basic", test_sequence_create_basic);
+
+  test_print_section("Testing sequence_append() / sequence_get()");
+  test_register("test_sequence_append_and_get", test_sequence_append_and_get);
+  test_register("test_sequence_get_out_of_bounds",
+                test_sequence_get_out_of_bounds);
+  test_register("test_sequence_append_many", test_sequence_append_many);
+
+  test_print_section("Testing sequence_remove() / sequence_clear()");
+  test_register("test_sequence_remove_keeps_order",
+                test_sequence_remove_keeps_order);
+  test_register("test_sequence_clear", test_sequence_clear);
+
+  test_print_section("Testing sequence_cursor()");
+  test_register("test_sequence_cursor", test_sequence_cursor);
+  test_register("test_sequence_cursor_empty", test_sequence_cursor_empty);
+
+  int result = test_run_all();
+
+  test_framework_cleanup();
+
+  return result;
+}
@@ -2,13 +2,19 @@
  * @file sorting.c
  * @brief Implementation of sorting algorithms
  *
- * Implements MergeSort with InsertionSort optimization for small subarrays.
+ * Implements MergeSort with InsertionSort optimization for small subarrays,
+ * and LSD radix sort on 64-bit keys.
  */
 
 #include "sorting.h"
 #include <stdlib.h>
 #include <string.h>
 
+// Key bits sorted per radix pass
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES (64 / RADIX_BITS)
+
 /**
  * Swaps two elements in memory
  */
@@ -30,17 +36,12 @@ static void *get_element(void *base, size_t index, size_t size) {
   return (unsigned char *)base + (index * size);
 }
 
-void sorting_insertionsort(void *base, size_t nmemb, size_t size,
-                           SortCompareFunc compar) {
-  if (nmemb <= 1) {
-    return;
-  }
-
+/**
+ * InsertionSort holding the element being placed in key (size bytes)
+ */
+static void insertionsort_with_key(void *base, size_t nmemb, size_t size,
+                                   SortCompareFunc compar, void *key) {
   unsigned char *arr = (unsigned char *)base;
-  unsigned char *key = malloc(size);
-  if (!key) {
-    return;
-  }
 
   for (size_t i = 1; i < nmemb; i++) {
     memcpy(key, arr + i * size, size);
@@ -53,6 +54,20 @@ void sorting_insertionsort(void *base, size_t nmemb, size_t size,
 
     memcpy(arr + j * size, key, size);
   }
+}
+
+void sorting_insertionsort(void *base, size_t nmemb, size_t size,
+                           SortCompareFunc compar) {
+  if (nmemb <= 1) {
+    return;
+  }
+
+  void *key = malloc(size);
+  if (!key) {
+    return;
+  }
+
+  insertionsort_with_key(base, nmemb, size, compar, key);
 
   free(key);
 }
@@ -106,11 +121,12 @@ static void merge(void *base, size_t left, size_t mid, size_t right,
 }
 
 /**
- * Recursive MergeSort with InsertionSort optimization
+ * Recursive MergeSort with InsertionSort optimization. temp holds the merge
+ * buffer followed by the InsertionSort key.
  */
 static void mergesort_recursive(void *base, size_t left, size_t right,
                                 size_t size, SortCompareFunc compar,
-                                int threshold, void *temp) {
+                                int threshold, void *temp, void *key) {
   if (left >= right) {
     return;
   }
@@ -119,58 +135,181 @@ static void mergesort_recursive(void *base, size_t left, size_t right,
 
   // Use InsertionSort for small subarrays
   if (subarray_size <= (size_t)threshold) {
-    sorting_insertionsort(get_element(base, left, size), subarray_size, size,
-                          compar);
+    insertionsort_with_key(get_element(base, left, size), subarray_size, size,
+                           compar, key);
     return;
   }
 
   size_t mid = left + (right - left) / 2;
 
-  mergesort_recursive(base, left, mid, size, compar, threshold, temp);
-  mergesort_recursive(base, mid + 1, right, size, compar, threshold, temp);
+  mergesort_recursive(base, left, mid, size, compar, threshold, temp, key);
+  mergesort_recursive(base, mid + 1, right, size, compar, threshold, temp, key);
 
   merge(base, left, mid, right, size, compar, temp);
 }
 
+/**
+ * MergeSort over a caller-provided buffer of SORTING_BUFFER_SIZE bytes
+ */
+static void mergesort_with_buffer(void *base, size_t nmemb, size_t size,
+                                  SortCompareFunc compar, int threshold,
+                                  void *buffer) {
+  if (threshold <= 0) {
+    threshold = 10; // Default threshold
+  }
+
+  unsigned char *temp = (unsigned char *)buffer;
+  mergesort_recursive(base, 0, nmemb - 1, size, compar, threshold, temp,
+                      temp + nmemb * size);
+}
+
 void sorting_mergesort(void *base, size_t nmemb, size_t size,
                        SortCompareFunc compar, int threshold) {
   if (nmemb <= 1) {
     return;
   }
 
-  if (threshold <= 0) {
-    threshold = 10; // Default threshold
-  }
-
   // Allocate temporary buffer for merging
-  void *temp = malloc(nmemb * size);
-  if (!temp) {
+  void *buffer = malloc(SORTING_BUFFER_SIZE(nmemb, size));
+  if (!buffer) {
     return;
   }
 
-  mergesort_recursive(base, 0, nmemb - 1, size, compar, threshold, temp);
+  mergesort_with_buffer(base, nmemb, size, compar, threshold, buffer);
 
-  free(temp);
+  free(buffer);
 }
 
-void sorting_sort(void *base, size_t nmemb, size_t size, SortCompareFunc compar,
-                  SortType sort_type, int threshold) {
+/**
+ * Gets the radix digit of a key for the pass sorting bits shift and up
+ */
+static size_t radix_digit(uint64_t key, int shift) {
+  return (size_t)(key >> shift) & (RADIX_BUCKETS - 1);
+}
+
+/**
+ * Radix sort over a caller-provided buffer of SORTING_RADIX_BUFFER_SIZE bytes.
+ * The buffer holds two key arrays, two index arrays, the permuted elements
+ * and the InsertionSort key, in that order.
+ */
+static void radixsort_with_buffer(void *base, size_t nmemb, size_t size,
+                                  SortKeyFunc key, SortCompareFunc compar,
+                                  void *buffer) {
+  unsigned char *arr = (unsigned char *)base;
+  uint64_t *keys = (uint64_t *)buffer;
+  uint64_t *keys_out = keys + nmemb;
+  size_t *order = (size_t *)(keys_out + nmemb);
+  size_t *order_out = order + nmemb;
+  unsigned char *elements = (unsigned char *)(order_out + nmemb);
+
+  // Histograms of every pass, built in a single read of the keys
+  size_t counts[RADIX_PASSES][RADIX_BUCKETS];
+  memset(counts, 0, sizeof(counts));
+  for (size_t i = 0; i < nmemb; i++) {
+    keys[i] = key(arr + i * size);
+    order[i] = i;
+    for (int pass = 0; pass < RADIX_PASSES; pass++) {
+      counts[pass][radix_digit(keys[i], pass * RADIX_BITS)]++;
+    }
+  }
+
+  for (int pass = 0; pass < RADIX_PASSES; pass++) {
+    size_t *count = counts[pass];
+    int shift = pass * RADIX_BITS;
+
+    // Skip bytes every key shares, such as the exponent of close doubles
+    if (count[radix_digit(keys[0], shift)] == nmemb) {
+      continue;
+    }
+
+    size_t offset = 0;
+    for (int bucket = 0; bucket < RADIX_BUCKETS; bucket++) {
+      size_t bucket_count = count[bucket];
+      count[bucket] = offset;
+      offset += bucket_count;
+    }
+
+    for (size_t i = 0; i < nmemb; i++) {
+      size_t slot = count[radix_digit(keys[i], shift)]++;
+      keys_out[slot] = keys[i];
+      order_out[slot] = order[i];
+    }
+
+    uint64_t *keys_tmp = keys;
+    keys = keys_out;
+    keys_out = keys_tmp;
+    size_t *order_tmp = order;
+    order = order_out;
+    order_out = order_tmp;
+  }
+
+  // Move every element once to its sorted place
+  for (size_t i = 0; i < nmemb; i++) {
+    memcpy(elements + i * size, arr + order[i] * size, size);
+  }
+  memcpy(arr, elements, nmemb * size);
+
+  if (compar != NULL) {
+    insertionsort_with_key(arr, nmemb, size, compar, elements + nmemb * size);
+  }
+}
+
+void sorting_radixsort(void *base, size_t nmemb, size_t size, SortKeyFunc key,
+                       SortCompareFunc compar, void *buffer) {
   if (nmemb <= 1) {
     return;
   }
 
-  switch (sort_type) {
-  case SORT_QSORT:
-    qsort(base, nmemb, size, compar);
-    break;
+  if (buffer != NULL) {
+    radixsort_with_buffer(base, nmemb, size, key, compar, buffer);
+    return;
+  }
+
+  buffer = malloc(SORTING_RADIX_BUFFER_SIZE(nmemb, size));
+  if (!buffer) {
+    return;
+  }
+
+  radixsort_with_buffer(base, nmemb, size, key, compar, buffer);
+
+  free(buffer);
+}
+
+uint64_t sorting_double_key(double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
 
-  case SORT_MERGESORT:
-    sorting_mergesort(base, nmemb, size, compar, threshold);
-    break;
+  // Setting the sign bit puts positives above negatives, and flipping every
+  // bit of a negative reverses its magnitude order
+  const uint64_t sign = (uint64_t)1 << 63;
+  return (bits & sign) ? ~bits : bits | sign;
+}
+
+bool sorting_sort(void *base, size_t nmemb, size_t size, SortCompareFunc compar,
+                  SortType sort_type, int threshold) {
+  return sorting_sort_with_buffer(base, nmemb, size, compar, sort_type,
+                                  threshold, NULL);
+}
+
+bool sorting_sort_with_buffer(void *base, size_t nmemb, size_t size,
+                              SortCompareFunc compar, SortType sort_type,
+                              int threshold, void *buffer) {
+  // Radix sort needs keys (see sorting_radixsort())
+  if (sort_type != SORT_QSORT && sort_type != SORT_MERGESORT) {
+    return false;
+  }
+  if (nmemb <= 1) {
+    return true;
+  }
 
-  default:
-    // Fallback to qsort
+  if (sort_type == SORT_MERGESORT) {
+    if (buffer != NULL) {
+      mergesort_with_buffer(base, nmemb, size, compar, threshold, buffer);
+    } else {
+      sorting_mergesort(base, nmemb, size, compar, threshold);
+    }
+  } else {
     qsort(base, nmemb, size, compar);
-    break;
   }
+  return true;
 }
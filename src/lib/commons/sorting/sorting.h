@@ -3,14 +3,17 @@
  * @brief Sorting algorithms module
  *
  * This module provides sorting algorithms including MergeSort with
- * InsertionSort optimization for small subarrays, and a unified interface
- * for selecting between qsort and custom mergesort.
+ * InsertionSort optimization for small subarrays, an LSD radix sort on 64-bit
+ * keys, and a unified interface for selecting between qsort and custom
+ * mergesort.
  */
 
 #ifndef SORTING_H
 #define SORTING_H
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /**
  * @brief Comparison function type (same signature as qsort)
@@ -20,12 +23,34 @@
  */
 typedef int (*SortCompareFunc)(const void *a, const void *b);
 
+/**
+ * @brief Key function type for sorting_radixsort()
+ * @param element Element to get the key of
+ * @return Unsigned key whose order is the order wanted for the elements
+ */
+typedef uint64_t (*SortKeyFunc)(const void *element);
+
+/**
+ * @brief Bytes of scratch sorting_sort_with_buffer() may use for nmemb
+ * elements of the given size
+ */
+#define SORTING_BUFFER_SIZE(nmemb, size) (((nmemb) + 1) * (size))
+
+/**
+ * @brief Bytes of scratch sorting_radixsort() may use for nmemb elements of
+ * the given size
+ */
+#define SORTING_RADIX_BUFFER_SIZE(nmemb, size)                                 \
+  ((nmemb) * (2 * (sizeof(uint64_t) + sizeof(size_t)) + (size)) + (size))
+
 /**
  * @brief Sorting algorithm type
  */
 typedef enum {
-  SORT_QSORT,    /**< Use standard library qsort */
-  SORT_MERGESORT /**< Use custom mergesort with insertionsort optimization */
+  SORT_QSORT,     /**< Use standard library qsort */
+  SORT_MERGESORT, /**< Use custom mergesort with insertionsort optimization */
+  SORT_RADIX      /**< Use sorting_radixsort() where the caller has keys;
+                       sorting_sort() rejects it */
 } SortType;
 
 /**
@@ -56,6 +81,37 @@ void sorting_insertionsort(void *base, size_t nmemb, size_t size,
 void sorting_mergesort(void *base, size_t nmemb, size_t size,
                        SortCompareFunc compar, int threshold);
 
+/**
+ * @brief Sorts an array by 64-bit keys using LSD radix sort
+ *
+ * Sorts (key, index) pairs a byte at a time, skipping bytes every key shares,
+ * then moves each element once. When compar is given, a final InsertionSort
+ * pass puts elements with equal or nearly equal keys in compar order, so the
+ * result matches a comparison sort as long as key(a) < key(b) implies
+ * compar(a, b) <= 0. The pass is linear when such ties are few.
+ *
+ * @param base Pointer to the first element of the array
+ * @param nmemb Number of elements in the array
+ * @param size Size of each element in bytes
+ * @param key Key function
+ * @param compar Comparison function settling ties, or NULL to keep equal keys
+ * in their original order
+ * @param buffer Scratch of SORTING_RADIX_BUFFER_SIZE(nmemb, size) bytes, or
+ * NULL to allocate it internally
+ */
+void sorting_radixsort(void *base, size_t nmemb, size_t size, SortKeyFunc key,
+                       SortCompareFunc compar, void *buffer);
+
+/**
+ * @brief Maps a double to a 64-bit key with the same order
+ *
+ * Negative zero sorts just before zero; NaNs sort at the ends.
+ *
+ * @param value Value to map
+ * @return Key for sorting_radixsort()
+ */
+uint64_t sorting_double_key(double value);
+
 /**
  * @brief Unified sorting interface - selects algorithm based on type
  *
@@ -65,8 +121,28 @@ void sorting_mergesort(void *base, size_t nmemb, size_t size,
  * @param compar Comparison function
  * @param sort_type Type of sorting algorithm to use
  * @param threshold InsertionSort threshold (only used for SORT_MERGESORT)
+ * @return true if the array was sorted, false for SORT_RADIX (which needs a
+ * key, see sorting_radixsort()) or an unknown type, leaving it untouched
  */
-void sorting_sort(void *base, size_t nmemb, size_t size, SortCompareFunc compar,
+bool sorting_sort(void *base, size_t nmemb, size_t size, SortCompareFunc compar,
                   SortType sort_type, int threshold);
 
+/**
+ * @brief Same as sorting_sort(), with the scratch memory supplied by the
+ * caller so that repeated sorts need not allocate
+ *
+ * @param base Pointer to the first element of the array
+ * @param nmemb Number of elements in the array
+ * @param size Size of each element in bytes
+ * @param compar Comparison function
+ * @param sort_type Type of sorting algorithm to use
+ * @param threshold InsertionSort threshold (only used for SORT_MERGESORT)
+ * @param buffer Scratch of SORTING_BUFFER_SIZE(nmemb, size) bytes, or NULL to
+ * allocate it internally
+ * @return Same as sorting_sort()
+ */
+bool sorting_sort_with_buffer(void *base, size_t nmemb, size_t size,
+                              SortCompareFunc compar, SortType sort_type,
+                              int threshold, void *buffer);
+
 #endif // SORTING_H
@@ -22,6 +22,23 @@ static int compare_int_desc(const void *a, const void *b) {
   return (ib > ia) - (ib < ia);
 }
 
+static uint64_t int_key(const void *a) {
+  return (uint64_t)(int64_t)*(const int *)a ^ ((uint64_t)1 << 63);
+}
+
+// Key that only knows the tens digit, leaving the rest to the comparator
+static uint64_t tens_key(const void *a) { return int_key(a) / 10; }
+
+// Pair sorted by value, with a tag to check the order of equal values
+typedef struct {
+  double value;
+  int tag;
+} Pair;
+
+static uint64_t pair_key(const void *a) {
+  return sorting_double_key(((const Pair *)a)->value);
+}
+
 // ============================================================================
 // Tests for InsertionSort
 // ============================================================================
@@ -181,6 +198,91 @@ bool test_sorting_descending(void) {
   return true;
 }
 
+bool test_sorting_sort_with_buffer(void) {
+  int arr[100];
+  for (int i = 0; i < 100; i++) {
+    arr[i] = (i * 37) % 100;
+  }
+  char buffer[SORTING_BUFFER_SIZE(100, sizeof(int))];
+  sorting_sort_with_buffer(arr, 100, sizeof(int), compare_int, SORT_MERGESORT,
+                           5, buffer);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQUAL(arr[i], i);
+  }
+  return true;
+}
+
+bool test_sorting_sort_rejects_radix(void) {
+  int arr[] = {3, 1, 2};
+  bool sorted = sorting_sort(arr, 3, sizeof(int), compare_int, SORT_RADIX, 10);
+  ASSERT_FALSE(sorted);
+  // The array is left as it was
+  ASSERT_EQUAL(arr[0], 3);
+  ASSERT_EQUAL(arr[1], 1);
+  ASSERT_EQUAL(arr[2], 2);
+
+  sorted = sorting_sort(arr, 3, sizeof(int), compare_int, SORT_QSORT, 10);
+  ASSERT_TRUE(sorted);
+  ASSERT_EQUAL(arr[0], 1);
+  return true;
+}
+
+// ============================================================================
+// Tests for RadixSort
+// ============================================================================
+
+bool test_radixsort_empty_array(void) {
+  int arr[1] = {7};
+  sorting_radixsort(arr, 0, sizeof(int), int_key, NULL, NULL);
+  ASSERT_EQUAL(arr[0], 7);
+  return true;
+}
+
+bool test_radixsort_negative_and_large(void) {
+  int arr[200];
+  for (int i = 0; i < 200; i++) {
+    arr[i] = ((i * 7919) % 200 - 100) * 1000003;
+  }
+  sorting_radixsort(arr, 200, sizeof(int), int_key, NULL, NULL);
+  for (int i = 0; i < 200; i++) {
+    ASSERT_EQUAL(arr[i], (i - 100) * 1000003);
+  }
+  return true;
+}
+
+bool test_radixsort_stable_without_comparator(void) {
+  Pair arr[6] = {{2.0, 0}, {-1.5, 1}, {2.0, 2}, {0.0, 3}, {-1.5, 4}, {-0.0, 5}};
+  sorting_radixsort(arr, 6, sizeof(Pair), pair_key, NULL, NULL);
+  int tags[6] = {1, 4, 5, 3, 0, 2};
+  for (int i = 0; i < 6; i++) {
+    ASSERT_EQUAL(arr[i].tag, tags[i]);
+  }
+  return true;
+}
+
+bool test_radixsort_comparator_settles_ties(void) {
+  int arr[100];
+  for (int i = 0; i < 100; i++) {
+    arr[i] = (i * 37) % 100;
+  }
+  char buffer[SORTING_RADIX_BUFFER_SIZE(100, sizeof(int))];
+  sorting_radixsort(arr, 100, sizeof(int), tens_key, compare_int, buffer);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQUAL(arr[i], i);
+  }
+  return true;
+}
+
+bool test_sorting_double_key_order(void) {
+  double values[7] = {-1e300, -2.5, -1e-300, -0.0, 0.0, 1e-300, 3.0};
+  for (int i = 0; i + 1 < 7; i++) {
+    uint64_t lower = sorting_double_key(values[i]);
+    uint64_t upper = sorting_double_key(values[i + 1]);
+    ASSERT_TRUE(lower < upper);
+  }
+  return true;
+}
+
 // ============================================================================
 // Main
 // ============================================================================
@@ -206,10 +308,22 @@ int main(void) {
   test_register("mergesort_with_threshold_1", test_mergesort_with_threshold_1);
   test_register("mergesort_with_threshold_5", test_mergesort_with_threshold_5);
 
+  test_print_section("RadixSort Tests");
+  test_register("radixsort_empty_array", test_radixsort_empty_array);
+  test_register("radixsort_negative_and_large",
+                test_radixsort_negative_and_large);
+  test_register("radixsort_stable_without_comparator",
+                test_radixsort_stable_without_comparator);
+  test_register("radixsort_comparator_settles_ties",
+                test_radixsort_comparator_settles_ties);
+  test_register("sorting_double_key_order", test_sorting_double_key_order);
+
   test_print_section("Unified Sort Interface Tests");
   test_register("sorting_sort_qsort", test_sorting_sort_qsort);
   test_register("sorting_sort_mergesort", test_sorting_sort_mergesort);
   test_register("sorting_descending", test_sorting_descending);
+  test_register("sorting_sort_with_buffer", test_sorting_sort_with_buffer);
+  test_register("sorting_sort_rejects_radix", test_sorting_sort_rejects_radix);
 
   int result = test_run_all();
   test_framework_cleanup();
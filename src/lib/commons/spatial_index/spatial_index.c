@@ -0,0 +1,575 @@
+#include "spatial_index.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define INITIAL_CELL_CAPACITY 64
+#define INITIAL_BUCKET_CAPACITY 4
+// Items covering more cells than this are kept outside the grid
+#define MAX_CELLS_PER_ITEM 64
+// Cell coordinates are clamped so huge boxes cannot overflow them
+#define MAX_CELL_COORD 1000000000L
+
+// Internal entry structure (one per stored item)
+typedef struct SpatialEntry {
+  void *item;                // Stored item
+  double min_x, min_y;       // Item bounding box
+  double max_x, max_y;       //
+  long cx0, cy0, cx1, cy1;   // Covered cell range
+  bool large;                // Stored in the large list instead of the grid
+  unsigned long seq;         // Insertion sequence number
+  unsigned long mark;        // Last query that collected this entry
+  struct SpatialEntry *prev; // Previous entry in insertion order
+  struct SpatialEntry *next; // Next entry in insertion order
+} SpatialEntry;
+
+// Grid cell (one hash table slot)
+typedef struct {
+  bool used;               // Slot holds a cell
+  long cx, cy;             // Cell coordinates
+  SpatialEntry **entries;  // Entries overlapping the cell
+  int count;               // Number of entries
+  int capacity;            // Allocated entry slots
+} Cell;
+
+// Internal spatial index structure
+typedef struct {
+  double cell_size;        // Side length of a cell
+  Cell *cells;             // Open-addressing cell table
+  int cell_capacity;       // Table size (power of two)
+  int cell_count;          // Used table slots
+  SpatialEntry **large;    // Entries covering too many cells
+  int large_count;         //
+  int large_capacity;      //
+  SpatialEntry *head;      // First entry in insertion order
+  SpatialEntry *tail;      // Last entry in insertion order
+  int size;                // Number of items
+  unsigned long next_seq;  // Next insertion sequence number
+  unsigned long query_mark; // Current query mark
+  SpatialEntry **results;  // Scratch buffer for query results
+  int results_capacity;    //
+} SpatialIndexImpl;
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+/**
+ * Converts a coordinate to a (clamped) cell coordinate.
+ */
+static long cell_coord(SpatialIndexImpl *impl, double v) {
+  double c = floor(v / impl->cell_size);
+  if (c != c || c < -MAX_CELL_COORD) {
+    return -MAX_CELL_COORD;
+  }
+  if (c > MAX_CELL_COORD) {
+    return MAX_CELL_COORD;
+  }
+  return (long)c;
+}
+
+/**
+ * Hashes a cell coordinate pair.
+ */
+static unsigned long hash_cell(long cx, long cy) {
+  unsigned long h = (unsigned long)cx * 73856093UL;
+  h ^= (unsigned long)cy * 19349663UL;
+  h ^= h >> 16;
+  return h;
+}
+
+/**
+ * Finds the table slot for a cell (either the cell itself or an empty slot).
+ */
+static Cell *find_slot(Cell *cells, int capacity, long cx, long cy) {
+  unsigned long mask = (unsigned long)capacity - 1;
+  unsigned long i = hash_cell(cx, cy) & mask;
+  while (cells[i].used && (cells[i].cx != cx || cells[i].cy != cy)) {
+    i = (i + 1) & mask;
+  }
+  return &cells[i];
+}
+
+/**
+ * Doubles the cell table and rehashes all cells.
+ */
+static bool grow_cells(SpatialIndexImpl *impl) {
+  int new_capacity = impl->cell_capacity * 2;
+  Cell *new_cells = calloc(new_capacity, sizeof(Cell));
+  if (new_cells == NULL) {
+    printf("Error: Failed to allocate memory for spatial index cells\n");
+    return false;
+  }
+
+  for (int i = 0; i < impl->cell_capacity; i++) {
+    if (impl->cells[i].used) {
+      Cell *slot = find_slot(new_cells, new_capacity, impl->cells[i].cx,
+                             impl->cells[i].cy);
+      *slot = impl->cells[i];
+    }
+  }
+
+  free(impl->cells);
+  impl->cells = new_cells;
+  impl->cell_capacity = new_capacity;
+  return true;
+}
+
+/**
+ * Gets the cell for a coordinate pair, creating it when missing.
+ */
+static Cell *get_or_create_cell(SpatialIndexImpl *impl, long cx, long cy) {
+  if ((impl->cell_count + 1) * 10 > impl->cell_capacity * 7) {
+    if (!grow_cells(impl)) {
+      return NULL;
+    }
+  }
+
+  Cell *cell = find_slot(impl->cells, impl->cell_capacity, cx, cy);
+  if (!cell->used) {
+    cell->used = true;
+    cell->cx = cx;
+    cell->cy = cy;
+    cell->entries = NULL;
+    cell->count = 0;
+    cell->capacity = 0;
+    impl->cell_count++;
+  }
+  return cell;
+}
+
+/**
+ * Gets the cell for a coordinate pair, or NULL when it does not exist.
+ */
+static Cell *get_cell(SpatialIndexImpl *impl, long cx, long cy) {
+  Cell *cell = find_slot(impl->cells, impl->cell_capacity, cx, cy);
+  return cell->used ? cell : NULL;
+}
+
+/**
+ * Appends an entry to a growable entry array.
+ */
+static bool push_entry(SpatialEntry ***array, int *count, int *capacity,
+                       SpatialEntry *entry) {
+  if (*count == *capacity) {
+    int new_capacity =
+        *capacity == 0 ? INITIAL_BUCKET_CAPACITY : *capacity * 2;
+    SpatialEntry **grown =
+        realloc(*array, new_capacity * sizeof(SpatialEntry *));
+    if (grown == NULL) {
+      printf("Error: Failed to allocate memory for spatial index entries\n");
+      return false;
+    }
+    *array = grown;
+    *capacity = new_capacity;
+  }
+  (*array)[(*count)++] = entry;
+  return true;
+}
+
+/**
+ * Removes an entry from an entry array, keeping the remaining order.
+ */
+static void drop_entry(SpatialEntry **array, int *count, SpatialEntry *entry) {
+  for (int i = 0; i < *count; i++) {
+    if (array[i] == entry) {
+      for (int j = i + 1; j < *count; j++) {
+        array[j - 1] = array[j];
+      }
+      (*count)--;
+      return;
+    }
+  }
+}
+
+/**
+ * Checks whether a box of cells is too large for the grid and belongs in the
+ * large list.
+ */
+static bool spans_too_many_cells(long cx0, long cy0, long cx1, long cy1) {
+  double span = (double)(cx1 - cx0 + 1) * (double)(cy1 - cy0 + 1);
+  return span > MAX_CELLS_PER_ITEM;
+}
+
+/**
+ * Removes an entry from every cell (or the large list) it was stored in.
+ */
+static void unlink_entry_cells(SpatialIndexImpl *impl, SpatialEntry *entry) {
+  if (entry->large) {
+    drop_entry(impl->large, &impl->large_count, entry);
+    return;
+  }
+  for (long cx = entry->cx0; cx <= entry->cx1; cx++) {
+    for (long cy = entry->cy0; cy <= entry->cy1; cy++) {
+      Cell *cell = get_cell(impl, cx, cy);
+      if (cell != NULL) {
+        drop_entry(cell->entries, &cell->count, entry);
+      }
+    }
+  }
+}
+
+/**
+ * Checks whether an entry bounding box intersects a box.
+ */
+static bool entry_intersects(SpatialEntry *entry, double min_x, double min_y,
+                             double max_x, double max_y) {
+  return entry->min_x <= max_x && entry->max_x >= min_x &&
+         entry->min_y <= max_y && entry->max_y >= min_y;
+}
+
+/**
+ * Collects an entry into the result buffer unless already collected.
+ */
+static bool collect_entry(SpatialIndexImpl *impl, SpatialEntry *entry,
+                          int *count) {
+  if (entry->mark == impl->query_mark) {
+    return true;
+  }
+  entry->mark = impl->query_mark;
+  return push_entry(&impl->results, count, &impl->results_capacity, entry);
+}
+
+/**
+ * Orders entries by insertion sequence.
+ */
+static int compare_entry_seq(const void *a, const void *b) {
+  const SpatialEntry *ea = *(SpatialEntry *const *)a;
+  const SpatialEntry *eb = *(SpatialEntry *const *)b;
+  if (ea->seq < eb->seq) {
+    return -1;
+  }
+  return ea->seq > eb->seq ? 1 : 0;
+}
+
+/**
+ * Squared distance from a point to an entry bounding box.
+ */
+static double entry_distance_sq(SpatialEntry *entry, double x, double y) {
+  double dx = 0.0;
+  double dy = 0.0;
+  if (x < entry->min_x) {
+    dx = entry->min_x - x;
+  } else if (x > entry->max_x) {
+    dx = x - entry->max_x;
+  }
+  if (y < entry->min_y) {
+    dy = entry->min_y - y;
+  } else if (y > entry->max_y) {
+    dy = y - entry->max_y;
+  }
+  return dx * dx + dy * dy;
+}
+
+/**
+ * Collects the entries whose bounding box intersects a box, sorted by
+ * insertion order. Returns the number of collected entries (results are in
+ * impl->results).
+ */
+static int collect_box(SpatialIndexImpl *impl, double min_x, double min_y,
+                       double max_x, double max_y) {
+  int count = 0;
+  long cx0 = cell_coord(impl, min_x);
+  long cy0 = cell_coord(impl, min_y);
+  long cx1 = cell_coord(impl, max_x);
+  long cy1 = cell_coord(impl, max_y);
+
+  // When the box covers more cells than exist, a linear walk is cheaper and
+  // already ordered
+  double span = (double)(cx1 - cx0 + 1) * (double)(cy1 - cy0 + 1);
+  if (span > impl->cell_capacity) {
+    for (SpatialEntry *e = impl->head; e != NULL; e = e->next) {
+      if (entry_intersects(e, min_x, min_y, max_x, max_y)) {
+        if (!push_entry(&impl->results, &count, &impl->results_capacity, e)) {
+          return count;
+        }
+      }
+    }
+    return count;
+  }
+
+  impl->query_mark++;
+  for (long cx = cx0; cx <= cx1; cx++) {
+    for (long cy = cy0; cy <= cy1; cy++) {
+      Cell *cell = get_cell(impl, cx, cy);
+      if (cell == NULL) {
+        continue;
+      }
+      for (int i = 0; i < cell->count; i++) {
+        SpatialEntry *e = cell->entries[i];
+        if (entry_intersects(e, min_x, min_y, max_x, max_y) &&
+            !collect_entry(impl, e, &count)) {
+          return count;
+        }
+      }
+    }
+  }
+  for (int i = 0; i < impl->large_count; i++) {
+    SpatialEntry *e = impl->large[i];
+    if (entry_intersects(e, min_x, min_y, max_x, max_y) &&
+        !collect_entry(impl, e, &count)) {
+      return count;
+    }
+  }
+
+  qsort(impl->results, count, sizeof(SpatialEntry *), compare_entry_seq);
+  return count;
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+SpatialIndex spatial_index_create(double cell_size) {
+  if (!(cell_size > 0.0)) {
+    return NULL;
+  }
+
+  SpatialIndexImpl *impl = malloc(sizeof(SpatialIndexImpl));
+  if (impl == NULL) {
+    printf("Error: Failed to allocate memory for spatial index\n");
+    return NULL;
+  }
+
+  impl->cells = calloc(INITIAL_CELL_CAPACITY, sizeof(Cell));
+  if (impl->cells == NULL) {
+    printf("Error: Failed to allocate memory for spatial index cells\n");
+    free(impl);
+    return NULL;
+  }
+
+  impl->cell_size = cell_size;
+  impl->cell_capacity = INITIAL_CELL_CAPACITY;
+  impl->cell_count = 0;
+  impl->large = NULL;
+  impl->large_count = 0;
+  impl->large_capacity = 0;
+  impl->head = NULL;
+  impl->tail = NULL;
+  impl->size = 0;
+  impl->next_seq = 0;
+  impl->query_mark = 0;
+  impl->results = NULL;
+  impl->results_capacity = 0;
+
+  return impl;
+}
+
+void spatial_index_destroy(SpatialIndex index) {
+  if (index == NULL) {
+    return;
+  }
+
+  SpatialIndexImpl *impl = (SpatialIndexImpl *)index;
+
+  for (int i = 0; i < impl->cell_capacity; i++) {
+    if (impl->cells[i].used) {
+      free(impl->cells[i].entries);
+    }
+  }
+  free(impl->cells);
+
+  SpatialEntry *entry = impl->head;
+  while (entry != NULL) {
+    SpatialEntry *next = entry->next;
+    free(entry);
+    entry = next;
+  }
+
+  free(impl->large);
+  free(impl->results);
+  free(impl);
+}
+
+bool spatial_index_insert(SpatialIndex index, void *item, double min_x,
+                          double min_y, double max_x, double max_y) {
+  if (index == NULL) {
+    return false;
+  }
+
+  SpatialIndexImpl *impl = (SpatialIndexImpl *)index;
+
+  SpatialEntry *entry = malloc(sizeof(SpatialEntry));
+  if (entry == NULL) {
+    printf("Error: Failed to allocate memory for spatial index entry\n");
+    return false;
+  }
+
+  entry->item = item;
+  entry->min_x = min_x;
+  entry->min_y = min_y;
+  entry->max_x = max_x;
+  entry->max_y = max_y;
+  entry->cx0 = cell_coord(impl, min_x);
+  entry->cy0 = cell_coord(impl, min_y);
+  entry->cx1 = cell_coord(impl, max_x);
+  entry->cy1 = cell_coord(impl, max_y);
+  entry->seq = impl->next_seq++;
+  entry->mark = 0;
+
+  entry->large =
+      spans_too_many_cells(entry->cx0, entry->cy0, entry->cx1, entry->cy1);
+
+  bool ok = true;
+  if (entry->large) {
+    ok = push_entry(&impl->large, &impl->large_count, &impl->large_capacity,
+                    entry);
+  } else {
+    for (long cx = entry->cx0; ok && cx <= entry->cx1; cx++) {
+      for (long cy = entry->cy0; ok && cy <= entry->cy1; cy++) {
+        Cell *cell = get_or_create_cell(impl, cx, cy);
+        ok = cell != NULL && push_entry(&cell->entries, &cell->count,
+                                        &cell->capacity, entry);
+      }
+    }
+  }
+
+  if (!ok) {
+    unlink_entry_cells(impl, entry);
+    free(entry);
+    return false;
+  }
+
+  entry->prev = impl->tail;
+  entry->next = NULL;
+  if (impl->tail != NULL) {
+    impl->tail->next = entry;
+  } else {
+    impl->head = entry;
+  }
+  impl->tail = entry;
+  impl->size++;
+
+  return true;
+}
+
+bool spatial_index_remove(SpatialIndex index, void *item, double min_x,
+                          double min_y, double max_x, double max_y) {
+  if (index == NULL) {
+    return false;
+  }
+
+  SpatialIndexImpl *impl = (SpatialIndexImpl *)index;
+
+  // The box tells where the entry was stored: the large list, or every cell
+  // of the box, whose first cell is enough to find it
+  long cx0 = cell_coord(impl, min_x);
+  long cy0 = cell_coord(impl, min_y);
+  bool large =
+      spans_too_many_cells(cx0, cy0, cell_coord(impl, max_x),
+                           cell_coord(impl, max_y));
+  SpatialEntry *entry = NULL;
+  if (large) {
+    for (int i = 0; i < impl->large_count && entry == NULL; i++) {
+      if (impl->large[i]->item == item) {
+        entry = impl->large[i];
+      }
+    }
+  } else {
+    Cell *cell = get_cell(impl, cx0, cy0);
+    for (int i = 0; cell != NULL && i < cell->count && entry == NULL; i++) {
+      if (cell->entries[i]->item == item) {
+        entry = cell->entries[i];
+      }
+    }
+  }
+
+  if (entry == NULL) {
+    return false;
+  }
+
+  unlink_entry_cells(impl, entry);
+
+  if (entry->prev != NULL) {
+    entry->prev->next = entry->next;
+  } else {
+    impl->head = entry->next;
+  }
+  if (entry->next != NULL) {
+    entry->next->prev = entry->prev;
+  } else {
+    impl->tail = entry->prev;
+  }
+
+  free(entry);
+  impl->size--;
+  return true;
+}
+
+void spatial_index_query_box(SpatialIndex index, double min_x, double min_y,
+                             double max_x, double max_y,
+                             SpatialIndexVisitFunc visit, void *user_data) {
+  if (index == NULL || visit == NULL) {
+    return;
+  }
+
+  SpatialIndexImpl *impl = (SpatialIndexImpl *)index;
+  int count = collect_box(impl, min_x, min_y, max_x, max_y);
+
+  // Copy out so callbacks may query the index again
+  SpatialEntry **found = malloc((count > 0 ? count : 1) * sizeof(void *));
+  if (found == NULL) {
+    printf("Error: Failed to allocate memory for spatial index query\n");
+    return;
+  }
+  for (int i = 0; i < count; i++) {
+    found[i] = impl->results[i];
+  }
+  for (int i = 0; i < count; i++) {
+    visit(found[i]->item, user_data);
+  }
+  free(found);
+}
+
+void spatial_index_query_radius(SpatialIndex index, double x, double y,
+                                double radius, SpatialIndexVisitFunc visit,
+                                void *user_data) {
+  if (index == NULL || visit == NULL || radius < 0.0) {
+    return;
+  }
+
+  SpatialIndexImpl *impl = (SpatialIndexImpl *)index;
+  int count = collect_box(impl, x - radius, y - radius, x + radius,
+                          y + radius);
+
+  SpatialEntry **found = malloc((count > 0 ? count : 1) * sizeof(void *));
+  if (found == NULL) {
+    printf("Error: Failed to allocate memory for spatial index query\n");
+    return;
+  }
+  int kept = 0;
+  double radius_sq = radius * radius;
+  for (int i = 0; i < count; i++) {
+    if (entry_distance_sq(impl->results[i], x, y) <= radius_sq) {
+      found[kept++] = impl->results[i];
+    }
+  }
+  for (int i = 0; i < kept; i++) {
+    visit(found[i]->item, user_data);
+  }
+  free(found);
+}
+
+void spatial_index_foreach(SpatialIndex index, SpatialIndexVisitFunc visit,
+                           void *user_data) {
+  if (index == NULL || visit == NULL) {
+    return;
+  }
+
+  SpatialIndexImpl *impl = (SpatialIndexImpl *)index;
+  SpatialEntry *entry = impl->head;
+  while (entry != NULL) {
+    SpatialEntry *next = entry->next;
+    visit(entry->item, user_data);
+    entry = next;
+  }
+}
+
+int spatial_index_size(SpatialIndex index) {
+  if (index == NULL) {
+    return 0;
+  }
+
+  SpatialIndexImpl *impl = (SpatialIndexImpl *)index;
+  return impl->size;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file spatial_index.h
+ * @brief Spatial index ADT for bounding-box and radius queries
+ *
+ * This module provides a uniform grid spatial index. Items are stored with
+ * their axis-aligned bounding box and registered in every grid cell the box
+ * covers; the grid is hashed, so it is unbounded and only occupied cells use
+ * memory. Queries only look at the cells overlapping the query region.
+ * Query results are always visited in insertion order.
+ */
+
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <stdbool.h>
+
+/**
+ * @brief Opaque pointer type for spatial index instances
+ */
+typedef void *SpatialIndex;
+
+/**
+ * Callback function type for visiting query results.
+ * @param item Stored item
+ * @param user_data User-provided context
+ */
+typedef void (*SpatialIndexVisitFunc)(void *item, void *user_data);
+
+/**
+ * @brief Creates a new empty spatial index
+ * @param cell_size Side length of the grid cells (must be positive)
+ * @return Pointer to new spatial index or NULL on error
+ */
+SpatialIndex spatial_index_create(double cell_size);
+
+/**
+ * @brief Destroys a spatial index and frees all memory (items are not freed)
+ * @param index Spatial index instance to destroy
+ */
+void spatial_index_destroy(SpatialIndex index);
+
+/**
+ * @brief Inserts an item with its bounding box
+ * @param index Spatial index instance
+ * @param item Item to insert
+ * @param min_x Minimum X of the item bounding box
+ * @param min_y Minimum Y of the item bounding box
+ * @param max_x Maximum X of the item bounding box
+ * @param max_y Maximum Y of the item bounding box
+ * @return true if successful, false otherwise
+ */
+bool spatial_index_insert(SpatialIndex index, void *item, double min_x,
+                          double min_y, double max_x, double max_y);
+
+/**
+ * @brief Removes an item from the index
+ * @param index Spatial index instance
+ * @param item Item to remove
+ * @param min_x Minimum X of the bounding box used on insertion
+ * @param min_y Minimum Y of the bounding box used on insertion
+ * @param max_x Maximum X of the bounding box used on insertion
+ * @param max_y Maximum Y of the bounding box used on insertion
+ * @return true if the item was found and removed, false otherwise
+ */
+bool spatial_index_remove(SpatialIndex index, void *item, double min_x,
+                          double min_y, double max_x, double max_y);
+
+/**
+ * @brief Visits every item whose bounding box intersects the query box
+ * @param index Spatial index instance
+ * @param min_x Minimum X of the query box
+ * @param min_y Minimum Y of the query box
+ * @param max_x Maximum X of the query box
+ * @param max_y Maximum Y of the query box
+ * @param visit Callback called once per matching item, in insertion order
+ * @param user_data User-provided context passed to the callback
+ */
+void spatial_index_query_box(SpatialIndex index, double min_x, double min_y,
+                             double max_x, double max_y,
+                             SpatialIndexVisitFunc visit, void *user_data);
+
+/**
+ * @brief Visits every item whose bounding box lies within a distance of a
+ * point
+ * @param index Spatial index instance
+ * @param x Query point X coordinate
+ * @param y Query point Y coordinate
+ * @param radius Maximum distance from the point to the item bounding box
+ * @param visit Callback called once per matching item, in insertion order
+ * @param user_data User-provided context passed to the callback
+ */
+void spatial_index_query_radius(SpatialIndex index, double x, double y,
+                                double radius, SpatialIndexVisitFunc visit,
+                                void *user_data);
+
+/**
+ * @brief Visits every item in the index
+ * @param index Spatial index instance
+ * @param visit Callback called once per item, in insertion order
+ * @param user_data User-provided context passed to the callback
+ */
+void spatial_index_foreach(SpatialIndex index, SpatialIndexVisitFunc visit,
+                           void *user_data);
+
+/**
+ * @brief Gets the number of items in the index
+ * @param index Spatial index instance
+ * @return Number of items
+ */
+int spatial_index_size(SpatialIndex index);
+
+#endif // SPATIAL_INDEX_H
@@ -0,0 +1,260 @@
+/**
+ * @file spatial_index.spec.c
+ * @brief Unit tests for spatial index module
+ *
+ * Unit tests for the spatial index ADT functions defined in spatial_index.h
+ */
+
+#include "./spatial_index.h"
+#include "../../test_framework/test_framework.h"
+
+#include <stdlib.h>
+
+#define CELL_SIZE 10.0
+#define MAX_COLLECTED 256
+
+// ============================================================================
+// Test Helpers
+// ============================================================================
+
+// Records visited items in visit order
+typedef struct {
+  int *items[MAX_COLLECTED];
+  int count;
+} Collected;
+
+static void collect(void *item, void *user_data) {
+  Collected *collected = (Collected *)user_data;
+  if (collected->count < MAX_COLLECTED) {
+    collected->items[collected->count] = (int *)item;
+  }
+  collected->count++;
+}
+
+// ============================================================================
+// Tests for spatial_index_create()
+// ============================================================================
+
+/**
+ * Test: spatial_index_create should return an empty index
+ */
+bool test_spatial_index_create_basic(void) {
+  SpatialIndex index = spatial_index_create(CELL_SIZE);
+
+  ASSERT_NOT_NULL(index);
+  ASSERT_EQUAL(spatial_index_size(index), 0);
+
+  spatial_index_destroy(index);
+  return true;
+}
+
+/**
+ * Test: spatial_index_create should reject non-positive cell sizes
+ */
+bool test_spatial_index_create_invalid_cell_size(void) {
+  ASSERT_NULL(spatial_index_create(0.0));
+  ASSERT_NULL(spatial_index_create(-5.0));
+  return true;
+}
+
+// ============================================================================
+// Tests for spatial_index_query_box()
+// ============================================================================
+
+/**
+ * Test: box queries should only report intersecting items
+ */
+bool test_spatial_index_query_box_filters(void) {
+  SpatialIndex index = spatial_index_create(CELL_SIZE);
+  int a = 1, b = 2, c = 3;
+
+  ASSERT_TRUE(spatial_index_insert(index, &a, 0, 0, 5, 5));
+  ASSERT_TRUE(spatial_index_insert(index, &b, 100, 100, 105, 105));
+  ASSERT_TRUE(spatial_index_insert(index, &c, -3, 4, 2, 12));
+  ASSERT_EQUAL(spatial_index_size(index), 3);
+
+  Collected collected = {{NULL}, 0};
+  spatial_index_query_box(index, 1, 1, 3, 3, collect, &collected);
+  ASSERT_EQUAL(collected.count, 1);
+  ASSERT_EQUAL(collected.items[0], &a);
+
+  collected.count = 0;
+  spatial_index_query_box(index, -1, 4, 1, 6, collect, &collected);
+  ASSERT_EQUAL(collected.count, 2);
+
+  collected.count = 0;
+  spatial_index_query_box(index, 50, 50, 60, 60, collect, &collected);
+  ASSERT_EQUAL(collected.count, 0);
+
+  spatial_index_destroy(index);
+  return true;
+}
+
+/**
+ * Test: items spanning many cells are reported once, in insertion order
+ */
+bool test_spatial_index_query_box_insertion_order(void) {
+  SpatialIndex index = spatial_index_create(CELL_SIZE);
+  int values[4] = {0, 1, 2, 3};
+
+  // Mix of small, multi-cell and huge (outside the grid) items
+  ASSERT_TRUE(spatial_index_insert(index, &values[0], 40, 40, 41, 41));
+  ASSERT_TRUE(spatial_index_insert(index, &values[1], -1000, -1000, 1000,
+                                   1000));
+  ASSERT_TRUE(spatial_index_insert(index, &values[2], 0, 0, 45, 45));
+  ASSERT_TRUE(spatial_index_insert(index, &values[3], 42, 42, 43, 43));
+
+  Collected collected = {{NULL}, 0};
+  spatial_index_query_box(index, 35, 35, 50, 50, collect, &collected);
+  ASSERT_EQUAL(collected.count, 4);
+  for (int i = 0; i < 4; i++) {
+    ASSERT_EQUAL(collected.items[i], &values[i]);
+  }
+
+  // A query larger than the grid falls back to a linear walk
+  collected.count = 0;
+  spatial_index_query_box(index, -1e9, -1e9, 1e9, 1e9, collect, &collected);
+  ASSERT_EQUAL(collected.count, 4);
+  for (int i = 0; i < 4; i++) {
+    ASSERT_EQUAL(collected.items[i], &values[i]);
+  }
+
+  spatial_index_destroy(index);
+  return true;
+}
+
+// ============================================================================
+// Tests for spatial_index_query_radius()
+// ============================================================================
+
+/**
+ * Test: radius queries should measure distance to the item bounding box
+ */
+bool test_spatial_index_query_radius(void) {
+  SpatialIndex index = spatial_index_create(CELL_SIZE);
+  int near = 1, corner = 2, far = 3;
+
+  ASSERT_TRUE(spatial_index_insert(index, &near, 5, -1, 6, 1));
+  ASSERT_TRUE(spatial_index_insert(index, &corner, 4, 4, 8, 8));
+  ASSERT_TRUE(spatial_index_insert(index, &far, 30, 30, 31, 31));
+
+  // corner is at distance sqrt(32) ~ 5.66 from the origin
+  Collected collected = {{NULL}, 0};
+  spatial_index_query_radius(index, 0, 0, 5.5, collect, &collected);
+  ASSERT_EQUAL(collected.count, 1);
+  ASSERT_EQUAL(collected.items[0], &near);
+
+  collected.count = 0;
+  spatial_index_query_radius(index, 0, 0, 6, collect, &collected);
+  ASSERT_EQUAL(collected.count, 2);
+  ASSERT_EQUAL(collected.items[0], &near);
+  ASSERT_EQUAL(collected.items[1], &corner);
+
+  spatial_index_destroy(index);
+  return true;
+}
+
+// ============================================================================
+// Tests for spatial_index_remove()
+// ============================================================================
+
+/**
+ * Test: removed items should no longer be reported
+ */
+bool test_spatial_index_remove(void) {
+  SpatialIndex index = spatial_index_create(CELL_SIZE);
+  int a = 1, b = 2, huge = 3;
+
+  ASSERT_TRUE(spatial_index_insert(index, &a, 0, 0, 25, 25));
+  ASSERT_TRUE(spatial_index_insert(index, &b, 10, 10, 12, 12));
+  ASSERT_TRUE(spatial_index_insert(index, &huge, -500, -500, 500, 500));
+
+  ASSERT_TRUE(spatial_index_remove(index, &a, 0, 0, 25, 25));
+  ASSERT_TRUE(spatial_index_remove(index, &huge, -500, -500, 500, 500));
+  ASSERT_FALSE(spatial_index_remove(index, &a, 0, 0, 25, 25));
+  ASSERT_EQUAL(spatial_index_size(index), 1);
+
+  Collected collected = {{NULL}, 0};
+  spatial_index_query_box(index, 0, 0, 30, 30, collect, &collected);
+  ASSERT_EQUAL(collected.count, 1);
+  ASSERT_EQUAL(collected.items[0], &b);
+
+  collected.count = 0;
+  spatial_index_foreach(index, collect, &collected);
+  ASSERT_EQUAL(collected.count, 1);
+  ASSERT_EQUAL(collected.items[0], &b);
+
+  spatial_index_destroy(index);
+  return true;
+}
+
+/**
+ * Test: the index should keep working as the cell table grows
+ */
+bool test_spatial_index_many_items(void) {
+  SpatialIndex index = spatial_index_create(CELL_SIZE);
+  int values[MAX_COLLECTED];
+
+  for (int i = 0; i < MAX_COLLECTED; i++) {
+    values[i] = i;
+    double x = (i % 16) * 25.0;
+    double y = (i / 16) * 25.0;
+    ASSERT_TRUE(spatial_index_insert(index, &values[i], x, y, x + 1, y + 1));
+  }
+  ASSERT_EQUAL(spatial_index_size(index), MAX_COLLECTED);
+
+  for (int i = 0; i < MAX_COLLECTED; i++) {
+    double x = (i % 16) * 25.0;
+    double y = (i / 16) * 25.0;
+    Collected collected = {{NULL}, 0};
+    spatial_index_query_box(index, x, y, x + 0.5, y + 0.5, collect,
+                            &collected);
+    ASSERT_EQUAL(collected.count, 1);
+    ASSERT_EQUAL(collected.items[0], &values[i]);
+  }
+
+  Collected all = {{NULL}, 0};
+  spatial_index_foreach(index, collect, &all);
+  ASSERT_EQUAL(all.count, MAX_COLLECTED);
+  for (int i = 0; i < MAX_COLLECTED; i++) {
+    ASSERT_EQUAL(all.items[i], &values[i]);
+  }
+
+  spatial_index_destroy(index);
+  return true;
+}
+
+// ============================================================================
+// Main Test Runner
+// ============================================================================
+
+int main(void) {
+  test_framework_init();
+
+  test_print_section("Testing spatial_index_create()");
+  test_register("test_spatial_index_create_basic",
+                test_spatial_index_create_basic);
+  test_register("test_spatial_index_create_invalid_cell_size",
+                test_spatial_index_create_invalid_cell_size);
+
+  test_print_section("Testing spatial_index_query_box()");
+  test_register("test_spatial_index_query_box_filters",
+                test_spatial_index_query_box_filters);
+  test_register("test_spatial_index_query_box_insertion_order",
+                test_spatial_index_query_box_insertion_order);
+
+  test_print_section("Testing spatial_index_query_radius()");
+  test_register("test_spatial_index_query_radius",
+                test_spatial_index_query_radius);
+
+  test_print_section("Testing spatial_index_remove()");
+  test_register("test_spatial_index_remove", test_spatial_index_remove);
+  test_register("test_spatial_index_many_items",
+                test_spatial_index_many_items);
+
+  int result = test_run_all();
+
+  test_framework_cleanup();
+
+  return result;
+}
@@ -0,0 +1,175 @@
+#include "thread_pool.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Internal thread pool structure. Every field below the threads is guarded by
+// the mutex.
+typedef struct {
+  pthread_t *threads;        // Worker threads
+  int thread_count;          // Number of started workers
+  pthread_mutex_t mutex;     // Guards the batch state
+  pthread_cond_t work_ready; // Signaled when a batch starts or on shutdown
+  pthread_cond_t work_done;  // Signaled when the last task of a batch ends
+  ThreadPoolTaskFunc task;   // Task of the current batch
+  void *user_data;           // Context of the current batch
+  int task_count;            // Tasks in the current batch
+  int next_task;             // Next task index to hand out
+  int pending;               // Tasks not finished yet
+  bool stopping;             // Workers must exit
+} ThreadPoolImpl;
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+/**
+ * Worker loop: takes task indexes until the pool stops.
+ */
+static void *worker_main(void *arg) {
+  ThreadPoolImpl *impl = (ThreadPoolImpl *)arg;
+
+  pthread_mutex_lock(&impl->mutex);
+  for (;;) {
+    while (!impl->stopping && impl->next_task >= impl->task_count) {
+      pthread_cond_wait(&impl->work_ready, &impl->mutex);
+    }
+    if (impl->stopping) {
+      break;
+    }
+
+    int index = impl->next_task++;
+    ThreadPoolTaskFunc task = impl->task;
+    void *user_data = impl->user_data;
+
+    pthread_mutex_unlock(&impl->mutex);
+    task(index, user_data);
+    pthread_mutex_lock(&impl->mutex);
+
+    impl->pending--;
+    if (impl->pending == 0) {
+      pthread_cond_signal(&impl->work_done);
+    }
+  }
+  pthread_mutex_unlock(&impl->mutex);
+
+  return NULL;
+}
+
+/**
+ * Asks the first started workers to exit and joins them.
+ */
+static void stop_workers(ThreadPoolImpl *impl, int started) {
+  pthread_mutex_lock(&impl->mutex);
+  impl->stopping = true;
+  pthread_cond_broadcast(&impl->work_ready);
+  pthread_mutex_unlock(&impl->mutex);
+
+  for (int i = 0; i < started; i++) {
+    pthread_join(impl->threads[i], NULL);
+  }
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+ThreadPool thread_pool_create(int thread_count) {
+  if (thread_count <= 0) {
+    return NULL;
+  }
+
+  ThreadPoolImpl *impl = malloc(sizeof(ThreadPoolImpl));
+  if (impl == NULL) {
+    printf("Error: Failed to allocate memory for thread pool\n");
+    return NULL;
+  }
+
+  impl->threads = malloc(thread_count * sizeof(pthread_t));
+  if (impl->threads == NULL) {
+    printf("Error: Failed to allocate memory for thread pool workers\n");
+    free(impl);
+    return NULL;
+  }
+
+  pthread_mutex_init(&impl->mutex, NULL);
+  pthread_cond_init(&impl->work_ready, NULL);
+  pthread_cond_init(&impl->work_done, NULL);
+  impl->task = NULL;
+  impl->user_data = NULL;
+  impl->task_count = 0;
+  impl->next_task = 0;
+  impl->pending = 0;
+  impl->stopping = false;
+
+  for (int i = 0; i < thread_count; i++) {
+    if (pthread_create(&impl->threads[i], NULL, worker_main, impl) != 0) {
+      printf("Error: Failed to start thread pool worker\n");
+      stop_workers(impl, i);
+      pthread_cond_destroy(&impl->work_done);
+      pthread_cond_destroy(&impl->work_ready);
+      pthread_mutex_destroy(&impl->mutex);
+      free(impl->threads);
+      free(impl);
+      return NULL;
+    }
+  }
+  impl->thread_count = thread_count;
+
+  return impl;
+}
+
+void thread_pool_destroy(ThreadPool pool) {
+  if (pool == NULL) {
+    return;
+  }
+
+  ThreadPoolImpl *impl = (ThreadPoolImpl *)pool;
+  stop_workers(impl, impl->thread_count);
+
+  pthread_cond_destroy(&impl->work_done);
+  pthread_cond_destroy(&impl->work_ready);
+  pthread_mutex_destroy(&impl->mutex);
+  free(impl->threads);
+  free(impl);
+}
+
+bool thread_pool_run(ThreadPool pool, int task_count, ThreadPoolTaskFunc task,
+                     void *user_data) {
+  if (pool == NULL || task == NULL || task_count < 0) {
+    return false;
+  }
+  if (task_count == 0) {
+    return true;
+  }
+
+  ThreadPoolImpl *impl = (ThreadPoolImpl *)pool;
+
+  pthread_mutex_lock(&impl->mutex);
+  impl->task = task;
+  impl->user_data = user_data;
+  impl->task_count = task_count;
+  impl->next_task = 0;
+  impl->pending = task_count;
+  pthread_cond_broadcast(&impl->work_ready);
+
+  while (impl->pending > 0) {
+    pthread_cond_wait(&impl->work_done, &impl->mutex);
+  }
+
+  impl->task = NULL;
+  impl->user_data = NULL;
+  impl->task_count = 0;
+  impl->next_task = 0;
+  pthread_mutex_unlock(&impl->mutex);
+
+  return true;
+}
+
+int thread_pool_get_thread_count(ThreadPool pool) {
+  if (pool == NULL) {
+    return 0;
+  }
+
+  return ((ThreadPoolImpl *)pool)->thread_count;
+}
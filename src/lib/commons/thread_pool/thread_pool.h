@@ -0,0 +1,63 @@
+/**
+ * @file thread_pool.h
+ * @brief Fixed-size worker thread pool
+ *
+ * This module keeps a set of POSIX worker threads alive and runs batches of
+ * independent tasks on them. A batch is submitted with thread_pool_run(), which
+ * blocks until every task of the batch has finished, so callers never need to
+ * synchronize with the workers themselves.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdbool.h>
+
+/**
+ * @brief Opaque pointer type for thread pool instances
+ */
+typedef void *ThreadPool;
+
+/**
+ * Callback function type for pool tasks.
+ * @param task_index Index of the task inside its batch
+ * @param user_data User-provided context shared by the batch
+ */
+typedef void (*ThreadPoolTaskFunc)(int task_index, void *user_data);
+
+/**
+ * @brief Creates a pool and starts its worker threads
+ * @param thread_count Number of worker threads (must be positive)
+ * @return Pointer to new thread pool or NULL on error
+ */
+ThreadPool thread_pool_create(int thread_count);
+
+/**
+ * @brief Stops the worker threads and frees the pool
+ * @param pool Thread pool instance to destroy
+ */
+void thread_pool_destroy(ThreadPool pool);
+
+/**
+ * @brief Runs a batch of tasks and waits for all of them to finish
+ *
+ * Tasks are handed out to the workers in index order, but may run (and
+ * complete) in any order. The pool must not be used by another thread while
+ * a batch is running.
+ * @param pool Thread pool instance
+ * @param task_count Number of tasks in the batch
+ * @param task Function run once for every index in [0, task_count)
+ * @param user_data User-provided context passed to every task
+ * @return true if the batch ran, false on invalid arguments
+ */
+bool thread_pool_run(ThreadPool pool, int task_count, ThreadPoolTaskFunc task,
+                     void *user_data);
+
+/**
+ * @brief Gets the number of worker threads
+ * @param pool Thread pool instance
+ * @return Number of worker threads
+ */
+int thread_pool_get_thread_count(ThreadPool pool);
+
+#endif // THREAD_POOL_H
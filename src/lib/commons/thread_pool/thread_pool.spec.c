@@ -0,0 +1,149 @@
+/**
+ * @file thread_pool.spec.c
+ * @brief Unit tests for thread pool module
+ *
+ * Unit tests for the thread pool functions defined in thread_pool.h
+ */
+
+#include "./thread_pool.h"
+#include "../../test_framework/test_framework.h"
+
+#include <stdlib.h>
+
+#define MANY_TASKS 1000
+
+// ============================================================================
+// Test Helpers
+// ============================================================================
+
+// Counts how many times each task index ran
+typedef struct {
+  int runs[MANY_TASKS];
+} TaskRuns;
+
+static void count_run(int task_index, void *user_data) {
+  TaskRuns *runs = (TaskRuns *)user_data;
+  runs->runs[task_index]++;
+}
+
+// Writes a value that depends only on the task index
+static void square_index(int task_index, void *user_data) {
+  long *results = (long *)user_data;
+  results[task_index] = (long)task_index * task_index;
+}
+
+// ============================================================================
+// Tests for thread_pool_create()
+// ============================================================================
+
+/**
+ * Test: thread_pool_create should start the requested workers
+ */
+bool test_thread_pool_create_basic(void) {
+  ThreadPool pool = thread_pool_create(4);
+
+  ASSERT_NOT_NULL(pool);
+  ASSERT_EQUAL(thread_pool_get_thread_count(pool), 4);
+
+  thread_pool_destroy(pool);
+  return true;
+}
+
+/**
+ * Test: thread_pool_create should reject a non-positive thread count
+ */
+bool test_thread_pool_create_invalid(void) {
+  ASSERT_NULL(thread_pool_create(0));
+  ASSERT_NULL(thread_pool_create(-3));
+  ASSERT_EQUAL(thread_pool_get_thread_count(NULL), 0);
+  return true;
+}
+
+// ============================================================================
+// Tests for thread_pool_run()
+// ============================================================================
+
+/**
+ * Test: every task of a batch should run exactly once
+ */
+bool test_thread_pool_run_each_task_once(void) {
+  ThreadPool pool = thread_pool_create(3);
+  TaskRuns *runs = calloc(1, sizeof(TaskRuns));
+  ASSERT_NOT_NULL(runs);
+
+  ASSERT_TRUE(thread_pool_run(pool, MANY_TASKS, count_run, runs));
+  for (int i = 0; i < MANY_TASKS; i++) {
+    ASSERT_EQUAL(runs->runs[i], 1);
+  }
+
+  free(runs);
+  thread_pool_destroy(pool);
+  return true;
+}
+
+/**
+ * Test: the pool should be reusable across batches of different sizes
+ */
+bool test_thread_pool_run_many_batches(void) {
+  ThreadPool pool = thread_pool_create(2);
+  long results[64];
+
+  for (int batch = 1; batch <= 64; batch++) {
+    for (int i = 0; i < 64; i++) {
+      results[i] = -1;
+    }
+    ASSERT_TRUE(thread_pool_run(pool, batch, square_index, results));
+    for (int i = 0; i < 64; i++) {
+      ASSERT_EQUAL(results[i], i < batch ? (long)i * i : -1);
+    }
+  }
+
+  thread_pool_destroy(pool);
+  return true;
+}
+
+/**
+ * Test: empty and invalid batches should not run anything
+ */
+bool test_thread_pool_run_edge_cases(void) {
+  ThreadPool pool = thread_pool_create(2);
+  TaskRuns *runs = calloc(1, sizeof(TaskRuns));
+  ASSERT_NOT_NULL(runs);
+
+  ASSERT_TRUE(thread_pool_run(pool, 0, count_run, runs));
+  ASSERT_FALSE(thread_pool_run(pool, -1, count_run, runs));
+  ASSERT_FALSE(thread_pool_run(pool, 1, NULL, runs));
+  ASSERT_FALSE(thread_pool_run(NULL, 1, count_run, runs));
+  ASSERT_EQUAL(runs->runs[0], 0);
+
+  free(runs);
+  thread_pool_destroy(pool);
+  return true;
+}
+
+// ============================================================================
+// Main Test Runner
+// ============================================================================
+
+int main(void) {
+  test_framework_init();
+
+  test_print_section("Testing thread_pool_create()");
+  test_register("test_thread_pool_create_basic", test_thread_pool_create_basic);
+  test_register("test_thread_pool_create_invalid",
+                test_thread_pool_create_invalid);
+
+  test_print_section("Testing thread_pool_run()");
+  test_register("test_thread_pool_run_each_task_once",
+                test_thread_pool_run_each_task_once);
+  test_register("test_thread_pool_run_many_batches",
+                test_thread_pool_run_many_batches);
+  test_register("test_thread_pool_run_edge_cases",
+                test_thread_pool_run_edge_cases);
+
+  int result = test_run_all();
+
+  test_framework_cleanup();
+
+  return result;
+}
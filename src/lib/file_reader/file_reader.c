@@ -2,9 +2,16 @@
 #include "../commons/queue/queue.h"
 #include "../commons/stack/stack.h"
 #include "../commons/utils/utils.h"
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define INITIAL_LINE_CAPACITY 64
+#define INITIAL_STREAM_BUFFER_SIZE 256
 
 struct FileData {
   const char *filepath;
@@ -13,6 +20,34 @@ struct FileData {
   // This stack is used to free the lines of
   // the file after the execution of the commands
   Stack linesStackToFree;
+  // Index of every line, in file order: where it starts and its length
+  // without the newline. In mapped mode the lines point into the mapping
+  // itself and the queue is only built if asked for.
+  const char **lineStarts;
+  int *lineLengths;
+  int lineCount;
+  int lineCapacity;
+  // The lines as terminated strings. The stdio reader fills it as it reads;
+  // mapped files get it, backed by terminatedCopy, on first use.
+  char **lines;
+  char *terminatedCopy;
+  // Mapped mode only: the read-only mapping of the file and, when the file
+  // does not end with a newline, a terminated copy of its last line
+  const char *mapping;
+  size_t mappingSize;
+  char *lastLineCopy;
+  // Position of the line the next file_data_next_line() call returns
+  int nextLine;
+  // Stream mode only: the open file and a ring of FILE_DATA_LOOKAHEAD line
+  // buffers. The current line sits at windowStart and the windowFilled - 1
+  // lines after it were read ahead by file_data_peek_line().
+  FILE *stream;
+  char **window;
+  size_t *windowSizes;
+  int windowStart;
+  int windowFilled;
+  // Set when a line could not be read, which then ends the file early
+  bool failed;
 };
 
 struct LinesQueueAndStack {
@@ -23,22 +58,24 @@ struct LinesQueueAndStack {
 // Private functions
 static char *read_line(FILE *file, char *buffer, size_t size);
 static struct LinesQueueAndStack *
-read_file_to_queue_and_stack(const char *filepath);
+read_file_to_queue_and_stack(struct FileData *file);
+static struct FileData *file_data_alloc(const char *filepath);
+static bool append_line_index(struct FileData *file, const char *start,
+                              int length, char *line);
+static bool index_mapped_lines(struct FileData *file);
+static char **get_terminated_lines(struct FileData *file);
+static int advance_line(struct FileData *file);
+static bool read_stream_line(struct FileData *file, int slot);
 
 // Creates a new FileData instance and reads the file
 FileData file_data_create(const char *filepath) {
-  struct FileData *file = malloc(sizeof(struct FileData));
+  struct FileData *file = file_data_alloc(filepath);
   if (file == NULL) {
-    printf("Error: Failed to allocate memory for FileData\n");
     return NULL;
   }
 
-  file->filepath = filepath;
-  file->filename =
-      strrchr(filepath, '/') ? strrchr(filepath, '/') + 1 : filepath;
-
   struct LinesQueueAndStack *linesQueueAndStack =
-      read_file_to_queue_and_stack(filepath);
+      read_file_to_queue_and_stack(file);
 
   if (linesQueueAndStack == NULL || linesQueueAndStack->linesQueue == NULL ||
       linesQueueAndStack->linesStackToFree == NULL) {
@@ -46,6 +83,10 @@ FileData file_data_create(const char *filepath) {
     if (linesQueueAndStack != NULL) {
       free(linesQueueAndStack);
     }
+    free(file->lineStarts);
+    free(file->lineLengths);
+    free(file->lines);
+    free(file);
     return NULL;
   }
 
@@ -55,9 +96,212 @@ FileData file_data_create(const char *filepath) {
   return (FileData)file;
 }
 
-// Reads the file lines and returns a Queue. This function is private.
+// Creates a new FileData instance backed by a read-only mapping of the file
+FileData file_data_create_mapped(const char *filepath) {
+  int fd = open(filepath, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+    // Not something we can map: read it the usual way
+    close(fd);
+    return file_data_create(filepath);
+  }
+
+  struct FileData *file = file_data_alloc(filepath);
+  if (file == NULL) {
+    close(fd);
+    return NULL;
+  }
+
+  file->mappingSize = (size_t)info.st_size;
+  if (file->mappingSize > 0) {
+    // Read-only, so the pages stay shared with the page cache
+    void *mapping =
+        mmap(NULL, file->mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      close(fd);
+      free(file);
+      return file_data_create(filepath);
+    }
+    file->mapping = (const char *)mapping;
+  }
+  close(fd);
+
+  if (!index_mapped_lines(file)) {
+    printf("Error: Failed to index the file lines\n");
+    file_data_destroy(file);
+    return NULL;
+  }
+
+  return (FileData)file;
+}
+
+// Creates a new FileData instance that reads the file as it is consumed
+FileData file_data_create_stream(const char *filepath) {
+  FILE *stream = fopen(filepath, "r");
+  if (stream == NULL) {
+    return NULL;
+  }
+
+  struct FileData *file = file_data_alloc(filepath);
+  if (file == NULL) {
+    fclose(stream);
+    return NULL;
+  }
+
+  file->stream = stream;
+  file->window = calloc(FILE_DATA_LOOKAHEAD, sizeof(char *));
+  file->windowSizes = calloc(FILE_DATA_LOOKAHEAD, sizeof(size_t));
+  if (file->window == NULL || file->windowSizes == NULL) {
+    printf("Error: Failed to allocate memory for the line window\n");
+    file_data_destroy(file);
+    return NULL;
+  }
+
+  return (FileData)file;
+}
+
+// Allocates an empty FileData for a path
+static struct FileData *file_data_alloc(const char *filepath) {
+  struct FileData *file = malloc(sizeof(struct FileData));
+  if (file == NULL) {
+    printf("Error: Failed to allocate memory for FileData\n");
+    return NULL;
+  }
+
+  file->filepath = filepath;
+  file->filename =
+      strrchr(filepath, '/') ? strrchr(filepath, '/') + 1 : filepath;
+  file->linesQueue = NULL;
+  file->linesStackToFree = NULL;
+  file->lineStarts = NULL;
+  file->lineLengths = NULL;
+  file->lineCount = 0;
+  file->lineCapacity = 0;
+  file->lines = NULL;
+  file->terminatedCopy = NULL;
+  file->mapping = NULL;
+  file->mappingSize = 0;
+  file->lastLineCopy = NULL;
+  file->nextLine = 0;
+  file->stream = NULL;
+  file->window = NULL;
+  file->windowSizes = NULL;
+  file->windowStart = 0;
+  file->windowFilled = 0;
+  file->failed = false;
+  return file;
+}
+
+// Appends a line to the line index, growing it geometrically. Lines read as
+// terminated strings (line is not NULL) also go to the string index.
+static bool append_line_index(struct FileData *file, const char *start,
+                              int length, char *line) {
+  if (file->lineCount == file->lineCapacity) {
+    int newCapacity = file->lineCapacity == 0 ? INITIAL_LINE_CAPACITY
+                                              : file->lineCapacity * 2;
+    const char **starts =
+        realloc(file->lineStarts, newCapacity * sizeof(const char *));
+    if (starts != NULL) {
+      file->lineStarts = starts;
+    }
+    int *lengths = realloc(file->lineLengths, newCapacity * sizeof(int));
+    if (lengths != NULL) {
+      file->lineLengths = lengths;
+    }
+    char **lines = file->lines;
+    if (line != NULL) {
+      lines = realloc(file->lines, newCapacity * sizeof(char *));
+      if (lines != NULL) {
+        file->lines = lines;
+      }
+    }
+    if (starts == NULL || lengths == NULL || (line != NULL && lines == NULL)) {
+      printf("Error: Failed to allocate memory for the line index\n");
+      return false;
+    }
+    file->lineCapacity = newCapacity;
+  }
+
+  file->lineStarts[file->lineCount] = start;
+  file->lineLengths[file->lineCount] = length;
+  if (line != NULL) {
+    file->lines[file->lineCount] = line;
+  }
+  file->lineCount++;
+  return true;
+}
+
+// Splits the mapping into lines in a single pass without writing to it. Every
+// line is followed by its newline, so it can be lexed in place. Lines have no
+// length limit.
+static bool index_mapped_lines(struct FileData *file) {
+  const char *cursor = file->mapping;
+  const char *end = file->mapping + file->mappingSize;
+
+  while (cursor < end) {
+    const char *newline = memchr(cursor, '\n', (size_t)(end - cursor));
+    if (newline == NULL) {
+      // Last line without a newline: the byte after it may be past the
+      // mapping, so it gets its own terminated copy
+      size_t length = (size_t)(end - cursor);
+      file->lastLineCopy = malloc(length + 1);
+      if (file->lastLineCopy == NULL) {
+        return false;
+      }
+      memcpy(file->lastLineCopy, cursor, length);
+      file->lastLineCopy[length] = '\0';
+      return append_line_index(file, file->lastLineCopy, (int)length, NULL);
+    }
+
+    if (!append_line_index(file, cursor, (int)(newline - cursor), NULL)) {
+      return false;
+    }
+    cursor = newline + 1;
+  }
+
+  return true;
+}
+
+// Gets the lines as terminated strings. Mapped files are read-only, so the
+// first call copies their lines, terminated, into one buffer.
+static char **get_terminated_lines(struct FileData *file) {
+  if (file->lines != NULL || file->lineCount == 0) {
+    return file->lines;
+  }
+
+  size_t size = 0;
+  for (int i = 0; i < file->lineCount; i++) {
+    size += (size_t)file->lineLengths[i] + 1;
+  }
+  char *copy = malloc(size);
+  char **lines = malloc(file->lineCount * sizeof(char *));
+  if (copy == NULL || lines == NULL) {
+    printf("Error: Failed to allocate memory for the file lines\n");
+    free(copy);
+    free(lines);
+    return NULL;
+  }
+
+  char *cursor = copy;
+  for (int i = 0; i < file->lineCount; i++) {
+    memcpy(cursor, file->lineStarts[i], (size_t)file->lineLengths[i]);
+    cursor[file->lineLengths[i]] = '\0';
+    lines[i] = cursor;
+    cursor += file->lineLengths[i] + 1;
+  }
+  file->terminatedCopy = copy;
+  file->lines = lines;
+  return lines;
+}
+
+// Reads the file lines and returns a Queue. The lines are also added to the
+// line index of the file. This function is private.
 static struct LinesQueueAndStack *
-read_file_to_queue_and_stack(const char *filepath) {
+read_file_to_queue_and_stack(struct FileData *fileData) {
   struct LinesQueueAndStack *linesQueueAndStack =
       malloc(sizeof(struct LinesQueueAndStack));
   if (linesQueueAndStack == NULL) {
@@ -67,7 +311,7 @@ read_file_to_queue_and_stack(const char *filepath) {
 
   Queue lines = queue_create();
   Stack linesStackToFree = stack_create();
-  FILE *file = fopen(filepath, "r");
+  FILE *file = fopen(fileData->filepath, "r");
   if (file == NULL) {
     // Cleanup and report error
     if (lines != NULL) {
@@ -85,6 +329,7 @@ read_file_to_queue_and_stack(const char *filepath) {
     char *line = duplicate_string(buffer);
     queue_enqueue(lines, line);
     stack_push(linesStackToFree, line);
+    append_line_index(fileData, line, (int)strlen(line), line);
   }
 
   fclose(file);
@@ -99,14 +344,36 @@ void file_data_destroy(FileData fileData) {
   if (fileData != NULL) {
     struct FileData *file = (struct FileData *)fileData;
     // This frees the lines of the file
-    while (!stack_is_empty(file->linesStackToFree)) {
-      void *line = stack_pop(file->linesStackToFree);
-      line != NULL ? free(line) : NULL;
+    if (file->linesStackToFree != NULL) {
+      while (!stack_is_empty(file->linesStackToFree)) {
+        void *line = stack_pop(file->linesStackToFree);
+        line != NULL ? free(line) : NULL;
+      }
+      // This destroys the stack of lines to free
+      stack_destroy(file->linesStackToFree);
     }
-    // This destroys the stack of lines to free
-    stack_destroy(file->linesStackToFree);
     // This destroys the queue of lines
-    queue_destroy(file->linesQueue);
+    if (file->linesQueue != NULL) {
+      queue_destroy(file->linesQueue);
+    }
+    // This releases the mapped file and the line index
+    if (file->mapping != NULL) {
+      munmap((void *)file->mapping, file->mappingSize);
+    }
+    free(file->lastLineCopy);
+    free(file->terminatedCopy);
+    free(file->lineStarts);
+    free(file->lineLengths);
+    free(file->lines);
+    // This closes the stream and frees its line window
+    if (file->stream != NULL) {
+      fclose(file->stream);
+    }
+    for (int i = 0; file->window != NULL && i < FILE_DATA_LOOKAHEAD; i++) {
+      free(file->window[i]);
+    }
+    free(file->window);
+    free(file->windowSizes);
     // This frees the file data
     free(fileData);
   }
@@ -124,12 +391,204 @@ const char *get_file_name(const FileData fileData) {
   return file->filename;
 }
 
-// Gets the file lines queue
+// Gets the file lines queue. In mapped mode it is built on first use; streams
+// have none.
 Queue get_file_lines_queue(const FileData fileData) {
   struct FileData *file = (struct FileData *)fileData;
+  if (file->stream != NULL) {
+    return NULL;
+  }
+  if (file->linesQueue == NULL) {
+    char **lines = get_terminated_lines(file);
+    if (lines == NULL && file->lineCount > 0) {
+      return NULL;
+    }
+    file->linesQueue = queue_create();
+    for (int i = 0; file->linesQueue != NULL && i < file->lineCount; i++) {
+      queue_enqueue(file->linesQueue, lines[i]);
+    }
+  }
   return file->linesQueue;
 }
 
+// Gets the number of lines
+int file_data_get_line_count(const FileData fileData) {
+  if (fileData == NULL) {
+    return 0;
+  }
+  return ((struct FileData *)fileData)->lineCount;
+}
+
+// Gets a line by index
+char *file_data_get_line(const FileData fileData, int index) {
+  if (fileData == NULL) {
+    return NULL;
+  }
+  struct FileData *file = (struct FileData *)fileData;
+  if (index < 0 || index >= file->lineCount) {
+    return NULL;
+  }
+  char **lines = get_terminated_lines(file);
+  return lines != NULL ? lines[index] : NULL;
+}
+
+// Gets a line by index without copying it
+const char *file_data_get_line_view(const FileData fileData, int index,
+                                    int *length) {
+  if (fileData == NULL) {
+    return NULL;
+  }
+  struct FileData *file = (struct FileData *)fileData;
+  if (index < 0 || index >= file->lineCount) {
+    return NULL;
+  }
+  *length = file->lineLengths[index];
+  return file->lineStarts[index];
+}
+
+// Moves an indexed file to its next line and returns the line's position, or
+// -1 past the end
+static int advance_line(struct FileData *file) {
+  if (file->nextLine >= file->lineCount) {
+    // Past the end there is no current line either
+    file->nextLine = file->lineCount + 1;
+    return -1;
+  }
+  return file->nextLine++;
+}
+
+// Advances to the next line
+char *file_data_next_line(FileData fileData) {
+  if (fileData == NULL) {
+    return NULL;
+  }
+  struct FileData *file = (struct FileData *)fileData;
+
+  if (file->stream == NULL) {
+    char **lines = get_terminated_lines(file);
+    if (lines == NULL && file->lineCount > 0) {
+      file->failed = true;
+      return NULL;
+    }
+    int index = advance_line(file);
+    return index >= 0 ? lines[index] : NULL;
+  }
+
+  // Drop the current line; the next one may already be in the window. Lines
+  // read before an error are still handed out.
+  if (file->windowFilled > 0) {
+    file->windowStart = (file->windowStart + 1) % FILE_DATA_LOOKAHEAD;
+    file->windowFilled--;
+  }
+  if (file->windowFilled == 0) {
+    if (file->failed || !read_stream_line(file, file->windowStart)) {
+      return NULL;
+    }
+    file->windowFilled = 1;
+  }
+  file->nextLine++;
+  return file->window[file->windowStart];
+}
+
+// Advances to the next line without copying it
+const char *file_data_next_line_view(FileData fileData, int *length) {
+  if (fileData == NULL) {
+    return NULL;
+  }
+  struct FileData *file = (struct FileData *)fileData;
+
+  if (file->stream != NULL) {
+    const char *line = file_data_next_line(fileData);
+    if (line != NULL) {
+      *length = (int)strlen(line);
+    }
+    return line;
+  }
+
+  int index = advance_line(file);
+  if (index < 0) {
+    return NULL;
+  }
+  *length = file->lineLengths[index];
+  return file->lineStarts[index];
+}
+
+// Looks at the current line or one of the lines after it
+const char *file_data_peek_line(FileData fileData, int ahead) {
+  if (fileData == NULL || ahead < 0 || ahead >= FILE_DATA_LOOKAHEAD) {
+    return NULL;
+  }
+  struct FileData *file = (struct FileData *)fileData;
+
+  if (file->stream == NULL) {
+    int index = file->nextLine - 1 + ahead;
+    if (file->nextLine == 0 || index >= file->lineCount) {
+      return NULL;
+    }
+    char **lines = get_terminated_lines(file);
+    return lines != NULL ? lines[index] : NULL;
+  }
+
+  if (file->windowFilled == 0) {
+    return NULL;
+  }
+  while (file->windowFilled <= ahead) {
+    int slot = (file->windowStart + file->windowFilled) % FILE_DATA_LOOKAHEAD;
+    if (file->failed || !read_stream_line(file, slot)) {
+      return NULL;
+    }
+    file->windowFilled++;
+  }
+  return file->window[(file->windowStart + ahead) % FILE_DATA_LOOKAHEAD];
+}
+
+// Reads the next line of a stream into a window slot, growing the slot buffer
+// until the whole line fits. Returns false at the end of the file, or on error
+// after marking the file as failed.
+static bool read_stream_line(struct FileData *file, int slot) {
+  size_t length = 0;
+  for (;;) {
+    if (file->windowSizes[slot] - length < 2) {
+      size_t newSize = file->windowSizes[slot] == 0
+                           ? INITIAL_STREAM_BUFFER_SIZE
+                           : file->windowSizes[slot] * 2;
+      char *buffer = realloc(file->window[slot], newSize);
+      if (buffer == NULL) {
+        printf("Error: Failed to allocate memory for a file line\n");
+        file->failed = true;
+        return false;
+      }
+      file->window[slot] = buffer;
+      file->windowSizes[slot] = newSize;
+    }
+
+    char *chunk = file->window[slot] + length;
+    if (fgets(chunk, (int)(file->windowSizes[slot] - length), file->stream) ==
+        NULL) {
+      if (ferror(file->stream)) {
+        printf("Error: Failed to read a line of %s\n", file->filename);
+        file->failed = true;
+        return false;
+      }
+      // A last line without a newline still counts
+      return length > 0;
+    }
+    length += strlen(chunk);
+    if (length > 0 && file->window[slot][length - 1] == '\n') {
+      file->window[slot][length - 1] = '\0';
+      return true;
+    }
+  }
+}
+
+// Checks whether reading stopped on an error
+bool file_data_failed(const FileData fileData) {
+  if (fileData == NULL) {
+    return false;
+  }
+  return ((struct FileData *)fileData)->failed;
+}
+
 // Reads a line from file using fgets
 static char *read_line(FILE *file, char *buffer, size_t size) {
   if (fgets(buffer, size, file) != NULL) {
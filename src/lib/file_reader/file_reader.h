@@ -10,6 +10,13 @@
 #define FILE_READER_H
 
 #include "../commons/queue/queue.h"
+#include <stdbool.h>
+
+/**
+ * @brief Number of lines file_data_peek_line() can see, counting the current
+ * one
+ */
+#define FILE_DATA_LOOKAHEAD 64
 
 /**
  * @brief Opaque pointer type for file data instances
@@ -27,6 +34,35 @@ typedef void *FileData;
  */
 FileData file_data_create(const char *filepath);
 
+/**
+ * @brief Creates a new FileData instance backed by a memory mapping
+ *
+ * Maps the file read-only and indexes its lines in one pass over the bytes,
+ * without writing to them. file_data_get_line_view() and
+ * file_data_next_line_view() hand the lines out as (start, length) views
+ * into the mapping, with no copy and no length limit. The functions that
+ * return terminated strings copy the lines the first time one of them is
+ * called. Files that cannot be mapped (pipes, devices) are read like
+ * file_data_create() does.
+ *
+ * @param filepath Path to the file to be read
+ * @return FileData instance or NULL if creation failed
+ */
+FileData file_data_create_mapped(const char *filepath);
+
+/**
+ * @brief Creates a new FileData instance that reads the file incrementally
+ *
+ * Lines are read only as file_data_next_line() and file_data_peek_line() ask
+ * for them, into a reused window of FILE_DATA_LOOKAHEAD buffers, so memory
+ * stays bounded by the window size times the longest line whatever the size
+ * of the file. Streams have no line index and no queue.
+ *
+ * @param filepath Path to the file to be read
+ * @return FileData instance or NULL if creation failed
+ */
+FileData file_data_create_stream(const char *filepath);
+
 /**
  * @brief Destroys a FileData instance and frees all memory
  * @param fileData FileData instance to destroy
@@ -49,9 +85,96 @@ const char *get_file_name(const FileData fileData);
 
 /**
  * @brief Gets the queue containing all file lines
+ *
+ * For mapped FileData instances the queue is built on the first call.
  * @param fileData FileData instance
- * @return Queue containing file lines
+ * @return Queue containing file lines, or NULL for streams
  */
 Queue get_file_lines_queue(const FileData fileData);
 
+/**
+ * @brief Gets the number of lines in the file
+ * @param fileData FileData instance
+ * @return Number of lines, or 0 for streams
+ */
+int file_data_get_line_count(const FileData fileData);
+
+/**
+ * @brief Gets a line by its position in the file
+ *
+ * Lines are indexed independently of the queue, so this works whether or not
+ * the queue was consumed. The returned string is owned by the FileData and may
+ * be modified in place (e.g. by strtok). For mapped files it is a copy, made
+ * for every line on the first call; file_data_get_line_view() avoids it.
+ * @param fileData FileData instance
+ * @param index Zero-based line index
+ * @return Line without its newline, or NULL if index is out of bounds (always
+ * NULL for streams)
+ */
+char *file_data_get_line(const FileData fileData, int index);
+
+/**
+ * @brief Gets a line by its position in the file, without copying it
+ *
+ * The line is not terminated and must not be modified, but the byte after it
+ * is always readable: its newline, or a terminator for a last line without
+ * one. That is what lexer_init_view() expects.
+ * @param fileData FileData instance
+ * @param index Zero-based line index
+ * @param length Receives the length of the line without its newline
+ * @return Start of the line, or NULL if index is out of bounds (always NULL
+ * for streams)
+ */
+const char *file_data_get_line_view(const FileData fileData, int index,
+                                    int *length);
+
+/**
+ * @brief Advances to the next line of the file
+ *
+ * Works the same for every kind of FileData and is the way to read a file
+ * that may be a stream. The returned line becomes the current line; it may
+ * be modified in place, and for streams it stays valid only until the next
+ * call.
+ * @param fileData FileData instance
+ * @return Next line without its newline, or NULL at the end of the file or
+ * when the line could not be read (see file_data_failed())
+ */
+char *file_data_next_line(FileData fileData);
+
+/**
+ * @brief Advances to the next line of the file, without copying it
+ *
+ * Same as file_data_next_line(), but mapped files hand out a view into the
+ * mapping, as file_data_get_line_view() does.
+ * @param fileData FileData instance
+ * @param length Receives the length of the line without its newline
+ * @return Start of the next line, or NULL at the end of the file or when the
+ * line could not be read
+ */
+const char *file_data_next_line_view(FileData fileData, int *length);
+
+/**
+ * @brief Looks at a line without consuming it
+ *
+ * Streams read the lines ahead into their window, so later calls to
+ * file_data_next_line() return them without reading again.
+ * @param fileData FileData instance
+ * @param ahead 0 for the current line, k for the k-th line after it; must be
+ * below FILE_DATA_LOOKAHEAD
+ * @return The line, or NULL past the end of the file, before the first call
+ * to file_data_next_line(), or if ahead is out of range
+ */
+const char *file_data_peek_line(FileData fileData, int ahead);
+
+/**
+ * @brief Checks whether reading the file stopped on an error
+ *
+ * file_data_next_line() and file_data_peek_line() return NULL both at the end
+ * of the file and when a line cannot be read (e.g. out of memory for a long
+ * line); this tells the two apart. Once set, no more lines are returned.
+ * @param fileData FileData instance
+ * @return true if a line could not be read, false otherwise (and for NULL)
+ */
+bool file_data_failed(const FileData fileData);
+
 #endif // FILE_READER_H
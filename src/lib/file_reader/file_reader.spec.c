@@ -419,6 +419,287 @@ bool test_get_file_lines_queue_special_chars(void) {
   return true;
 }
 
+// ============================================================================
+// Tests for file_data_create_mapped() / file_data_get_line()
+// ============================================================================
+
+/**
+ * Test: mapped files should expose the same lines as the stdio reader
+ */
+bool test_file_data_create_mapped_matches_stdio(void) {
+  const char *test_lines[] = {"c 1 10.5 20.3 5.0 red", "",
+                              "t 3 30.0 40.0 Hello", NULL};
+  const char *filepath = "/tmp/test_file_reader_mapped.geo";
+  ASSERT_TRUE(create_test_file(filepath, test_lines));
+
+  FileData mapped = file_data_create_mapped(filepath);
+  FileData plain = file_data_create(filepath);
+  ASSERT_NOT_NULL(mapped);
+  ASSERT_NOT_NULL(plain);
+
+  ASSERT_EQUAL(file_data_get_line_count(mapped), 3);
+  ASSERT_EQUAL(file_data_get_line_count(plain), 3);
+  for (int i = 0; i < 3; i++) {
+    ASSERT_STR_EQUAL(file_data_get_line(mapped, i), test_lines[i]);
+    ASSERT_STR_EQUAL(file_data_get_line(plain, i), test_lines[i]);
+  }
+  ASSERT_NULL(file_data_get_line(mapped, 3));
+  ASSERT_NULL(file_data_get_line(mapped, -1));
+  ASSERT_STR_EQUAL(get_file_name(mapped), "test_file_reader_mapped.geo");
+
+  // The queue is still available and hands out the same lines
+  Queue lines = get_file_lines_queue(mapped);
+  ASSERT_NOT_NULL(lines);
+  ASSERT_EQUAL(queue_dequeue(lines), file_data_get_line(mapped, 0));
+
+  file_data_destroy(mapped);
+  file_data_destroy(plain);
+  remove_test_file(filepath);
+
+  return true;
+}
+
+/**
+ * Test: mapped files should keep a last line without newline and long lines
+ */
+bool test_file_data_create_mapped_edge_lines(void) {
+  const char *filepath = "/tmp/test_file_reader_mapped_edges.qry";
+  FILE *file = fopen(filepath, "w");
+  ASSERT_NOT_NULL(file);
+  for (int i = 0; i < 3000; i++) {
+    fputc('x', file);
+  }
+  fprintf(file, "\nd 10 20 -");
+  fclose(file);
+
+  FileData mapped = file_data_create_mapped(filepath);
+  ASSERT_NOT_NULL(mapped);
+  ASSERT_EQUAL(file_data_get_line_count(mapped), 2);
+  ASSERT_EQUAL(strlen(file_data_get_line(mapped, 0)), 3000);
+  ASSERT_STR_EQUAL(file_data_get_line(mapped, 1), "d 10 20 -");
+
+  // Lines can be tokenized in place
+  char *line = file_data_get_line(mapped, 1);
+  ASSERT_STR_EQUAL(strtok(line, " "), "d");
+
+  file_data_destroy(mapped);
+  remove_test_file(filepath);
+
+  return true;
+}
+
+/**
+ * Test: line views should match the lines and end where the lines end
+ */
+bool test_file_data_line_views(void) {
+  const char *test_lines[] = {"c 1 10.5 20.3 5.0 red", "",
+                              "t 3 30.0 40.0 Hello", NULL};
+  const char *filepath = "/tmp/test_file_reader_views.geo";
+  ASSERT_TRUE(create_test_file(filepath, test_lines));
+
+  FileData files[3] = {file_data_create(filepath),
+                       file_data_create_mapped(filepath),
+                       file_data_create_stream(filepath)};
+  for (int f = 0; f < 3; f++) {
+    ASSERT_NOT_NULL(files[f]);
+    for (int i = 0; i < 3; i++) {
+      int length = -1;
+      const char *line = file_data_next_line_view(files[f], &length);
+      ASSERT_NOT_NULL(line);
+      ASSERT_EQUAL(length, (int)strlen(test_lines[i]));
+      ASSERT_TRUE(strncmp(line, test_lines[i], (size_t)length) == 0);
+      ASSERT_TRUE(line[length] == '\n' || line[length] == '\0');
+    }
+    int length = 0;
+    ASSERT_NULL(file_data_next_line_view(files[f], &length));
+  }
+
+  // Views of a mapped file point into the mapping, strings are copies
+  int length = 0;
+  const char *view = file_data_get_line_view(files[1], 2, &length);
+  ASSERT_NOT_NULL(view);
+  ASSERT_EQUAL(length, 19);
+  ASSERT_TRUE(view[length] == '\n');
+  ASSERT_TRUE(file_data_get_line(files[1], 2) != view);
+  ASSERT_NULL(file_data_get_line_view(files[1], 3, &length));
+  ASSERT_NULL(file_data_get_line_view(files[2], 0, &length));
+
+  for (int f = 0; f < 3; f++) {
+    file_data_destroy(files[f]);
+  }
+  remove_test_file(filepath);
+
+  return true;
+}
+
+/**
+ * Test: mapping should handle empty and missing files
+ */
+bool test_file_data_create_mapped_empty_and_missing(void) {
+  const char *test_lines[] = {NULL};
+  const char *filepath = "/tmp/test_file_reader_mapped_empty.geo";
+  ASSERT_TRUE(create_test_file(filepath, test_lines));
+
+  FileData mapped = file_data_create_mapped(filepath);
+  ASSERT_NOT_NULL(mapped);
+  ASSERT_EQUAL(file_data_get_line_count(mapped), 0);
+  ASSERT_TRUE(queue_is_empty(get_file_lines_queue(mapped)));
+  file_data_destroy(mapped);
+  remove_test_file(filepath);
+
+  ASSERT_NULL(file_data_create_mapped("/tmp/nonexistent_file_12345.geo"));
+  ASSERT_EQUAL(file_data_get_line_count(NULL), 0);
+
+  return true;
+}
+
+// ============================================================================
+// Tests for file_data_create_stream() / file_data_next_line()
+// ============================================================================
+
+/**
+ * Test: every kind of FileData should hand out the same lines in order
+ */
+bool test_file_data_next_line_all_modes(void) {
+  const char *test_lines[] = {"c 1 10.5 20.3 5.0 red", "",
+                              "t 3 30.0 40.0 Hello", NULL};
+  const char *filepath = "/tmp/test_file_reader_next_line.qry";
+  ASSERT_TRUE(create_test_file(filepath, test_lines));
+
+  FileData files[3] = {file_data_create(filepath),
+                       file_data_create_mapped(filepath),
+                       file_data_create_stream(filepath)};
+  for (int f = 0; f < 3; f++) {
+    ASSERT_NOT_NULL(files[f]);
+    ASSERT_NULL(file_data_peek_line(files[f], 0));
+    for (int i = 0; i < 3; i++) {
+      char *line = file_data_next_line(files[f]);
+      ASSERT_STR_EQUAL(line, test_lines[i]);
+      ASSERT_EQUAL(file_data_peek_line(files[f], 0), line);
+    }
+    ASSERT_NULL(file_data_peek_line(files[f], 1));
+    ASSERT_NULL(file_data_next_line(files[f]));
+    ASSERT_NULL(file_data_peek_line(files[f], 0));
+    ASSERT_NULL(file_data_next_line(files[f]));
+    file_data_destroy(files[f]);
+  }
+
+  remove_test_file(filepath);
+  return true;
+}
+
+/**
+ * Test: peeking a stream should not skip or repeat lines
+ */
+bool test_file_data_stream_peek(void) {
+  const char *filepath = "/tmp/test_file_reader_stream_peek.qry";
+  const int line_count = FILE_DATA_LOOKAHEAD * 3 + 5;
+  FILE *file = fopen(filepath, "w");
+  ASSERT_NOT_NULL(file);
+  for (int i = 0; i < line_count; i++) {
+    fprintf(file, "d %d 0 -\n", i);
+  }
+  fclose(file);
+
+  FileData stream = file_data_create_stream(filepath);
+  ASSERT_NOT_NULL(stream);
+  ASSERT_NULL(get_file_lines_queue(stream));
+  ASSERT_EQUAL(file_data_get_line_count(stream), 0);
+
+  char expected[32];
+  for (int i = 0; i < line_count; i++) {
+    char *line = file_data_next_line(stream);
+    ASSERT_NOT_NULL(line);
+    snprintf(expected, sizeof(expected), "d %d 0 -", i);
+    ASSERT_STR_EQUAL(line, expected);
+
+    // Look as far ahead as the window allows every few lines
+    if (i % 7 == 0) {
+      for (int ahead = 1; ahead < FILE_DATA_LOOKAHEAD; ahead++) {
+        const char *next = file_data_peek_line(stream, ahead);
+        if (i + ahead >= line_count) {
+          ASSERT_NULL(next);
+          break;
+        }
+        snprintf(expected, sizeof(expected), "d %d 0 -", i + ahead);
+        ASSERT_STR_EQUAL(next, expected);
+      }
+      ASSERT_NULL(file_data_peek_line(stream, FILE_DATA_LOOKAHEAD));
+    }
+
+    // The current line survives the peeks and can be tokenized in place
+    snprintf(expected, sizeof(expected), "d %d 0 -", i);
+    ASSERT_STR_EQUAL(line, expected);
+    ASSERT_STR_EQUAL(strtok(line, " "), "d");
+  }
+  ASSERT_NULL(file_data_next_line(stream));
+
+  file_data_destroy(stream);
+  remove_test_file(filepath);
+  return true;
+}
+
+/**
+ * Test: streams should keep long lines and a last line without newline
+ */
+bool test_file_data_stream_edge_lines(void) {
+  const char *filepath = "/tmp/test_file_reader_stream_edges.qry";
+  FILE *file = fopen(filepath, "w");
+  ASSERT_NOT_NULL(file);
+  for (int i = 0; i < 3000; i++) {
+    fputc('x', file);
+  }
+  fprintf(file, "\nd 10 20 -");
+  fclose(file);
+
+  FileData stream = file_data_create_stream(filepath);
+  ASSERT_NOT_NULL(stream);
+  char *line = file_data_next_line(stream);
+  ASSERT_NOT_NULL(line);
+  ASSERT_EQUAL(strlen(line), 3000);
+  const char *next = file_data_peek_line(stream, 1);
+  ASSERT_STR_EQUAL(next, "d 10 20 -");
+  line = file_data_next_line(stream);
+  ASSERT_STR_EQUAL(line, "d 10 20 -");
+  ASSERT_NULL(file_data_next_line(stream));
+  file_data_destroy(stream);
+  remove_test_file(filepath);
+
+  ASSERT_NULL(file_data_create_stream("/tmp/nonexistent_file_12345.qry"));
+  ASSERT_NULL(file_data_next_line(NULL));
+
+  return true;
+}
+
+/**
+ * Test: a read error should be told apart from the end of the file
+ */
+bool test_file_data_stream_read_error(void) {
+  const char *filepath = "/tmp/test_file_reader_stream_error";
+  const char *test_lines[] = {"d 1 0 -", NULL};
+  ASSERT_TRUE(create_test_file(filepath, test_lines));
+
+  FileData stream = file_data_create_stream(filepath);
+  ASSERT_NOT_NULL(stream);
+  ASSERT_NOT_NULL(file_data_next_line(stream));
+  ASSERT_NULL(file_data_next_line(stream));
+  ASSERT_FALSE(file_data_failed(stream));
+  file_data_destroy(stream);
+  remove_test_file(filepath);
+
+  // A directory opens as a stream but cannot be read
+  FileData broken = file_data_create_stream("/tmp");
+  if (broken != NULL) {
+    ASSERT_NULL(file_data_next_line(broken));
+    ASSERT_TRUE(file_data_failed(broken));
+    file_data_destroy(broken);
+  }
+
+  ASSERT_FALSE(file_data_failed(NULL));
+
+  return true;
+}
+
 // ============================================================================
 // Tests for file_data_destroy()
 // ============================================================================
@@ -499,6 +780,26 @@ int main(void) {
   test_register("test_get_file_lines_queue_special_chars",
                 test_get_file_lines_queue_special_chars);
 
+  // Register tests for file_data_create_mapped
+  test_print_section("Testing file_data_create_mapped()");
+  test_register("test_file_data_create_mapped_matches_stdio",
+                test_file_data_create_mapped_matches_stdio);
+  test_register("test_file_data_create_mapped_edge_lines",
+                test_file_data_create_mapped_edge_lines);
+  test_register("test_file_data_line_views", test_file_data_line_views);
+  test_register("test_file_data_create_mapped_empty_and_missing",
+                test_file_data_create_mapped_empty_and_missing);
+
+  // Register tests for file_data_create_stream
+  test_print_section("Testing file_data_create_stream()");
+  test_register("test_file_data_next_line_all_modes",
+                test_file_data_next_line_all_modes);
+  test_register("test_file_data_stream_peek", test_file_data_stream_peek);
+  test_register("test_file_data_stream_edge_lines",
+                test_file_data_stream_edge_lines);
+  test_register("test_file_data_stream_read_error",
+                test_file_data_stream_read_error);
+
   // Register tests for file_data_destroy
   test_print_section("Testing file_data_destroy()");
   test_register("test_file_data_destroy_null", test_file_data_destroy_null);
@@ -1,7 +1,8 @@
 #include "geo_handler.h"
 #include "../city/city.h"
-#include "../commons/queue/queue.h"
+#include "../commons/thread_pool/thread_pool.h"
 #include "../file_reader/file_reader.h"
+#include "../lexer/lexer.h"
 #include "../shapes/circle/circle.h"
 #include "../shapes/line/line.h"
 #include "../shapes/rectangle/rectangle.h"
@@ -12,51 +13,68 @@
 #include <stdlib.h>
 #include <string.h>
 
-// Private functions for command execution
-static void execute_circle_command(City city);
-static void execute_rectangle_command(City city);
-static void execute_line_command(City city);
-static void execute_text_command(City city);
-static void execute_text_style_command(City city);
+// Fewest lines worth handing to a worker thread
+#define MIN_CHUNK_LINES 1024
+
+// Chunks per worker, so uneven chunks still balance out
+#define CHUNKS_PER_THREAD 4
+
+// Buffer the string tokens of read-only lines are copied to, grown to fit
+// the longest line seen
+typedef struct {
+  char *bytes;
+  int capacity;
+} Scratch;
+
+// Lines of an indexed .geo file parsed in chunks. Slot i receives the shape
+// of line i (NULL for lines that are not shapes).
+typedef struct {
+  FileData file_data;
+  ShapeStore store;
+  int line_count;
+  int chunk_count;
+  Shape *shapes;
+} ChunkedParse;
+
+// Private functions for command parsing
+static Shape parse_circle_command(ShapeStore store, Lexer *lexer);
+static Shape parse_rectangle_command(ShapeStore store, Lexer *lexer);
+static Shape parse_line_command(ShapeStore store, Lexer *lexer);
+static Shape parse_text_command(ShapeStore store, Lexer *lexer);
+static Shape parse_text_style_command(ShapeStore store, Lexer *lexer);
+static Shape parse_shape_command(ShapeStore store, LexerCommand command,
+                                 Lexer *lexer);
+static bool is_shape_command(LexerCommand command);
+static char *reserve_scratch(Scratch *scratch, int length);
+static void add_line_shape(City city, LexerCommand command, Lexer *lexer,
+                           Shape shape);
+static void parse_lines_serial(City city, FileData file_data);
+static bool parse_lines_parallel(City city, FileData file_data,
+                                 int thread_count, int chunk_count);
 
 City geo_handler_create_city_from_file(FileData file_data,
                                        const char *output_path,
-                                       const char *command_suffix) {
+                                       const char *command_suffix,
+                                       int thread_count) {
   City city = city_create();
   if (city == NULL) {
     printf("Error: Failed to create city\n");
     return NULL;
   }
 
-  Queue file_lines = get_file_lines_queue(file_data);
-
-  while (!queue_is_empty(file_lines)) {
-    char *line = (char *)queue_dequeue(file_lines);
-    char *command = strtok(line, " ");
-
-    // Circle command: c i x y r corb corp
-    if (strcmp(command, "c") == 0) {
-      execute_circle_command(city);
-    }
-    // Rectangle command: r i x y w h corb corp
-    else if (strcmp(command, "r") == 0) {
-      execute_rectangle_command(city);
-    }
-    // Line command: l i x1 y1 x2 y2 cor
-    else if (strcmp(command, "l") == 0) {
-      execute_line_command(city);
-    }
-    // Text command: t i x y corb corp a txto
-    else if (strcmp(command, "t") == 0) {
-      execute_text_command(city);
-    }
-    // Text style command: ts fFamily fWeight fSize
-    else if (strcmp(command, "ts") == 0) {
-      execute_text_style_command(city);
-    } else {
-      printf("Unknown command: %s\n", command);
+  // Indexed files big enough are parsed in chunks on worker threads; streams
+  // and small files are parsed line by line
+  int chunk_count = 0;
+  if (thread_count > 1) {
+    chunk_count = file_data_get_line_count(file_data) / MIN_CHUNK_LINES;
+    if (chunk_count > thread_count * CHUNKS_PER_THREAD) {
+      chunk_count = thread_count * CHUNKS_PER_THREAD;
     }
   }
+  if (chunk_count < 2 ||
+      !parse_lines_parallel(city, file_data, thread_count, chunk_count)) {
+    parse_lines_serial(city, file_data);
+  }
 
   city_generate_svg(city, output_path, file_data, command_suffix);
 
@@ -68,71 +86,215 @@ City geo_handler_create_city_from_file(FileData file_data,
 * Private functions
 **************************
 */
-static void execute_circle_command(City city) {
-  char *identifier = strtok(NULL, " ");
-  char *pos_x = strtok(NULL, " ");
-  char *pos_y = strtok(NULL, " ");
-  char *radius = strtok(NULL, " ");
-  char *border_color = strtok(NULL, " ");
-  char *fill_color = strtok(NULL, " ");
-
-  Shape shape = circle_create(atoi(identifier), atof(pos_x), atof(pos_y),
-                              atof(radius), border_color, fill_color);
-
-  city_add_shape(city, shape);
+static Shape parse_circle_command(ShapeStore store, Lexer *lexer) {
+  int identifier = 0;
+  double pos_x = 0.0, pos_y = 0.0, radius = 0.0;
+  lexer_next_int(lexer, &identifier);
+  lexer_next_double(lexer, &pos_x);
+  lexer_next_double(lexer, &pos_y);
+  lexer_next_double(lexer, &radius);
+  char *border_color = lexer_next_token(lexer);
+  char *fill_color = lexer_next_token(lexer);
+
+  return circle_create_in(store, identifier, pos_x, pos_y, radius,
+                          border_color, fill_color);
+}
+
+static Shape parse_rectangle_command(ShapeStore store, Lexer *lexer) {
+  int identifier = 0;
+  double pos_x = 0.0, pos_y = 0.0, width = 0.0, height = 0.0;
+  lexer_next_int(lexer, &identifier);
+  lexer_next_double(lexer, &pos_x);
+  lexer_next_double(lexer, &pos_y);
+  lexer_next_double(lexer, &width);
+  lexer_next_double(lexer, &height);
+  char *border_color = lexer_next_token(lexer);
+  char *fill_color = lexer_next_token(lexer);
+
+  return rectangle_create_in(store, identifier, pos_x, pos_y, width, height,
+                             border_color, fill_color);
 }
 
-static void execute_rectangle_command(City city) {
-  char *identifier = strtok(NULL, " ");
-  char *pos_x = strtok(NULL, " ");
-  char *pos_y = strtok(NULL, " ");
-  char *width = strtok(NULL, " ");
-  char *height = strtok(NULL, " ");
-  char *border_color = strtok(NULL, " ");
-  char *fill_color = strtok(NULL, " ");
+static Shape parse_line_command(ShapeStore store, Lexer *lexer) {
+  int identifier = 0;
+  double x1 = 0.0, y1 = 0.0, x2 = 0.0, y2 = 0.0;
+  lexer_next_int(lexer, &identifier);
+  lexer_next_double(lexer, &x1);
+  lexer_next_double(lexer, &y1);
+  lexer_next_double(lexer, &x2);
+  lexer_next_double(lexer, &y2);
+  char *color = lexer_next_token(lexer);
+
+  return line_create_in(store, identifier, x1, y1, x2, y2, color);
+}
+
+static Shape parse_text_command(ShapeStore store, Lexer *lexer) {
+  int identifier = 0;
+  double pos_x = 0.0, pos_y = 0.0;
+  lexer_next_int(lexer, &identifier);
+  lexer_next_double(lexer, &pos_x);
+  lexer_next_double(lexer, &pos_y);
+  char *border_color = lexer_next_token(lexer);
+  char *fill_color = lexer_next_token(lexer);
+  char *anchor = lexer_next_token(lexer);
+  char *text = lexer_rest(lexer);
+
+  return text_create_in(store, identifier, pos_x, pos_y, border_color,
+                        fill_color, *anchor, text);
+}
 
-  Shape shape =
-      rectangle_create(atoi(identifier), atof(pos_x), atof(pos_y), atof(width),
-                       atof(height), border_color, fill_color);
+static Shape parse_text_style_command(ShapeStore store, Lexer *lexer) {
+  int font_size = 0;
+  char *font_family = lexer_next_token(lexer);
+  char *font_weight = lexer_next_token(lexer);
+  lexer_next_int(lexer, &font_size);
 
-  city_add_shape(city, shape);
+  return text_style_create_in(store, font_family, *font_weight, font_size);
+}
+static Shape parse_shape_command(ShapeStore store, LexerCommand command,
+                                 Lexer *lexer) {
+  switch (command) {
+  // Circle command: c i x y r corb corp
+  case LEXER_COMMAND_CIRCLE:
+    return parse_circle_command(store, lexer);
+  // Rectangle command: r i x y w h corb corp
+  case LEXER_COMMAND_RECTANGLE:
+    return parse_rectangle_command(store, lexer);
+  // Line command: l i x1 y1 x2 y2 cor
+  case LEXER_COMMAND_LINE:
+    return parse_line_command(store, lexer);
+  // Text command: t i x y corb corp a txto
+  case LEXER_COMMAND_TEXT:
+    return parse_text_command(store, lexer);
+  // Text style command: ts fFamily fWeight fSize
+  case LEXER_COMMAND_TEXT_STYLE:
+    return parse_text_style_command(store, lexer);
+  default:
+    return NULL;
+  }
 }
 
-static void execute_line_command(City city) {
-  char *identifier = strtok(NULL, " ");
-  char *x1 = strtok(NULL, " ");
-  char *y1 = strtok(NULL, " ");
-  char *x2 = strtok(NULL, " ");
-  char *y2 = strtok(NULL, " ");
-  char *color = strtok(NULL, " ");
+// Tells whether a command describes a shape of the .geo language
+static bool is_shape_command(LexerCommand command) {
+  return command == LEXER_COMMAND_CIRCLE ||
+         command == LEXER_COMMAND_RECTANGLE || command == LEXER_COMMAND_LINE ||
+         command == LEXER_COMMAND_TEXT || command == LEXER_COMMAND_TEXT_STYLE;
+}
 
-  Shape shape = line_create(atoi(identifier), atof(x1), atof(y1), atof(x2),
-                            atof(y2), color);
+// Adds the shape of one line to the city, or reports the line's command if
+// it is not a shape. Lines with no command are skipped.
+static void add_line_shape(City city, LexerCommand command, Lexer *lexer,
+                           Shape shape) {
+  if (is_shape_command(command)) {
+    city_add_shape(city, shape);
+  } else if (command != LEXER_COMMAND_NONE) {
+    printf("Unknown command: %.*s\n", lexer_token_length(lexer),
+           lexer_token(lexer));
+  }
+}
 
-  city_add_shape(city, shape);
+// Makes room in the scratch buffer for the tokens of a line. Returns NULL if
+// the buffer could not grow.
+static char *reserve_scratch(Scratch *scratch, int length) {
+  if (length + 1 > scratch->capacity) {
+    int capacity = scratch->capacity == 0 ? 256 : scratch->capacity;
+    while (capacity < length + 1) {
+      capacity *= 2;
+    }
+    char *bytes = realloc(scratch->bytes, (size_t)capacity);
+    if (bytes == NULL) {
+      printf("Error: Failed to allocate memory for a .geo line\n");
+      return NULL;
+    }
+    scratch->bytes = bytes;
+    scratch->capacity = capacity;
+  }
+  return scratch->bytes;
 }
 
-static void execute_text_command(City city) {
-  char *identifier = strtok(NULL, " ");
-  char *pos_x = strtok(NULL, " ");
-  char *pos_y = strtok(NULL, " ");
-  char *border_color = strtok(NULL, " ");
-  char *fill_color = strtok(NULL, " ");
-  char *anchor = strtok(NULL, " ");
-  char *text = strtok(NULL, "");
+// Parses every line in serial, in file order
+static void parse_lines_serial(City city, FileData file_data) {
+  Scratch scratch = {NULL, 0};
+  const char *line;
+  int length = 0;
+  while ((line = file_data_next_line_view(file_data, &length)) != NULL) {
+    char *bytes = reserve_scratch(&scratch, length);
+    if (bytes == NULL) {
+      continue;
+    }
+    Lexer lexer;
+    lexer_init_view(&lexer, line, length, bytes);
+    LexerCommand command = lexer_next_command(&lexer);
+    add_line_shape(city, command, &lexer,
+                   parse_shape_command(city_get_shape_store(city), command,
+                                       &lexer));
+  }
+  free(scratch.bytes);
+}
 
-  Shape shape = text_create(atoi(identifier), atof(pos_x), atof(pos_y),
-                            border_color, fill_color, *anchor, text);
+// Parses the lines of one chunk into their slots. Each chunk allocates from
+// its own child of the city's store, so workers never wait on one another's
+// allocations and string lookups.
+static void parse_chunk(int task_index, void *user_data) {
+  ChunkedParse *parse = (ChunkedParse *)user_data;
+  int start = (int)((long)parse->line_count * task_index / parse->chunk_count);
+  int end =
+      (int)((long)parse->line_count * (task_index + 1) / parse->chunk_count);
+  ShapeStore store = shape_store_create_child(parse->store);
+  if (store == NULL) {
+    store = parse->store;
+  }
 
-  city_add_shape(city, shape);
+  Scratch scratch = {NULL, 0};
+  for (int i = start; i < end; i++) {
+    int length = 0;
+    const char *line = file_data_get_line_view(parse->file_data, i, &length);
+    char *bytes = reserve_scratch(&scratch, length);
+    if (bytes == NULL) {
+      parse->shapes[i] = NULL;
+      continue;
+    }
+    Lexer lexer;
+    lexer_init_view(&lexer, line, length, bytes);
+    LexerCommand command = lexer_next_command(&lexer);
+    parse->shapes[i] = parse_shape_command(store, command, &lexer);
+  }
+  free(scratch.bytes);
 }
 
-static void execute_text_style_command(City city) {
-  char *font_family = strtok(NULL, " ");
-  char *font_weight = strtok(NULL, " ");
-  char *font_size = strtok(NULL, " ");
+// Parses the lines in chunks on a worker pool, then adds the shapes to the
+// city in file order. Returns false, without touching the city, if the
+// chunks could not be set up.
+static bool parse_lines_parallel(City city, FileData file_data,
+                                 int thread_count, int chunk_count) {
+  ChunkedParse parse;
+  parse.file_data = file_data;
+  parse.store = city_get_shape_store(city);
+  parse.line_count = file_data_get_line_count(file_data);
+  parse.chunk_count = chunk_count;
+  parse.shapes = malloc(parse.line_count * sizeof(Shape));
+  if (parse.shapes == NULL) {
+    return false;
+  }
 
-  Shape shape = text_style_create(font_family, *font_weight, atoi(font_size));
+  ThreadPool pool = thread_pool_create(thread_count);
+  if (pool == NULL) {
+    free(parse.shapes);
+    return false;
+  }
+  thread_pool_run(pool, chunk_count, parse_chunk, &parse);
+  thread_pool_destroy(pool);
 
-  city_add_shape(city, shape);
-}
\ No newline at end of file
+  // Only the command names are read again, so no scratch buffer is needed
+  for (int i = 0; i < parse.line_count; i++) {
+    int length = 0;
+    const char *line = file_data_get_line_view(file_data, i, &length);
+    Lexer lexer;
+    lexer_init_view(&lexer, line, length, NULL);
+    LexerCommand command = lexer_next_command(&lexer);
+    add_line_shape(city, command, &lexer, parse.shapes[i]);
+  }
+
+  free(parse.shapes);
+  return true;
+}
@@ -17,10 +17,13 @@
  * @param file_data File data containing .geo file lines
  * @param output_path Path to the output directory
  * @param command_suffix Command suffix to add to the output file name
+ * @param thread_count Worker threads used to parse large indexed files in
+ * chunks; shapes are still added in file order (1 parses serially)
  * @return City instance with all shapes or NULL on error
  */
 City geo_handler_create_city_from_file(FileData file_data,
                                        const char *output_path,
-                                       const char *command_suffix);
+                                       const char *command_suffix,
+                                       int thread_count);
 
 #endif // GEO_HANDLER_H
\ No newline at end of file
@@ -0,0 +1,235 @@
+/**
+ * @file lexer.bench.c
+ * @brief Parse throughput of the lexer against strtok/atof
+ *
+ * Parses the same synthetic .geo/.qry lines with the strtok + strcmp + atof
+ * path the handlers used before and with the lexer, and reports the time of
+ * each. Both paths must produce the same checksum, or the benchmark fails.
+ */
+
+#include "./lexer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LINE_COUNT 200000
+#define ROUND_COUNT 10
+#define MAX_LINE_LENGTH 96
+
+// Lines stored back to back, each terminated by NUL
+typedef struct {
+  char *bytes;
+  size_t size;
+  int count;
+} LineBlock;
+
+// ============================================================================
+// Input Generation
+// ============================================================================
+
+// Random coordinate with up to two decimals, like the course inputs
+static double random_coordinate(void) {
+  return (double)(rand() % 100000) / 100.0;
+}
+
+// Writes one random command line and returns its length
+static int write_random_line(char *out, int id) {
+  switch (rand() % 8) {
+  case 0:
+    return snprintf(out, MAX_LINE_LENGTH, "c %d %.2f %.2f %.2f #ff0000 #00ff00",
+                    id, random_coordinate(), random_coordinate(),
+                    random_coordinate() / 10.0);
+  case 1:
+    return snprintf(out, MAX_LINE_LENGTH, "r %d %.2f %.2f %.2f %.2f red blue",
+                    id, random_coordinate(), random_coordinate(),
+                    random_coordinate() / 10.0, random_coordinate() / 10.0);
+  case 2:
+    return snprintf(out, MAX_LINE_LENGTH, "l %d %.2f %.2f %.2f %.2f black", id,
+                    random_coordinate(), random_coordinate(),
+                    random_coordinate(), random_coordinate());
+  case 3:
+    return snprintf(out, MAX_LINE_LENGTH, "t %d %.2f %.2f black white m Rua %d",
+                    id, random_coordinate(), random_coordinate(), id);
+  case 4:
+    return snprintf(out, MAX_LINE_LENGTH, "ts sans n %d", 8 + id % 10);
+  case 5:
+    return snprintf(out, MAX_LINE_LENGTH, "d %.2f %.2f -", random_coordinate(),
+                    random_coordinate());
+  case 6:
+    return snprintf(out, MAX_LINE_LENGTH, "p %.2f %.2f yellow sfx",
+                    random_coordinate(), random_coordinate());
+  default:
+    return snprintf(out, MAX_LINE_LENGTH, "cln %.2f %.2f %.2f %.2f -",
+                    random_coordinate(), random_coordinate(),
+                    random_coordinate() / 10.0, random_coordinate() / 10.0);
+  }
+}
+
+static bool build_lines(LineBlock *block) {
+  block->bytes = malloc((size_t)LINE_COUNT * MAX_LINE_LENGTH);
+  if (block->bytes == NULL) {
+    printf("Error: Failed to allocate memory for benchmark lines\n");
+    return false;
+  }
+
+  srand(7);
+  block->size = 0;
+  block->count = LINE_COUNT;
+  for (int i = 0; i < LINE_COUNT; i++) {
+    int length = write_random_line(block->bytes + block->size, i);
+    block->size += (size_t)length + 1;
+  }
+  return true;
+}
+
+// ============================================================================
+// Parsers
+// ============================================================================
+
+// The handlers' previous path: strtok, a strcmp chain and atof/atoi
+static double parse_with_strtok(char *bytes, int count) {
+  double checksum = 0.0;
+  char *line = bytes;
+
+  for (int i = 0; i < count; i++) {
+    char *next = line + strlen(line) + 1;
+    char *command = strtok(line, " ");
+    int numbers = 0;
+    if (strcmp(command, "c") == 0 || strcmp(command, "r") == 0 ||
+        strcmp(command, "l") == 0 || strcmp(command, "t") == 0) {
+      checksum += atoi(strtok(NULL, " "));
+      numbers = strcmp(command, "c") == 0   ? 3
+                : strcmp(command, "t") == 0 ? 2
+                                            : 4;
+    } else if (strcmp(command, "ts") == 0) {
+      strtok(NULL, " ");
+      strtok(NULL, " ");
+      checksum += atoi(strtok(NULL, " "));
+    } else if (strcmp(command, "d") == 0 || strcmp(command, "p") == 0) {
+      numbers = 2;
+    } else if (strcmp(command, "cln") == 0) {
+      numbers = 4;
+    }
+    for (int k = 0; k < numbers; k++) {
+      checksum += atof(strtok(NULL, " "));
+    }
+    line = next;
+  }
+
+  return checksum;
+}
+
+// The same work through the lexer
+static double parse_with_lexer(char *bytes, int count) {
+  double checksum = 0.0;
+  char *line = bytes;
+
+  for (int i = 0; i < count; i++) {
+    char *next = line + strlen(line) + 1;
+    Lexer lexer;
+    lexer_init(&lexer, line);
+    int numbers = 0;
+    int id = 0;
+    double value = 0.0;
+    switch (lexer_next_command(&lexer)) {
+    case LEXER_COMMAND_CIRCLE:
+      numbers = 3;
+      lexer_next_int(&lexer, &id);
+      checksum += id;
+      break;
+    case LEXER_COMMAND_TEXT:
+      numbers = 2;
+      lexer_next_int(&lexer, &id);
+      checksum += id;
+      break;
+    case LEXER_COMMAND_RECTANGLE:
+    case LEXER_COMMAND_LINE:
+      numbers = 4;
+      lexer_next_int(&lexer, &id);
+      checksum += id;
+      break;
+    case LEXER_COMMAND_TEXT_STYLE:
+      lexer_next_token(&lexer);
+      lexer_next_token(&lexer);
+      lexer_next_int(&lexer, &id);
+      checksum += id;
+      break;
+    case LEXER_COMMAND_DESTRUCTION:
+    case LEXER_COMMAND_PAINTING:
+      numbers = 2;
+      break;
+    case LEXER_COMMAND_CLONING:
+      numbers = 4;
+      break;
+    default:
+      break;
+    }
+    for (int k = 0; k < numbers; k++) {
+      lexer_next_double(&lexer, &value);
+      checksum += value;
+    }
+    line = next;
+  }
+
+  return checksum;
+}
+
+// Runs a parser over fresh copies of the lines and returns the seconds taken
+static double time_parser(double (*parse)(char *, int), const LineBlock *block,
+                          char *work, double *checksum) {
+  clock_t total = 0;
+  for (int round = 0; round < ROUND_COUNT; round++) {
+    memcpy(work, block->bytes, block->size);
+    clock_t start = clock();
+    *checksum = parse(work, block->count);
+    total += clock() - start;
+  }
+  return (double)total / CLOCKS_PER_SEC;
+}
+
+// ============================================================================
+// Main Benchmark Runner
+// ============================================================================
+
+int main(void) {
+  LineBlock block;
+  if (!build_lines(&block)) {
+    return 1;
+  }
+  char *work = malloc(block.size);
+  if (work == NULL) {
+    printf("Error: Failed to allocate memory for benchmark lines\n");
+    free(block.bytes);
+    return 1;
+  }
+
+  double strtok_checksum = 0.0;
+  double lexer_checksum = 0.0;
+  double strtok_seconds =
+      time_parser(parse_with_strtok, &block, work, &strtok_checksum);
+  double lexer_seconds =
+      time_parser(parse_with_lexer, &block, work, &lexer_checksum);
+
+  double lines = (double)LINE_COUNT * ROUND_COUNT;
+  double megabytes = (double)block.size * ROUND_COUNT / (1024.0 * 1024.0);
+  printf("Parsed %d lines x %d rounds (%.1f MB)\n", LINE_COUNT, ROUND_COUNT,
+         megabytes);
+  printf("  strtok/atof: %8.3f s  %8.2f Mlines/s  %8.1f MB/s\n",
+         strtok_seconds, lines / strtok_seconds / 1e6,
+         megabytes / strtok_seconds);
+  printf("  lexer:       %8.3f s  %8.2f Mlines/s  %8.1f MB/s\n", lexer_seconds,
+         lines / lexer_seconds / 1e6, megabytes / lexer_seconds);
+  printf("  speedup:     %8.2fx\n", strtok_seconds / lexer_seconds);
+
+  free(work);
+  free(block.bytes);
+
+  if (strtok_checksum != lexer_checksum) {
+    printf("Error: checksums differ (%.6f vs %.6f)\n", strtok_checksum,
+           lexer_checksum);
+    return 1;
+  }
+  return 0;
+}
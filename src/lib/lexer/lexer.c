@@ -0,0 +1,254 @@
+#include "lexer.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Largest mantissa a double holds exactly
+#define MAX_EXACT_MANTISSA (1ULL << 53)
+
+// Powers of ten a double holds exactly
+#define MAX_EXACT_POWER 22
+static const double POWERS_OF_TEN[MAX_EXACT_POWER + 1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+/**
+ * Finds the next space-delimited token and moves the cursor past it and the
+ * delimiter that ends it. Returns false if the line has no token left.
+ */
+static bool scan_token(Lexer *lexer) {
+  char *p = lexer->cursor;
+  while (p < lexer->end && *p == ' ') {
+    p++;
+  }
+  if (p == lexer->end) {
+    lexer->cursor = p;
+    lexer->token = NULL;
+    lexer->token_length = 0;
+    return false;
+  }
+
+  char *start = p;
+  while (p < lexer->end && *p != ' ') {
+    p++;
+  }
+  lexer->token = start;
+  lexer->token_length = (int)(p - start);
+  lexer->cursor = p < lexer->end ? p + 1 : p;
+  return true;
+}
+
+/**
+ * Copies bytes of a read-only line into the scratch buffer, terminated, and
+ * moves the scratch buffer past them.
+ */
+static char *copy_to_scratch(Lexer *lexer, const char *text, int length) {
+  char *copy = lexer->scratch;
+  memcpy(copy, text, (size_t)length);
+  copy[length] = '\0';
+  lexer->scratch += length + 1;
+  return copy;
+}
+
+/**
+ * Parses a decimal number that ends at end, giving exactly what atof() gives.
+ */
+static double parse_double(const char *text, const char *end) {
+  const char *p = text;
+  bool negative = *p == '-';
+  if (*p == '-' || *p == '+') {
+    p++;
+  }
+
+  // Read [digits][.digits] into an integer mantissa and a count of decimals.
+  // While both fit a double exactly, one division rounds the same way
+  // strtod() does.
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int decimals = 0;
+  bool exact = true;
+  for (; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+    mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+    exact = exact && mantissa <= MAX_EXACT_MANTISSA;
+  }
+  if (p < end && *p == '.') {
+    for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits++, decimals++) {
+      mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+      exact = exact && mantissa <= MAX_EXACT_MANTISSA;
+    }
+  }
+
+  if (!exact || digits == 0 || digits > 19 || decimals > MAX_EXACT_POWER ||
+      p != end) {
+    return strtod(text, NULL);
+  }
+
+  double value = (double)mantissa / POWERS_OF_TEN[decimals];
+  return negative ? -value : value;
+}
+
+/**
+ * Parses an integer that ends at end, giving exactly what atoi() gives for
+ * values that fit in an int.
+ */
+static int parse_int(const char *text, const char *end) {
+  const char *p = text;
+  bool negative = *p == '-';
+  if (*p == '-' || *p == '+') {
+    p++;
+  }
+
+  // Up to nine digits can never overflow an int
+  int value = 0;
+  int digits = 0;
+  for (; p < end && *p >= '0' && *p <= '9' && digits < 9; p++, digits++) {
+    value = value * 10 + (*p - '0');
+  }
+
+  if (digits == 0 || p != end) {
+    return (int)strtol(text, NULL, 10);
+  }
+  return negative ? -value : value;
+}
+
+/**
+ * Finds where a number given as a string ends: at the first space or at its
+ * terminator.
+ */
+static const char *number_end(const char *text) {
+  return text + strcspn(text, " ");
+}
+
+/**
+ * Tells whether a token spells a given word.
+ */
+static bool token_is(const Lexer *lexer, const char *word, int length) {
+  for (int i = 0; i < length; i++) {
+    if (lexer->token[i] != word[i]) {
+      return false;
+    }
+  }
+  return lexer->token_length == length;
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+void lexer_init(Lexer *lexer, char *line) {
+  lexer->cursor = line;
+  lexer->end = line + strlen(line);
+  lexer->token = NULL;
+  lexer->token_length = 0;
+  lexer->scratch = NULL;
+}
+
+void lexer_init_view(Lexer *lexer, const char *line, int length,
+                     char *scratch) {
+  // The cursor is only read through: tokens go to the scratch buffer
+  lexer->cursor = (char *)line;
+  lexer->end = line + length;
+  lexer->token = NULL;
+  lexer->token_length = 0;
+  lexer->scratch = scratch;
+}
+
+LexerCommand lexer_next_command(Lexer *lexer) {
+  if (!scan_token(lexer)) {
+    return LEXER_COMMAND_NONE;
+  }
+
+  // Dispatch on the first byte, then check the length
+  switch (lexer->token[0]) {
+  case 'c':
+    if (lexer->token_length == 1) {
+      return LEXER_COMMAND_CIRCLE;
+    }
+    return token_is(lexer, "cln", 3) ? LEXER_COMMAND_CLONING
+                                     : LEXER_COMMAND_UNKNOWN;
+  case 'r':
+    return lexer->token_length == 1 ? LEXER_COMMAND_RECTANGLE
+                                    : LEXER_COMMAND_UNKNOWN;
+  case 'l':
+    return lexer->token_length == 1 ? LEXER_COMMAND_LINE
+                                    : LEXER_COMMAND_UNKNOWN;
+  case 't':
+    if (lexer->token_length == 1) {
+      return LEXER_COMMAND_TEXT;
+    }
+    return token_is(lexer, "ts", 2) ? LEXER_COMMAND_TEXT_STYLE
+                                    : LEXER_COMMAND_UNKNOWN;
+  case 'a':
+    return lexer->token_length == 1 ? LEXER_COMMAND_ANTEPARO
+                                    : LEXER_COMMAND_UNKNOWN;
+  case 'd':
+    return lexer->token_length == 1 ? LEXER_COMMAND_DESTRUCTION
+                                    : LEXER_COMMAND_UNKNOWN;
+  case 'p':
+    return lexer->token_length == 1 ? LEXER_COMMAND_PAINTING
+                                    : LEXER_COMMAND_UNKNOWN;
+  default:
+    return LEXER_COMMAND_UNKNOWN;
+  }
+}
+
+char *lexer_next_token(Lexer *lexer) {
+  if (!scan_token(lexer)) {
+    return NULL;
+  }
+
+  if (lexer->scratch != NULL) {
+    return copy_to_scratch(lexer, lexer->token, lexer->token_length);
+  }
+  char *token = (char *)lexer->token;
+  token[lexer->token_length] = '\0';
+  return token;
+}
+
+bool lexer_next_double(Lexer *lexer, double *value) {
+  if (!scan_token(lexer)) {
+    return false;
+  }
+
+  *value = parse_double(lexer->token, lexer->token + lexer->token_length);
+  return true;
+}
+
+bool lexer_next_int(Lexer *lexer, int *value) {
+  if (!scan_token(lexer)) {
+    return false;
+  }
+
+  *value = parse_int(lexer->token, lexer->token + lexer->token_length);
+  return true;
+}
+
+char *lexer_rest(Lexer *lexer) {
+  if (lexer->cursor == lexer->end) {
+    return NULL;
+  }
+
+  char *rest = lexer->cursor;
+  int length = (int)(lexer->end - rest);
+  lexer->cursor += length;
+  if (lexer->scratch != NULL) {
+    return copy_to_scratch(lexer, rest, length);
+  }
+  return rest;
+}
+
+const char *lexer_token(const Lexer *lexer) { return lexer->token; }
+
+int lexer_token_length(const Lexer *lexer) { return lexer->token_length; }
+
+double lexer_parse_double(const char *text) {
+  return parse_double(text, number_end(text));
+}
+
+int lexer_parse_int(const char *text) {
+  return parse_int(text, number_end(text));
+}
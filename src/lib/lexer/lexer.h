@@ -0,0 +1,162 @@
+/**
+ * @file lexer.h
+ * @brief Reentrant tokenizer for .geo and .qry command lines
+ *
+ * Splits a command line on spaces the same way strtok(line, " ") does, but
+ * keeps its position in a caller-owned Lexer instead of hidden global state,
+ * so several lines can be lexed at once from different threads. Nothing is
+ * allocated: tokens are read in place, and numbers are parsed straight from
+ * the line with a fast path for plain decimals.
+ *
+ * Read-only lines (e.g. views into a mapped file) are lexed with
+ * lexer_init_view(): they are never written to, and only the tokens taken as
+ * strings are copied, terminated, into a scratch buffer of the caller.
+ */
+
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <stdbool.h>
+
+/**
+ * @brief Commands of the .geo and .qry languages
+ */
+typedef enum {
+  LEXER_COMMAND_NONE,        /**< Blank line */
+  LEXER_COMMAND_UNKNOWN,     /**< Anything not listed below */
+  LEXER_COMMAND_CIRCLE,      /**< c */
+  LEXER_COMMAND_RECTANGLE,   /**< r */
+  LEXER_COMMAND_LINE,        /**< l */
+  LEXER_COMMAND_TEXT,        /**< t */
+  LEXER_COMMAND_TEXT_STYLE,  /**< ts */
+  LEXER_COMMAND_ANTEPARO,    /**< a */
+  LEXER_COMMAND_DESTRUCTION, /**< d */
+  LEXER_COMMAND_PAINTING,    /**< p */
+  LEXER_COMMAND_CLONING      /**< cln */
+} LexerCommand;
+
+/**
+ * @brief Position of a lexer inside a line
+ *
+ * Declared here so it can live on the stack; use the functions below rather
+ * than the fields.
+ */
+typedef struct {
+  char *cursor;      // First character not consumed yet
+  const char *end;   // End of the line
+  const char *token; // Start of the last token read (NULL if none)
+  int token_length;  // Length of the last token read
+  char *scratch;     // Where string tokens are copied, or NULL to terminate
+                     // them in place
+} Lexer;
+
+/**
+ * @brief Starts lexing a line
+ * @param lexer Lexer to initialize
+ * @param line Line to read; only lexer_next_token() writes to it
+ */
+void lexer_init(Lexer *lexer, char *line);
+
+/**
+ * @brief Starts lexing a read-only line of known length
+ *
+ * The line is never written to. The byte right after it must be readable
+ * and cannot continue a number (a newline or a terminator), since numbers
+ * are parsed straight from the line.
+ * @param lexer Lexer to initialize
+ * @param line Start of the line, not necessarily terminated
+ * @param length Length of the line in bytes
+ * @param scratch Buffer of at least length + 1 bytes that receives the
+ * tokens read by lexer_next_token() and lexer_rest(); may be NULL only if
+ * neither is called
+ */
+void lexer_init_view(Lexer *lexer, const char *line, int length,
+                     char *scratch);
+
+/**
+ * @brief Reads the next token as a command name
+ *
+ * The line is not modified. The name itself stays available through
+ * lexer_token() / lexer_token_length().
+ * @param lexer Lexer instance
+ * @return The command, or LEXER_COMMAND_NONE if no token is left
+ */
+LexerCommand lexer_next_command(Lexer *lexer);
+
+/**
+ * @brief Reads the next token as a string
+ *
+ * Terminates the token in place, like strtok() does, or for read-only lines
+ * returns a terminated copy in the scratch buffer.
+ * @param lexer Lexer instance
+ * @return The token, or NULL if no token is left
+ */
+char *lexer_next_token(Lexer *lexer);
+
+/**
+ * @brief Reads the next token as a double, like atof() would
+ *
+ * The line is not modified.
+ * @param lexer Lexer instance
+ * @param value Receives the number (0.0 if the token is not a number)
+ * @return false only if no token is left
+ */
+bool lexer_next_double(Lexer *lexer, double *value);
+
+/**
+ * @brief Reads the next token as an int, like atoi() would
+ *
+ * The line is not modified.
+ * @param lexer Lexer instance
+ * @param value Receives the number (0 if the token is not a number)
+ * @return false only if no token is left
+ */
+bool lexer_next_int(Lexer *lexer, int *value);
+
+/**
+ * @brief Takes the rest of the line, like strtok(NULL, "") does
+ *
+ * Starts right after the delimiter that ended the last token, so extra
+ * spaces are kept. For read-only lines the rest is copied into the scratch
+ * buffer.
+ * @param lexer Lexer instance
+ * @return The rest of the line, or NULL if nothing is left
+ */
+char *lexer_rest(Lexer *lexer);
+
+/**
+ * @brief Gets the last token read, which is not terminated unless it was
+ * read with lexer_next_token()
+ * @param lexer Lexer instance
+ * @return Start of the token, or NULL if the last read found no token
+ */
+const char *lexer_token(const Lexer *lexer);
+
+/**
+ * @brief Gets the length of the last token read
+ * @param lexer Lexer instance
+ * @return Length in bytes (0 if the last read found no token)
+ */
+int lexer_token_length(const Lexer *lexer);
+
+/**
+ * @brief Parses a decimal number, giving exactly what atof() gives
+ *
+ * Plain decimals whose digits fit in 53 bits (about 15 digits) and that have at
+ * most 22 decimals are converted with a single exact division; anything else
+ * (exponents, long mantissas, inf/nan) goes through strtod().
+ * Parsing stops at the first space.
+ * @param text Number to parse
+ * @return The parsed value
+ */
+double lexer_parse_double(const char *text);
+
+/**
+ * @brief Parses an integer, giving exactly what atoi() gives for values that
+ * fit in an int
+ * @param text Number to parse
+ * @return The parsed value
+ */
+int lexer_parse_int(const char *text);
+
+#endif // LEXER_H
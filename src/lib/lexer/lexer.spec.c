@@ -0,0 +1,286 @@
+/**
+ * @file lexer.spec.c
+ * @brief Unit tests for lexer module
+ *
+ * Unit tests for the command lexer functions defined in lexer.h
+ */
+
+#include "./lexer.h"
+#include "../test_framework/test_framework.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RANDOM_NUMBER_COUNT 20000
+
+// ============================================================================
+// Tests for lexer_next_command()
+// ============================================================================
+
+/**
+ * Test: every command name should be recognized
+ */
+bool test_lexer_next_command_known(void) {
+  const char *names[] = {"c", "r", "l", "t", "ts", "a", "d", "p", "cln"};
+  const LexerCommand commands[] = {
+      LEXER_COMMAND_CIRCLE,     LEXER_COMMAND_RECTANGLE,
+      LEXER_COMMAND_LINE,       LEXER_COMMAND_TEXT,
+      LEXER_COMMAND_TEXT_STYLE, LEXER_COMMAND_ANTEPARO,
+      LEXER_COMMAND_DESTRUCTION, LEXER_COMMAND_PAINTING,
+      LEXER_COMMAND_CLONING};
+  char line[16];
+
+  for (int i = 0; i < 9; i++) {
+    snprintf(line, sizeof(line), "%s 1 2", names[i]);
+    Lexer lexer;
+    lexer_init(&lexer, line);
+    ASSERT_EQUAL(lexer_next_command(&lexer), commands[i]);
+    ASSERT_EQUAL(lexer_token_length(&lexer), (int)strlen(names[i]));
+  }
+
+  return true;
+}
+
+/**
+ * Test: unknown names and blank lines should be told apart
+ */
+bool test_lexer_next_command_unknown_and_blank(void) {
+  const char *unknown[] = {"x", "cl", "clnn", "tss", "dd", "C", "r2"};
+  char line[16];
+
+  for (int i = 0; i < 7; i++) {
+    snprintf(line, sizeof(line), "%s 1", unknown[i]);
+    Lexer lexer;
+    lexer_init(&lexer, line);
+    ASSERT_EQUAL(lexer_next_command(&lexer), LEXER_COMMAND_UNKNOWN);
+    ASSERT_EQUAL(lexer_token_length(&lexer), (int)strlen(unknown[i]));
+    ASSERT_TRUE(strncmp(lexer_token(&lexer), unknown[i],
+                        strlen(unknown[i])) == 0);
+  }
+
+  char blank[] = "   ";
+  Lexer lexer;
+  lexer_init(&lexer, blank);
+  ASSERT_EQUAL(lexer_next_command(&lexer), LEXER_COMMAND_NONE);
+  ASSERT_NULL(lexer_token(&lexer));
+
+  return true;
+}
+
+// ============================================================================
+// Tests for lexer_next_token() / lexer_rest()
+// ============================================================================
+
+/**
+ * Test: tokens should match strtok on the same line, rest included
+ */
+bool test_lexer_matches_strtok(void) {
+  const char *lines[] = {"t 5 10 20 black white m Hello  world ",
+                         "  c   1 2.5  3 4 red blue",
+                         "ts sans n 12",
+                         "a 1 9",
+                         "d 1 2 ",
+                         "x",
+                         ""};
+
+  for (int i = 0; i < 7; i++) {
+    char expected[64];
+    char actual[64];
+    strcpy(expected, lines[i]);
+    strcpy(actual, lines[i]);
+
+    Lexer lexer;
+    lexer_init(&lexer, actual);
+    char *want = strtok(expected, " ");
+    char *got = lexer_next_token(&lexer);
+    for (int k = 0; k < 4; k++) {
+      ASSERT_EQUAL(want == NULL, got == NULL);
+      if (want != NULL) {
+        ASSERT_STR_EQUAL(got, want);
+      }
+      want = strtok(NULL, " ");
+      got = lexer_next_token(&lexer);
+    }
+
+    want = strtok(NULL, "");
+    got = lexer_rest(&lexer);
+    ASSERT_EQUAL(want == NULL, got == NULL);
+    if (want != NULL) {
+      ASSERT_STR_EQUAL(got, want);
+    }
+    ASSERT_NULL(lexer_rest(&lexer));
+    ASSERT_NULL(lexer_next_token(&lexer));
+  }
+
+  return true;
+}
+
+/**
+ * Test: numbers should be read in place and leave the line untouched
+ */
+bool test_lexer_next_number(void) {
+  char line[] = "r 17 -3.25 +8 1e2 abc";
+  Lexer lexer;
+  lexer_init(&lexer, line);
+
+  int id = -1;
+  double x = 0.0, y = 0.0, w = 0.0, junk = 1.0;
+  ASSERT_EQUAL(lexer_next_command(&lexer), LEXER_COMMAND_RECTANGLE);
+  ASSERT_TRUE(lexer_next_int(&lexer, &id));
+  ASSERT_TRUE(lexer_next_double(&lexer, &x));
+  ASSERT_TRUE(lexer_next_double(&lexer, &y));
+  ASSERT_TRUE(lexer_next_double(&lexer, &w));
+  ASSERT_TRUE(lexer_next_double(&lexer, &junk));
+  ASSERT_FALSE(lexer_next_double(&lexer, &junk));
+  ASSERT_FALSE(lexer_next_int(&lexer, &id));
+
+  ASSERT_EQUAL(id, 17);
+  ASSERT_EQUAL(x, -3.25);
+  ASSERT_EQUAL(y, 8.0);
+  ASSERT_EQUAL(w, 100.0);
+  ASSERT_EQUAL(junk, 0.0);
+  ASSERT_STR_EQUAL(line, "r 17 -3.25 +8 1e2 abc");
+
+  return true;
+}
+
+/**
+ * Test: read-only lines should lex like terminated ones without being written
+ */
+bool test_lexer_view_matches_line(void) {
+  // Two lines back to back, as in a mapped file, in read-only memory
+  static const char text[] =
+      "t 5 10 20.5 black white m Hello  world\nts sans n 12\n";
+  const char *second = strchr(text, '\n') + 1;
+  char scratch[sizeof(text)];
+
+  Lexer lexer;
+  lexer_init_view(&lexer, text, (int)(second - 1 - text), scratch);
+  int id = 0;
+  double x = 0.0, y = 0.0;
+  ASSERT_EQUAL(lexer_next_command(&lexer), LEXER_COMMAND_TEXT);
+  ASSERT_TRUE(lexer_next_int(&lexer, &id));
+  ASSERT_TRUE(lexer_next_double(&lexer, &x));
+  ASSERT_TRUE(lexer_next_double(&lexer, &y));
+  char *border = lexer_next_token(&lexer);
+  char *fill = lexer_next_token(&lexer);
+  char *anchor = lexer_next_token(&lexer);
+  char *rest = lexer_rest(&lexer);
+  ASSERT_EQUAL(id, 5);
+  ASSERT_EQUAL(x, 10.0);
+  ASSERT_EQUAL(y, 20.5);
+  ASSERT_STR_EQUAL(border, "black");
+  ASSERT_STR_EQUAL(fill, "white");
+  ASSERT_STR_EQUAL(anchor, "m");
+  ASSERT_STR_EQUAL(rest, "Hello  world");
+  ASSERT_NULL(lexer_rest(&lexer));
+
+  // The last number of a line ends at the line, not at its newline
+  int size = 0;
+  lexer_init_view(&lexer, second, (int)strlen(second) - 1, scratch);
+  ASSERT_EQUAL(lexer_next_command(&lexer), LEXER_COMMAND_TEXT_STYLE);
+  char *family = lexer_next_token(&lexer);
+  char *weight = lexer_next_token(&lexer);
+  ASSERT_TRUE(lexer_next_int(&lexer, &size));
+  ASSERT_FALSE(lexer_next_int(&lexer, &size));
+  ASSERT_STR_EQUAL(family, "sans");
+  ASSERT_STR_EQUAL(weight, "n");
+  ASSERT_EQUAL(size, 12);
+
+  return true;
+}
+
+// ============================================================================
+// Tests for lexer_parse_double() / lexer_parse_int()
+// ============================================================================
+
+/**
+ * Test: unusual numbers should parse exactly like atof and atoi
+ */
+bool test_lexer_parse_edge_cases(void) {
+  const char *numbers[] = {"0",
+                           "-0",
+                           "-0.0",
+                           ".5",
+                           "5.",
+                           "-",
+                           ".",
+                           "0.1",
+                           "123456789012345678",
+                           "9007199254740993",
+                           "0.30000000000000004",
+                           "1.00000000000000000000000001",
+                           "2.5e-3",
+                           "inf",
+                           "nan",
+                           "0x1p3",
+                           "12abc",
+                           "2147483647",
+                           "-2147483648",
+                           "000000000042",
+                           "  7"};
+
+  for (int i = 0; i < 21; i++) {
+    double expected = atof(numbers[i]);
+    double actual = lexer_parse_double(numbers[i]);
+    if (expected != expected) {
+      ASSERT_TRUE(actual != actual);
+    } else {
+      ASSERT_EQUAL(memcmp(&expected, &actual, sizeof(double)), 0);
+    }
+    ASSERT_EQUAL(lexer_parse_int(numbers[i]), atoi(numbers[i]));
+  }
+
+  return true;
+}
+
+/**
+ * Test: random decimals should parse bit-for-bit like atof
+ */
+bool test_lexer_parse_double_random(void) {
+  srand(42);
+  char text[48];
+
+  for (int i = 0; i < RANDOM_NUMBER_COUNT; i++) {
+    int decimals = rand() % 8;
+    double magnitude = (double)rand() / RAND_MAX * (rand() % 2 ? 1e6 : 10.0);
+    snprintf(text, sizeof(text), "%s%.*f", rand() % 2 ? "-" : "", decimals,
+             magnitude);
+
+    double expected = atof(text);
+    double actual = lexer_parse_double(text);
+    ASSERT_EQUAL(memcmp(&expected, &actual, sizeof(double)), 0);
+  }
+
+  return true;
+}
+
+// ============================================================================
+// Main Test Runner
+// ============================================================================
+
+int main(void) {
+  test_framework_init();
+
+  test_print_section("Testing lexer_next_command()");
+  test_register("test_lexer_next_command_known", test_lexer_next_command_known);
+  test_register("test_lexer_next_command_unknown_and_blank",
+                test_lexer_next_command_unknown_and_blank);
+
+  test_print_section("Testing lexer_next_token() / lexer_rest()");
+  test_register("test_lexer_matches_strtok", test_lexer_matches_strtok);
+  test_register("test_lexer_next_number", test_lexer_next_number);
+  test_register("test_lexer_view_matches_line", test_lexer_view_matches_line);
+
+  test_print_section("Testing lexer_parse_double() / lexer_parse_int()");
+  test_register("test_lexer_parse_edge_cases", test_lexer_parse_edge_cases);
+  test_register("test_lexer_parse_double_random",
+                test_lexer_parse_double_random);
+
+  int result = test_run_all();
+
+  test_framework_cleanup();
+
+  return result;
+}
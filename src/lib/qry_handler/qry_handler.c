@@ -1,15 +1,18 @@
 #include "qry_handler.h"
 #include "../city/city.h"
-#include "../commons/list/list.h"
-#include "../commons/queue/queue.h"
+#include "../commons/sequence/sequence.h"
+#include "../commons/thread_pool/thread_pool.h"
 #include "../file_reader/file_reader.h"
+#include "../lexer/lexer.h"
 #include "../shapes/circle/circle.h"
 #include "../shapes/line/line.h"
 #include "../shapes/rectangle/rectangle.h"
 #include "../shapes/shapes.h"
 #include "../shapes/text/text.h"
+#include "../svg_writer/svg_writer.h"
 #include "../visibility/geometry.h"
 #include "../visibility/visibility.h"
+#include "../visibility/visibility_cache.h"
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -22,27 +25,122 @@ typedef struct {
   double source_y;
 } VisPolygonData;
 
+// Slack added around a visibility polygon bounding box when querying the city,
+// covering the tolerance of the boundary checks
+#define VISIBILITY_QUERY_MARGIN 1e-3
+
+// Margin added around the city bounding box to form the scene of a bomb
+#define BOMB_SCENE_MARGIN 20.0
+
+// Bomb SVGs that may wait for the writer thread before the next one blocks
+#define SVG_QUEUE_CAPACITY 4
+
+// Most consecutive bombs whose polygons are computed ahead in one batch. The
+// batch is read through the look-ahead window of the .qry file.
+#define PREFETCH_BATCH_SIZE FILE_DATA_LOOKAHEAD
+
+// Visibility polygons kept for bombs that repeat an earlier source
+#define VISIBILITY_CACHE_CAPACITY 64
+
+// Polygon edges collected from an edge cursor before the geometry kernels
+// test them together
+#define EDGE_BATCH_SIZE 64
+
+// Bombs whose visibility polygons are computed ahead, in parallel, from the
+// scene and barrier set in effect when the batch was planned. Line
+// first_line + k gets polygon entries[k]; lines whose source was already
+// cached, or repeats an earlier line of the batch, get none.
+typedef struct {
+  int first_line;           // Line of the first bomb in the batch
+  int line_count;           // Consecutive bomb lines the batch covers
+  int count;                // Polygons computed for them
+  unsigned barrier_version; // City barrier version the batch was computed with
+  BarrierSet barriers;      // Barrier set read by the workers
+  double min_x, min_y, max_x, max_y; // Scene read by the workers
+  SortType sort_type;                // Sorting read by the workers
+  int sort_threshold;                // InsertionSort threshold
+  int task_count;                    // Chunks the batch is split into
+  VisibilityWorkspace *workspaces;   // Sweep scratch of each chunk
+  int entries[PREFETCH_BATCH_SIZE];  // Polygon of each line, or -1
+  double xs[PREFETCH_BATCH_SIZE];    // Bomb x coordinates
+  double ys[PREFETCH_BATCH_SIZE];    // Bomb y coordinates
+  double radii[PREFETCH_BATCH_SIZE]; // Bomb radii
+  VisibilityPolygon polygons[PREFETCH_BATCH_SIZE]; // Results, NULL once taken
+} PrefetchBatch;
+
+// State shared by the bombs of a .qry file
+typedef struct {
+  BarrierSet barrier_set;        // Cached barrier set (NULL before first use)
+  unsigned barrier_version;      // City barrier version of barrier_set
+  VisibilityCache cache;         // Polygons of recent bomb sources
+  ThreadPool pool;               // Prefetch workers (NULL when serial)
+  VisibilityWorkspace workspace; // Sweep scratch of the query thread
+  SvgQueue svg_queue;            // Writer of bomb SVGs (NULL when serial)
+  PrefetchBatch batch;           // Current prefetch batch
+  int current_line;              // Line being executed
+} BombState;
+
+// Context for transforming the shapes of an 'a' command
+typedef struct {
+  City city;
+  FILE *txt_output;
+  char orient;
+  Sequence shapes_to_remove;
+  Sequence segments_to_add;
+} AnteparoContext;
+
+// Context for collecting the shapes inside a visibility region
+typedef struct {
+  VisibilityPolygon polygon;
+  Sequence found;
+} RegionQuery;
+
 // Private helper functions
-static void execute_anteparo_command(City city, FILE *txt_output);
-static void execute_destruction_bomb(City city, const char *output_path,
+static void execute_anteparo_command(City city, Lexer *lexer, FILE *txt_output);
+static void transform_to_barrier(int id, Shape shape, void *user_data);
+static void execute_destruction_bomb(City city, Lexer *lexer,
+                                     const char *output_path,
                                      FileData geo_file_data,
                                      FileData qry_file_data, const char *suffix,
                                      FILE *txt_output, SortType sort_type,
                                      int sort_threshold,
-                                     List accumulated_polygons);
-static void execute_painting_bomb(City city, const char *output_path,
+                                     Sequence accumulated_polygons,
+                                     BombState *bomb_state);
+static void execute_painting_bomb(City city, Lexer *lexer,
+                                  const char *output_path,
                                   FileData geo_file_data,
                                   FileData qry_file_data, const char *suffix,
                                   FILE *txt_output, SortType sort_type,
                                   int sort_threshold,
-                                  List accumulated_polygons);
-static void execute_cloning_bomb(City city, const char *output_path,
+                                  Sequence accumulated_polygons,
+                                  BombState *bomb_state);
+static void execute_cloning_bomb(City city, Lexer *lexer,
+                                 const char *output_path,
                                  FileData geo_file_data, FileData qry_file_data,
                                  const char *suffix, FILE *txt_output,
                                  SortType sort_type, int sort_threshold,
-                                 List accumulated_polygons);
+                                 Sequence accumulated_polygons,
+                                 BombState *bomb_state);
 static bool shape_in_visibility_region(Shape shape, VisibilityPolygon polygon);
+static Sequence find_shapes_in_visibility_region(City city,
+                                                 VisibilityPolygon polygon);
 static const char *get_shape_type_name(ShapeType type);
+static BarrierSet get_barrier_set(City city, BombState *state);
+static void get_bomb_key(City city, double x, double y, double radius,
+                         VisibilityCacheKey *key);
+static double next_bomb_radius(Lexer *lexer);
+static void print_bomb_radius(FILE *txt_output, double radius);
+static VisibilityPolygon compute_bomb_polygon(City city, BombState *state,
+                                              double x, double y,
+                                              double radius,
+                                              SortType sort_type,
+                                              int sort_threshold);
+static void prefetch_bomb_polygons(City city, BombState *state,
+                                   FileData qry_file_data, int first_line,
+                                   SortType sort_type, int sort_threshold);
+static void release_prefetch_batch(BombState *state);
+static VisibilityWorkspace *create_workspaces(int count);
+static void destroy_workspaces(VisibilityWorkspace *workspaces, int count);
 
 // Visibility check helpers
 static bool is_segment_visible(double x1, double y1, double x2, double y2,
@@ -51,11 +149,16 @@ static bool is_rectangle_visible(Rectangle rect, VisibilityPolygon polygon);
 static bool is_circle_visible(Circle circle, VisibilityPolygon polygon);
 static bool is_point_in_rect(double px, double py, Rectangle rect);
 
-void qry_handler_process_file(City city, FileData geo_file_data,
+bool qry_handler_process_file(City city, FileData geo_file_data,
                               FileData qry_file_data, const char *output_path,
-                              SortType sort_type, int sort_threshold) {
+                              SortType sort_type, int sort_threshold,
+                              int thread_count, QryStats *stats) {
+  if (stats != NULL) {
+    stats->visibility_cache_hits = 0;
+    stats->visibility_cache_misses = 0;
+  }
   if (!city || !geo_file_data || !qry_file_data || !output_path) {
-    return;
+    return false;
   }
 
   // Create text output file
@@ -74,7 +177,7 @@ void qry_handler_process_file(City city, FileData geo_file_data,
     printf("Error: Memory allocation failed for file names\n");
     free(qry_name); // One might be NULL, but free(NULL) is safe
     free(geo_name);
-    return;
+    return false;
   }
 
   // Remove extensions
@@ -100,7 +203,7 @@ void qry_handler_process_file(City city, FileData geo_file_data,
     printf("Error: Memory allocation failed for path\n");
     free(qry_name);
     free(geo_name);
-    return;
+    return false;
   }
 
   snprintf(txt_path, total_len, "%s/%s-%s.txt", output_path, geo_name,
@@ -113,40 +216,96 @@ void qry_handler_process_file(City city, FileData geo_file_data,
   if (!txt_output) {
     printf("Error: Failed to open text output file: %s\n", txt_path);
     free(txt_path);
-    return;
+    return false;
   }
 
   fprintf(txt_output, "Query Command Results\n");
   fprintf(txt_output, "=====================\n\n");
 
-  // List to accumulate visibility polygons for bombs with suffix "-"
-  List accumulated_polygons = list_create();
+  // Sequence to accumulate visibility polygons for bombs with suffix "-"
+  Sequence accumulated_polygons = sequence_create();
+
+  // Barrier set shared by consecutive bombs, rebuilt after the barriers
+  // change, and polygons shared by bombs with the same source. With more than
+  // one thread, runs of bombs get their polygons computed ahead on a worker
+  // pool.
+  BombState bomb_state;
+  bomb_state.barrier_set = NULL;
+  bomb_state.barrier_version = 0;
+  bomb_state.cache = visibility_cache_create(VISIBILITY_CACHE_CAPACITY);
+  bomb_state.pool = thread_count > 1 ? thread_pool_create(thread_count) : NULL;
+  bomb_state.workspace = visibility_workspace_create();
+  bomb_state.svg_queue =
+      thread_count > 1 ? svg_queue_create(SVG_QUEUE_CAPACITY) : NULL;
+  bomb_state.batch.first_line = 0;
+  bomb_state.batch.line_count = 0;
+  bomb_state.batch.count = 0;
+  bomb_state.batch.workspaces =
+      bomb_state.pool != NULL ? create_workspaces(thread_count) : NULL;
+  bomb_state.current_line = 0;
 
   // Process each command line
-  Queue file_lines = get_file_lines_queue(qry_file_data);
-  while (!queue_is_empty(file_lines)) {
-    char *line = (char *)queue_dequeue(file_lines);
-    char *command = strtok(line, " ");
-
-    if (strcmp(command, "a") == 0) {
-      execute_anteparo_command(city, txt_output);
-    } else if (strcmp(command, "d") == 0) {
-      execute_destruction_bomb(city, output_path, geo_file_data, qry_file_data,
-                               NULL, txt_output, sort_type, sort_threshold,
-                               accumulated_polygons);
-    } else if (strcmp(command, "p") == 0) {
-      execute_painting_bomb(city, output_path, geo_file_data, qry_file_data,
-                            NULL, txt_output, sort_type, sort_threshold,
-                            accumulated_polygons);
-    } else if (strcmp(command, "cln") == 0) {
-      execute_cloning_bomb(city, output_path, geo_file_data, qry_file_data,
-                           NULL, txt_output, sort_type, sort_threshold,
-                           accumulated_polygons);
-    } else {
-      fprintf(txt_output, "Unknown command: %s\n\n", command);
+  char *line;
+  for (int i = 0; (line = file_data_next_line(qry_file_data)) != NULL; i++) {
+    bomb_state.current_line = i;
+    if (bomb_state.pool != NULL &&
+        i >= bomb_state.batch.first_line + bomb_state.batch.line_count) {
+      prefetch_bomb_polygons(city, &bomb_state, qry_file_data, i, sort_type,
+                             sort_threshold);
+    }
+
+    Lexer lexer;
+    lexer_init(&lexer, line);
+
+    switch (lexer_next_command(&lexer)) {
+    case LEXER_COMMAND_NONE:
+      break;
+    case LEXER_COMMAND_ANTEPARO:
+      execute_anteparo_command(city, &lexer, txt_output);
+      break;
+    case LEXER_COMMAND_DESTRUCTION:
+      execute_destruction_bomb(city, &lexer, output_path, geo_file_data,
+                               qry_file_data, NULL, txt_output, sort_type,
+                               sort_threshold, accumulated_polygons,
+                               &bomb_state);
+      break;
+    case LEXER_COMMAND_PAINTING:
+      execute_painting_bomb(city, &lexer, output_path, geo_file_data,
+                            qry_file_data, NULL, txt_output, sort_type,
+                            sort_threshold, accumulated_polygons, &bomb_state);
+      break;
+    case LEXER_COMMAND_CLONING:
+      execute_cloning_bomb(city, &lexer, output_path, geo_file_data,
+                           qry_file_data, NULL, txt_output, sort_type,
+                           sort_threshold, accumulated_polygons, &bomb_state);
+      break;
+    default:
+      fprintf(txt_output, "Unknown command: %.*s\n\n",
+              lexer_token_length(&lexer), lexer_token(&lexer));
+      break;
     }
+    // Each command's report reaches the file before the next one runs
+    fflush(txt_output);
+  }
+
+  // A line that could not be read ends the loop like the end of the file
+  bool completed = !file_data_failed(qry_file_data);
+  if (!completed) {
+    fprintf(txt_output, "Error: Failed to read the rest of the .qry file\n");
   }
 
+  release_prefetch_batch(&bomb_state);
+  thread_pool_destroy(bomb_state.pool);
+  destroy_workspaces(bomb_state.batch.workspaces, thread_count);
+  visibility_workspace_destroy(bomb_state.workspace);
+  svg_queue_destroy(bomb_state.svg_queue);
+  visibility_barrier_set_destroy(bomb_state.barrier_set);
+  if (stats != NULL) {
+    stats->visibility_cache_hits = visibility_cache_get_hits(bomb_state.cache);
+    stats->visibility_cache_misses =
+        visibility_cache_get_misses(bomb_state.cache);
+  }
+  visibility_cache_destroy(bomb_state.cache);
   fclose(txt_output);
   free(txt_path);
 
@@ -155,218 +314,221 @@ void qry_handler_process_file(City city, FileData geo_file_data,
                         accumulated_polygons);
 
   // Clean up accumulated polygons
-  int polygon_count = list_size(accumulated_polygons);
+  int polygon_count = sequence_size(accumulated_polygons);
   for (int i = 0; i < polygon_count; i++) {
-    VisPolygonData *data = (VisPolygonData *)list_get(accumulated_polygons, i);
+    VisPolygonData *data =
+        (VisPolygonData *)sequence_get(accumulated_polygons, i);
     if (data) {
       visibility_polygon_destroy(data->polygon);
       free(data);
     }
   }
-  list_destroy(accumulated_polygons);
+  sequence_destroy(accumulated_polygons);
+  return completed;
 }
 
-static void execute_anteparo_command(City city, FILE *txt_output) {
-  char *start_id_str = strtok(NULL, " ");
-  char *end_id_str = strtok(NULL, " ");
-  char *orientation = strtok(NULL, " ");
+// Transforms one shape of an 'a' command into barrier segments
+static void transform_to_barrier(int id, Shape shape, void *user_data) {
+  AnteparoContext *context = (AnteparoContext *)user_data;
+  City city = context->city;
+  FILE *txt_output = context->txt_output;
+  char orient = context->orient;
+  Sequence shapes_to_remove = context->shapes_to_remove;
+  Sequence segments_to_add = context->segments_to_add;
+  ShapeStore store = city_get_shape_store(city);
 
-  if (!start_id_str || !end_id_str) {
-    fprintf(txt_output, "Error: Command 'a' requires start and end IDs\n\n");
-    return;
-  }
+  ShapeType type = shape_get_type(shape);
+  sequence_append(shapes_to_remove, shape);
 
-  int start_id = atoi(start_id_str);
-  int end_id = atoi(end_id_str);
-  char orient = orientation ? orientation[0] : 'h';
+  switch (type) {
+  case CIRCLE: {
+    Circle circle = (Circle)shape_get_shape(shape);
+    double cx = circle_get_x(circle);
+    double cy = circle_get_y(circle);
+    double r = circle_get_radius(circle);
+    const char *color = circle_get_border_color(circle);
+
+    int new_id = city_get_next_id(city);
+    Shape segment;
+
+    if (orient == 'v' || orient == 'V') {
+      segment = line_create_in(store, new_id, cx, cy - r, cx, cy + r, color);
+      fprintf(txt_output,
+              "  Circle id=%d -> Vertical segment id=%d "
+              "(%.2f,%.2f)-(%.2f,%.2f)\n",
+              id, new_id, cx, cy - r, cx, cy + r);
+    } else {
+      segment = line_create_in(store, new_id, cx - r, cy, cx + r, cy, color);
+      fprintf(txt_output,
+              "  Circle id=%d -> Horizontal segment id=%d "
+              "(%.2f,%.2f)-(%.2f,%.2f)\n",
+              id, new_id, cx - r, cy, cx + r, cy);
+    }
 
-  fprintf(txt_output, "Command: a %d %d %c\n", start_id, end_id, orient);
-  fprintf(txt_output, "Transformed to barriers:\n");
+    Line line = (Line)shape_get_shape(segment);
+    line_set_barrier(line, true);
+    sequence_append(segments_to_add, segment);
+    break;
+  }
 
-  List shapes_to_remove = list_create();
-  List segments_to_add = list_create();
+  case RECTANGLE: {
+    Rectangle rect = (Rectangle)shape_get_shape(shape);
+    double x = rectangle_get_x(rect);
+    double y = rectangle_get_y(rect);
+    double w = rectangle_get_width(rect);
+    double h = rectangle_get_height(rect);
+    const char *color = rectangle_get_border_color(rect);
 
-  // Find and transform shapes in the ID range
-  for (int id = start_id; id <= end_id; id++) {
-    Shape shape = city_get_shape_by_id(city, id);
-    if (!shape) {
-      continue;
-    }
+    fprintf(txt_output, "  Rectangle id=%d -> Segments:", id);
 
-    ShapeType type = shape_get_type(shape);
-    list_insert_back(shapes_to_remove, shape);
+    int ids[4];
+    for (int i = 0; i < 4; i++) {
+      ids[i] = city_get_next_id(city);
+    }
 
-    switch (type) {
-    case CIRCLE: {
-      Circle circle = (Circle)shape_get_shape(shape);
-      double cx = circle_get_x(circle);
-      double cy = circle_get_y(circle);
-      double r = circle_get_radius(circle);
-      const char *color = circle_get_border_color(circle);
-
-      int new_id = city_get_next_id(city);
-      Shape segment;
-
-      if (orient == 'v' || orient == 'V') {
-        segment = line_create(new_id, cx, cy - r, cx, cy + r, color);
-        fprintf(txt_output,
-                "  Circle id=%d -> Vertical segment id=%d "
-                "(%.2f,%.2f)-(%.2f,%.2f)\n",
-                id, new_id, cx, cy - r, cx, cy + r);
-      } else {
-        segment = line_create(new_id, cx - r, cy, cx + r, cy, color);
-        fprintf(txt_output,
-                "  Circle id=%d -> Horizontal segment id=%d "
-                "(%.2f,%.2f)-(%.2f,%.2f)\n",
-                id, new_id, cx - r, cy, cx + r, cy);
-      }
+    Shape segments[4];
+    segments[0] = line_create_in(store, ids[0], x, y, x + w, y, color);
+    segments[1] = line_create_in(store, ids[1], x + w, y, x + w, y + h, color);
+    segments[2] = line_create_in(store, ids[2], x + w, y + h, x, y + h, color);
+    segments[3] = line_create_in(store, ids[3], x, y + h, x, y, color);
 
-      Line line = (Line)shape_get_shape(segment);
+    for (int i = 0; i < 4; i++) {
+      Line line = (Line)shape_get_shape(segments[i]);
       line_set_barrier(line, true);
-      list_insert_back(segments_to_add, segment);
-      break;
+      sequence_append(segments_to_add, segments[i]);
+      fprintf(txt_output, " id=%d", ids[i]);
     }
+    fprintf(txt_output, "\n");
+    break;
+  }
 
-    case RECTANGLE: {
-      Rectangle rect = (Rectangle)shape_get_shape(shape);
-      double x = rectangle_get_x(rect);
-      double y = rectangle_get_y(rect);
-      double w = rectangle_get_width(rect);
-      double h = rectangle_get_height(rect);
-      const char *color = rectangle_get_border_color(rect);
-
-      fprintf(txt_output, "  Rectangle id=%d -> Segments:", id);
-
-      int ids[4];
-      for (int i = 0; i < 4; i++) {
-        ids[i] = city_get_next_id(city);
-      }
+  case LINE: {
+    city_mark_barrier(city, shape);
+    fprintf(txt_output, "  Line id=%d -> Marked as barrier\n", id);
+    sequence_remove(shapes_to_remove, shape);
+    break;
+  }
 
-      Shape segments[4];
-      segments[0] = line_create(ids[0], x, y, x + w, y, color);
-      segments[1] = line_create(ids[1], x + w, y, x + w, y + h, color);
-      segments[2] = line_create(ids[2], x + w, y + h, x, y + h, color);
-      segments[3] = line_create(ids[3], x, y + h, x, y, color);
-
-      for (int i = 0; i < 4; i++) {
-        Line line = (Line)shape_get_shape(segments[i]);
-        line_set_barrier(line, true);
-        list_insert_back(segments_to_add, segments[i]);
-        fprintf(txt_output, " id=%d", ids[i]);
-      }
-      fprintf(txt_output, "\n");
-      break;
+  case TEXT: {
+    Text text = (Text)shape_get_shape(shape);
+    double x = text_get_x(text);
+    double y = text_get_y(text);
+    const char *text_str = text_get_text(text);
+    char anchor = text_get_anchor(text);
+    const char *color = text_get_border_color(text);
+
+    int text_len = strlen(text_str);
+    double x1, x2;
+
+    if (anchor == 'i' || anchor == 'I') {
+      x1 = x;
+      x2 = x + 10.0 * text_len;
+    } else if (anchor == 'f' || anchor == 'F') {
+      x1 = x - 10.0 * text_len;
+      x2 = x;
+    } else {
+      x1 = x - 10.0 * text_len / 2.0;
+      x2 = x + 10.0 * text_len / 2.0;
     }
 
-    case LINE: {
-      Line line = (Line)shape_get_shape(shape);
-      line_set_barrier(line, true);
-      fprintf(txt_output, "  Line id=%d -> Marked as barrier\n", id);
-      list_remove(shapes_to_remove, shape);
-      break;
-    }
+    int new_id = city_get_next_id(city);
+    Shape segment = line_create_in(store, new_id, x1, y, x2, y, color);
+    Line line = (Line)shape_get_shape(segment);
+    line_set_barrier(line, true);
+    sequence_append(segments_to_add, segment);
 
-    case TEXT: {
-      Text text = (Text)shape_get_shape(shape);
-      double x = text_get_x(text);
-      double y = text_get_y(text);
-      const char *text_str = text_get_text(text);
-      char anchor = text_get_anchor(text);
-      const char *color = text_get_border_color(text);
-
-      int text_len = strlen(text_str);
-      double x1, x2;
-
-      if (anchor == 'i' || anchor == 'I') {
-        x1 = x;
-        x2 = x + 10.0 * text_len;
-      } else if (anchor == 'f' || anchor == 'F') {
-        x1 = x - 10.0 * text_len;
-        x2 = x;
-      } else {
-        x1 = x - 10.0 * text_len / 2.0;
-        x2 = x + 10.0 * text_len / 2.0;
-      }
+    fprintf(txt_output,
+            "  Text id=%d -> Segment id=%d (%.2f,%.2f)-(%.2f,%.2f)\n", id,
+            new_id, x1, y, x2, y);
+    break;
+  }
 
-      int new_id = city_get_next_id(city);
-      Shape segment = line_create(new_id, x1, y, x2, y, color);
-      Line line = (Line)shape_get_shape(segment);
-      line_set_barrier(line, true);
-      list_insert_back(segments_to_add, segment);
+  default:
+    break;
+  }
+}
 
-      fprintf(txt_output,
-              "  Text id=%d -> Segment id=%d (%.2f,%.2f)-(%.2f,%.2f)\n", id,
-              new_id, x1, y, x2, y);
-      break;
-    }
+static void execute_anteparo_command(City city, Lexer *lexer,
+                                     FILE *txt_output) {
+  int start_id, end_id;
+  bool has_ids = lexer_next_int(lexer, &start_id) &&
+                 lexer_next_int(lexer, &end_id);
+  char *orientation = lexer_next_token(lexer);
 
-    default:
-      break;
-    }
+  if (!has_ids) {
+    fprintf(txt_output, "Error: Command 'a' requires start and end IDs\n\n");
+    return;
   }
 
-  int remove_count = list_size(shapes_to_remove);
+  char orient = orientation ? orientation[0] : 'h';
+
+  fprintf(txt_output, "Command: a %d %d %c\n", start_id, end_id, orient);
+  fprintf(txt_output, "Transformed to barriers:\n");
+
+  Sequence shapes_to_remove = sequence_create();
+  Sequence segments_to_add = sequence_create();
+
+  // Transform the shapes in the ID range
+  AnteparoContext context = {city, txt_output, orient, shapes_to_remove,
+                             segments_to_add};
+  city_foreach_shape_in_id_range(city, start_id, end_id, transform_to_barrier,
+                                 &context);
+
+  int remove_count = sequence_size(shapes_to_remove);
   for (int i = 0; i < remove_count; i++) {
-    Shape shape = list_get(shapes_to_remove, i);
+    Shape shape = sequence_get(shapes_to_remove, i);
     city_remove_shape(city, shape);
   }
 
-  int add_count = list_size(segments_to_add);
+  int add_count = sequence_size(segments_to_add);
   for (int i = 0; i < add_count; i++) {
-    Shape segment = list_get(segments_to_add, i);
+    Shape segment = sequence_get(segments_to_add, i);
     city_add_shape(city, segment);
   }
 
-  list_destroy(shapes_to_remove);
-  list_destroy(segments_to_add);
+  sequence_destroy(shapes_to_remove);
+  sequence_destroy(segments_to_add);
 
   fprintf(txt_output, "\n");
 }
 
-static void execute_destruction_bomb(City city, const char *output_path,
+static void execute_destruction_bomb(City city, Lexer *lexer,
+                                     const char *output_path,
                                      FileData geo_file_data,
                                      FileData qry_file_data, const char *suffix,
                                      FILE *txt_output, SortType sort_type,
                                      int sort_threshold,
-                                     List accumulated_polygons) {
-  char *x_str = strtok(NULL, " ");
-  char *y_str = strtok(NULL, " ");
-  char *sfx = strtok(NULL, " ");
-
-  if (!x_str || !y_str) {
+                                     Sequence accumulated_polygons,
+                                     BombState *bomb_state) {
+  double x, y;
+  bool has_source =
+      lexer_next_double(lexer, &x) && lexer_next_double(lexer, &y);
+  char *sfx = lexer_next_token(lexer);
+  double radius = next_bomb_radius(lexer);
+
+  if (!has_source) {
     fprintf(txt_output, "Error: Command 'd' requires x and y coordinates\n\n");
     return;
   }
 
-  double x = atof(x_str);
-  double y = atof(y_str);
-
-  fprintf(txt_output, "Command: d %.2f %.2f %s\n", x, y, sfx ? sfx : "-");
+  fprintf(txt_output, "Command: d %.2f %.2f %s", x, y, sfx ? sfx : "-");
+  print_bomb_radius(txt_output, radius);
   fprintf(txt_output, "Destroyed shapes:\n");
 
-  double min_x, min_y, max_x, max_y;
-  city_get_bounding_box(city, &min_x, &min_y, &max_x, &max_y);
-  double margin = 20.0;
-  min_x -= margin;
-  min_y -= margin;
-  max_x += margin;
-  max_y += margin;
-
-  List barriers = city_get_barriers(city);
   VisibilityPolygon polygon =
-      visibility_calculate(x, y, barriers, 1000.0, sort_type, sort_threshold,
-                           min_x, min_y, max_x, max_y);
+      compute_bomb_polygon(city, bomb_state, x, y, radius, sort_type,
+                           sort_threshold);
 
   if (!polygon) {
     fprintf(txt_output, "  Error calculating visibility region\n\n");
-    list_destroy(barriers);
     return;
   }
 
   // Generate SVG with visibility polygon if suffix is provided and not "-"
   if (sfx != NULL && strcmp(sfx, "-") != 0) {
     city_generate_svg_with_visibility(city, output_path, geo_file_data,
-                                      qry_file_data, sfx, polygon, x, y);
+                                      qry_file_data, sfx, polygon, x, y,
+                                      bomb_state->svg_queue);
   } else if (sfx == NULL || strcmp(sfx, "-") == 0) {
     // Accumulate polygon for final SVG when suffix is "-"
     VisPolygonData *data = malloc(sizeof(VisPolygonData));
@@ -374,31 +536,24 @@ static void execute_destruction_bomb(City city, const char *output_path,
       data->polygon = polygon;
       data->source_x = x;
       data->source_y = y;
-      list_insert_back(accumulated_polygons, data);
+      sequence_append(accumulated_polygons, data);
       polygon = NULL; // Don't destroy, will be cleaned up later
     }
   }
 
-  List shapes_to_destroy = list_create();
-  List shapes_list = city_get_shapes_list(city);
-  int shape_count = list_size(shapes_list);
-
-  for (int i = 0; i < shape_count; i++) {
-    Shape shape = list_get(shapes_list, i);
-    VisibilityPolygon check_poly = polygon;
-    if (check_poly == NULL && list_size(accumulated_polygons) > 0) {
-      VisPolygonData *last =
-          (VisPolygonData *)list_get_last(accumulated_polygons);
-      check_poly = last->polygon;
-    }
-    if (shape && shape_in_visibility_region(shape, check_poly)) {
-      list_insert_back(shapes_to_destroy, shape);
-    }
+  VisibilityPolygon check_poly = polygon;
+  if (check_poly == NULL && sequence_size(accumulated_polygons) > 0) {
+    VisPolygonData *last =
+        (VisPolygonData *)sequence_get_last(accumulated_polygons);
+    check_poly = last->polygon;
   }
 
-  int destroy_count = list_size(shapes_to_destroy);
+  Sequence shapes_to_destroy =
+      find_shapes_in_visibility_region(city, check_poly);
+
+  int destroy_count = sequence_size(shapes_to_destroy);
   for (int i = 0; i < destroy_count; i++) {
-    Shape shape = list_get(shapes_to_destroy, i);
+    Shape shape = sequence_get(shapes_to_destroy, i);
     ShapeType type = shape_get_type(shape);
     int id = -1;
 
@@ -427,8 +582,7 @@ static void execute_destruction_bomb(City city, const char *output_path,
     fprintf(txt_output, "  No shapes destroyed\n");
   }
 
-  list_destroy(shapes_to_destroy);
-  list_destroy(barriers);
+  sequence_destroy(shapes_to_destroy);
   if (polygon) {
     visibility_polygon_destroy(polygon);
   }
@@ -436,53 +590,46 @@ static void execute_destruction_bomb(City city, const char *output_path,
   fprintf(txt_output, "\n");
 }
 
-static void execute_painting_bomb(City city, const char *output_path,
+static void execute_painting_bomb(City city, Lexer *lexer,
+                                  const char *output_path,
                                   FileData geo_file_data,
                                   FileData qry_file_data, const char *suffix,
                                   FILE *txt_output, SortType sort_type,
                                   int sort_threshold,
-                                  List accumulated_polygons) {
-  char *x_str = strtok(NULL, " ");
-  char *y_str = strtok(NULL, " ");
-  char *color = strtok(NULL, " ");
-  char *sfx = strtok(NULL, " ");
-
-  if (!x_str || !y_str || !color) {
+                                  Sequence accumulated_polygons,
+                                  BombState *bomb_state) {
+  double x, y;
+  bool has_source =
+      lexer_next_double(lexer, &x) && lexer_next_double(lexer, &y);
+  char *color = lexer_next_token(lexer);
+  char *sfx = lexer_next_token(lexer);
+  double radius = next_bomb_radius(lexer);
+
+  if (!has_source || !color) {
     fprintf(txt_output,
             "Error: Command 'p' requires x, y coordinates and color\n\n");
     return;
   }
 
-  double x = atof(x_str);
-  double y = atof(y_str);
-
-  fprintf(txt_output, "Command: p %.2f %.2f %s %s\n", x, y, color,
+  fprintf(txt_output, "Command: p %.2f %.2f %s %s", x, y, color,
           sfx ? sfx : "-");
+  print_bomb_radius(txt_output, radius);
   fprintf(txt_output, "Painted shapes:\n");
 
-  double min_x, min_y, max_x, max_y;
-  city_get_bounding_box(city, &min_x, &min_y, &max_x, &max_y);
-  double margin = 20.0;
-  min_x -= margin;
-  min_y -= margin;
-  max_x += margin;
-  max_y += margin;
-
-  List barriers = city_get_barriers(city);
   VisibilityPolygon polygon =
-      visibility_calculate(x, y, barriers, 1000.0, sort_type, sort_threshold,
-                           min_x, min_y, max_x, max_y);
+      compute_bomb_polygon(city, bomb_state, x, y, radius, sort_type,
+                           sort_threshold);
 
   if (!polygon) {
     fprintf(txt_output, "  Error calculating visibility region\n\n");
-    list_destroy(barriers);
     return;
   }
 
   // Generate SVG with visibility polygon if suffix is provided and not "-"
   if (sfx != NULL && strcmp(sfx, "-") != 0) {
     city_generate_svg_with_visibility(city, output_path, geo_file_data,
-                                      qry_file_data, sfx, polygon, x, y);
+                                      qry_file_data, sfx, polygon, x, y,
+                                      bomb_state->svg_queue);
   } else if (sfx == NULL || strcmp(sfx, "-") == 0) {
     // Accumulate polygon for final SVG when suffix is "-"
     VisPolygonData *data = malloc(sizeof(VisPolygonData));
@@ -490,28 +637,25 @@ static void execute_painting_bomb(City city, const char *output_path,
       data->polygon = polygon;
       data->source_x = x;
       data->source_y = y;
-      list_insert_back(accumulated_polygons, data);
+      sequence_append(accumulated_polygons, data);
       polygon = NULL; // Don't destroy, will be cleaned up later
     }
   }
 
-  List shapes_list = city_get_shapes_list(city);
-  int shape_count = list_size(shapes_list);
   int painted_count = 0;
 
   VisibilityPolygon check_poly = polygon;
-  if (check_poly == NULL && list_size(accumulated_polygons) > 0) {
+  if (check_poly == NULL && sequence_size(accumulated_polygons) > 0) {
     VisPolygonData *last =
-        (VisPolygonData *)list_get_last(accumulated_polygons);
+        (VisPolygonData *)sequence_get_last(accumulated_polygons);
     check_poly = last->polygon;
   }
 
-  for (int i = 0; i < shape_count; i++) {
-    Shape shape = list_get(shapes_list, i);
-    if (!shape || !shape_in_visibility_region(shape, check_poly)) {
-      continue;
-    }
+  Sequence shapes_to_paint = find_shapes_in_visibility_region(city, check_poly);
+  int paint_count = sequence_size(shapes_to_paint);
 
+  for (int i = 0; i < paint_count; i++) {
+    Shape shape = sequence_get(shapes_to_paint, i);
     ShapeType type = shape_get_type(shape);
     int id = -1;
 
@@ -557,7 +701,7 @@ static void execute_painting_bomb(City city, const char *output_path,
     fprintf(txt_output, "  No shapes painted\n");
   }
 
-  list_destroy(barriers);
+  sequence_destroy(shapes_to_paint);
   if (polygon) {
     visibility_polygon_destroy(polygon);
   }
@@ -565,55 +709,45 @@ static void execute_painting_bomb(City city, const char *output_path,
   fprintf(txt_output, "\n");
 }
 
-static void execute_cloning_bomb(City city, const char *output_path,
+static void execute_cloning_bomb(City city, Lexer *lexer,
+                                 const char *output_path,
                                  FileData geo_file_data, FileData qry_file_data,
                                  const char *suffix, FILE *txt_output,
                                  SortType sort_type, int sort_threshold,
-                                 List accumulated_polygons) {
-  char *x_str = strtok(NULL, " ");
-  char *y_str = strtok(NULL, " ");
-  char *dx_str = strtok(NULL, " ");
-  char *dy_str = strtok(NULL, " ");
-  char *sfx = strtok(NULL, " ");
-
-  if (!x_str || !y_str || !dx_str || !dy_str) {
+                                 Sequence accumulated_polygons,
+                                 BombState *bomb_state) {
+  double x, y, dx, dy;
+  bool has_offsets =
+      lexer_next_double(lexer, &x) && lexer_next_double(lexer, &y) &&
+      lexer_next_double(lexer, &dx) && lexer_next_double(lexer, &dy);
+  char *sfx = lexer_next_token(lexer);
+  double radius = next_bomb_radius(lexer);
+
+  if (!has_offsets) {
     fprintf(txt_output,
             "Error: Command 'cln' requires x, y, dx, dy coordinates\n\n");
     return;
   }
 
-  double x = atof(x_str);
-  double y = atof(y_str);
-  double dx = atof(dx_str);
-  double dy = atof(dy_str);
-
-  fprintf(txt_output, "Command: cln %.2f %.2f %.2f %.2f %s\n", x, y, dx, dy,
+  fprintf(txt_output, "Command: cln %.2f %.2f %.2f %.2f %s", x, y, dx, dy,
           sfx ? sfx : "-");
+  print_bomb_radius(txt_output, radius);
   fprintf(txt_output, "Cloned shapes:\n");
 
-  double min_x, min_y, max_x, max_y;
-  city_get_bounding_box(city, &min_x, &min_y, &max_x, &max_y);
-  double margin = 20.0;
-  min_x -= margin;
-  min_y -= margin;
-  max_x += margin;
-  max_y += margin;
-
-  List barriers = city_get_barriers(city);
   VisibilityPolygon polygon =
-      visibility_calculate(x, y, barriers, 1000.0, sort_type, sort_threshold,
-                           min_x, min_y, max_x, max_y);
+      compute_bomb_polygon(city, bomb_state, x, y, radius, sort_type,
+                           sort_threshold);
 
   if (!polygon) {
     fprintf(txt_output, "  Error calculating visibility region\n\n");
-    list_destroy(barriers);
     return;
   }
 
   // Generate SVG with visibility polygon if suffix is provided and not "-"
   if (sfx != NULL && strcmp(sfx, "-") != 0) {
     city_generate_svg_with_visibility(city, output_path, geo_file_data,
-                                      qry_file_data, sfx, polygon, x, y);
+                                      qry_file_data, sfx, polygon, x, y,
+                                      bomb_state->svg_queue);
   } else if (sfx == NULL || strcmp(sfx, "-") == 0) {
     // Accumulate polygon for final SVG when suffix is "-"
     VisPolygonData *data = malloc(sizeof(VisPolygonData));
@@ -621,32 +755,24 @@ static void execute_cloning_bomb(City city, const char *output_path,
       data->polygon = polygon;
       data->source_x = x;
       data->source_y = y;
-      list_insert_back(accumulated_polygons, data);
+      sequence_append(accumulated_polygons, data);
       polygon = NULL; // Don't destroy, will be cleaned up later
     }
   }
 
-  List shapes_to_clone = list_create();
-  List shapes_list = city_get_shapes_list(city);
-  int shape_count = list_size(shapes_list);
-
   VisibilityPolygon check_poly = polygon;
-  if (check_poly == NULL && list_size(accumulated_polygons) > 0) {
+  if (check_poly == NULL && sequence_size(accumulated_polygons) > 0) {
     VisPolygonData *last =
-        (VisPolygonData *)list_get_last(accumulated_polygons);
+        (VisPolygonData *)sequence_get_last(accumulated_polygons);
     check_poly = last->polygon;
   }
 
-  for (int i = 0; i < shape_count; i++) {
-    Shape shape = list_get(shapes_list, i);
-    if (shape && shape_in_visibility_region(shape, check_poly)) {
-      list_insert_back(shapes_to_clone, shape);
-    }
-  }
+  Sequence shapes_to_clone = find_shapes_in_visibility_region(city, check_poly);
 
-  int clone_count = list_size(shapes_to_clone);
+  ShapeStore store = city_get_shape_store(city);
+  int clone_count = sequence_size(shapes_to_clone);
   for (int i = 0; i < clone_count; i++) {
-    Shape original = list_get(shapes_to_clone, i);
+    Shape original = sequence_get(shapes_to_clone, i);
     ShapeType type = shape_get_type(original);
     int original_id = -1;
     int clone_id = city_get_next_id(city);
@@ -656,36 +782,37 @@ static void execute_cloning_bomb(City city, const char *output_path,
     case CIRCLE: {
       Circle circle = (Circle)shape_get_shape(original);
       original_id = circle_get_id(circle);
-      clone = circle_create(
-          clone_id, circle_get_x(circle) + dx, circle_get_y(circle) + dy,
-          circle_get_radius(circle), circle_get_border_color(circle),
-          circle_get_fill_color(circle));
+      clone = circle_create_in(
+          store, clone_id, circle_get_x(circle) + dx,
+          circle_get_y(circle) + dy, circle_get_radius(circle),
+          circle_get_border_color(circle), circle_get_fill_color(circle));
       break;
     }
     case RECTANGLE: {
       Rectangle rect = (Rectangle)shape_get_shape(original);
       original_id = rectangle_get_id(rect);
-      clone = rectangle_create(
-          clone_id, rectangle_get_x(rect) + dx, rectangle_get_y(rect) + dy,
-          rectangle_get_width(rect), rectangle_get_height(rect),
-          rectangle_get_border_color(rect), rectangle_get_fill_color(rect));
+      clone = rectangle_create_in(
+          store, clone_id, rectangle_get_x(rect) + dx,
+          rectangle_get_y(rect) + dy, rectangle_get_width(rect),
+          rectangle_get_height(rect), rectangle_get_border_color(rect),
+          rectangle_get_fill_color(rect));
       break;
     }
     case LINE: {
       Line line = (Line)shape_get_shape(original);
       original_id = line_get_id(line);
-      clone = line_create(clone_id, line_get_x1(line) + dx,
-                          line_get_y1(line) + dy, line_get_x2(line) + dx,
-                          line_get_y2(line) + dy, line_get_color(line));
+      clone = line_create_in(store, clone_id, line_get_x1(line) + dx,
+                             line_get_y1(line) + dy, line_get_x2(line) + dx,
+                             line_get_y2(line) + dy, line_get_color(line));
       break;
     }
     case TEXT: {
       Text text = (Text)shape_get_shape(original);
       original_id = text_get_id(text);
-      clone =
-          text_create(clone_id, text_get_x(text) + dx, text_get_y(text) + dy,
-                      text_get_border_color(text), text_get_fill_color(text),
-                      text_get_anchor(text), text_get_text(text));
+      clone = text_create_in(
+          store, clone_id, text_get_x(text) + dx, text_get_y(text) + dy,
+          text_get_border_color(text), text_get_fill_color(text),
+          text_get_anchor(text), text_get_text(text));
       break;
     }
     default:
@@ -703,8 +830,7 @@ static void execute_cloning_bomb(City city, const char *output_path,
     fprintf(txt_output, "  No shapes cloned\n");
   }
 
-  list_destroy(shapes_to_clone);
-  list_destroy(barriers);
+  sequence_destroy(shapes_to_clone);
   if (polygon) {
     visibility_polygon_destroy(polygon);
   }
@@ -744,6 +870,294 @@ static bool shape_in_visibility_region(Shape shape, VisibilityPolygon polygon) {
   }
 }
 
+// Returns the barrier set of the city's current barriers, rebuilding the
+// cached one when they changed since it was built
+static BarrierSet get_barrier_set(City city, BombState *state) {
+  unsigned version = city_get_barrier_version(city);
+  if (state->barrier_set != NULL && state->barrier_version != version) {
+    visibility_barrier_set_destroy(state->barrier_set);
+    state->barrier_set = NULL;
+  }
+  if (state->barrier_set == NULL) {
+    Sequence barriers = city_get_barriers(city);
+    state->barrier_set = visibility_barrier_set_create(barriers);
+    sequence_destroy(barriers);
+    state->barrier_version = version;
+  }
+  return state->barrier_set;
+}
+
+// Gets everything the polygon of a bomb depends on: its source and radius,
+// the city's barriers and the scene, which is the city bounding box plus a
+// margin
+static void get_bomb_key(City city, double x, double y, double radius,
+                         VisibilityCacheKey *key) {
+  key->x = x;
+  key->y = y;
+  key->radius = radius;
+  key->barrier_version = city_get_barrier_version(city);
+  city_get_bounding_box(city, &key->min_x, &key->min_y, &key->max_x,
+                        &key->max_y);
+  key->min_x -= BOMB_SCENE_MARGIN;
+  key->min_y -= BOMB_SCENE_MARGIN;
+  key->max_x += BOMB_SCENE_MARGIN;
+  key->max_y += BOMB_SCENE_MARGIN;
+}
+
+// Reads the optional radius after the suffix of a bomb. Bombs without one
+// (or with one that is not positive) are bounded only by the scene.
+static double next_bomb_radius(Lexer *lexer) {
+  double radius;
+  if (!lexer_next_double(lexer, &radius) || !(radius > 0)) {
+    return VISIBILITY_UNBOUNDED;
+  }
+  return radius;
+}
+
+// Ends the echoed command line of a bomb, with its radius if it has one
+static void print_bomb_radius(FILE *txt_output, double radius) {
+  if (isfinite(radius)) {
+    fprintf(txt_output, " %.2f", radius);
+  }
+  fprintf(txt_output, "\n");
+}
+
+// Takes the polygon prefetched for the current line, if it was computed for
+// exactly this key
+static VisibilityPolygon take_prefetched_polygon(BombState *state,
+                                                 const VisibilityCacheKey *key) {
+  PrefetchBatch *batch = &state->batch;
+  int offset = state->current_line - batch->first_line;
+  if (offset < 0 || offset >= batch->line_count) {
+    return NULL;
+  }
+
+  int entry = batch->entries[offset];
+  if (entry < 0 || batch->polygons[entry] == NULL ||
+      batch->barrier_version != key->barrier_version ||
+      batch->xs[entry] != key->x || batch->ys[entry] != key->y ||
+      batch->radii[entry] != key->radius || batch->min_x != key->min_x ||
+      batch->min_y != key->min_y || batch->max_x != key->max_x ||
+      batch->max_y != key->max_y) {
+    return NULL;
+  }
+
+  VisibilityPolygon polygon = batch->polygons[entry];
+  batch->polygons[entry] = NULL;
+  return polygon;
+}
+
+// Computes the visibility polygon of the bomb on the current line. Cached and
+// prefetched polygons are used only if they were computed from exactly the
+// same source, radius, scene and barriers, so the result never depends on the
+// thread count or on the cache.
+static VisibilityPolygon compute_bomb_polygon(City city, BombState *state,
+                                              double x, double y,
+                                              double radius,
+                                              SortType sort_type,
+                                              int sort_threshold) {
+  VisibilityCacheKey key;
+  get_bomb_key(city, x, y, radius, &key);
+
+  VisibilityPolygon polygon = visibility_cache_get(state->cache, &key);
+  if (polygon != NULL) {
+    return polygon;
+  }
+
+  polygon = take_prefetched_polygon(state, &key);
+  if (polygon == NULL) {
+    BarrierSet barriers = get_barrier_set(city, state);
+    polygon = visibility_calculate_with_set(
+        x, y, barriers, state->workspace, radius, sort_type, sort_threshold,
+        key.min_x, key.min_y, key.max_x, key.max_y);
+  }
+  visibility_cache_put(state->cache, &key, polygon);
+  return polygon;
+}
+
+// Pool task: computes one contiguous chunk of a prefetch batch
+static void prefetch_chunk(int task_index, void *user_data) {
+  PrefetchBatch *batch = (PrefetchBatch *)user_data;
+  int start = task_index * batch->count / batch->task_count;
+  int end = (task_index + 1) * batch->count / batch->task_count;
+
+  VisibilityWorkspace workspace =
+      batch->workspaces != NULL ? batch->workspaces[task_index] : NULL;
+  visibility_calculate_batch(&batch->xs[start], &batch->ys[start],
+                             end - start, batch->barriers, workspace,
+                             &batch->radii[start],
+                             batch->sort_type, batch->sort_threshold,
+                             batch->min_x, batch->min_y, batch->max_x,
+                             batch->max_y, &batch->polygons[start]);
+}
+
+// Reads the source and radius of the bomb on a line, without touching the
+// line itself. Returns false if the line is not a bomb.
+static bool parse_bomb_source(const char *line, double *x, double *y,
+                              double *radius) {
+  // Commands and numbers are read without writing to the line
+  Lexer lexer;
+  lexer_init(&lexer, (char *)line);
+
+  LexerCommand command = lexer_next_command(&lexer);
+  if (command != LEXER_COMMAND_DESTRUCTION &&
+      command != LEXER_COMMAND_PAINTING && command != LEXER_COMMAND_CLONING) {
+    return false;
+  }
+
+  *x = 0.0;
+  *y = 0.0;
+  lexer_next_double(&lexer, x);
+  lexer_next_double(&lexer, y);
+
+  // Skip what comes between the source and the suffix: the color of 'p' or
+  // the offsets of 'cln'
+  int skipped = command == LEXER_COMMAND_PAINTING  ? 1
+                : command == LEXER_COMMAND_CLONING ? 2
+                                                   : 0;
+  double ignored;
+  for (int i = 0; i < skipped + 1; i++) {
+    lexer_next_double(&lexer, &ignored);
+  }
+  *radius = next_bomb_radius(&lexer);
+  return true;
+}
+
+// Adds a bomb of a new prefetch batch, unless its polygon is already cached
+// or planned earlier in the batch. Returns the entry that computes the
+// polygon, or -1.
+static int plan_bomb_polygon(BombState *state, const VisibilityCacheKey *key) {
+  PrefetchBatch *batch = &state->batch;
+  if (visibility_cache_contains(state->cache, key)) {
+    return -1;
+  }
+  for (int entry = 0; entry < batch->count; entry++) {
+    if (batch->xs[entry] == key->x && batch->ys[entry] == key->y &&
+        batch->radii[entry] == key->radius) {
+      return -1;
+    }
+  }
+
+  int entry = batch->count++;
+  batch->xs[entry] = key->x;
+  batch->ys[entry] = key->y;
+  batch->radii[entry] = key->radius;
+  batch->polygons[entry] = NULL;
+  return entry;
+}
+
+// Starts a new prefetch batch at the current line: the run of bombs beginning
+// there gets its polygons computed on the pool, all with the current scene and
+// barrier set. Bombs that change either simply recompute their own polygon,
+// and bombs that repeat a source take it from the cache instead.
+static void prefetch_bomb_polygons(City city, BombState *state,
+                                   FileData qry_file_data, int first_line,
+                                   SortType sort_type, int sort_threshold) {
+  release_prefetch_batch(state);
+
+  PrefetchBatch *batch = &state->batch;
+  batch->first_line = first_line;
+
+  VisibilityCacheKey key;
+  get_bomb_key(city, 0.0, 0.0, VISIBILITY_UNBOUNDED, &key);
+  const char *line;
+  while (batch->line_count < PREFETCH_BATCH_SIZE &&
+         (line = file_data_peek_line(qry_file_data, batch->line_count)) !=
+             NULL &&
+         parse_bomb_source(line, &key.x, &key.y, &key.radius)) {
+    batch->entries[batch->line_count] = plan_bomb_polygon(state, &key);
+    batch->line_count++;
+  }
+
+  // A lone polygon gains nothing from the pool; its bomb computes it
+  if (batch->count < 2) {
+    for (int k = 0; k < batch->line_count; k++) {
+      batch->entries[k] = -1;
+    }
+    batch->count = 0;
+    return;
+  }
+
+  batch->min_x = key.min_x;
+  batch->min_y = key.min_y;
+  batch->max_x = key.max_x;
+  batch->max_y = key.max_y;
+  batch->barriers = get_barrier_set(city, state);
+  batch->barrier_version = key.barrier_version;
+  batch->sort_type = sort_type;
+  batch->sort_threshold = sort_threshold;
+
+  int thread_count = thread_pool_get_thread_count(state->pool);
+  batch->task_count = batch->count < thread_count ? batch->count : thread_count;
+  thread_pool_run(state->pool, batch->task_count, prefetch_chunk, batch);
+}
+
+// Destroys the prefetched polygons no bomb took
+static void release_prefetch_batch(BombState *state) {
+  PrefetchBatch *batch = &state->batch;
+  for (int i = 0; i < batch->count; i++) {
+    if (batch->polygons[i] != NULL) {
+      visibility_polygon_destroy(batch->polygons[i]);
+    }
+  }
+  batch->line_count = 0;
+  batch->count = 0;
+}
+
+// Creates one sweep workspace per pool task, so every worker sweeps in its own
+// scratch memory. Entries that fail to allocate stay NULL and make their task
+// use temporary scratch instead.
+static VisibilityWorkspace *create_workspaces(int count) {
+  VisibilityWorkspace *workspaces = malloc(sizeof(VisibilityWorkspace) * count);
+  if (workspaces == NULL) {
+    printf("Error: Failed to allocate memory for sweep workspaces\n");
+    return NULL;
+  }
+  for (int i = 0; i < count; i++) {
+    workspaces[i] = visibility_workspace_create();
+  }
+  return workspaces;
+}
+
+// Destroys the workspaces made by create_workspaces()
+static void destroy_workspaces(VisibilityWorkspace *workspaces, int count) {
+  if (workspaces == NULL) {
+    return;
+  }
+  for (int i = 0; i < count; i++) {
+    visibility_workspace_destroy(workspaces[i]);
+  }
+  free(workspaces);
+}
+
+// Adds a candidate shape to the query result if it is inside the region
+static void collect_visible_shape(void *item, void *user_data) {
+  RegionQuery *query = (RegionQuery *)user_data;
+  if (shape_in_visibility_region((Shape)item, query->polygon)) {
+    sequence_append(query->found, item);
+  }
+}
+
+// Collects, in shapes list order, the shapes inside a visibility region. Only
+// shapes near the polygon bounding box are tested.
+static Sequence find_shapes_in_visibility_region(City city,
+                                                 VisibilityPolygon polygon) {
+  RegionQuery query = {polygon, sequence_create()};
+
+  double min_x, min_y, max_x, max_y;
+  if (!visibility_polygon_get_bounds(polygon, &min_x, &min_y, &max_x,
+                                     &max_y)) {
+    return query.found;
+  }
+
+  city_query_box(city, min_x - VISIBILITY_QUERY_MARGIN,
+                 min_y - VISIBILITY_QUERY_MARGIN,
+                 max_x + VISIBILITY_QUERY_MARGIN,
+                 max_y + VISIBILITY_QUERY_MARGIN, collect_visible_shape,
+                 &query);
+  return query.found;
+}
+
 // Helper to check if a point lies on a segment (within tolerance)
 static bool point_on_segment(double px, double py, double x1, double y1,
                              double x2, double y2) {
@@ -762,18 +1176,55 @@ static bool point_on_segment(double px, double py, double x1, double y1,
   return px >= min_x && px <= max_x && py >= min_y && py <= max_y;
 }
 
+// Check if a box, grown by the query margin, overlaps the polygon bounding box.
+// Every visibility test below fails for shapes outside of it.
+static bool overlaps_polygon_bounds(double min_x, double min_y, double max_x,
+                                    double max_y, VisibilityPolygon polygon) {
+  double poly_min_x, poly_min_y, poly_max_x, poly_max_y;
+  if (!visibility_polygon_get_bounds(polygon, &poly_min_x, &poly_min_y,
+                                     &poly_max_x, &poly_max_y)) {
+    return false;
+  }
+
+  return min_x - VISIBILITY_QUERY_MARGIN <= poly_max_x &&
+         max_x + VISIBILITY_QUERY_MARGIN >= poly_min_x &&
+         min_y - VISIBILITY_QUERY_MARGIN <= poly_max_y &&
+         max_y + VISIBILITY_QUERY_MARGIN >= poly_min_y;
+}
+
+// Visits the polygon edges near a y range, widened by the query margin
+static VisibilityEdgeCursor edges_near(VisibilityPolygon polygon, double min_y,
+                                       double max_y) {
+  return visibility_polygon_edges_in_range(polygon,
+                                           min_y - VISIBILITY_QUERY_MARGIN,
+                                           max_y + VISIBILITY_QUERY_MARGIN);
+}
+
+// Collects the next edges of a cursor, returning how many it got (0 once the
+// cursor is done)
+static int next_edge_batch(VisibilityEdgeCursor *cursor, int *edges) {
+  int count = 0;
+  while (count < EDGE_BATCH_SIZE &&
+         visibility_edge_cursor_next(cursor, &edges[count])) {
+    count++;
+  }
+  return count;
+}
+
 // Check if a point is on the boundary of the polygon
 static bool point_on_polygon_boundary(double px, double py,
                                       VisibilityPolygon polygon) {
-  Point *vertices = visibility_polygon_get_vertices(polygon);
+  const double *xy = visibility_polygon_get_coords(polygon);
   int count = visibility_polygon_get_vertex_count(polygon);
 
-  for (int i = 0; i < count; i++) {
-    int j = (i + 1) % count;
-    double vx1 = geometry_point_get_x(vertices[i]);
-    double vy1 = geometry_point_get_y(vertices[i]);
-    double vx2 = geometry_point_get_x(vertices[j]);
-    double vy2 = geometry_point_get_y(vertices[j]);
+  VisibilityEdgeCursor edges = edges_near(polygon, py, py);
+  int i;
+  while (visibility_edge_cursor_next(&edges, &i)) {
+    int j = i + 1 < count ? i + 1 : 0;
+    double vx1 = xy[2 * i];
+    double vy1 = xy[2 * i + 1];
+    double vx2 = xy[2 * j];
+    double vy2 = xy[2 * j + 1];
 
     if (point_on_segment(px, py, vx1, vy1, vx2, vy2)) {
       return true;
@@ -784,7 +1235,12 @@ static bool point_on_polygon_boundary(double px, double py,
 
 static bool is_segment_visible(double x1, double y1, double x2, double y2,
                                VisibilityPolygon polygon) {
-  Point *vertices = visibility_polygon_get_vertices(polygon);
+  if (!overlaps_polygon_bounds(fmin(x1, x2), fmin(y1, y2), fmax(x1, x2),
+                               fmax(y1, y2), polygon)) {
+    return false;
+  }
+
+  const double *xy = visibility_polygon_get_coords(polygon);
   int count = visibility_polygon_get_vertex_count(polygon);
 
   // 1. Check if endpoints are inside
@@ -800,15 +1256,12 @@ static bool is_segment_visible(double x1, double y1, double x2, double y2,
   }
 
   // 3. Check intersection with polygon edges
-  for (int i = 0; i < count; i++) {
-    int j = (i + 1) % count;
-    double px1 = geometry_point_get_x(vertices[i]);
-    double py1 = geometry_point_get_y(vertices[i]);
-    double px2 = geometry_point_get_x(vertices[j]);
-    double py2 = geometry_point_get_y(vertices[j]);
-
-    if (geometry_segment_intersects_segment(x1, y1, x2, y2, px1, py1, px2,
-                                            py2)) {
+  VisibilityEdgeCursor edges = edges_near(polygon, fmin(y1, y2), fmax(y1, y2));
+  int batch[EDGE_BATCH_SIZE];
+  int batch_count;
+  while ((batch_count = next_edge_batch(&edges, batch)) > 0) {
+    if (geometry_segment_crosses_edges(x1, y1, x2, y2, xy, count, batch,
+                                       batch_count)) {
       return true;
     }
   }
@@ -830,6 +1283,10 @@ static bool is_rectangle_visible(Rectangle rect, VisibilityPolygon polygon) {
   double rw = rectangle_get_width(rect);
   double rh = rectangle_get_height(rect);
 
+  if (!overlaps_polygon_bounds(rx, ry, rx + rw, ry + rh, polygon)) {
+    return false;
+  }
+
   // Vertices of rectangle
   double vx[4] = {rx, rx + rw, rx + rw, rx};
   double vy[4] = {ry, ry, ry + rh, ry + rh};
@@ -841,33 +1298,28 @@ static bool is_rectangle_visible(Rectangle rect, VisibilityPolygon polygon) {
     }
   }
 
-  Point *poly_verts = visibility_polygon_get_vertices(polygon);
+  const double *xy = visibility_polygon_get_coords(polygon);
   int count = visibility_polygon_get_vertex_count(polygon);
 
-  // 2. Check if any polygon vertex is inside rect
-  for (int i = 0; i < count; i++) {
-    if (is_point_in_rect(geometry_point_get_x(poly_verts[i]),
-                         geometry_point_get_y(poly_verts[i]), rect)) {
+  // 2. Check if any polygon vertex is inside rect (vertex j starts edge j, so
+  // the edges near the rect cover every vertex inside it)
+  VisibilityEdgeCursor edges = edges_near(polygon, ry, ry + rh);
+  int j;
+  while (visibility_edge_cursor_next(&edges, &j)) {
+    if (is_point_in_rect(xy[2 * j], xy[2 * j + 1], rect)) {
       return true;
     }
   }
 
   // 3. Check intersection of edges
-  for (int i = 0; i < 4; i++) {
-    double r_x1 = vx[i];
-    double r_y1 = vy[i];
-    double r_x2 = vx[(i + 1) % 4];
-    double r_y2 = vy[(i + 1) % 4];
-
-    for (int j = 0; j < count; j++) {
-      int k = (j + 1) % count;
-      double p_x1 = geometry_point_get_x(poly_verts[j]);
-      double p_y1 = geometry_point_get_y(poly_verts[j]);
-      double p_x2 = geometry_point_get_x(poly_verts[k]);
-      double p_y2 = geometry_point_get_y(poly_verts[k]);
-
-      if (geometry_segment_intersects_segment(r_x1, r_y1, r_x2, r_y2, p_x1,
-                                              p_y1, p_x2, p_y2)) {
+  edges = edges_near(polygon, ry, ry + rh);
+  int batch[EDGE_BATCH_SIZE];
+  int batch_count;
+  while ((batch_count = next_edge_batch(&edges, batch)) > 0) {
+    for (int i = 0; i < 4; i++) {
+      if (geometry_segment_crosses_edges(vx[i], vy[i], vx[(i + 1) % 4],
+                                         vy[(i + 1) % 4], xy, count, batch,
+                                         batch_count)) {
         return true;
       }
     }
@@ -881,32 +1333,36 @@ static bool is_circle_visible(Circle circle, VisibilityPolygon polygon) {
   double cy = circle_get_y(circle);
   double r = circle_get_radius(circle);
 
+  if (!overlaps_polygon_bounds(cx - r, cy - r, cx + r, cy + r, polygon)) {
+    return false;
+  }
+
   // 1. Check if center is inside
   if (visibility_polygon_contains_point(polygon, cx, cy)) {
     return true;
   }
 
-  Point *poly_verts = visibility_polygon_get_vertices(polygon);
+  const double *xy = visibility_polygon_get_coords(polygon);
   int count = visibility_polygon_get_vertex_count(polygon);
 
   // 2. Check if any polygon vertex is inside circle
-  for (int i = 0; i < count; i++) {
-    double px = geometry_point_get_x(poly_verts[i]);
-    double py = geometry_point_get_y(poly_verts[i]);
+  VisibilityEdgeCursor edges = edges_near(polygon, cy - r, cy + r);
+  int i;
+  while (visibility_edge_cursor_next(&edges, &i)) {
+    double px = xy[2 * i];
+    double py = xy[2 * i + 1];
     if (geometry_distance(cx, cy, px, py) <= r) {
       return true;
     }
   }
 
   // 3. Check if any polygon edge intersects circle (dist to center <= r)
-  for (int i = 0; i < count; i++) {
-    int j = (i + 1) % count;
-    double px1 = geometry_point_get_x(poly_verts[i]);
-    double py1 = geometry_point_get_y(poly_verts[i]);
-    double px2 = geometry_point_get_x(poly_verts[j]);
-    double py2 = geometry_point_get_y(poly_verts[j]);
-
-    if (geometry_distance_point_segment(cx, cy, px1, py1, px2, py2) <= r) {
+  edges = edges_near(polygon, cy - r, cy + r);
+  int batch[EDGE_BATCH_SIZE];
+  int batch_count;
+  while ((batch_count = next_edge_batch(&edges, batch)) > 0) {
+    if (geometry_edges_within_distance(cx, cy, r, xy, count, batch,
+                                       batch_count)) {
       return true;
     }
   }
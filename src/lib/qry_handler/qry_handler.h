@@ -14,17 +14,33 @@
 #include "../commons/sorting/sorting.h"
 #include "../file_reader/file_reader.h"
 
+/**
+ * @brief Statistics of a processed .qry file
+ */
+typedef struct {
+  long visibility_cache_hits;   /**< Bombs that reused a cached polygon */
+  long visibility_cache_misses; /**< Bombs that needed a polygon of their own */
+} QryStats;
+
 /**
  * @brief Processes a .qry file and executes commands on the city
  * @param city City instance to operate on
  * @param geo_file_data File data from .geo file (for SVG naming)
  * @param qry_file_data File data containing .qry file lines
  * @param output_path Path to the output directory
- * @param sort_type Sorting algorithm to use (SORT_QSORT or SORT_MERGESORT)
+ * @param sort_type Sorting algorithm to use (SORT_QSORT, SORT_MERGESORT or
+ * SORT_RADIX)
  * @param sort_threshold Threshold for InsertionSort (only for SORT_MERGESORT)
+ * @param thread_count Threads used to compute the visibility polygons of
+ * consecutive bombs ahead of time (1 computes them serially). The output does
+ * not depend on this value.
+ * @param stats Filled with the statistics of the run (can be NULL)
+ * @return true if every command of the file was run, false if the file could
+ * not be read to the end or the output could not be created
  */
-void qry_handler_process_file(City city, FileData geo_file_data,
+bool qry_handler_process_file(City city, FileData geo_file_data,
                               FileData qry_file_data, const char *output_path,
-                              SortType sort_type, int sort_threshold);
+                              SortType sort_type, int sort_threshold,
+                              int thread_count, QryStats *stats);
 
 #endif // QRY_HANDLER_H
\ No newline at end of file
@@ -1,5 +1,4 @@
 #include "circle.h"
-#include "../../commons/utils/utils.h"
 #include <stdlib.h>
 #include <string.h>
 /**
@@ -10,17 +9,27 @@ struct Circle {
   double x;
   double y;
   double radius;
-  char *border_color;
-  char *fill_color;
+  const char *border_color;
+  const char *fill_color;
+  ShapeStore store; // Store the circle and its colors came from, or NULL
+  // Cached SVG element, dropped on every change
+  ShapeFragment fragment;
 };
 
 void *circle_create(int id, double x, double y, double radius,
                     const char *border_color, const char *fill_color) {
+  return circle_create_in(NULL, id, x, y, radius, border_color, fill_color);
+}
+
+void *circle_create_in(ShapeStore store, int id, double x, double y,
+                       double radius, const char *border_color,
+                       const char *fill_color) {
   if (!border_color || !fill_color) {
     return NULL;
   }
 
-  struct Circle *circle = malloc(sizeof(struct Circle));
+  struct Circle *circle =
+      shape_store_alloc(store, CIRCLE, sizeof(struct Circle));
   if (!circle) {
     return NULL;
   }
@@ -29,22 +38,25 @@ void *circle_create(int id, double x, double y, double radius,
   circle->x = x;
   circle->y = y;
   circle->radius = radius;
+  circle->store = store;
+  circle->fragment.bytes = NULL;
+  circle->fragment.length = 0;
 
-  circle->border_color = duplicate_string(border_color);
+  circle->border_color = shape_store_copy_string(store, border_color);
   if (!circle->border_color) {
-    free(circle);
+    shape_store_free(store, CIRCLE, circle);
     return NULL;
   }
 
-  circle->fill_color = duplicate_string(fill_color);
+  circle->fill_color = shape_store_copy_string(store, fill_color);
   if (!circle->fill_color) {
-    free(circle->border_color);
-    free(circle);
+    shape_store_drop_string(store, circle->border_color);
+    shape_store_free(store, CIRCLE, circle);
     return NULL;
   }
 
   // Wrap the circle in a Shape wrapper
-  return shape_create_wrapper(CIRCLE, circle);
+  return shape_create_wrapper_in(store, CIRCLE, circle);
 }
 
 void circle_destroy(void *circle) {
@@ -52,9 +64,10 @@ void circle_destroy(void *circle) {
     return;
 
   struct Circle *c = (struct Circle *)circle;
-  free(c->border_color);
-  free(c->fill_color);
-  free(c);
+  shape_store_drop_string(c->store, c->border_color);
+  shape_store_drop_string(c->store, c->fill_color);
+  shape_fragment_clear(&c->fragment);
+  shape_store_free(c->store, CIRCLE, c);
 }
 
 int circle_get_id(void *circle) {
@@ -101,10 +114,17 @@ void circle_set_colors(void *circle, const char *color) {
   struct Circle *c = (struct Circle *)circle;
 
   // Free old colors
-  free(c->border_color);
-  free(c->fill_color);
+  shape_store_drop_string(c->store, c->border_color);
+  shape_store_drop_string(c->store, c->fill_color);
 
   // Set new colors
-  c->border_color = duplicate_string(color);
-  c->fill_color = duplicate_string(color);
+  c->border_color = shape_store_copy_string(c->store, color);
+  c->fill_color = shape_store_copy_string(c->store, color);
+  shape_fragment_clear(&c->fragment);
+}
+
+ShapeFragment *circle_get_fragment(void *circle) {
+  if (!circle)
+    return NULL;
+  return &((struct Circle *)circle)->fragment;
 }
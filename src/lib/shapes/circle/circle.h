@@ -24,6 +24,21 @@ typedef void *Circle;
 Shape circle_create(int id, double x, double y, double radius,
                     const char *border_color, const char *fill_color);
 
+/**
+ * Creates a new circle instance inside a shape store
+ * @param store Store to allocate from (NULL uses the heap)
+ * @param id Circle identifier
+ * @param x X coordinate of center
+ * @param y Y coordinate of center
+ * @param radius Circle radius
+ * @param border_color Border color string
+ * @param fill_color Fill color string
+ * @return Pointer to new Shape wrapper or NULL on error
+ */
+Shape circle_create_in(ShapeStore store, int id, double x, double y,
+                       double radius, const char *border_color,
+                       const char *fill_color);
+
 /**
  * Destroys a circle instance and frees all memory
  * @param circle Circle instance to destroy
@@ -79,4 +94,12 @@ const char *circle_get_fill_color(Circle circle);
  */
 void circle_set_colors(Circle circle, const char *color);
 
+/**
+ * Gets the cached SVG fragment of the circle, which is dropped whenever its
+ * colors change
+ * @param circle Circle instance
+ * @return Fragment cache owned by the circle
+ */
+ShapeFragment *circle_get_fragment(Circle circle);
+
 #endif // CIRCLE_H
@@ -1,5 +1,4 @@
 #include "line.h"
-#include "../../commons/utils/utils.h"
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,17 +12,25 @@ struct Line {
   double y1;
   double x2;
   double y2;
-  char *color;
+  const char *color;
   bool is_barrier; // true if this line is a barrier (anteparo), false otherwise
+  ShapeStore store; // Store the line and its color came from, or NULL
+  // Cached SVG element, dropped on every change
+  ShapeFragment fragment;
 };
 
 void *line_create(int id, double x1, double y1, double x2, double y2,
                   const char *color) {
+  return line_create_in(NULL, id, x1, y1, x2, y2, color);
+}
+
+void *line_create_in(ShapeStore store, int id, double x1, double y1,
+                     double x2, double y2, const char *color) {
   if (!color) {
     return NULL;
   }
 
-  struct Line *line = malloc(sizeof(struct Line));
+  struct Line *line = shape_store_alloc(store, LINE, sizeof(struct Line));
   if (!line) {
     return NULL;
   }
@@ -34,15 +41,18 @@ void *line_create(int id, double x1, double y1, double x2, double y2,
   line->x2 = x2;
   line->y2 = y2;
   line->is_barrier = false; // Default: not a barrier
+  line->store = store;
+  line->fragment.bytes = NULL;
+  line->fragment.length = 0;
 
-  line->color = duplicate_string(color);
+  line->color = shape_store_copy_string(store, color);
   if (!line->color) {
-    free(line);
+    shape_store_free(store, LINE, line);
     return NULL;
   }
 
   // Wrap the line in a Shape wrapper
-  return shape_create_wrapper(LINE, line);
+  return shape_create_wrapper_in(store, LINE, line);
 }
 
 void line_destroy(void *line) {
@@ -50,8 +60,9 @@ void line_destroy(void *line) {
     return;
 
   struct Line *l = (struct Line *)line;
-  free(l->color);
-  free(l);
+  shape_store_drop_string(l->store, l->color);
+  shape_fragment_clear(&l->fragment);
+  shape_store_free(l->store, LINE, l);
 }
 
 int line_get_id(void *line) {
@@ -109,6 +120,13 @@ void line_set_color(void *line, const char *color) {
 
   struct Line *l = (struct Line *)line;
 
-  free(l->color);
-  l->color = duplicate_string(color);
+  shape_store_drop_string(l->store, l->color);
+  l->color = shape_store_copy_string(l->store, color);
+  shape_fragment_clear(&l->fragment);
+}
+
+ShapeFragment *line_get_fragment(void *line) {
+  if (!line)
+    return NULL;
+  return &((struct Line *)line)->fragment;
 }
@@ -26,6 +26,20 @@ typedef void *Line;
 Shape line_create(int id, double x1, double y1, double x2, double y2,
                   const char *color);
 
+/**
+ * Creates a new line instance inside a shape store
+ * @param store Store to allocate from (NULL uses the heap)
+ * @param id Line identifier
+ * @param x1 X coordinate of start point
+ * @param y1 Y coordinate of start point
+ * @param x2 X coordinate of end point
+ * @param y2 Y coordinate of end point
+ * @param color Line color string
+ * @return Pointer to new Shape wrapper or NULL on error
+ */
+Shape line_create_in(ShapeStore store, int id, double x1, double y1,
+                     double x2, double y2, const char *color);
+
 /**
  * Destroys a line instance and frees all memory
  * @param line Line instance to destroy
@@ -95,4 +109,12 @@ bool line_is_barrier(Line line);
  */
 void line_set_barrier(Line line, bool is_barrier);
 
+/**
+ * Gets the cached SVG fragment of the line, which is dropped whenever its
+ * colors change
+ * @param line Line instance
+ * @return Fragment cache owned by the line
+ */
+ShapeFragment *line_get_fragment(Line line);
+
 #endif // LINE_H
@@ -1,5 +1,4 @@
 #include "rectangle.h"
-#include "../../commons/utils/utils.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -12,17 +11,28 @@ struct Rectangle {
   double y;
   double width;
   double height;
-  char *border_color;
-  char *fill_color;
+  const char *border_color;
+  const char *fill_color;
+  ShapeStore store; // Store the rectangle and its colors came from, or NULL
+  // Cached SVG element, dropped on every change
+  ShapeFragment fragment;
 };
 
 void *rectangle_create(int id, double x, double y, double width, double height,
                        const char *border_color, const char *fill_color) {
+  return rectangle_create_in(NULL, id, x, y, width, height, border_color,
+                             fill_color);
+}
+
+void *rectangle_create_in(ShapeStore store, int id, double x, double y,
+                          double width, double height,
+                          const char *border_color, const char *fill_color) {
   if (!border_color || !fill_color) {
     return NULL;
   }
 
-  struct Rectangle *rectangle = malloc(sizeof(struct Rectangle));
+  struct Rectangle *rectangle =
+      shape_store_alloc(store, RECTANGLE, sizeof(struct Rectangle));
   if (!rectangle) {
     return NULL;
   }
@@ -32,22 +42,25 @@ void *rectangle_create(int id, double x, double y, double width, double height,
   rectangle->y = y;
   rectangle->width = width;
   rectangle->height = height;
+  rectangle->store = store;
+  rectangle->fragment.bytes = NULL;
+  rectangle->fragment.length = 0;
 
-  rectangle->border_color = duplicate_string(border_color);
+  rectangle->border_color = shape_store_copy_string(store, border_color);
   if (!rectangle->border_color) {
-    free(rectangle);
+    shape_store_free(store, RECTANGLE, rectangle);
     return NULL;
   }
 
-  rectangle->fill_color = duplicate_string(fill_color);
+  rectangle->fill_color = shape_store_copy_string(store, fill_color);
   if (!rectangle->fill_color) {
-    free(rectangle->border_color);
-    free(rectangle);
+    shape_store_drop_string(store, rectangle->border_color);
+    shape_store_free(store, RECTANGLE, rectangle);
     return NULL;
   }
 
   // Wrap the rectangle in a Shape wrapper
-  return shape_create_wrapper(RECTANGLE, rectangle);
+  return shape_create_wrapper_in(store, RECTANGLE, rectangle);
 }
 
 void rectangle_destroy(void *rectangle) {
@@ -55,9 +68,10 @@ void rectangle_destroy(void *rectangle) {
     return;
 
   struct Rectangle *r = (struct Rectangle *)rectangle;
-  free(r->border_color);
-  free(r->fill_color);
-  free(r);
+  shape_store_drop_string(r->store, r->border_color);
+  shape_store_drop_string(r->store, r->fill_color);
+  shape_fragment_clear(&r->fragment);
+  shape_store_free(r->store, RECTANGLE, r);
 }
 
 int rectangle_get_id(void *rectangle) {
@@ -109,9 +123,16 @@ void rectangle_set_colors(void *rectangle, const char *color) {
 
   struct Rectangle *r = (struct Rectangle *)rectangle;
 
-  free(r->border_color);
-  free(r->fill_color);
+  shape_store_drop_string(r->store, r->border_color);
+  shape_store_drop_string(r->store, r->fill_color);
+
+  r->border_color = shape_store_copy_string(r->store, color);
+  r->fill_color = shape_store_copy_string(r->store, color);
+  shape_fragment_clear(&r->fragment);
+}
 
-  r->border_color = duplicate_string(color);
-  r->fill_color = duplicate_string(color);
+ShapeFragment *rectangle_get_fragment(void *rectangle) {
+  if (!rectangle)
+    return NULL;
+  return &((struct Rectangle *)rectangle)->fragment;
 }
@@ -25,6 +25,22 @@ typedef void *Rectangle;
 Shape rectangle_create(int id, double x, double y, double width, double height,
                        const char *border_color, const char *fill_color);
 
+/**
+ * Creates a new rectangle instance inside a shape store
+ * @param store Store to allocate from (NULL uses the heap)
+ * @param id Rectangle identifier
+ * @param x X coordinate of anchor point
+ * @param y Y coordinate of anchor point
+ * @param width Rectangle width
+ * @param height Rectangle height
+ * @param border_color Border color string
+ * @param fill_color Fill color string
+ * @return Pointer to new Shape wrapper or NULL on error
+ */
+Shape rectangle_create_in(ShapeStore store, int id, double x, double y,
+                          double width, double height,
+                          const char *border_color, const char *fill_color);
+
 /**
  * Destroys a rectangle instance and frees all memory
  * @param rectangle Rectangle instance to destroy
@@ -87,4 +103,12 @@ const char *rectangle_get_fill_color(Rectangle rectangle);
  */
 void rectangle_set_colors(Rectangle rectangle, const char *color);
 
+/**
+ * Gets the cached SVG fragment of the rectangle, which is dropped whenever its
+ * colors change
+ * @param rectangle Rectangle instance
+ * @return Fragment cache owned by the rectangle
+ */
+ShapeFragment *rectangle_get_fragment(Rectangle rectangle);
+
 #endif // RECTANGLE_H
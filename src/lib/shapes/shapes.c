@@ -4,7 +4,22 @@
 #include "rectangle/rectangle.h"
 #include "text/text.h"
 #include "text_style/text_style.h"
+#include "../commons/arena/arena.h"
+#include "../commons/utils/utils.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+// Pool of the wrappers, after the pools of each shape type
+#define WRAPPER_POOL (TEXT_STYLE + 1)
+#define POOL_COUNT (WRAPPER_POOL + 1)
+// Size of the first block of each pool and of the string arena
+#define STORE_BLOCK_SIZE (16 * 1024)
+// Initial number of slots of the string set (a power of two)
+#define STRING_SET_INITIAL_SLOTS 64
 
 /**
  * Internal Shape structure that wraps all shape types
@@ -12,8 +27,265 @@
 struct ShapeWrapper {
   ShapeType type;
   void *shape;
+  ShapeStore store; // Store the wrapper and shape came from, or NULL
 };
 
+// Freed object waiting to be handed out again by its pool
+typedef struct FreeSlot {
+  struct FreeSlot *next;
+} FreeSlot;
+
+// Objects of one size, carved out of an arena and recycled through a list
+typedef struct {
+  Arena arena;
+  FreeSlot *free_slots;
+} ShapePool;
+
+typedef struct ShapeStoreImpl {
+  ShapePool pools[POOL_COUNT];
+  Arena strings;                     // Bytes of the interned strings
+  const char **string_slots;         // Open addressing set of interned strings
+  size_t slot_count;                 // Always a power of two
+  size_t used_slots;                 //
+  struct ShapeStoreImpl *children;   // Stores created from this one
+  pthread_mutex_t lock;              // Guards everything above
+  struct ShapeStoreImpl *owner;      // Store this one was created from, or NULL
+  struct ShapeStoreImpl *next_child; // Next store of the same owner
+} ShapeStoreImpl;
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+/**
+ * Hashes a string with FNV-1a.
+ */
+static uint64_t hash_string(const char *text) {
+  uint64_t hash = 1469598103934665603ULL;
+  for (const unsigned char *c = (const unsigned char *)text; *c; c++) {
+    hash ^= *c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/**
+ * Gets an object from a pool, reusing freed ones first. Called with the lock
+ * held.
+ */
+static void *pool_alloc(ShapePool *pool, size_t size) {
+  if (pool->free_slots != NULL) {
+    FreeSlot *slot = pool->free_slots;
+    pool->free_slots = slot->next;
+    return slot;
+  }
+  if (size < sizeof(FreeSlot)) {
+    size = sizeof(FreeSlot);
+  }
+  return arena_alloc(pool->arena, size);
+}
+
+/**
+ * Doubles the string set and rehashes it. Called with the lock held.
+ */
+static bool grow_string_set(ShapeStoreImpl *impl) {
+  size_t slot_count = impl->slot_count * 2;
+  const char **slots = calloc(slot_count, sizeof(const char *));
+  if (slots == NULL) {
+    printf("Error: Failed to allocate memory for string set\n");
+    return false;
+  }
+
+  for (size_t i = 0; i < impl->slot_count; i++) {
+    const char *text = impl->string_slots[i];
+    if (text == NULL) {
+      continue;
+    }
+    size_t slot = (size_t)hash_string(text) & (slot_count - 1);
+    while (slots[slot] != NULL) {
+      slot = (slot + 1) & (slot_count - 1);
+    }
+    slots[slot] = text;
+  }
+
+  free(impl->string_slots);
+  impl->string_slots = slots;
+  impl->slot_count = slot_count;
+  return true;
+}
+
+/**
+ * Finds a string in the set, adding a copy if it is not there yet. Called
+ * with the lock held.
+ */
+static const char *intern_string(ShapeStoreImpl *impl, const char *text) {
+  if ((impl->used_slots + 1) * 2 > impl->slot_count &&
+      !grow_string_set(impl)) {
+    return NULL;
+  }
+
+  size_t mask = impl->slot_count - 1;
+  size_t slot = (size_t)hash_string(text) & mask;
+  while (impl->string_slots[slot] != NULL) {
+    if (strcmp(impl->string_slots[slot], text) == 0) {
+      return impl->string_slots[slot];
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  size_t length = strlen(text) + 1;
+  char *copy = arena_alloc(impl->strings, length);
+  if (copy == NULL) {
+    return NULL;
+  }
+  memcpy(copy, text, length);
+  impl->string_slots[slot] = copy;
+  impl->used_slots++;
+  return copy;
+}
+
+// ============================================================================
+// Shape Store
+// ============================================================================
+
+ShapeStore shape_store_create(void) {
+  ShapeStoreImpl *impl = calloc(1, sizeof(ShapeStoreImpl));
+  if (impl == NULL) {
+    printf("Error: Failed to allocate memory for ShapeStore\n");
+    return NULL;
+  }
+
+  bool ok = true;
+  for (int i = 0; i < POOL_COUNT; i++) {
+    impl->pools[i].arena = arena_create(STORE_BLOCK_SIZE);
+    ok = ok && impl->pools[i].arena != NULL;
+  }
+  impl->strings = arena_create(STORE_BLOCK_SIZE);
+  impl->string_slots = calloc(STRING_SET_INITIAL_SLOTS, sizeof(const char *));
+  impl->slot_count = STRING_SET_INITIAL_SLOTS;
+  if (!ok || impl->strings == NULL || impl->string_slots == NULL ||
+      pthread_mutex_init(&impl->lock, NULL) != 0) {
+    printf("Error: Failed to allocate memory for ShapeStore\n");
+    for (int i = 0; i < POOL_COUNT; i++) {
+      arena_destroy(impl->pools[i].arena);
+    }
+    arena_destroy(impl->strings);
+    free(impl->string_slots);
+    free(impl);
+    return NULL;
+  }
+
+  return (ShapeStore)impl;
+}
+
+ShapeStore shape_store_create_child(ShapeStore owner) {
+  if (owner == NULL) {
+    return NULL;
+  }
+
+  ShapeStoreImpl *root = (ShapeStoreImpl *)shape_store_get_owner(owner);
+  ShapeStoreImpl *child = (ShapeStoreImpl *)shape_store_create();
+  if (child == NULL) {
+    return NULL;
+  }
+
+  child->owner = root;
+  pthread_mutex_lock(&root->lock);
+  child->next_child = root->children;
+  root->children = child;
+  pthread_mutex_unlock(&root->lock);
+  return (ShapeStore)child;
+}
+
+ShapeStore shape_store_get_owner(ShapeStore store) {
+  if (store == NULL) {
+    return NULL;
+  }
+  ShapeStoreImpl *impl = (ShapeStoreImpl *)store;
+  return impl->owner != NULL ? (ShapeStore)impl->owner : store;
+}
+
+void shape_store_destroy(ShapeStore store) {
+  if (store == NULL) {
+    return;
+  }
+
+  ShapeStoreImpl *impl = (ShapeStoreImpl *)store;
+  if (impl->owner != NULL) {
+    // Children go with their owner
+    return;
+  }
+  while (impl->children != NULL) {
+    ShapeStoreImpl *child = impl->children;
+    impl->children = child->next_child;
+    child->owner = NULL;
+    shape_store_destroy((ShapeStore)child);
+  }
+  for (int i = 0; i < POOL_COUNT; i++) {
+    arena_destroy(impl->pools[i].arena);
+  }
+  arena_destroy(impl->strings);
+  free(impl->string_slots);
+  pthread_mutex_destroy(&impl->lock);
+  free(impl);
+}
+
+void *shape_store_alloc(ShapeStore store, ShapeType type, size_t size) {
+  if (store == NULL) {
+    return malloc(size);
+  }
+
+  ShapeStoreImpl *impl = (ShapeStoreImpl *)store;
+  pthread_mutex_lock(&impl->lock);
+  void *object = pool_alloc(&impl->pools[type], size);
+  pthread_mutex_unlock(&impl->lock);
+  return object;
+}
+
+void shape_store_free(ShapeStore store, ShapeType type, void *object) {
+  if (store == NULL) {
+    free(object);
+    return;
+  }
+  if (object == NULL) {
+    return;
+  }
+
+  ShapeStoreImpl *impl = (ShapeStoreImpl *)store;
+  ShapePool *pool = &impl->pools[type];
+  pthread_mutex_lock(&impl->lock);
+  FreeSlot *slot = (FreeSlot *)object;
+  slot->next = pool->free_slots;
+  pool->free_slots = slot;
+  pthread_mutex_unlock(&impl->lock);
+}
+
+const char *shape_store_copy_string(ShapeStore store, const char *text) {
+  if (text == NULL) {
+    return NULL;
+  }
+  if (store == NULL) {
+    return duplicate_string(text);
+  }
+
+  ShapeStoreImpl *impl = (ShapeStoreImpl *)store;
+  pthread_mutex_lock(&impl->lock);
+  const char *copy = intern_string(impl, text);
+  pthread_mutex_unlock(&impl->lock);
+  return copy;
+}
+
+void shape_store_drop_string(ShapeStore store, const char *text) {
+  // Interned strings live as long as their store
+  if (store == NULL) {
+    free((char *)text);
+  }
+}
+
+// ============================================================================
+// Shape Wrapper
+// ============================================================================
+
 /**
  * Creates a new Shape wrapper
  * @param type The type of shape
@@ -21,17 +293,23 @@ struct ShapeWrapper {
  * @return Pointer to new Shape wrapper or NULL on error
  */
 Shape shape_create_wrapper(ShapeType type, void *shape) {
+  return shape_create_wrapper_in(NULL, type, shape);
+}
+
+Shape shape_create_wrapper_in(ShapeStore store, ShapeType type, void *shape) {
   if (!shape) {
     return NULL;
   }
 
-  struct ShapeWrapper *wrapper = malloc(sizeof(struct ShapeWrapper));
+  struct ShapeWrapper *wrapper =
+      shape_store_alloc(store, WRAPPER_POOL, sizeof(struct ShapeWrapper));
   if (!wrapper) {
     return NULL;
   }
 
   wrapper->type = type;
   wrapper->shape = shape;
+  wrapper->store = store;
 
   return (Shape)wrapper;
 }
@@ -44,6 +322,14 @@ ShapeType shape_get_type(Shape shape) {
   return wrapper->type;
 }
 
+ShapeStore shape_get_store(Shape shape) {
+  if (!shape) {
+    return NULL;
+  }
+  struct ShapeWrapper *wrapper = (struct ShapeWrapper *)shape;
+  return wrapper->store;
+}
+
 void *shape_get_shape(Shape shape) {
   if (!shape) {
     return NULL;
@@ -52,6 +338,35 @@ void *shape_get_shape(Shape shape) {
   return wrapper->shape;
 }
 
+ShapeFragment *shape_get_fragment(Shape shape) {
+  if (!shape) {
+    return NULL;
+  }
+
+  struct ShapeWrapper *wrapper = (struct ShapeWrapper *)shape;
+  switch (wrapper->type) {
+  case CIRCLE:
+    return circle_get_fragment(wrapper->shape);
+  case RECTANGLE:
+    return rectangle_get_fragment(wrapper->shape);
+  case LINE:
+    return line_get_fragment(wrapper->shape);
+  case TEXT:
+    return text_get_fragment(wrapper->shape);
+  default:
+    return NULL;
+  }
+}
+
+void shape_fragment_clear(ShapeFragment *fragment) {
+  if (!fragment) {
+    return;
+  }
+  free(fragment->bytes);
+  fragment->bytes = NULL;
+  fragment->length = 0;
+}
+
 void shape_destroy(Shape shape) {
   if (!shape) {
     return;
@@ -79,7 +394,7 @@ void shape_destroy(Shape shape) {
   }
 
   // Free the wrapper itself
-  free(wrapper);
+  shape_store_free(wrapper->store, WRAPPER_POOL, wrapper);
 }
 
 Shape shape_create_circle(int id, double x, double y, double radius,
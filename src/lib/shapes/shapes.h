@@ -5,11 +5,17 @@
  * This module defines the enumeration of all geometric shape types
  * supported in the system and provides a unified Shape type that
  * wraps all specific shape types.
+ *
+ * Shapes are either allocated one by one on the heap or carved out of a
+ * ShapeStore, which keeps each shape type in its own pool of large blocks,
+ * stores every distinct color string once and frees everything at once.
  */
 
 #ifndef SHAPES_H
 #define SHAPES_H
 
+#include <stddef.h>
+
 /**
  * @brief Enumeration of geometric shape types
  */
@@ -31,6 +37,22 @@ typedef enum ShapeType ShapeType;
  */
 typedef void *Shape;
 
+/**
+ * @brief Opaque pointer to a pool of shapes and interned strings
+ */
+typedef void *ShapeStore;
+
+/**
+ * @brief Serialized form of a shape, cached for whoever renders it
+ *
+ * Owned by the shape, which drops it whenever it changes and when it is
+ * destroyed. Renderers fill it in lazily.
+ */
+typedef struct {
+  char *bytes;   /**< Cached bytes, or NULL if nothing is cached */
+  size_t length; /**< Number of cached bytes */
+} ShapeFragment;
+
 /**
  * Gets the type of a shape
  * @param shape Shape instance
@@ -45,12 +67,32 @@ ShapeType shape_get_type(Shape shape);
  */
 void *shape_get_shape(Shape shape);
 
+/**
+ * Gets the fragment cache of a shape
+ * @param shape Shape instance
+ * @return The cache, or NULL for shapes that are never rendered (text styles)
+ */
+ShapeFragment *shape_get_fragment(Shape shape);
+
+/**
+ * Drops a cached fragment, leaving the cache empty
+ * @param fragment Fragment cache
+ */
+void shape_fragment_clear(ShapeFragment *fragment);
+
 /**
  * Destroys a shape instance and frees all memory
  * @param shape Shape instance to destroy
  */
 void shape_destroy(Shape shape);
 
+/**
+ * Gets the store a shape was allocated from
+ * @param shape Shape instance
+ * @return The ShapeStore, or NULL for shapes allocated on the heap
+ */
+ShapeStore shape_get_store(Shape shape);
+
 /**
  * Creates a Shape wrapper (internal use by shape modules)
  * @param type The type of shape
@@ -59,6 +101,92 @@ void shape_destroy(Shape shape);
  */
 Shape shape_create_wrapper(ShapeType type, void *shape);
 
+/**
+ * Creates a Shape wrapper inside a store (internal use by shape modules)
+ * @param store Store to allocate the wrapper from (NULL uses the heap)
+ * @param type The type of shape
+ * @param shape Pointer to the actual shape object
+ * @return Pointer to new Shape wrapper or NULL on error
+ */
+Shape shape_create_wrapper_in(ShapeStore store, ShapeType type, void *shape);
+
+/**
+ * Creates an empty shape store
+ *
+ * Stores may be used from several threads at once.
+ * @return ShapeStore instance or NULL on error
+ */
+ShapeStore shape_store_create(void);
+
+/**
+ * Creates an empty store that is freed along with another one
+ *
+ * The child has its own pools, strings and lock, so threads that each fill a
+ * child of the same store never wait for one another. Its shapes still belong
+ * to the owner: shape_store_get_owner() tells them apart, and they are freed
+ * when the owner is destroyed.
+ * @param owner Store the child belongs to (the child of a child belongs to the
+ * same owner)
+ * @return ShapeStore instance or NULL on error
+ */
+ShapeStore shape_store_create_child(ShapeStore owner);
+
+/**
+ * Gets the store that owns a store
+ * @param store Store instance
+ * @return The store it was created as a child of, the store itself if it is
+ * not a child, or NULL for NULL
+ */
+ShapeStore shape_store_get_owner(ShapeStore store);
+
+/**
+ * Frees a store along with its children and every shape and string allocated
+ * from them
+ *
+ * Fragments cached by those shapes are not freed; callers clear them first.
+ * Children are only freed through their owner; destroying one does nothing.
+ * @param store Store instance to destroy
+ */
+void shape_store_destroy(ShapeStore store);
+
+/**
+ * Allocates a shape object from the pool of its type (internal use by shape
+ * modules)
+ * @param store Store instance (NULL uses malloc())
+ * @param type Type of the shape; every object of a type must have the same
+ * size
+ * @param size Size of the object
+ * @return Uninitialized memory or NULL on error
+ */
+void *shape_store_alloc(ShapeStore store, ShapeType type, size_t size);
+
+/**
+ * Returns a shape object to the pool of its type (internal use by shape
+ * modules)
+ * @param store Store the object came from (NULL uses free())
+ * @param type Type of the shape
+ * @param object Object to free
+ */
+void shape_store_free(ShapeStore store, ShapeType type, void *object);
+
+/**
+ * Copies a string for a shape (internal use by shape modules)
+ *
+ * With a store, equal strings are stored once and live as long as the store.
+ * @param store Store instance (NULL makes a heap copy)
+ * @param text String to copy
+ * @return The copy or NULL on error
+ */
+const char *shape_store_copy_string(ShapeStore store, const char *text);
+
+/**
+ * Drops a string returned by shape_store_copy_string() (internal use by
+ * shape modules)
+ * @param store Store the string came from (NULL frees the heap copy)
+ * @param text String to drop
+ */
+void shape_store_drop_string(ShapeStore store, const char *text);
+
 /**
  * Creates a new Circle shape
  * @param id Circle identifier
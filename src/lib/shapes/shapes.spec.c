@@ -8,7 +8,14 @@
 
 #include "shapes.h"
 #include "../test_framework/test_framework.h"
-
+#include "circle/circle.h"
+#include "line/line.h"
+#include "rectangle/rectangle.h"
+#include "text/text.h"
+#include "text_style/text_style.h"
+
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 // ============================================================================
@@ -351,6 +358,213 @@ bool test_shape_destroy_all_types(void) {
   return true;
 }
 
+// ============================================================================
+// Tests for shape_get_fragment()
+// ============================================================================
+
+// Caches a placeholder fragment in a shape
+static bool fill_fragment(Shape shape) {
+  ShapeFragment *fragment = shape_get_fragment(shape);
+  if (fragment == NULL) {
+    return false;
+  }
+  fragment->bytes = malloc(4);
+  fragment->length = 4;
+  return fragment->bytes != NULL;
+}
+
+/**
+ * Test: drawable shapes should start with an empty cache, text styles with
+ * none
+ */
+bool test_shape_get_fragment_initial(void) {
+  Shape circle = shape_create_circle(1, 10.0, 20.0, 5.0, "red", "blue");
+  Shape text = shape_create_text(4, 10.0, 20.0, "red", "blue", 'n', "Test");
+  Shape text_style = shape_create_text_style("Arial", 'n', 12);
+
+  ShapeFragment *fragment = shape_get_fragment(circle);
+  ASSERT_NOT_NULL(fragment);
+  ASSERT_NULL(fragment->bytes);
+  ASSERT_EQUAL(fragment->length, 0);
+  ASSERT_NOT_NULL(shape_get_fragment(text));
+  ASSERT_NULL(shape_get_fragment(text_style));
+  ASSERT_NULL(shape_get_fragment(NULL));
+
+  shape_destroy(circle);
+  shape_destroy(text);
+  shape_destroy(text_style);
+
+  return true;
+}
+
+/**
+ * Test: changing colors should drop the cached fragment of every shape type
+ */
+bool test_shape_get_fragment_dropped_on_color_change(void) {
+  Shape circle = shape_create_circle(1, 10.0, 20.0, 5.0, "red", "blue");
+  Shape rectangle =
+      shape_create_rectangle(2, 10.0, 20.0, 15.0, 25.0, "red", "blue");
+  Shape line = shape_create_line(3, 10.0, 20.0, 30.0, 40.0, "red");
+  Shape text = shape_create_text(4, 10.0, 20.0, "red", "blue", 'n', "Test");
+  Shape shapes[] = {circle, rectangle, line, text};
+
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(fill_fragment(shapes[i]));
+  }
+  circle_set_colors(shape_get_shape(circle), "green");
+  rectangle_set_colors(shape_get_shape(rectangle), "green");
+  line_set_color(shape_get_shape(line), "green");
+  text_set_colors(shape_get_shape(text), "green");
+  for (int i = 0; i < 4; i++) {
+    ShapeFragment *fragment = shape_get_fragment(shapes[i]);
+    ASSERT_NULL(fragment->bytes);
+    ASSERT_EQUAL(fragment->length, 0);
+  }
+
+  // Cached fragments are freed with their shape
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(fill_fragment(shapes[i]));
+    shape_destroy(shapes[i]);
+  }
+
+  return true;
+}
+
+// ============================================================================
+// Tests for shape_store_create() / shape_store_destroy()
+// ============================================================================
+
+/**
+ * Test: shapes created in a store should behave like heap shapes and be freed
+ * with the store
+ */
+bool test_shape_store_creates_every_type(void) {
+  ShapeStore store = shape_store_create();
+  ASSERT_NOT_NULL(store);
+
+  Shape circle = circle_create_in(store, 1, 10.0, 20.0, 5.0, "red", "blue");
+  Shape rectangle =
+      rectangle_create_in(store, 2, 10.0, 20.0, 15.0, 25.0, "red", "blue");
+  Shape line = line_create_in(store, 3, 10.0, 20.0, 30.0, 40.0, "red");
+  Shape text =
+      text_create_in(store, 4, 10.0, 20.0, "red", "blue", 'i', "Test");
+  Shape text_style = text_style_create_in(store, "Arial", 'n', 12);
+  Shape shapes[] = {circle, rectangle, line, text, text_style};
+
+  for (int i = 0; i < 5; i++) {
+    ASSERT_NOT_NULL(shapes[i]);
+    ASSERT_TRUE(shape_get_store(shapes[i]) == store);
+  }
+  ASSERT_EQUAL(shape_get_type(text_style), TEXT_STYLE);
+  ASSERT_EQUAL(circle_get_id(shape_get_shape(circle)), 1);
+  ASSERT_STR_EQUAL(rectangle_get_fill_color(shape_get_shape(rectangle)),
+                   "blue");
+  ASSERT_STR_EQUAL(text_get_text(shape_get_shape(text)), "Test");
+  ASSERT_STR_EQUAL(text_style_get_font_family(shape_get_shape(text_style)),
+                   "Arial");
+
+  Shape heap_line = shape_create_line(5, 0.0, 0.0, 1.0, 1.0, "red");
+  ASSERT_NULL(shape_get_store(heap_line));
+  shape_destroy(heap_line);
+
+  shape_store_destroy(store);
+  shape_store_destroy(NULL);
+  return true;
+}
+
+/**
+ * Test: equal strings should be stored once, across shapes and repaints
+ */
+bool test_shape_store_interns_strings(void) {
+  ShapeStore store = shape_store_create();
+  ASSERT_NOT_NULL(store);
+
+  char color[16];
+  strcpy(color, "red");
+  Shape first = circle_create_in(store, 1, 0.0, 0.0, 1.0, color, "blue");
+  strcpy(color, "blue");
+  Shape second = line_create_in(store, 2, 0.0, 0.0, 1.0, 1.0, color);
+  Circle circle = shape_get_shape(first);
+  Line line = shape_get_shape(second);
+
+  ASSERT_TRUE(circle_get_fill_color(circle) == line_get_color(line));
+  ASSERT_TRUE(circle_get_border_color(circle) != line_get_color(line));
+
+  circle_set_colors(circle, "blue");
+  ASSERT_TRUE(circle_get_border_color(circle) == line_get_color(line));
+  ASSERT_STR_EQUAL(circle_get_border_color(circle), "blue");
+
+  // Enough distinct strings to grow the set, each still found again
+  for (int i = 0; i < 200; i++) {
+    snprintf(color, sizeof(color), "#%06d", i);
+    line_set_color(line, color);
+    ASSERT_STR_EQUAL(line_get_color(line), color);
+  }
+  const char *last = line_get_color(line);
+  line_set_color(line, "#000000");
+  line_set_color(line, color);
+  ASSERT_TRUE(line_get_color(line) == last);
+
+  shape_store_destroy(store);
+  return true;
+}
+
+/**
+ * Test: a destroyed shape should hand its memory to the next shape of its
+ * type
+ */
+bool test_shape_store_reuses_destroyed_shapes(void) {
+  ShapeStore store = shape_store_create();
+  ASSERT_NOT_NULL(store);
+
+  Shape first = text_create_in(store, 1, 0.0, 0.0, "red", "blue", 'i', "a");
+  void *first_text = shape_get_shape(first);
+  ASSERT_TRUE(fill_fragment(first));
+  shape_destroy(first);
+
+  Shape second = text_create_in(store, 2, 5.0, 5.0, "red", "blue", 'm', "b");
+  ASSERT_TRUE(second == first);
+  ASSERT_TRUE(shape_get_shape(second) == first_text);
+  ASSERT_EQUAL(text_get_id(shape_get_shape(second)), 2);
+  ASSERT_NULL(shape_get_fragment(second)->bytes);
+
+  shape_store_destroy(store);
+  return true;
+}
+
+/**
+ * Test: child stores should belong to their owner and be freed with it
+ */
+bool test_shape_store_children(void) {
+  ShapeStore owner = shape_store_create();
+  ASSERT_NOT_NULL(owner);
+  ShapeStore child = shape_store_create_child(owner);
+  ShapeStore grandchild = shape_store_create_child(child);
+  ASSERT_NOT_NULL(child);
+  ASSERT_NOT_NULL(grandchild);
+  ASSERT_TRUE(child != owner);
+
+  ShapeStore root = shape_store_get_owner(grandchild);
+  ASSERT_TRUE(root == owner);
+  root = shape_store_get_owner(owner);
+  ASSERT_TRUE(root == owner);
+  ASSERT_NULL(shape_store_get_owner(NULL));
+  ASSERT_NULL(shape_store_create_child(NULL));
+
+  Shape shape = circle_create_in(child, 1, 0.0, 0.0, 1.0, "red", "blue");
+  ASSERT_NOT_NULL(shape);
+  ShapeStore store = shape_get_store(shape);
+  ASSERT_TRUE(store == child);
+  root = shape_store_get_owner(store);
+  ASSERT_TRUE(root == owner);
+
+  // Destroying a child leaves it to its owner
+  shape_store_destroy(child);
+  ASSERT_STR_EQUAL(circle_get_fill_color(shape_get_shape(shape)), "blue");
+  shape_store_destroy(owner);
+  return true;
+}
+
 // ============================================================================
 // Main test runner
 // ============================================================================
@@ -404,6 +618,23 @@ int main(void) {
   test_register("test_shape_destroy_null", test_shape_destroy_null);
   test_register("test_shape_destroy_all_types", test_shape_destroy_all_types);
 
+  // Register tests for shape_get_fragment
+  test_print_section("Testing shape_get_fragment()");
+  test_register("test_shape_get_fragment_initial",
+                test_shape_get_fragment_initial);
+  test_register("test_shape_get_fragment_dropped_on_color_change",
+                test_shape_get_fragment_dropped_on_color_change);
+
+  // Register tests for shape_store_create
+  test_print_section("Testing shape_store_create()");
+  test_register("test_shape_store_creates_every_type",
+                test_shape_store_creates_every_type);
+  test_register("test_shape_store_interns_strings",
+                test_shape_store_interns_strings);
+  test_register("test_shape_store_reuses_destroyed_shapes",
+                test_shape_store_reuses_destroyed_shapes);
+  test_register("test_shape_store_children", test_shape_store_children);
+
   // Run all tests
   int result = test_run_all();
 
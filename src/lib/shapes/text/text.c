@@ -1,5 +1,4 @@
 #include "text.h"
-#include "../../commons/utils/utils.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -10,19 +9,29 @@ struct Text {
   int id;
   double x;
   double y;
-  char *border_color;
-  char *fill_color;
+  const char *border_color;
+  const char *fill_color;
   char anchor;
-  char *text;
+  const char *text;
+  ShapeStore store; // Store the text and its strings came from, or NULL
+  // Cached SVG element, dropped on every change
+  ShapeFragment fragment;
 };
 
 void *text_create(int id, double x, double y, const char *border_color,
                   const char *fill_color, char anchor, const char *text) {
+  return text_create_in(NULL, id, x, y, border_color, fill_color, anchor,
+                        text);
+}
+
+void *text_create_in(ShapeStore store, int id, double x, double y,
+                     const char *border_color, const char *fill_color,
+                     char anchor, const char *text) {
   if (!border_color || !fill_color || !text) {
     return NULL;
   }
 
-  struct Text *t = malloc(sizeof(struct Text));
+  struct Text *t = shape_store_alloc(store, TEXT, sizeof(struct Text));
   if (!t) {
     return NULL;
   }
@@ -31,30 +40,33 @@ void *text_create(int id, double x, double y, const char *border_color,
   t->x = x;
   t->y = y;
   t->anchor = anchor;
+  t->store = store;
+  t->fragment.bytes = NULL;
+  t->fragment.length = 0;
 
-  t->border_color = duplicate_string(border_color);
+  t->border_color = shape_store_copy_string(store, border_color);
   if (!t->border_color) {
-    free(t);
+    shape_store_free(store, TEXT, t);
     return NULL;
   }
 
-  t->fill_color = duplicate_string(fill_color);
+  t->fill_color = shape_store_copy_string(store, fill_color);
   if (!t->fill_color) {
-    free(t->border_color);
-    free(t);
+    shape_store_drop_string(store, t->border_color);
+    shape_store_free(store, TEXT, t);
     return NULL;
   }
 
-  t->text = duplicate_string(text);
+  t->text = shape_store_copy_string(store, text);
   if (!t->text) {
-    free(t->border_color);
-    free(t->fill_color);
-    free(t);
+    shape_store_drop_string(store, t->border_color);
+    shape_store_drop_string(store, t->fill_color);
+    shape_store_free(store, TEXT, t);
     return NULL;
   }
 
   // Wrap the text in a Shape wrapper
-  return shape_create_wrapper(TEXT, t);
+  return shape_create_wrapper_in(store, TEXT, t);
 }
 
 void text_destroy(void *text) {
@@ -62,10 +74,11 @@ void text_destroy(void *text) {
     return;
 
   struct Text *t = (struct Text *)text;
-  free(t->border_color);
-  free(t->fill_color);
-  free(t->text);
-  free(t);
+  shape_store_drop_string(t->store, t->border_color);
+  shape_store_drop_string(t->store, t->fill_color);
+  shape_store_drop_string(t->store, t->text);
+  shape_fragment_clear(&t->fragment);
+  shape_store_free(t->store, TEXT, t);
 }
 
 int text_get_id(void *text) {
@@ -117,9 +130,16 @@ void text_set_colors(void *text, const char *color) {
 
   struct Text *t = (struct Text *)text;
 
-  free(t->border_color);
-  free(t->fill_color);
+  shape_store_drop_string(t->store, t->border_color);
+  shape_store_drop_string(t->store, t->fill_color);
+
+  t->border_color = shape_store_copy_string(t->store, color);
+  t->fill_color = shape_store_copy_string(t->store, color);
+  shape_fragment_clear(&t->fragment);
+}
 
-  t->border_color = duplicate_string(color);
-  t->fill_color = duplicate_string(color);
+ShapeFragment *text_get_fragment(void *text) {
+  if (!text)
+    return NULL;
+  return &((struct Text *)text)->fragment;
 }
@@ -25,6 +25,22 @@ typedef void *Text;
 Shape text_create(int id, double x, double y, const char *border_color,
                   const char *fill_color, char anchor, const char *text);
 
+/**
+ * Creates a new text instance inside a shape store
+ * @param store Store to allocate from (NULL uses the heap)
+ * @param id Text identifier
+ * @param x X coordinate of text position
+ * @param y Y coordinate of text position
+ * @param border_color Border color string
+ * @param fill_color Fill color string
+ * @param anchor Text anchor character
+ * @param text Text content string
+ * @return Pointer to new Shape wrapper or NULL on error
+ */
+Shape text_create_in(ShapeStore store, int id, double x, double y,
+                     const char *border_color, const char *fill_color,
+                     char anchor, const char *text);
+
 /**
  * Destroys a text instance and frees all memory
  * @param text Text instance to destroy
@@ -87,4 +103,12 @@ const char *text_get_text(Text text);
  */
 void text_set_colors(Text text, const char *color);
 
+/**
+ * Gets the cached SVG fragment of the text, which is dropped whenever its
+ * colors change
+ * @param text Text instance
+ * @return Fragment cache owned by the text
+ */
+ShapeFragment *text_get_fragment(Text text);
+
 #endif // TEXT_H
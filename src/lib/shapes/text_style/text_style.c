@@ -1,5 +1,4 @@
 #include "text_style.h"
-#include "../../commons/utils/utils.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -7,33 +6,41 @@
  * Internal TextStyle structure
  */
 struct TextStyle {
-  char *font_family;
+  const char *font_family;
   char font_weight;
   int font_size;
+  ShapeStore store; // Store the style and its font came from, or NULL
 };
 
 void *text_style_create(const char *font_family, char font_weight,
                         int font_size) {
+  return text_style_create_in(NULL, font_family, font_weight, font_size);
+}
+
+void *text_style_create_in(ShapeStore store, const char *font_family,
+                           char font_weight, int font_size) {
   if (!font_family) {
     return NULL;
   }
 
-  struct TextStyle *text_style = malloc(sizeof(struct TextStyle));
+  struct TextStyle *text_style =
+      shape_store_alloc(store, TEXT_STYLE, sizeof(struct TextStyle));
   if (!text_style) {
     return NULL;
   }
 
   text_style->font_weight = font_weight;
   text_style->font_size = font_size;
+  text_style->store = store;
 
-  text_style->font_family = duplicate_string(font_family);
+  text_style->font_family = shape_store_copy_string(store, font_family);
   if (!text_style->font_family) {
-    free(text_style);
+    shape_store_free(store, TEXT_STYLE, text_style);
     return NULL;
   }
 
   // Wrap the text style in a Shape wrapper
-  return shape_create_wrapper(TEXT_STYLE, text_style);
+  return shape_create_wrapper_in(store, TEXT_STYLE, text_style);
 }
 
 void text_style_destroy(void *text_style) {
@@ -41,8 +48,8 @@ void text_style_destroy(void *text_style) {
     return;
 
   struct TextStyle *ts = (struct TextStyle *)text_style;
-  free(ts->font_family);
-  free(ts);
+  shape_store_drop_string(ts->store, ts->font_family);
+  shape_store_free(ts->store, TEXT_STYLE, ts);
 }
 
 const char *text_style_get_font_family(void *text_style) {
@@ -21,6 +21,17 @@ typedef void *TextStyle;
 Shape text_style_create(const char *font_family, char font_weight,
                         int font_size);
 
+/**
+ * Creates a new text style instance inside a shape store
+ * @param store Store to allocate from (NULL uses the heap)
+ * @param font_family Font family string
+ * @param font_weight Font weight character
+ * @param font_size Font size
+ * @return Pointer to new Shape wrapper or NULL on error
+ */
+Shape text_style_create_in(ShapeStore store, const char *font_family,
+                           char font_weight, int font_size);
+
 /**
  * Destroys a text style instance and frees all memory
  * @param text_style Text style instance to destroy
@@ -0,0 +1,417 @@
+#include "svg_writer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Bytes collected before they are handed to write()
+#define SVG_WRITER_BUFFER_SIZE (256 * 1024)
+
+// Largest magnitude formatted without snprintf(). Below it, value * 100 is off
+// from the exact product by less than 2^-15, far inside ROUNDING_MARGIN.
+#define MAX_FAST_NUMBER 1e9
+
+// Distance from a tie below which rounding is left to snprintf()
+#define ROUNDING_MARGIN 1e-4
+
+// A finished file waiting for the writer thread
+typedef struct {
+  char *path;
+  char *bytes;
+  size_t length;
+} SvgJob;
+
+// Background writer. Every field below the thread is guarded by the mutex.
+typedef struct {
+  pthread_t thread;         // Writer thread
+  pthread_mutex_t mutex;    // Guards the job ring and the flags
+  pthread_cond_t not_empty; // Signaled when a job is queued or on shutdown
+  pthread_cond_t not_full;  // Signaled when the thread takes a job
+  pthread_cond_t idle;      // Signaled when the last queued job is written
+  SvgJob *jobs;             // Ring of queued jobs
+  int capacity;             // Slots in the ring
+  int head;                 // Oldest queued job
+  int count;                // Queued jobs
+  bool busy;                // The thread is writing a job
+  bool failed;              // A job failed since the last flush
+  bool stopping;            // The thread must exit once the ring is empty
+} SvgQueueImpl;
+
+typedef struct {
+  int fd;              // Output file, or -1 when queued
+  SvgQueueImpl *queue; // Queue that receives the file, or NULL
+  char *path;          // Output path when queued
+  char *buffer;        // Collected bytes
+  size_t capacity;     // Size of the buffer
+  size_t used;         // Bytes in the buffer
+  bool failed;         // A write or an allocation failed
+} SvgWriterImpl;
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+/**
+ * Writes bytes to a file, retrying partial and interrupted writes. Returns
+ * false if the file refused them.
+ */
+static bool write_all(int fd, const char *bytes, size_t length) {
+  while (length > 0) {
+    ssize_t written = write(fd, bytes, length);
+    if (written < 0) {
+      if (errno != EINTR) {
+        return false;
+      }
+      continue;
+    }
+    bytes += written;
+    length -= (size_t)written;
+  }
+  return true;
+}
+
+/**
+ * Hands the buffered bytes to the file.
+ */
+static void flush_buffer(SvgWriterImpl *impl) {
+  if (!impl->failed && !write_all(impl->fd, impl->buffer, impl->used)) {
+    impl->failed = true;
+  }
+  impl->used = 0;
+}
+
+/**
+ * Makes room for length more bytes: queued writers grow their buffer, file
+ * writers flush it. Returns false if the bytes still do not fit.
+ */
+static bool make_room(SvgWriterImpl *impl, size_t length) {
+  if (impl->queue == NULL) {
+    flush_buffer(impl);
+    return length <= impl->capacity;
+  }
+  if (impl->failed) {
+    return false;
+  }
+
+  size_t capacity = impl->capacity;
+  while (impl->used + length > capacity) {
+    capacity *= 2;
+  }
+  char *buffer = realloc(impl->buffer, capacity);
+  if (buffer == NULL) {
+    printf("Error: Failed to allocate memory for SVG output\n");
+    impl->failed = true;
+    return false;
+  }
+  impl->buffer = buffer;
+  impl->capacity = capacity;
+  return true;
+}
+
+/**
+ * Writes one queued file. Returns false if it could not be written.
+ */
+static bool write_job(const SvgJob *job) {
+  int fd = open(job->path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    printf("Error: Failed to open file: %s\n", job->path);
+    return false;
+  }
+  bool ok = write_all(fd, job->bytes, job->length);
+  if (close(fd) != 0) {
+    ok = false;
+  }
+  if (!ok) {
+    printf("Error: Failed to write file: %s\n", job->path);
+  }
+  return ok;
+}
+
+/**
+ * Writer thread loop: writes queued files in order until the queue stops
+ * and is empty.
+ */
+static void *queue_main(void *arg) {
+  SvgQueueImpl *impl = (SvgQueueImpl *)arg;
+
+  pthread_mutex_lock(&impl->mutex);
+  for (;;) {
+    while (!impl->stopping && impl->count == 0) {
+      pthread_cond_wait(&impl->not_empty, &impl->mutex);
+    }
+    if (impl->count == 0) {
+      break;
+    }
+
+    SvgJob job = impl->jobs[impl->head];
+    impl->head = (impl->head + 1) % impl->capacity;
+    impl->count--;
+    impl->busy = true;
+    pthread_cond_signal(&impl->not_full);
+
+    pthread_mutex_unlock(&impl->mutex);
+    bool ok = write_job(&job);
+    free(job.path);
+    free(job.bytes);
+    pthread_mutex_lock(&impl->mutex);
+
+    impl->busy = false;
+    if (!ok) {
+      impl->failed = true;
+    }
+    if (impl->count == 0) {
+      pthread_cond_broadcast(&impl->idle);
+    }
+  }
+  pthread_mutex_unlock(&impl->mutex);
+
+  return NULL;
+}
+
+/**
+ * Queues a finished file, waiting while the ring is full.
+ */
+static void queue_push(SvgQueueImpl *impl, SvgJob job) {
+  pthread_mutex_lock(&impl->mutex);
+  while (impl->count == impl->capacity) {
+    pthread_cond_wait(&impl->not_full, &impl->mutex);
+  }
+  impl->jobs[(impl->head + impl->count) % impl->capacity] = job;
+  impl->count++;
+  pthread_cond_signal(&impl->not_empty);
+  pthread_mutex_unlock(&impl->mutex);
+}
+
+/**
+ * Allocates a writer with an empty buffer. Returns NULL if out of memory.
+ */
+static SvgWriterImpl *allocate_writer(int fd, SvgQueueImpl *queue) {
+  SvgWriterImpl *impl = malloc(sizeof(SvgWriterImpl));
+  char *buffer = malloc(SVG_WRITER_BUFFER_SIZE);
+  if (impl == NULL || buffer == NULL) {
+    printf("Error: Failed to allocate memory for SvgWriter\n");
+    free(impl);
+    free(buffer);
+    return NULL;
+  }
+
+  impl->fd = fd;
+  impl->queue = queue;
+  impl->path = NULL;
+  impl->buffer = buffer;
+  impl->capacity = SVG_WRITER_BUFFER_SIZE;
+  impl->used = 0;
+  impl->failed = false;
+  return impl;
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+SvgWriter svg_writer_create(const char *path) {
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  SvgWriterImpl *impl = allocate_writer(fd, NULL);
+  if (impl == NULL) {
+    close(fd);
+  }
+  return impl;
+}
+
+SvgWriter svg_writer_create_queued(SvgQueue queue, const char *path) {
+  if (queue == NULL) {
+    return svg_writer_create(path);
+  }
+
+  SvgWriterImpl *impl = allocate_writer(-1, (SvgQueueImpl *)queue);
+  if (impl == NULL) {
+    return NULL;
+  }
+  impl->path = malloc(strlen(path) + 1);
+  if (impl->path == NULL) {
+    printf("Error: Failed to allocate memory for SvgWriter\n");
+    free(impl->buffer);
+    free(impl);
+    return NULL;
+  }
+  strcpy(impl->path, path);
+  return impl;
+}
+
+void svg_writer_write(SvgWriter writer, const char *bytes, size_t length) {
+  SvgWriterImpl *impl = (SvgWriterImpl *)writer;
+  if (impl->used + length > impl->capacity && !make_room(impl, length)) {
+    // Larger than a file writer buffer, or out of memory when queued
+    if (impl->queue == NULL && !impl->failed &&
+        !write_all(impl->fd, bytes, length)) {
+      impl->failed = true;
+    }
+    return;
+  }
+  memcpy(impl->buffer + impl->used, bytes, length);
+  impl->used += length;
+}
+
+void svg_writer_write_string(SvgWriter writer, const char *text) {
+  svg_writer_write(writer, text, strlen(text));
+}
+
+void svg_writer_write_number(SvgWriter writer, double value) {
+  SvgWriterImpl *impl = (SvgWriterImpl *)writer;
+  if (impl->used + SVG_NUMBER_SIZE > impl->capacity &&
+      !make_room(impl, SVG_NUMBER_SIZE)) {
+    return;
+  }
+  impl->used += (size_t)svg_format_number(impl->buffer + impl->used, value);
+}
+
+bool svg_writer_close(SvgWriter writer) {
+  SvgWriterImpl *impl = (SvgWriterImpl *)writer;
+  bool ok;
+  if (impl->queue != NULL) {
+    ok = !impl->failed;
+    if (ok) {
+      SvgJob job = {impl->path, impl->buffer, impl->used};
+      queue_push(impl->queue, job);
+    } else {
+      free(impl->path);
+      free(impl->buffer);
+    }
+  } else {
+    flush_buffer(impl);
+    ok = !impl->failed;
+    if (close(impl->fd) != 0) {
+      ok = false;
+    }
+    free(impl->buffer);
+  }
+  free(impl);
+  return ok;
+}
+
+SvgQueue svg_queue_create(int capacity) {
+  if (capacity <= 0) {
+    return NULL;
+  }
+
+  SvgQueueImpl *impl = malloc(sizeof(SvgQueueImpl));
+  SvgJob *jobs = malloc((size_t)capacity * sizeof(SvgJob));
+  if (impl == NULL || jobs == NULL) {
+    printf("Error: Failed to allocate memory for SvgQueue\n");
+    free(impl);
+    free(jobs);
+    return NULL;
+  }
+
+  pthread_mutex_init(&impl->mutex, NULL);
+  pthread_cond_init(&impl->not_empty, NULL);
+  pthread_cond_init(&impl->not_full, NULL);
+  pthread_cond_init(&impl->idle, NULL);
+  impl->jobs = jobs;
+  impl->capacity = capacity;
+  impl->head = 0;
+  impl->count = 0;
+  impl->busy = false;
+  impl->failed = false;
+  impl->stopping = false;
+
+  if (pthread_create(&impl->thread, NULL, queue_main, impl) != 0) {
+    printf("Error: Failed to start SVG writer thread\n");
+    pthread_cond_destroy(&impl->idle);
+    pthread_cond_destroy(&impl->not_full);
+    pthread_cond_destroy(&impl->not_empty);
+    pthread_mutex_destroy(&impl->mutex);
+    free(jobs);
+    free(impl);
+    return NULL;
+  }
+
+  return impl;
+}
+
+bool svg_queue_flush(SvgQueue queue) {
+  if (queue == NULL) {
+    return true;
+  }
+
+  SvgQueueImpl *impl = (SvgQueueImpl *)queue;
+  pthread_mutex_lock(&impl->mutex);
+  while (impl->count > 0 || impl->busy) {
+    pthread_cond_wait(&impl->idle, &impl->mutex);
+  }
+  bool ok = !impl->failed;
+  impl->failed = false;
+  pthread_mutex_unlock(&impl->mutex);
+  return ok;
+}
+
+void svg_queue_destroy(SvgQueue queue) {
+  if (queue == NULL) {
+    return;
+  }
+
+  SvgQueueImpl *impl = (SvgQueueImpl *)queue;
+  pthread_mutex_lock(&impl->mutex);
+  impl->stopping = true;
+  pthread_cond_signal(&impl->not_empty);
+  pthread_mutex_unlock(&impl->mutex);
+  pthread_join(impl->thread, NULL);
+
+  pthread_cond_destroy(&impl->idle);
+  pthread_cond_destroy(&impl->not_full);
+  pthread_cond_destroy(&impl->not_empty);
+  pthread_mutex_destroy(&impl->mutex);
+  free(impl->jobs);
+  free(impl);
+}
+
+int svg_format_number(char *out, double value) {
+  double magnitude = fabs(value);
+  if (!(magnitude < MAX_FAST_NUMBER)) {
+    return snprintf(out, SVG_NUMBER_SIZE, "%.2f", value);
+  }
+
+  // printf rounds the exact binary value, ties to even. Away from a tie the
+  // rounded product lands on the same side, so it decides the same way.
+  double scaled = magnitude * 100.0;
+  double whole = floor(scaled);
+  double fraction = scaled - whole;
+  if (fabs(fraction - 0.5) < ROUNDING_MARGIN) {
+    return snprintf(out, SVG_NUMBER_SIZE, "%.2f", value);
+  }
+  uint64_t hundredths = (uint64_t)whole + (fraction > 0.5 ? 1 : 0);
+
+  // Digits come out last first
+  char digits[24];
+  int count = 0;
+  digits[count++] = (char)('0' + hundredths % 10);
+  hundredths /= 10;
+  digits[count++] = (char)('0' + hundredths % 10);
+  hundredths /= 10;
+  do {
+    digits[count++] = (char)('0' + hundredths % 10);
+    hundredths /= 10;
+  } while (hundredths > 0);
+
+  char *p = out;
+  if (signbit(value)) {
+    *p++ = '-';
+  }
+  for (int i = count - 1; i >= 2; i--) {
+    *p++ = digits[i];
+  }
+  *p++ = '.';
+  *p++ = digits[1];
+  *p++ = digits[0];
+  *p = '\0';
+  return (int)(p - out);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file svg_writer.h
+ * @brief Buffered output for SVG files
+ *
+ * Collects output in a large owned buffer and hands it to the kernel with few
+ * large write() calls instead of one stdio call per element. Numbers are
+ * formatted by a fast routine that gives exactly what printf("%.2f") gives.
+ *
+ * Writers may also hand finished files to an SvgQueue, whose background
+ * thread writes them while the caller moves on.
+ */
+
+#ifndef SVG_WRITER_H
+#define SVG_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Bytes svg_format_number() may write, terminator included
+ */
+#define SVG_NUMBER_SIZE 320
+
+/**
+ * @brief Opaque pointer type for SVG writer instances
+ */
+typedef void *SvgWriter;
+
+/**
+ * @brief Opaque pointer type for background SVG writer queues
+ */
+typedef void *SvgQueue;
+
+/**
+ * @brief Creates (or truncates) a file and a writer for it
+ * @param path Path of the file to write
+ * @return SvgWriter instance or NULL if the file could not be opened
+ */
+SvgWriter svg_writer_create(const char *path);
+
+/**
+ * @brief Creates a writer whose file is written by a queue's thread
+ *
+ * The whole file is collected in memory and queued by svg_writer_close(),
+ * which waits while the queue is full. Errors opening or writing the file are
+ * reported by the writer thread and by svg_queue_flush().
+ * @param queue Queue that writes the file; NULL behaves like
+ * svg_writer_create()
+ * @param path Path of the file to write
+ * @return SvgWriter instance or NULL on error
+ */
+SvgWriter svg_writer_create_queued(SvgQueue queue, const char *path);
+
+/**
+ * @brief Appends raw bytes
+ * @param writer Writer instance
+ * @param bytes Bytes to append
+ * @param length Number of bytes
+ */
+void svg_writer_write(SvgWriter writer, const char *bytes, size_t length);
+
+/**
+ * @brief Appends a NUL-terminated string
+ * @param writer Writer instance
+ * @param text String to append
+ */
+void svg_writer_write_string(SvgWriter writer, const char *text);
+
+/**
+ * @brief Appends a number formatted like printf("%.2f")
+ * @param writer Writer instance
+ * @param value Number to append
+ */
+void svg_writer_write_number(SvgWriter writer, double value);
+
+/**
+ * @brief Flushes what is left, closes the file and destroys the writer
+ * @param writer Writer instance
+ * @return true if every byte reached the file, or was queued for it
+ */
+bool svg_writer_close(SvgWriter writer);
+
+/**
+ * @brief Starts a thread that writes queued files in order
+ * @param capacity Files that may wait in the queue before
+ * svg_writer_close() blocks (must be positive)
+ * @return SvgQueue instance or NULL on error
+ */
+SvgQueue svg_queue_create(int capacity);
+
+/**
+ * @brief Waits until every queued file has been written
+ * @param queue Queue instance (NULL is an empty queue)
+ * @return true if no file failed since the last flush
+ */
+bool svg_queue_flush(SvgQueue queue);
+
+/**
+ * @brief Writes the files still queued, stops the thread and frees the queue
+ * @param queue Queue instance to destroy
+ */
+void svg_queue_destroy(SvgQueue queue);
+
+/**
+ * @brief Formats a number exactly like snprintf(out, size, "%.2f", value)
+ *
+ * Values below a billion that are not within rounding error of a tie are
+ * formatted from an integer count of hundredths; anything else (ties, huge
+ * values, inf/nan) goes through snprintf().
+ * @param out Receives the text; must hold SVG_NUMBER_SIZE bytes
+ * @param value Number to format
+ * @return Length of the text, terminator excluded
+ */
+int svg_format_number(char *out, double value);
+
+#endif // SVG_WRITER_H
@@ -0,0 +1,295 @@
+/**
+ * @file svg_writer.spec.c
+ * @brief Unit tests for svg_writer module
+ *
+ * Unit tests for the buffered SVG output functions defined in svg_writer.h
+ */
+
+#include "./svg_writer.h"
+#include "../test_framework/test_framework.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WRITER_PATH "/tmp/test_svg_writer.svg"
+#define QUEUED_FILE_COUNT 6
+#define RANDOM_NUMBER_COUNT 50000
+
+// ============================================================================
+// Test Helpers
+// ============================================================================
+
+// Tells whether svg_format_number() and snprintf() agree on a value
+static bool formats_like_printf(double value) {
+  char expected[SVG_NUMBER_SIZE];
+  char actual[SVG_NUMBER_SIZE];
+  int expected_length = snprintf(expected, sizeof(expected), "%.2f", value);
+  int actual_length = svg_format_number(actual, value);
+  if (expected_length != actual_length || strcmp(expected, actual) != 0) {
+    printf("    %.17g: expected %s, got %s\n", value, expected, actual);
+    return false;
+  }
+  return true;
+}
+
+// Reads a whole file into a NUL-terminated buffer
+static char *read_file(const char *path, long *size) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  *size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *bytes = malloc((size_t)*size + 1);
+  if (bytes != NULL) {
+    bytes[fread(bytes, 1, (size_t)*size, file)] = '\0';
+  }
+  fclose(file);
+  return bytes;
+}
+
+// ============================================================================
+// Tests for svg_format_number()
+// ============================================================================
+
+/**
+ * Test: ties, signed zeros and values beyond the fast path should match
+ * printf
+ */
+bool test_svg_format_number_edge_cases(void) {
+  const double values[] = {0.0,           -0.0,          0.005,
+                           -0.005,        0.125,         0.375,
+                           2.675,         1.005,         0.994999,
+                           0.995,         -0.001,        99.995,
+                           123456.78,     1e-300,        5e-324,
+                           999999999.994, 999999999.995, 1e9,
+                           -1e9,          1e15,          DBL_MAX,
+                           -DBL_MAX,      INFINITY,      -INFINITY,
+                           NAN};
+  int count = (int)(sizeof(values) / sizeof(values[0]));
+
+  for (int i = 0; i < count; i++) {
+    ASSERT_TRUE(formats_like_printf(values[i]));
+  }
+
+  return true;
+}
+
+/**
+ * Test: random coordinates of every magnitude should match printf
+ */
+bool test_svg_format_number_random(void) {
+  srand(42);
+
+  for (int i = 0; i < RANDOM_NUMBER_COUNT; i++) {
+    double magnitude = pow(10.0, rand() % 12 - 3);
+    double value = (double)rand() / RAND_MAX * magnitude;
+    if (rand() % 2) {
+      value = -value;
+    }
+    ASSERT_TRUE(formats_like_printf(value));
+
+    // Values parsed from two-decimal input sit right next to a hundredth
+    double hundredths = (double)(rand() % 10000000) / 100.0;
+    ASSERT_TRUE(formats_like_printf(hundredths));
+    ASSERT_TRUE(formats_like_printf(hundredths + 0.005));
+  }
+
+  return true;
+}
+
+// ============================================================================
+// Tests for svg_writer_create() / svg_writer_write*() / svg_writer_close()
+// ============================================================================
+
+/**
+ * Test: strings and numbers should reach the file in order
+ */
+bool test_svg_writer_writes_in_order(void) {
+  SvgWriter writer = svg_writer_create(WRITER_PATH);
+  ASSERT_NOT_NULL(writer);
+
+  svg_writer_write_string(writer, "<circle cx='");
+  svg_writer_write_number(writer, 10.0);
+  svg_writer_write_string(writer, "' r='");
+  svg_writer_write_number(writer, -2.5);
+  svg_writer_write(writer, "'/>\nignored", 4);
+  ASSERT_TRUE(svg_writer_close(writer));
+
+  long size = 0;
+  char *bytes = read_file(WRITER_PATH, &size);
+  ASSERT_NOT_NULL(bytes);
+  ASSERT_STR_EQUAL(bytes, "<circle cx='10.00' r='-2.50'/>\n");
+
+  free(bytes);
+  remove(WRITER_PATH);
+  return true;
+}
+
+/**
+ * Test: output larger than the buffer, including single writes larger than
+ * it, should arrive whole
+ */
+bool test_svg_writer_large_output(void) {
+  size_t big_length = 600 * 1024;
+  char *big = malloc(big_length);
+  ASSERT_NOT_NULL(big);
+  memset(big, 'x', big_length);
+
+  SvgWriter writer = svg_writer_create(WRITER_PATH);
+  ASSERT_NOT_NULL(writer);
+  for (int i = 0; i < 100000; i++) {
+    svg_writer_write_number(writer, 1.25);
+    svg_writer_write_string(writer, " ");
+  }
+  svg_writer_write(writer, big, big_length);
+  svg_writer_write_string(writer, "end");
+  ASSERT_TRUE(svg_writer_close(writer));
+
+  long size = 0;
+  char *bytes = read_file(WRITER_PATH, &size);
+  ASSERT_NOT_NULL(bytes);
+  ASSERT_EQUAL(size, (long)(100000 * 5 + big_length + 3));
+  ASSERT_TRUE(strncmp(bytes, "1.25 1.25 ", 10) == 0);
+  ASSERT_EQUAL(bytes[100000 * 5], 'x');
+  ASSERT_STR_EQUAL(bytes + size - 4, "xend");
+
+  free(bytes);
+  free(big);
+  remove(WRITER_PATH);
+  return true;
+}
+
+/**
+ * Test: a path that cannot be opened should give NULL
+ */
+bool test_svg_writer_create_invalid_path(void) {
+  ASSERT_NULL(svg_writer_create("/tmp/nonexistent_dir_12345/out.svg"));
+  return true;
+}
+
+// ============================================================================
+// Tests for svg_queue_create() / svg_writer_create_queued()
+// ============================================================================
+
+/**
+ * Test: files queued behind a full queue should all be written once flushed
+ */
+bool test_svg_queue_writes_every_file(void) {
+  SvgQueue queue = svg_queue_create(1);
+  ASSERT_NOT_NULL(queue);
+
+  char path[64];
+  for (int i = 0; i < QUEUED_FILE_COUNT; i++) {
+    snprintf(path, sizeof(path), "/tmp/test_svg_queue_%d.svg", i);
+    SvgWriter writer = svg_writer_create_queued(queue, path);
+    ASSERT_NOT_NULL(writer);
+    svg_writer_write_string(writer, "file ");
+    svg_writer_write_number(writer, i);
+    ASSERT_TRUE(svg_writer_close(writer));
+  }
+  ASSERT_TRUE(svg_queue_flush(queue));
+
+  for (int i = 0; i < QUEUED_FILE_COUNT; i++) {
+    char expected[32];
+    snprintf(path, sizeof(path), "/tmp/test_svg_queue_%d.svg", i);
+    snprintf(expected, sizeof(expected), "file %d.00", i);
+    long size = 0;
+    char *bytes = read_file(path, &size);
+    ASSERT_NOT_NULL(bytes);
+    ASSERT_STR_EQUAL(bytes, expected);
+    free(bytes);
+    remove(path);
+  }
+
+  svg_queue_destroy(queue);
+  return true;
+}
+
+/**
+ * Test: queued files should grow past the buffer size and be written by
+ * svg_queue_destroy() without a flush
+ */
+bool test_svg_queue_large_file_on_destroy(void) {
+  SvgQueue queue = svg_queue_create(2);
+  ASSERT_NOT_NULL(queue);
+
+  SvgWriter writer = svg_writer_create_queued(queue, WRITER_PATH);
+  ASSERT_NOT_NULL(writer);
+  for (int i = 0; i < 200000; i++) {
+    svg_writer_write_number(writer, 1.25);
+    svg_writer_write_string(writer, " ");
+  }
+  ASSERT_TRUE(svg_writer_close(writer));
+  svg_queue_destroy(queue);
+
+  long size = 0;
+  char *bytes = read_file(WRITER_PATH, &size);
+  ASSERT_NOT_NULL(bytes);
+  ASSERT_EQUAL(size, 200000 * 5);
+  ASSERT_STR_EQUAL(bytes + size - 5, "1.25 ");
+
+  free(bytes);
+  remove(WRITER_PATH);
+  return true;
+}
+
+/**
+ * Test: a file that cannot be opened should fail the next flush only
+ */
+bool test_svg_queue_reports_failure(void) {
+  ASSERT_NULL(svg_queue_create(0));
+  ASSERT_TRUE(svg_queue_flush(NULL));
+
+  SvgQueue queue = svg_queue_create(2);
+  ASSERT_NOT_NULL(queue);
+  SvgWriter writer =
+      svg_writer_create_queued(queue, "/tmp/nonexistent_dir_12345/out.svg");
+  ASSERT_NOT_NULL(writer);
+  svg_writer_write_string(writer, "lost");
+  ASSERT_TRUE(svg_writer_close(writer));
+  ASSERT_FALSE(svg_queue_flush(queue));
+  ASSERT_TRUE(svg_queue_flush(queue));
+
+  svg_queue_destroy(queue);
+  return true;
+}
+
+// ============================================================================
+// Main Test Runner
+// ============================================================================
+
+int main(void) {
+  test_framework_init();
+
+  test_print_section("Testing svg_format_number()");
+  test_register("test_svg_format_number_edge_cases",
+                test_svg_format_number_edge_cases);
+  test_register("test_svg_format_number_random",
+                test_svg_format_number_random);
+
+  test_print_section("Testing svg_writer_create() / svg_writer_close()");
+  test_register("test_svg_writer_writes_in_order",
+                test_svg_writer_writes_in_order);
+  test_register("test_svg_writer_large_output", test_svg_writer_large_output);
+  test_register("test_svg_writer_create_invalid_path",
+                test_svg_writer_create_invalid_path);
+
+  test_print_section("Testing svg_queue_create() / svg_queue_flush()");
+  test_register("test_svg_queue_writes_every_file",
+                test_svg_queue_writes_every_file);
+  test_register("test_svg_queue_large_file_on_destroy",
+                test_svg_queue_large_file_on_destroy);
+  test_register("test_svg_queue_reports_failure",
+                test_svg_queue_reports_failure);
+
+  int result = test_run_all();
+
+  test_framework_cleanup();
+
+  return result;
+}
@@ -8,6 +8,42 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+// SSE2 is part of every x86-64 CPU; AVX2 code is compiled in with a target
+// attribute and only run when the CPU reports it
+#if defined(__SSE2__)
+#define GEOMETRY_HAVE_SSE2 1
+#include <emmintrin.h>
+#else
+#define GEOMETRY_HAVE_SSE2 0
+#endif
+
+// The kernels are built with optimization even in debug builds: at -O0 every
+// intrinsic and helper call spills to the stack and costs more than the
+// scalar loop it replaces
+#if defined(__GNUC__) && !defined(__clang__)
+#define KERNEL_FUNCTION __attribute__((optimize("O2")))
+#else
+#define KERNEL_FUNCTION
+#endif
+
+#if GEOMETRY_HAVE_SSE2 && defined(__GNUC__) &&                                 \
+    (defined(__x86_64__) || defined(__i386__))
+#define GEOMETRY_HAVE_AVX2 1
+#include <immintrin.h>
+#define AVX2_FUNCTION KERNEL_FUNCTION __attribute__((target("avx2")))
+#else
+#define GEOMETRY_HAVE_AVX2 0
+#endif
+
+// Fewest edges worth handing to the vector kernels
+#define MIN_VECTOR_EDGES 8
+
+// Level forced by geometry_simd_set_level(), or -1 for the best one
+static int forced_simd_level = -1;
+
+// Level picked on first use when none was forced
+static int detected_simd_level = -1;
+
 /**
  * Internal Point structure
  */
@@ -55,6 +91,19 @@ double geometry_calculate_angle(double x, double y, double px, double py) {
   return atan2(dy, dx);
 }
 
+double geometry_calculate_pseudo_angle(double x, double y, double px,
+                                       double py) {
+  double dx = x - px;
+  double dy = y - py;
+  if (dx == 0 && dy == 0)
+    return 0;
+
+  // Position along the diamond |dx| + |dy| = 1, one unit per quadrant
+  if (dy >= 0)
+    return dx >= 0 ? dy / (dx + dy) : 1 - dx / (dy - dx);
+  return dx < 0 ? 2 - dy / (-dx - dy) : 3 + dx / (dx - dy);
+}
+
 double geometry_distance(double x1, double y1, double x2, double y2) {
   double dx = x2 - x1;
   double dy = y2 - y1;
@@ -106,31 +155,17 @@ bool geometry_segment_intersects_ray(Line segment, double x, double y,
   return false;
 }
 
-bool geometry_point_in_polygon(double x, double y, Point *vertices,
+bool geometry_point_in_polygon(double x, double y, const double *xy,
                                int vertex_count) {
-  if (!vertices || vertex_count < 3) {
+  if (!xy || vertex_count < 3) {
     return false;
   }
 
   // Ray casting algorithm: cast a ray from the point to infinity
-  // and count how many times it crosses polygon edges
-  int crossings = 0;
-
-  for (int i = 0; i < vertex_count; i++) {
-    int j = (i + 1) % vertex_count;
-
-    double xi = geometry_point_get_x(vertices[i]);
-    double yi = geometry_point_get_y(vertices[i]);
-    double xj = geometry_point_get_x(vertices[j]);
-    double yj = geometry_point_get_y(vertices[j]);
-
-    // Check if edge crosses the horizontal ray from point (x, y) to the right
-    if (((yi > y) != (yj > y)) && (x < (xj - xi) * (y - yi) / (yj - yi) + xi)) {
-      crossings++;
-    }
-  }
-
-  // Point is inside if number of crossings is odd
+  // and count how many times it crosses polygon edges. Point is inside if
+  // number of crossings is odd
+  int crossings =
+      geometry_count_crossings(x, y, xy, vertex_count, NULL, vertex_count);
   return (crossings % 2) == 1;
 }
 
@@ -204,3 +239,479 @@ double geometry_distance_point_segment(double px, double py, double x1,
 
   return geometry_distance(px, py, proj_x, proj_y);
 }
+
+// ============================================================================
+// Edge Kernels
+// ============================================================================
+
+/**
+ * Gets the best instruction set the CPU supports.
+ */
+static GeometrySimdLevel best_simd_level(void) {
+#if GEOMETRY_HAVE_AVX2
+  if (__builtin_cpu_supports("avx2")) {
+    return GEOMETRY_SIMD_AVX2;
+  }
+#endif
+#if GEOMETRY_HAVE_SSE2
+  return GEOMETRY_SIMD_SSE2;
+#else
+  return GEOMETRY_SIMD_NONE;
+#endif
+}
+
+GeometrySimdLevel geometry_simd_get_level(void) {
+  if (forced_simd_level >= 0) {
+    return (GeometrySimdLevel)forced_simd_level;
+  }
+  if (detected_simd_level < 0) {
+    detected_simd_level = best_simd_level();
+  }
+  return (GeometrySimdLevel)detected_simd_level;
+}
+
+GeometrySimdLevel geometry_simd_set_level(GeometrySimdLevel level) {
+  GeometrySimdLevel best = best_simd_level();
+  forced_simd_level = level < best ? level : best;
+  return (GeometrySimdLevel)forced_simd_level;
+}
+
+// Index of the k-th edge to test, and the vertex that ends edge i. Macros
+// rather than functions so the kernel loops make no calls per edge.
+#define EDGE_AT(edges, k) ((edges) ? (edges)[k] : (k))
+#define EDGE_END(i, vertex_count) ((i) + 1 < (vertex_count) ? (i) + 1 : 0)
+
+/**
+ * Checks if the horizontal ray from (x, y) to the right crosses an edge.
+ */
+KERNEL_FUNCTION
+static bool ray_crosses_edge(double x, double y, double xi, double yi,
+                             double xj, double yj) {
+  return ((yi > y) != (yj > y)) && (x < (xj - xi) * (y - yi) / (yj - yi) + xi);
+}
+
+#if GEOMETRY_HAVE_SSE2
+/**
+ * Loads the endpoints of edges a and b as vectors of x and y coordinates.
+ */
+KERNEL_FUNCTION
+static void load_edges_sse2(const double *xy, int vertex_count, int a, int b,
+                            __m128d *xi, __m128d *yi, __m128d *xj,
+                            __m128d *yj) {
+  __m128d start_a = _mm_loadu_pd(xy + 2 * a);
+  __m128d start_b = _mm_loadu_pd(xy + 2 * b);
+  __m128d end_a = _mm_loadu_pd(xy + 2 * EDGE_END(a, vertex_count));
+  __m128d end_b = _mm_loadu_pd(xy + 2 * EDGE_END(b, vertex_count));
+  *xi = _mm_unpacklo_pd(start_a, start_b);
+  *yi = _mm_unpackhi_pd(start_a, start_b);
+  *xj = _mm_unpacklo_pd(end_a, end_b);
+  *yj = _mm_unpackhi_pd(end_a, end_b);
+}
+
+/**
+ * Counts the crossings of the first edge_count edges, two at a time.
+ * edge_count must be even.
+ */
+KERNEL_FUNCTION
+static int count_crossings_sse2(double x, double y, const double *xy,
+                                int vertex_count, const int *edges,
+                                int edge_count) {
+  __m128d vx = _mm_set1_pd(x);
+  __m128d vy = _mm_set1_pd(y);
+  int crossings = 0;
+  for (int k = 0; k < edge_count; k += 2) {
+    __m128d xi, yi, xj, yj;
+    load_edges_sse2(xy, vertex_count, EDGE_AT(edges, k),
+                    EDGE_AT(edges, k + 1), &xi, &yi, &xj, &yj);
+    __m128d spans =
+        _mm_xor_pd(_mm_cmpgt_pd(yi, vy), _mm_cmpgt_pd(yj, vy));
+    __m128d hit = _mm_add_pd(
+        _mm_div_pd(_mm_mul_pd(_mm_sub_pd(xj, xi), _mm_sub_pd(vy, yi)),
+                   _mm_sub_pd(yj, yi)),
+        xi);
+    int mask = _mm_movemask_pd(_mm_and_pd(spans, _mm_cmplt_pd(vx, hit)));
+    crossings += (mask & 1) + (mask >> 1);
+  }
+  return crossings;
+}
+
+/**
+ * Tells which lanes hold cross products of opposite strict signs.
+ */
+KERNEL_FUNCTION
+static __m128d opposite_signs_sse2(__m128d a, __m128d b) {
+  __m128d zero = _mm_setzero_pd();
+  return _mm_or_pd(
+      _mm_and_pd(_mm_cmpgt_pd(a, zero), _mm_cmplt_pd(b, zero)),
+      _mm_and_pd(_mm_cmplt_pd(a, zero), _mm_cmpgt_pd(b, zero)));
+}
+
+/**
+ * Checks the first edge_count edges against a segment, two at a time.
+ * edge_count must be even.
+ */
+KERNEL_FUNCTION
+static bool segment_crosses_edges_sse2(double x1, double y1, double x2,
+                                       double y2, const double *xy,
+                                       int vertex_count, const int *edges,
+                                       int edge_count) {
+  __m128d vx1 = _mm_set1_pd(x1);
+  __m128d vy1 = _mm_set1_pd(y1);
+  __m128d vx2 = _mm_set1_pd(x2);
+  __m128d vy2 = _mm_set1_pd(y2);
+  __m128d dx = _mm_set1_pd(x2 - x1);
+  __m128d dy = _mm_set1_pd(y2 - y1);
+  for (int k = 0; k < edge_count; k += 2) {
+    __m128d x3, y3, x4, y4;
+    load_edges_sse2(xy, vertex_count, EDGE_AT(edges, k),
+                    EDGE_AT(edges, k + 1), &x3, &y3, &x4, &y4);
+    // Same products, in the same order, as geometry_cross_product()
+    __m128d cp1 = _mm_sub_pd(_mm_mul_pd(dx, _mm_sub_pd(y3, vy1)),
+                             _mm_mul_pd(dy, _mm_sub_pd(x3, vx1)));
+    __m128d cp2 = _mm_sub_pd(_mm_mul_pd(dx, _mm_sub_pd(y4, vy1)),
+                             _mm_mul_pd(dy, _mm_sub_pd(x4, vx1)));
+    __m128d ex = _mm_sub_pd(x4, x3);
+    __m128d ey = _mm_sub_pd(y4, y3);
+    __m128d cp3 = _mm_sub_pd(_mm_mul_pd(ex, _mm_sub_pd(vy1, y3)),
+                             _mm_mul_pd(ey, _mm_sub_pd(vx1, x3)));
+    __m128d cp4 = _mm_sub_pd(_mm_mul_pd(ex, _mm_sub_pd(vy2, y3)),
+                             _mm_mul_pd(ey, _mm_sub_pd(vx2, x3)));
+    __m128d crosses = _mm_and_pd(opposite_signs_sse2(cp1, cp2),
+                                 opposite_signs_sse2(cp3, cp4));
+    if (_mm_movemask_pd(crosses) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Checks the distance from a point to the first edge_count edges, two at a
+ * time. edge_count must be even.
+ */
+KERNEL_FUNCTION
+static bool edges_within_distance_sse2(double px, double py, double radius,
+                                       const double *xy, int vertex_count,
+                                       const int *edges, int edge_count) {
+  __m128d vpx = _mm_set1_pd(px);
+  __m128d vpy = _mm_set1_pd(py);
+  __m128d vr = _mm_set1_pd(radius);
+  __m128d zero = _mm_setzero_pd();
+  __m128d one = _mm_set1_pd(1.0);
+  for (int k = 0; k < edge_count; k += 2) {
+    __m128d x1, y1, x2, y2;
+    load_edges_sse2(xy, vertex_count, EDGE_AT(edges, k),
+                    EDGE_AT(edges, k + 1), &x1, &y1, &x2, &y2);
+    // Same steps as geometry_distance_point_segment(), with the branches
+    // turned into selects of the closest point
+    __m128d ex = _mm_sub_pd(x2, x1);
+    __m128d ey = _mm_sub_pd(y2, y1);
+    __m128d l2 = _mm_add_pd(_mm_mul_pd(ex, ex), _mm_mul_pd(ey, ey));
+    __m128d t = _mm_div_pd(
+        _mm_add_pd(_mm_mul_pd(_mm_sub_pd(vpx, x1), ex),
+                   _mm_mul_pd(_mm_sub_pd(vpy, y1), ey)),
+        l2);
+    __m128d qx = _mm_add_pd(x1, _mm_mul_pd(t, ex));
+    __m128d qy = _mm_add_pd(y1, _mm_mul_pd(t, ey));
+    __m128d past_end = _mm_cmpgt_pd(t, one);
+    qx = _mm_or_pd(_mm_and_pd(past_end, x2), _mm_andnot_pd(past_end, qx));
+    qy = _mm_or_pd(_mm_and_pd(past_end, y2), _mm_andnot_pd(past_end, qy));
+    __m128d at_start =
+        _mm_or_pd(_mm_cmpeq_pd(l2, zero), _mm_cmplt_pd(t, zero));
+    qx = _mm_or_pd(_mm_and_pd(at_start, x1), _mm_andnot_pd(at_start, qx));
+    qy = _mm_or_pd(_mm_and_pd(at_start, y1), _mm_andnot_pd(at_start, qy));
+    __m128d dx = _mm_sub_pd(qx, vpx);
+    __m128d dy = _mm_sub_pd(qy, vpy);
+    __m128d distance =
+        _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)));
+    if (_mm_movemask_pd(_mm_cmple_pd(distance, vr)) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
+#if GEOMETRY_HAVE_AVX2
+/**
+ * Loads the endpoints of edges k to k + 3 as vectors of x and y coordinates.
+ */
+AVX2_FUNCTION
+static void load_edges_avx2(const double *xy, int vertex_count,
+                            const int *edges, int k, __m256d *xi,
+                            __m256d *yi, __m256d *xj, __m256d *yj) {
+  int a = EDGE_AT(edges, k);
+  int b = EDGE_AT(edges, k + 1);
+  int c = EDGE_AT(edges, k + 2);
+  int d = EDGE_AT(edges, k + 3);
+  // Starts of a and c, then of b and d, so unpacking gives lanes a, b, c, d
+  __m256d start_ac = _mm256_insertf128_pd(
+      _mm256_castpd128_pd256(_mm_loadu_pd(xy + 2 * a)),
+      _mm_loadu_pd(xy + 2 * c), 1);
+  __m256d start_bd = _mm256_insertf128_pd(
+      _mm256_castpd128_pd256(_mm_loadu_pd(xy + 2 * b)),
+      _mm_loadu_pd(xy + 2 * d), 1);
+  __m256d end_ac = _mm256_insertf128_pd(
+      _mm256_castpd128_pd256(
+          _mm_loadu_pd(xy + 2 * EDGE_END(a, vertex_count))),
+      _mm_loadu_pd(xy + 2 * EDGE_END(c, vertex_count)), 1);
+  __m256d end_bd = _mm256_insertf128_pd(
+      _mm256_castpd128_pd256(
+          _mm_loadu_pd(xy + 2 * EDGE_END(b, vertex_count))),
+      _mm_loadu_pd(xy + 2 * EDGE_END(d, vertex_count)), 1);
+  *xi = _mm256_unpacklo_pd(start_ac, start_bd);
+  *yi = _mm256_unpackhi_pd(start_ac, start_bd);
+  *xj = _mm256_unpacklo_pd(end_ac, end_bd);
+  *yj = _mm256_unpackhi_pd(end_ac, end_bd);
+}
+
+/**
+ * Counts the crossings of the first edge_count edges, four at a time.
+ * edge_count must be a multiple of four.
+ */
+AVX2_FUNCTION
+static int count_crossings_avx2(double x, double y, const double *xy,
+                                int vertex_count, const int *edges,
+                                int edge_count) {
+  __m256d vx = _mm256_set1_pd(x);
+  __m256d vy = _mm256_set1_pd(y);
+  int crossings = 0;
+  for (int k = 0; k < edge_count; k += 4) {
+    __m256d xi, yi, xj, yj;
+    load_edges_avx2(xy, vertex_count, edges, k, &xi, &yi, &xj, &yj);
+    __m256d spans = _mm256_xor_pd(_mm256_cmp_pd(yi, vy, _CMP_GT_OQ),
+                                  _mm256_cmp_pd(yj, vy, _CMP_GT_OQ));
+    __m256d hit = _mm256_add_pd(
+        _mm256_div_pd(
+            _mm256_mul_pd(_mm256_sub_pd(xj, xi), _mm256_sub_pd(vy, yi)),
+            _mm256_sub_pd(yj, yi)),
+        xi);
+    __m256d crosses =
+        _mm256_and_pd(spans, _mm256_cmp_pd(vx, hit, _CMP_LT_OQ));
+    crossings += __builtin_popcount(_mm256_movemask_pd(crosses));
+  }
+  return crossings;
+}
+
+/**
+ * Tells which lanes hold cross products of opposite strict signs.
+ */
+AVX2_FUNCTION
+static __m256d opposite_signs_avx2(__m256d a, __m256d b) {
+  __m256d zero = _mm256_setzero_pd();
+  return _mm256_or_pd(_mm256_and_pd(_mm256_cmp_pd(a, zero, _CMP_GT_OQ),
+                                    _mm256_cmp_pd(b, zero, _CMP_LT_OQ)),
+                      _mm256_and_pd(_mm256_cmp_pd(a, zero, _CMP_LT_OQ),
+                                    _mm256_cmp_pd(b, zero, _CMP_GT_OQ)));
+}
+
+/**
+ * Checks the first edge_count edges against a segment, four at a time.
+ * edge_count must be a multiple of four.
+ */
+AVX2_FUNCTION
+static bool segment_crosses_edges_avx2(double x1, double y1, double x2,
+                                       double y2, const double *xy,
+                                       int vertex_count, const int *edges,
+                                       int edge_count) {
+  __m256d vx1 = _mm256_set1_pd(x1);
+  __m256d vy1 = _mm256_set1_pd(y1);
+  __m256d vx2 = _mm256_set1_pd(x2);
+  __m256d vy2 = _mm256_set1_pd(y2);
+  __m256d dx = _mm256_set1_pd(x2 - x1);
+  __m256d dy = _mm256_set1_pd(y2 - y1);
+  for (int k = 0; k < edge_count; k += 4) {
+    __m256d x3, y3, x4, y4;
+    load_edges_avx2(xy, vertex_count, edges, k, &x3, &y3, &x4, &y4);
+    // Same products, in the same order, as geometry_cross_product()
+    __m256d cp1 = _mm256_sub_pd(_mm256_mul_pd(dx, _mm256_sub_pd(y3, vy1)),
+                                _mm256_mul_pd(dy, _mm256_sub_pd(x3, vx1)));
+    __m256d cp2 = _mm256_sub_pd(_mm256_mul_pd(dx, _mm256_sub_pd(y4, vy1)),
+                                _mm256_mul_pd(dy, _mm256_sub_pd(x4, vx1)));
+    __m256d ex = _mm256_sub_pd(x4, x3);
+    __m256d ey = _mm256_sub_pd(y4, y3);
+    __m256d cp3 = _mm256_sub_pd(_mm256_mul_pd(ex, _mm256_sub_pd(vy1, y3)),
+                                _mm256_mul_pd(ey, _mm256_sub_pd(vx1, x3)));
+    __m256d cp4 = _mm256_sub_pd(_mm256_mul_pd(ex, _mm256_sub_pd(vy2, y3)),
+                                _mm256_mul_pd(ey, _mm256_sub_pd(vx2, x3)));
+    __m256d crosses = _mm256_and_pd(opposite_signs_avx2(cp1, cp2),
+                                    opposite_signs_avx2(cp3, cp4));
+    if (_mm256_movemask_pd(crosses) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Checks the distance from a point to the first edge_count edges, four at a
+ * time. edge_count must be a multiple of four.
+ */
+AVX2_FUNCTION
+static bool edges_within_distance_avx2(double px, double py, double radius,
+                                       const double *xy, int vertex_count,
+                                       const int *edges, int edge_count) {
+  __m256d vpx = _mm256_set1_pd(px);
+  __m256d vpy = _mm256_set1_pd(py);
+  __m256d vr = _mm256_set1_pd(radius);
+  __m256d zero = _mm256_setzero_pd();
+  __m256d one = _mm256_set1_pd(1.0);
+  for (int k = 0; k < edge_count; k += 4) {
+    __m256d x1, y1, x2, y2;
+    load_edges_avx2(xy, vertex_count, edges, k, &x1, &y1, &x2, &y2);
+    // Same steps as geometry_distance_point_segment(), with the branches
+    // turned into selects of the closest point
+    __m256d ex = _mm256_sub_pd(x2, x1);
+    __m256d ey = _mm256_sub_pd(y2, y1);
+    __m256d l2 =
+        _mm256_add_pd(_mm256_mul_pd(ex, ex), _mm256_mul_pd(ey, ey));
+    __m256d t = _mm256_div_pd(
+        _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(vpx, x1), ex),
+                      _mm256_mul_pd(_mm256_sub_pd(vpy, y1), ey)),
+        l2);
+    __m256d qx = _mm256_add_pd(x1, _mm256_mul_pd(t, ex));
+    __m256d qy = _mm256_add_pd(y1, _mm256_mul_pd(t, ey));
+    __m256d past_end = _mm256_cmp_pd(t, one, _CMP_GT_OQ);
+    qx = _mm256_blendv_pd(qx, x2, past_end);
+    qy = _mm256_blendv_pd(qy, y2, past_end);
+    __m256d at_start = _mm256_or_pd(_mm256_cmp_pd(l2, zero, _CMP_EQ_OQ),
+                                    _mm256_cmp_pd(t, zero, _CMP_LT_OQ));
+    qx = _mm256_blendv_pd(qx, x1, at_start);
+    qy = _mm256_blendv_pd(qy, y1, at_start);
+    __m256d dx = _mm256_sub_pd(qx, vpx);
+    __m256d dy = _mm256_sub_pd(qy, vpy);
+    __m256d distance = _mm256_sqrt_pd(
+        _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)));
+    if (_mm256_movemask_pd(_mm256_cmp_pd(distance, vr, _CMP_LE_OQ)) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
+/**
+ * Gets how many of edge_count edges the vector kernels take: a multiple of
+ * the width of the current level (0 for GEOMETRY_SIMD_NONE, or when there are
+ * too few edges to pay for the setup).
+ */
+static int vector_edge_count(GeometrySimdLevel level, int edge_count) {
+  if (edge_count < MIN_VECTOR_EDGES) {
+    return 0;
+  }
+  switch (level) {
+  case GEOMETRY_SIMD_AVX2:
+    return edge_count - edge_count % 4;
+  case GEOMETRY_SIMD_SSE2:
+    return edge_count - edge_count % 2;
+  default:
+    return 0;
+  }
+}
+
+KERNEL_FUNCTION
+int geometry_count_crossings(double x, double y, const double *xy,
+                             int vertex_count, const int *edges,
+                             int edge_count) {
+  if (!xy || vertex_count < 1 || edge_count <= 0) {
+    return 0;
+  }
+
+  GeometrySimdLevel level = geometry_simd_get_level();
+  int done = vector_edge_count(level, edge_count);
+  int crossings = 0;
+#if GEOMETRY_HAVE_AVX2
+  if (level == GEOMETRY_SIMD_AVX2) {
+    crossings = count_crossings_avx2(x, y, xy, vertex_count, edges, done);
+  }
+#endif
+#if GEOMETRY_HAVE_SSE2
+  if (level == GEOMETRY_SIMD_SSE2) {
+    crossings = count_crossings_sse2(x, y, xy, vertex_count, edges, done);
+  }
+#endif
+
+  for (int k = done; k < edge_count; k++) {
+    int i = EDGE_AT(edges, k);
+    int j = EDGE_END(i, vertex_count);
+    if (ray_crosses_edge(x, y, xy[2 * i], xy[2 * i + 1], xy[2 * j],
+                         xy[2 * j + 1])) {
+      crossings++;
+    }
+  }
+  return crossings;
+}
+
+KERNEL_FUNCTION
+bool geometry_segment_crosses_edges(double x1, double y1, double x2,
+                                    double y2, const double *xy,
+                                    int vertex_count, const int *edges,
+                                    int edge_count) {
+  if (!xy || vertex_count < 1 || edge_count <= 0) {
+    return false;
+  }
+
+  GeometrySimdLevel level = geometry_simd_get_level();
+  int done = vector_edge_count(level, edge_count);
+#if GEOMETRY_HAVE_AVX2
+  if (level == GEOMETRY_SIMD_AVX2 &&
+      segment_crosses_edges_avx2(x1, y1, x2, y2, xy, vertex_count, edges,
+                                 done)) {
+    return true;
+  }
+#endif
+#if GEOMETRY_HAVE_SSE2
+  if (level == GEOMETRY_SIMD_SSE2 &&
+      segment_crosses_edges_sse2(x1, y1, x2, y2, xy, vertex_count, edges,
+                                 done)) {
+    return true;
+  }
+#endif
+
+  for (int k = done; k < edge_count; k++) {
+    int i = EDGE_AT(edges, k);
+    int j = EDGE_END(i, vertex_count);
+    if (geometry_segment_intersects_segment(x1, y1, x2, y2, xy[2 * i],
+                                            xy[2 * i + 1], xy[2 * j],
+                                            xy[2 * j + 1])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+KERNEL_FUNCTION
+bool geometry_edges_within_distance(double px, double py, double radius,
+                                    const double *xy, int vertex_count,
+                                    const int *edges, int edge_count) {
+  if (!xy || vertex_count < 1 || edge_count <= 0) {
+    return false;
+  }
+
+  GeometrySimdLevel level = geometry_simd_get_level();
+  int done = vector_edge_count(level, edge_count);
+#if GEOMETRY_HAVE_AVX2
+  if (level == GEOMETRY_SIMD_AVX2 &&
+      edges_within_distance_avx2(px, py, radius, xy, vertex_count, edges,
+                                 done)) {
+    return true;
+  }
+#endif
+#if GEOMETRY_HAVE_SSE2
+  if (level == GEOMETRY_SIMD_SSE2 &&
+      edges_within_distance_sse2(px, py, radius, xy, vertex_count, edges,
+                                 done)) {
+    return true;
+  }
+#endif
+
+  for (int k = done; k < edge_count; k++) {
+    int i = EDGE_AT(edges, k);
+    int j = EDGE_END(i, vertex_count);
+    if (geometry_distance_point_segment(px, py, xy[2 * i], xy[2 * i + 1],
+                                        xy[2 * j], xy[2 * j + 1]) <= radius) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -5,6 +5,11 @@
  * This module provides geometric primitives and calculations needed for
  * the visibility algorithm, including point operations, angle calculations,
  * ray-segment intersections, and point-in-polygon tests.
+ *
+ * The edge kernels (geometry_count_crossings() and friends) test many polygon
+ * edges per call. On x86 they run 2 edges at a time with SSE2, or 4 with AVX2
+ * when the CPU reports it, and give exactly the answers of the one-edge
+ * functions.
  */
 
 #ifndef GEOMETRY_H
@@ -13,6 +18,15 @@
 #include "../shapes/line/line.h"
 #include <stdbool.h>
 
+/**
+ * @brief Instruction sets the edge kernels may use
+ */
+typedef enum {
+  GEOMETRY_SIMD_NONE, /**< One edge at a time */
+  GEOMETRY_SIMD_SSE2, /**< Two edges at a time */
+  GEOMETRY_SIMD_AVX2  /**< Four edges at a time */
+} GeometrySimdLevel;
+
 /**
  * @brief Opaque pointer type for Point instances
  */
@@ -57,6 +71,23 @@ double geometry_point_get_y(Point point);
  */
 double geometry_calculate_angle(double x, double y, double px, double py);
 
+/**
+ * @brief Calculates a pseudo-angle from source point (px, py) to target point
+ * (x, y), without trigonometry
+ *
+ * The diamond angle grows with the polar angle measured counterclockwise from
+ * the positive X axis: 0, 1, 2 and 3 along the axes, approaching 4 just below
+ * the positive X axis. It orders directions exactly like
+ * geometry_calculate_angle() shifted to [0, 2π).
+ * @param x Target point X coordinate
+ * @param y Target point Y coordinate
+ * @param px Source point X coordinate
+ * @param py Source point Y coordinate
+ * @return Pseudo-angle in [0, 4), 0 when both points coincide
+ */
+double geometry_calculate_pseudo_angle(double x, double y, double px,
+                                       double py);
+
 /**
  * @brief Calculates the Euclidean distance between two points
  * @param x1 First point X coordinate
@@ -84,11 +115,11 @@ bool geometry_segment_intersects_ray(Line segment, double x, double y,
  * @brief Determines if a point is inside a polygon using ray casting
  * @param x Point X coordinate
  * @param y Point Y coordinate
- * @param vertices Array of Point instances forming the polygon
+ * @param xy Interleaved vertex coordinates (x0, y0, x1, y1, ...)
  * @param vertex_count Number of vertices in the polygon
  * @return true if point is inside polygon, false otherwise
  */
-bool geometry_point_in_polygon(double x, double y, Point *vertices,
+bool geometry_point_in_polygon(double x, double y, const double *xy,
                                int vertex_count);
 
 /**
@@ -142,4 +173,75 @@ bool geometry_segment_intersects_segment(double x1, double y1, double x2,
 double geometry_distance_point_segment(double px, double py, double x1,
                                        double y1, double x2, double y2);
 
+/**
+ * @brief Gets the instruction set the edge kernels use
+ * @return The level picked with geometry_simd_set_level(), or else the best
+ * one the CPU supports
+ */
+GeometrySimdLevel geometry_simd_get_level(void);
+
+/**
+ * @brief Picks the instruction set of the edge kernels, for tests and
+ * benchmarks
+ *
+ * Not thread-safe: call it while no kernel is running.
+ * @param level Wanted level; lowered to the best one the CPU supports
+ * @return The level the kernels will use
+ */
+GeometrySimdLevel geometry_simd_set_level(GeometrySimdLevel level);
+
+/**
+ * @brief Counts the polygon edges a horizontal ray from a point crosses
+ *
+ * Uses the same crossing test as geometry_point_in_polygon(). Edge i runs
+ * from vertex i to vertex i + 1 (the last one wraps back to the first).
+ * @param x Ray origin X coordinate
+ * @param y Ray origin Y coordinate
+ * @param xy Interleaved vertex coordinates (x0, y0, x1, y1, ...)
+ * @param vertex_count Number of vertices in the polygon
+ * @param edges Indices of the edges to test, or NULL for edges 0 to
+ * edge_count - 1
+ * @param edge_count Number of edges to test
+ * @return Number of edges the ray crosses to the right of the point
+ */
+int geometry_count_crossings(double x, double y, const double *xy,
+                             int vertex_count, const int *edges,
+                             int edge_count);
+
+/**
+ * @brief Checks if a segment crosses any of a polygon's edges, as
+ * geometry_segment_intersects_segment() would tell
+ * @param x1 Segment start X
+ * @param y1 Segment start Y
+ * @param x2 Segment end X
+ * @param y2 Segment end Y
+ * @param xy Interleaved vertex coordinates (x0, y0, x1, y1, ...)
+ * @param vertex_count Number of vertices in the polygon
+ * @param edges Indices of the edges to test, or NULL for edges 0 to
+ * edge_count - 1
+ * @param edge_count Number of edges to test
+ * @return true if the segment strictly crosses one of the edges
+ */
+bool geometry_segment_crosses_edges(double x1, double y1, double x2,
+                                    double y2, const double *xy,
+                                    int vertex_count, const int *edges,
+                                    int edge_count);
+
+/**
+ * @brief Checks if any of a polygon's edges comes within a distance of a
+ * point, as geometry_distance_point_segment() would tell
+ * @param px Point X coordinate
+ * @param py Point Y coordinate
+ * @param radius Largest distance that counts
+ * @param xy Interleaved vertex coordinates (x0, y0, x1, y1, ...)
+ * @param vertex_count Number of vertices in the polygon
+ * @param edges Indices of the edges to test, or NULL for edges 0 to
+ * edge_count - 1
+ * @param edge_count Number of edges to test
+ * @return true if some edge is at most radius away from the point
+ */
+bool geometry_edges_within_distance(double px, double py, double radius,
+                                    const double *xy, int vertex_count,
+                                    const int *edges, int edge_count);
+
 #endif // GEOMETRY_H
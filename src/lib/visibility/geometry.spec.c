@@ -0,0 +1,245 @@
+/**
+ * @file geometry.spec.c
+ * @brief Unit tests for the geometry edge kernels
+ *
+ * Checks that the vectorized kernels defined in geometry.h give exactly the
+ * answers of the one-edge functions, at every instruction set level the CPU
+ * supports.
+ */
+
+#include "./geometry.h"
+#include "../test_framework/test_framework.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_VERTICES 67
+#define POLYGON_COUNT 300
+#define QUERIES_PER_POLYGON 40
+
+// ============================================================================
+// Test Helpers
+// ============================================================================
+
+// Random coordinate on a coarse grid, so ties, shared vertices and
+// horizontal or collinear edges come up often
+static double grid_coordinate(void) { return (double)(rand() % 41) * 0.5; }
+
+// Random coordinate anywhere in the polygon area
+static double fine_coordinate(void) {
+  return (double)rand() / RAND_MAX * 24.0 - 2.0;
+}
+
+// Fills a polygon with random vertices, repeating some of them
+static int random_polygon(double *xy) {
+  int count = 1 + rand() % MAX_VERTICES;
+  for (int i = 0; i < count; i++) {
+    if (i > 0 && rand() % 8 == 0) {
+      xy[2 * i] = xy[2 * (i - 1)];
+      xy[2 * i + 1] = xy[2 * (i - 1) + 1];
+    } else {
+      xy[2 * i] = grid_coordinate();
+      xy[2 * i + 1] = grid_coordinate();
+    }
+  }
+  return count;
+}
+
+// Picks random edges of a polygon, in any order and possibly repeated
+static int random_edges(int *edges, int vertex_count) {
+  int count = rand() % (2 * MAX_VERTICES);
+  for (int k = 0; k < count; k++) {
+    edges[k] = rand() % vertex_count;
+  }
+  return count;
+}
+
+// One query point, segment and radius, on the grid half of the time
+typedef struct {
+  double x1, y1, x2, y2, radius;
+} Query;
+
+static Query random_query(void) {
+  Query query;
+  bool on_grid = rand() % 2 == 0;
+  query.x1 = on_grid ? grid_coordinate() : fine_coordinate();
+  query.y1 = on_grid ? grid_coordinate() : fine_coordinate();
+  query.x2 = on_grid ? grid_coordinate() : fine_coordinate();
+  query.y2 = on_grid ? grid_coordinate() : fine_coordinate();
+  query.radius = (double)(rand() % 9) * 0.25;
+  return query;
+}
+
+// Answers of the three kernels for one query
+typedef struct {
+  int crossings;
+  bool segment_crosses;
+  bool within_distance;
+} Answers;
+
+// Answers a query with the one-edge functions
+static Answers reference_answers(Query query, const double *xy,
+                                 int vertex_count, const int *edges,
+                                 int edge_count) {
+  Answers answers = {0, false, false};
+  for (int k = 0; k < edge_count; k++) {
+    int i = edges ? edges[k] : k;
+    int j = i + 1 < vertex_count ? i + 1 : 0;
+    double xi = xy[2 * i];
+    double yi = xy[2 * i + 1];
+    double xj = xy[2 * j];
+    double yj = xy[2 * j + 1];
+    if (((yi > query.y1) != (yj > query.y1)) &&
+        (query.x1 < (xj - xi) * (query.y1 - yi) / (yj - yi) + xi)) {
+      answers.crossings++;
+    }
+    if (geometry_segment_intersects_segment(query.x1, query.y1, query.x2,
+                                            query.y2, xi, yi, xj, yj)) {
+      answers.segment_crosses = true;
+    }
+    if (geometry_distance_point_segment(query.x1, query.y1, xi, yi, xj, yj) <=
+        query.radius) {
+      answers.within_distance = true;
+    }
+  }
+  return answers;
+}
+
+// Answers a query with the kernels at the current level
+static Answers kernel_answers(Query query, const double *xy, int vertex_count,
+                              const int *edges, int edge_count) {
+  Answers answers;
+  answers.crossings = geometry_count_crossings(query.x1, query.y1, xy,
+                                               vertex_count, edges, edge_count);
+  answers.segment_crosses =
+      geometry_segment_crosses_edges(query.x1, query.y1, query.x2, query.y2,
+                                     xy, vertex_count, edges, edge_count);
+  answers.within_distance = geometry_edges_within_distance(
+      query.x1, query.y1, query.radius, xy, vertex_count, edges, edge_count);
+  return answers;
+}
+
+// Runs random queries on random polygons at one level, reporting the first
+// mismatch
+static bool kernels_match_reference(GeometrySimdLevel level) {
+  srand(1234);
+  double xy[2 * MAX_VERTICES];
+  int edges[2 * MAX_VERTICES];
+  for (int p = 0; p < POLYGON_COUNT; p++) {
+    int vertex_count = random_polygon(xy);
+    int edge_count = random_edges(edges, vertex_count);
+    for (int q = 0; q < QUERIES_PER_POLYGON; q++) {
+      Query query = random_query();
+      bool all_edges = q % 2 == 0;
+      const int *list = all_edges ? NULL : edges;
+      int count = all_edges ? vertex_count : edge_count;
+
+      Answers expected =
+          reference_answers(query, xy, vertex_count, list, count);
+      Answers actual = kernel_answers(query, xy, vertex_count, list, count);
+      if (expected.crossings != actual.crossings ||
+          expected.segment_crosses != actual.segment_crosses ||
+          expected.within_distance != actual.within_distance) {
+        printf("    level %d, polygon %d, query %d: expected %d/%d/%d, "
+               "got %d/%d/%d\n",
+               (int)level, p, q, expected.crossings, expected.segment_crosses,
+               expected.within_distance, actual.crossings,
+               actual.segment_crosses, actual.within_distance);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// ============================================================================
+// Tests for geometry_simd_set_level()
+// ============================================================================
+
+/**
+ * Test: levels above what the CPU supports should be lowered, never raised
+ */
+bool test_geometry_simd_set_level(void) {
+  GeometrySimdLevel best = geometry_simd_set_level(GEOMETRY_SIMD_AVX2);
+  ASSERT_EQUAL(geometry_simd_get_level(), best);
+
+  GeometrySimdLevel none = geometry_simd_set_level(GEOMETRY_SIMD_NONE);
+  ASSERT_EQUAL(none, GEOMETRY_SIMD_NONE);
+  ASSERT_EQUAL(geometry_simd_get_level(), GEOMETRY_SIMD_NONE);
+
+  geometry_simd_set_level(best);
+  return true;
+}
+
+// ============================================================================
+// Tests for the edge kernels
+// ============================================================================
+
+/**
+ * Test: every level should agree with the one-edge functions on every query
+ */
+bool test_geometry_kernels_match_scalar(void) {
+  GeometrySimdLevel best = geometry_simd_set_level(GEOMETRY_SIMD_AVX2);
+  for (int level = GEOMETRY_SIMD_NONE; level <= (int)best; level++) {
+    GeometrySimdLevel used = geometry_simd_set_level((GeometrySimdLevel)level);
+    ASSERT_EQUAL(used, level);
+    bool match = kernels_match_reference(used);
+    ASSERT_TRUE(match);
+  }
+  geometry_simd_set_level(best);
+  return true;
+}
+
+/**
+ * Test: known answers on a square, with edge counts around every vector
+ * width
+ */
+bool test_geometry_kernels_square(void) {
+  double xy[8] = {0.0, 0.0, 10.0, 0.0, 10.0, 10.0, 0.0, 10.0};
+  int right[5] = {1, 1, 1, 1, 1};
+
+  int inside = geometry_count_crossings(5.0, 5.0, xy, 4, NULL, 4);
+  ASSERT_EQUAL(inside, 1);
+  int outside = geometry_count_crossings(-5.0, 5.0, xy, 4, NULL, 4);
+  ASSERT_EQUAL(outside, 2);
+  for (int count = 1; count <= 5; count++) {
+    int crossings = geometry_count_crossings(5.0, 5.0, xy, 4, right, count);
+    ASSERT_EQUAL(crossings, count);
+  }
+
+  ASSERT_TRUE(geometry_segment_crosses_edges(5.0, 5.0, 15.0, 5.0, xy, 4, NULL,
+                                             4));
+  ASSERT_FALSE(geometry_segment_crosses_edges(2.0, 2.0, 8.0, 8.0, xy, 4, NULL,
+                                              4));
+  ASSERT_TRUE(geometry_edges_within_distance(12.0, 5.0, 2.0, xy, 4, NULL, 4));
+  ASSERT_FALSE(
+      geometry_edges_within_distance(12.5, 5.0, 2.0, xy, 4, right, 5));
+
+  // Nothing to test
+  ASSERT_EQUAL(geometry_count_crossings(5.0, 5.0, NULL, 4, NULL, 4), 0);
+  ASSERT_FALSE(geometry_segment_crosses_edges(0, 0, 1, 1, xy, 4, NULL, 0));
+  ASSERT_FALSE(geometry_edges_within_distance(0, 0, 1, xy, 0, NULL, 4));
+  return true;
+}
+
+// ============================================================================
+// Main Test Runner
+// ============================================================================
+
+int main(void) {
+  test_framework_init();
+
+  test_print_section("Testing geometry_simd_set_level()");
+  test_register("test_geometry_simd_set_level", test_geometry_simd_set_level);
+
+  test_print_section("Testing geometry edge kernels");
+  test_register("test_geometry_kernels_match_scalar",
+                test_geometry_kernels_match_scalar);
+  test_register("test_geometry_kernels_square", test_geometry_kernels_square);
+
+  int result = test_run_all();
+
+  test_framework_cleanup();
+
+  return result;
+}
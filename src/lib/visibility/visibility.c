@@ -1,6 +1,7 @@
 #include "visibility.h"
+#include "../commons/arena/arena.h"
 #include "../commons/bst/bst.h"
-#include "../commons/list/list.h"
+#include "../commons/sequence/sequence.h"
 #include "../commons/sorting/sorting.h"
 #include "../shapes/line/line.h"
 #include "../shapes/shapes.h"
@@ -14,10 +15,20 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+// Vertices are stored interleaved (x0, y0, x1, y1, ...) in one buffer. Once
+// the sweep is done, the edges are bucketed into horizontal slabs of equal
+// height spanning the bounding box: edge i (vertex i to vertex i + 1) is
+// listed in every slab its y range touches.
 struct VisibilityPolygon {
-  Point *vertices;
+  double *xy;
   int vertex_count;
   int capacity;
+  double min_x, min_y, max_x, max_y; // Bounding box (when vertex_count > 0)
+  int band_count;    // Number of slabs (0 when not built)
+  double band_scale; // Slabs per unit of y
+  int *band_start;   // Slab b lists band_edges[band_start[b]..band_start[b+1])
+  int *band_edges;   // Edge indexes, grouped by slab
+  int references;    // Owners sharing the polygon
 };
 
 typedef struct {
@@ -30,10 +41,17 @@ typedef struct Segment {
   Point2D p_final;
   int id;
   BSTNode helper;
+  // Whether rays between its events cross it ahead of the source. Pieces
+  // below the source that end on the angle 0 ray get their events at 0 and
+  // past 2, and segments through the source are only met at distance 0, so
+  // these stay out of the tree.
+  bool swept;
 } Segment;
 
 typedef enum { EVENT_START, EVENT_END } EventType;
 
+// Sweep angles are pseudo-angles (see geometry_calculate_pseudo_angle()),
+// which order directions like polar angles without trigonometry
 typedef struct {
   Point2D point;
   EventType type;
@@ -45,35 +63,75 @@ typedef struct {
 typedef struct {
   Point2D source;
   double current_angle;
+  Point2D direction; // Unit vector of the ray at current_angle
 } SweepContext;
 
+// Point where two neighbouring active segments cross ahead of the sweep;
+// first is the nearer one before the crossing
+typedef struct {
+  double angle;
+  Point2D point;
+  Segment *first;
+  Segment *second;
+} Crossing;
+
+// Min-heap of pending crossings by angle. Entries may go stale when the
+// segments stop being neighbours; they are checked again when popped.
+typedef struct {
+  Crossing *items;
+  int count;
+  int capacity;
+  Arena arena;
+} CrossingQueue;
+
+// Barrier endpoints extracted once and shared by every sweep
+struct BarrierSet {
+  double *coords; // x1, y1, x2, y2 per barrier
+  int *ids;       // Line id per barrier
+  int count;
+};
+
+// First arena block of a workspace; it grows to fit the largest sweep
+#define WORKSPACE_BLOCK_SIZE (64 * 1024)
+
+// Cosine and sine of the angular step (1e-7 radians) used to break distance
+// ties just past the current ray
+#define TIE_BREAK_COS 0.999999999999995
+#define TIE_BREAK_SIN 1e-7
+
+// Slab entries allowed per polygon edge before the slabs get coarser
+#define SLAB_ENTRIES_PER_EDGE 8
+
+// Most slabs built for one polygon
+#define MAX_SLAB_COUNT 4096
+
+// Slack for rejecting points to the right of the polygon, well above the
+// rounding of the ray casting intersections
+#define CONTAINMENT_SLACK 1e-6
+
 static bool add_vertex(struct VisibilityPolygon *polygon, double x, double y) {
   if (!polygon)
     return false;
 
   if (polygon->vertex_count >= polygon->capacity) {
     int new_capacity = polygon->capacity == 0 ? 16 : polygon->capacity * 2;
-    Point *new_vertices =
-        realloc(polygon->vertices, new_capacity * sizeof(Point));
-    if (!new_vertices)
+    double *new_xy = realloc(polygon->xy, new_capacity * 2 * sizeof(double));
+    if (!new_xy)
       return false;
-    polygon->vertices = new_vertices;
+    polygon->xy = new_xy;
     polygon->capacity = new_capacity;
   }
 
   if (polygon->vertex_count > 0) {
-    Point last = polygon->vertices[polygon->vertex_count - 1];
-    double lx = geometry_point_get_x(last);
-    double ly = geometry_point_get_y(last);
-    if (fabs(x - lx) < 1e-9 && fabs(y - ly) < 1e-9) {
+    const double *last = &polygon->xy[2 * (polygon->vertex_count - 1)];
+    if (fabs(x - last[0]) < 1e-9 && fabs(y - last[1]) < 1e-9) {
       return true;
     }
   }
 
-  Point point = geometry_point_create(x, y);
-  if (!point)
-    return false;
-  polygon->vertices[polygon->vertex_count++] = point;
+  double *slot = &polygon->xy[2 * polygon->vertex_count++];
+  slot[0] = x;
+  slot[1] = y;
   return true;
 }
 
@@ -107,10 +165,20 @@ static Point2D ray_segment_intersect(Point2D source, Point2D direction_point,
   return (Point2D){source.x + dx / len * 10000, source.y + dy / len * 10000};
 }
 
+// Gets the unit vector from the source to a point at the given distance, or
+// the direction of angle 0 for the source itself
+static Point2D ray_direction(Point2D point, Point2D source, double distance) {
+  if (distance == 0)
+    return (Point2D){1, 0};
+  return (Point2D){(point.x - source.x) / distance,
+                   (point.y - source.y) / distance};
+}
+
+// Gets the distance along a ray to a segment, or 1e18 when the ray misses it
 static double calc_ray_segment_distance(Segment *s, Point2D source,
-                                        double angle) {
-  double dx = cos(angle);
-  double dy = sin(angle);
+                                        Point2D direction) {
+  double dx = direction.x;
+  double dy = direction.y;
 
   double x1 = s->p_initial.x, y1 = s->p_initial.y;
   double x2 = s->p_final.x, y2 = s->p_final.y;
@@ -129,6 +197,13 @@ static double calc_ray_segment_distance(Segment *s, Point2D source,
   return t;
 }
 
+// Gets the direction of the ray just past the given one, used to break
+// distance ties
+static Point2D just_past(Point2D direction) {
+  return (Point2D){direction.x * TIE_BREAK_COS - direction.y * TIE_BREAK_SIN,
+                   direction.x * TIE_BREAK_SIN + direction.y * TIE_BREAK_COS};
+}
+
 static int compare_segments(void *a, void *b, void *context) {
   Segment *s1 = (Segment *)a;
   Segment *s2 = (Segment *)b;
@@ -137,9 +212,19 @@ static int compare_segments(void *a, void *b, void *context) {
   if (s1 == s2)
     return 0;
 
-  double d1 = calc_ray_segment_distance(s1, ctx->source, ctx->current_angle);
-  double d2 = calc_ray_segment_distance(s2, ctx->source, ctx->current_angle);
+  double d1 = calc_ray_segment_distance(s1, ctx->source, ctx->direction);
+  double d2 = calc_ray_segment_distance(s2, ctx->source, ctx->direction);
 
+  if (fabs(d1 - d2) > 1e-9) {
+    return (d1 < d2) ? -1 : 1;
+  }
+
+  // Segments meeting on the current ray (e.g. two sides leaving a shared
+  // corner) are ordered by which one is nearer just past it, so the tree
+  // stays valid as the sweep advances
+  Point2D after = just_past(ctx->direction);
+  d1 = calc_ray_segment_distance(s1, ctx->source, after);
+  d2 = calc_ray_segment_distance(s2, ctx->source, after);
   if (fabs(d1 - d2) > 1e-9) {
     return (d1 < d2) ? -1 : 1;
   }
@@ -164,61 +249,492 @@ static int compare_vertices(const void *a, const void *b) {
   return 0;
 }
 
-static bool is_in_front(Point2D v, double v_distance, Segment *biombo,
-                        Point2D source, double angle) {
+// Radix key of a sweep event: its angle. Events with close angles are put in
+// compare_vertices() order by the tie pass of sorting_radixsort().
+static uint64_t vertex_key(const void *a) {
+  return sorting_double_key(((const Vertex *)a)->angle);
+}
+
+// Radix key ordering sweep events at one angle: START before END, then by
+// distance. Distances are never negative, so the top bit of their key is
+// always set and can hold the type instead.
+static uint64_t vertex_tie_key(const void *a) {
+  const Vertex *v = (const Vertex *)a;
+  const uint64_t top = (uint64_t)1 << 63;
+  uint64_t key = sorting_double_key(v->distance) & ~top;
+  return v->type == EVENT_END ? key | top : key;
+}
+
+static bool is_in_front(double v_distance, Segment *biombo, Point2D source,
+                        Point2D direction) {
   if (!biombo)
     return true;
-  double biombo_dist = calc_ray_segment_distance(biombo, source, angle);
+  double biombo_dist = calc_ray_segment_distance(biombo, source, direction);
   // If biombo doesn't intersect at current angle, v is in front
   if (biombo_dist >= 1e17)
     return true;
   return v_distance < biombo_dist - 1e-9;
 }
 
-// Helper struct for BST traversal to find closest segment
-typedef struct {
-  Segment *closest;
-  double closest_dist;
-  Point2D source;
-  double angle;
-} FindClosestContext;
+/**
+ * Finds the point where two segments cross or touch (e.g. one ends on the
+ * other). Returns false if they do not meet or are parallel.
+ */
+static bool crossing_point(Segment *a, Segment *b, Point2D *point) {
+  double ax = a->p_final.x - a->p_initial.x;
+  double ay = a->p_final.y - a->p_initial.y;
+  double bx = b->p_final.x - b->p_initial.x;
+  double by = b->p_final.y - b->p_initial.y;
+
+  double denom = ax * by - ay * bx;
+  if (fabs(denom) < 1e-12)
+    return false;
+
+  double wx = b->p_initial.x - a->p_initial.x;
+  double wy = b->p_initial.y - a->p_initial.y;
+  double t = (wx * by - wy * bx) / denom;
+  double u = (wx * ay - wy * ax) / denom;
+  if (t < -1e-9 || t > 1.0 + 1e-9 || u < -1e-9 || u > 1.0 + 1e-9)
+    return false;
+
+  *point = (Point2D){a->p_initial.x + t * ax, a->p_initial.y + t * ay};
+  return true;
+}
+
+// Adds a crossing to the queue, growing it in the sweep arena when full
+static void push_crossing(CrossingQueue *queue, Crossing crossing) {
+  if (queue->count == queue->capacity) {
+    int capacity = queue->capacity == 0 ? 64 : queue->capacity * 2;
+    Crossing *items = arena_alloc(queue->arena, sizeof(Crossing) * capacity);
+    if (!items)
+      return;
+    if (queue->count > 0)
+      memcpy(items, queue->items, sizeof(Crossing) * queue->count);
+    queue->items = items;
+    queue->capacity = capacity;
+  }
 
-static void find_closest_callback(void *data, void *ctx) {
-  Segment *s = (Segment *)data;
-  FindClosestContext *fcc = (FindClosestContext *)ctx;
-  double dist = calc_ray_segment_distance(s, fcc->source, fcc->angle);
-  if (dist > 0 && dist < fcc->closest_dist) {
-    fcc->closest_dist = dist;
-    fcc->closest = s;
+  int i = queue->count++;
+  while (i > 0 && queue->items[(i - 1) / 2].angle > crossing.angle) {
+    queue->items[i] = queue->items[(i - 1) / 2];
+    i = (i - 1) / 2;
   }
+  queue->items[i] = crossing;
 }
 
-static Segment *find_closest_at_angle(BST tree, Point2D source, double angle) {
-  FindClosestContext fcc = {NULL, 1e18, source, angle};
-  bst_foreach(tree, find_closest_callback, &fcc);
-  return fcc.closest;
+// Takes the first crossing in the queue if it is at most at the given angle
+static bool pop_crossing(CrossingQueue *queue, double angle,
+                         Crossing *crossing) {
+  if (queue->count == 0 || queue->items[0].angle > angle)
+    return false;
+
+  *crossing = queue->items[0];
+  Crossing last = queue->items[--queue->count];
+  int i = 0;
+  for (;;) {
+    int child = 2 * i + 1;
+    if (child >= queue->count)
+      break;
+    if (child + 1 < queue->count &&
+        queue->items[child + 1].angle < queue->items[child].angle)
+      child++;
+    if (queue->items[child].angle >= last.angle)
+      break;
+    queue->items[i] = queue->items[child];
+    i = child;
+  }
+  if (queue->count > 0)
+    queue->items[i] = last;
+  return true;
 }
 
-VisibilityPolygon visibility_calculate(double x, double y, List barriers,
-                                       double max_radius, SortType sort_type,
+/**
+ * Queues the crossing of two neighbouring nodes if it is not behind the
+ * sweep. Before any pair of active segments can swap order they must be
+ * adjacent in the tree, so watching neighbours is enough.
+ */
+static void watch_crossing(CrossingQueue *queue, SweepContext *ctx, BSTNode a,
+                           BSTNode b) {
+  if (!a || !b)
+    return;
+
+  Crossing crossing;
+  crossing.first = (Segment *)bst_node_get_data(a);
+  crossing.second = (Segment *)bst_node_get_data(b);
+  if (!crossing_point(crossing.first, crossing.second, &crossing.point))
+    return;
+  crossing.angle = geometry_calculate_pseudo_angle(
+      crossing.point.x, crossing.point.y, ctx->source.x, ctx->source.y);
+  // Crossings found right at the current angle may round to just below it
+  if (crossing.angle >= ctx->current_angle - 1e-9)
+    push_crossing(queue, crossing);
+}
+
+/**
+ * Swaps every pair of neighbouring segments that cross at or before the
+ * given angle, in angle order, so the tree is ordered by distance along the
+ * ray at that angle. Pairs that no longer are neighbours, or that only
+ * touch without changing order, are left alone.
+ */
+static void pass_crossings(CrossingQueue *queue, SweepContext *ctx,
+                           double angle) {
+  Crossing crossing;
+  while (pop_crossing(queue, angle, &crossing)) {
+    Segment *a = crossing.first;
+    Segment *b = crossing.second;
+    if (!a->helper || !b->helper || bst_node_next(a->helper) != b->helper)
+      continue;
+
+    ctx->current_angle = crossing.angle;
+    double distance = geometry_distance(ctx->source.x, ctx->source.y,
+                                        crossing.point.x, crossing.point.y);
+    ctx->direction = ray_direction(crossing.point, ctx->source, distance);
+    Point2D after = just_past(ctx->direction);
+    if (calc_ray_segment_distance(b, ctx->source, after) >=
+        calc_ray_segment_distance(a, ctx->source, after))
+      continue;
+
+    BSTNode node = a->helper;
+    bst_node_swap_data(a->helper, b->helper);
+    a->helper = b->helper;
+    b->helper = node;
+    watch_crossing(queue, ctx, bst_node_prev(b->helper), b->helper);
+    watch_crossing(queue, ctx, a->helper, bst_node_next(a->helper));
+  }
+}
+
+static void insert_active(BST tree, SweepContext *ctx, CrossingQueue *queue,
+                          Segment *s) {
+  s->helper = bst_insert(tree, s);
+  watch_crossing(queue, ctx, bst_node_prev(s->helper), s->helper);
+  watch_crossing(queue, ctx, s->helper, bst_node_next(s->helper));
+}
+
+static void remove_active(BST tree, SweepContext *ctx, CrossingQueue *queue,
+                          Segment *s) {
+  BSTNode prev = bst_node_prev(s->helper);
+  BSTNode next = bst_node_next(s->helper);
+  bst_remove_node(tree, s->helper);
+  s->helper = NULL;
+  watch_crossing(queue, ctx, prev, next);
+}
+
+/**
+ * Finds the active segment closest to the source along the current ray.
+ * Crossings are swapped as the sweep passes them, so the tree is ordered by
+ * ray distance and this is its minimum.
+ */
+static Segment *find_closest_at_angle(BST tree, SweepContext *ctx) {
+  // Skip segments touching the source and segments whose END event at
+  // this angle is still pending (the ray already misses them)
+  BSTNode node = bst_find_min_node(tree);
+  while (node) {
+    Segment *s = (Segment *)bst_node_get_data(node);
+    double dist = calc_ray_segment_distance(s, ctx->source, ctx->direction);
+    if (dist > 0 && dist < 1e18)
+      return s;
+    node = bst_node_next(node);
+  }
+  return NULL;
+}
+
+#ifdef VISIBILITY_CHECK_SWEEP
+long visibility_sweep_mismatches = 0;
+
+// Compares the closest segment found in the tree with a scan of every active
+// segment along the current ray, counting disagreements
+static void check_closest(BST tree, SweepContext *ctx, Segment *found) {
+  double closest_dist = 1e18;
+  for (BSTNode node = bst_find_min_node(tree); node;
+       node = bst_node_next(node)) {
+    Segment *s = (Segment *)bst_node_get_data(node);
+    double dist = calc_ray_segment_distance(s, ctx->source, ctx->direction);
+    if (dist > 0 && dist < closest_dist)
+      closest_dist = dist;
+  }
+
+  double found_dist =
+      found ? calc_ray_segment_distance(found, ctx->source, ctx->direction)
+            : 1e18;
+  if (fabs(found_dist - closest_dist) > 1e-9)
+    visibility_sweep_mismatches++;
+}
+#endif
+
+// Gets the slab holding a y coordinate (clamped to the valid slabs). The
+// mapping is monotonic in y.
+static int band_of(const struct VisibilityPolygon *polygon, double y) {
+  double band = (y - polygon->min_y) * polygon->band_scale;
+  // Also catches NaN, which the sweep gives for a source on a barrier end
+  if (!(band >= 0))
+    return 0;
+  if (band >= polygon->band_count)
+    return polygon->band_count - 1;
+  return (int)band;
+}
+
+// Gets the y range of edge i
+static void edge_y_range(const struct VisibilityPolygon *polygon, int i,
+                         double *low, double *high) {
+  int j = i + 1 < polygon->vertex_count ? i + 1 : 0;
+  double yi = polygon->xy[2 * i + 1];
+  double yj = polygon->xy[2 * j + 1];
+  // fmin() and fmax() skip a NaN end, so low <= high always holds and the
+  // counting and filling passes agree
+  *low = fmin(yi, yj);
+  *high = fmax(yi, yj);
+}
+
+// Counts the slab entries needed with the current slab count
+static long count_slab_entries(const struct VisibilityPolygon *polygon) {
+  long total = 0;
+  for (int i = 0; i < polygon->vertex_count; i++) {
+    double low, high;
+    edge_y_range(polygon, i, &low, &high);
+    total += band_of(polygon, high) - band_of(polygon, low) + 1;
+  }
+  return total;
+}
+
+// Computes the bounding box and buckets the edges into slabs. Slabs start as
+// fine as one per vertex and are halved until long edges no longer blow up
+// the entry count. On allocation failure the polygon is left without slabs
+// and queries fall back to scanning every edge. The fill cursors are scratch
+// taken from the sweep arena.
+static void build_slabs(struct VisibilityPolygon *polygon, Arena arena) {
+  int n = polygon->vertex_count;
+  if (n == 0)
+    return;
+
+  const double *xy = polygon->xy;
+  polygon->min_x = polygon->max_x = xy[0];
+  polygon->min_y = polygon->max_y = xy[1];
+  for (int i = 1; i < n; i++) {
+    double vx = xy[2 * i];
+    double vy = xy[2 * i + 1];
+    if (vx < polygon->min_x)
+      polygon->min_x = vx;
+    if (vx > polygon->max_x)
+      polygon->max_x = vx;
+    if (vy < polygon->min_y)
+      polygon->min_y = vy;
+    if (vy > polygon->max_y)
+      polygon->max_y = vy;
+  }
+
+  double height = polygon->max_y - polygon->min_y;
+  int band_count = n < MAX_SLAB_COUNT ? n : MAX_SLAB_COUNT;
+  if (!(height > 0.0))
+    band_count = 1;
+
+  long total;
+  for (;;) {
+    polygon->band_count = band_count;
+    polygon->band_scale = height > 0.0 ? band_count / height : 0.0;
+    total = count_slab_entries(polygon);
+    if (band_count == 1 || total <= (long)SLAB_ENTRIES_PER_EDGE * n)
+      break;
+    band_count /= 2;
+  }
+
+  polygon->band_start = calloc(band_count + 1, sizeof(int));
+  polygon->band_edges = malloc(sizeof(int) * total);
+  if (!polygon->band_start || !polygon->band_edges) {
+    free(polygon->band_start);
+    free(polygon->band_edges);
+    polygon->band_start = NULL;
+    polygon->band_edges = NULL;
+    polygon->band_count = 0;
+    return;
+  }
+
+  // Count the edges of every slab, then turn the counts into offsets
+  for (int i = 0; i < n; i++) {
+    double low, high;
+    edge_y_range(polygon, i, &low, &high);
+    for (int b = band_of(polygon, low); b <= band_of(polygon, high); b++)
+      polygon->band_start[b + 1]++;
+  }
+  for (int b = 0; b < band_count; b++)
+    polygon->band_start[b + 1] += polygon->band_start[b];
+
+  // Fill the slabs, keeping edges in index order inside each one
+  int *fill = arena_alloc(arena, sizeof(int) * band_count);
+  if (!fill) {
+    free(polygon->band_start);
+    free(polygon->band_edges);
+    polygon->band_start = NULL;
+    polygon->band_edges = NULL;
+    polygon->band_count = 0;
+    return;
+  }
+  memcpy(fill, polygon->band_start, sizeof(int) * band_count);
+  for (int i = 0; i < n; i++) {
+    double low, high;
+    edge_y_range(polygon, i, &low, &high);
+    for (int b = band_of(polygon, low); b <= band_of(polygon, high); b++)
+      polygon->band_edges[fill[b]++] = i;
+  }
+  arena_release(arena, fill);
+}
+
+// Checks if a radius bounds the region (see visibility_calculate())
+static bool is_bounded(double max_radius) {
+  return max_radius > 0 && isfinite(max_radius);
+}
+
+// Adds the points of the circle around source from point from to point to,
+// counterclockwise, both excluded. Points are VISIBILITY_ARC_SEGMENTS to a
+// turn; a full turn is made when from and to coincide.
+static void add_arc(struct VisibilityPolygon *polygon, Point2D source,
+                    double radius, Point2D from, Point2D to) {
+  double from_angle =
+      geometry_calculate_pseudo_angle(from.x, from.y, source.x, source.y);
+  double span =
+      geometry_calculate_pseudo_angle(to.x, to.y, source.x, source.y) -
+      from_angle;
+  if (span <= 0)
+    span += 4;
+
+  double step = 2 * M_PI / VISIBILITY_ARC_SEGMENTS;
+  double step_cos = cos(step);
+  double step_sin = sin(step);
+  Point2D direction = {(from.x - source.x) / radius,
+                       (from.y - source.y) / radius};
+  for (int k = 1; k < VISIBILITY_ARC_SEGMENTS; k++) {
+    direction = (Point2D){direction.x * step_cos - direction.y * step_sin,
+                          direction.x * step_sin + direction.y * step_cos};
+    double offset =
+        geometry_calculate_pseudo_angle(direction.x, direction.y, 0, 0) -
+        from_angle;
+    if (offset < 0)
+      offset += 4;
+    if (offset >= span)
+      break;
+    add_vertex(polygon, source.x + radius * direction.x,
+               source.y + radius * direction.y);
+  }
+}
+
+// Clips a polygon swept from source to the circle of the given radius. The
+// polygon is star-shaped around the source, so walking its boundary once
+// and replacing every stretch outside the circle with an arc is enough. The
+// copy of the old boundary is scratch taken from the sweep arena.
+static void clip_to_radius(struct VisibilityPolygon *polygon, Point2D source,
+                           double radius, Arena arena) {
+  int n = polygon->vertex_count;
+  double *xy = arena_alloc(arena, sizeof(double) * 2 * n);
+  if (n == 0 || !xy)
+    return;
+  memcpy(xy, polygon->xy, sizeof(double) * 2 * n);
+  polygon->vertex_count = 0;
+
+  double radius2 = radius * radius;
+  bool exited = false;  // The boundary left the circle at exit_point
+  bool entered = false; // The boundary entered the circle at first_entry
+  Point2D exit_point = {0, 0};
+  Point2D first_entry = {0, 0};
+  bool any_inside = false;
+
+  for (int i = 0; i < n; i++) {
+    int j = i + 1 < n ? i + 1 : 0;
+    Point2D a = {xy[2 * i], xy[2 * i + 1]};
+    Point2D b = {xy[2 * j], xy[2 * j + 1]};
+    double ax = a.x - source.x, ay = a.y - source.y;
+    double dx = b.x - a.x, dy = b.y - a.y;
+    double c = ax * ax + ay * ay - radius2;
+    double bx = b.x - source.x, by = b.y - source.y;
+    bool a_inside = c <= 0;
+    bool b_inside = bx * bx + by * by <= radius2;
+
+    if (a_inside) {
+      add_vertex(polygon, a.x, a.y);
+      any_inside = true;
+    }
+    if (a_inside && b_inside)
+      continue;
+
+    // Parameters t1 <= t2 where a + t * (b - a) meets the circle
+    double qa = dx * dx + dy * dy;
+    double qb = 2 * (dx * ax + dy * ay);
+    double disc = qb * qb - 4 * qa * c;
+    // An edge with both ends outside only counts if it cuts a chord; one
+    // with an end on each side crosses even if rounding says it grazes
+    if (qa == 0 || (!a_inside && !b_inside && disc <= 0))
+      continue;
+    double root = disc > 0 ? sqrt(disc) : 0;
+    double t1 = (-qb - root) / (2 * qa);
+    double t2 = (-qb + root) / (2 * qa);
+    if (!a_inside && !b_inside && !(t1 > 0 && t2 < 1))
+      continue;
+
+    if (!a_inside) {
+      t1 = t1 < 0 ? 0 : (t1 > 1 ? 1 : t1);
+      Point2D entry = {a.x + t1 * dx, a.y + t1 * dy};
+      if (exited) {
+        add_arc(polygon, source, radius, exit_point, entry);
+      } else if (!entered) {
+        first_entry = entry;
+        entered = true;
+      }
+      add_vertex(polygon, entry.x, entry.y);
+      any_inside = true;
+    }
+    if (!b_inside) {
+      t2 = t2 < 0 ? 0 : (t2 > 1 ? 1 : t2);
+      exit_point = (Point2D){a.x + t2 * dx, a.y + t2 * dy};
+      add_vertex(polygon, exit_point.x, exit_point.y);
+      exited = true;
+    }
+  }
+
+  // Close the last stretch outside back to where the walk first entered
+  if (exited && entered) {
+    add_arc(polygon, source, radius, exit_point, first_entry);
+  } else if (!any_inside) {
+    // Nothing blocks the view inside the circle
+    Point2D start = {source.x + radius, source.y};
+    add_vertex(polygon, start.x, start.y);
+    add_arc(polygon, source, radius, start, start);
+  }
+  arena_release(arena, xy);
+}
+
+/**
+ * Runs the angular sweep for one source against a prepared barrier set. All
+ * scratch memory (segments, events, sort buffer, the active segment tree and
+ * its nodes) comes from the arena, which is reset first; only the polygon is
+ * allocated on the heap.
+ */
+static VisibilityPolygon sweep_polygon(Arena arena, struct BarrierSet *set,
+                                       double x, double y, double max_radius,
+                                       SortType sort_type,
                                        int sort_threshold, double min_x,
                                        double min_y, double max_x,
                                        double max_y) {
-  if (!barriers)
-    return NULL;
-
   struct VisibilityPolygon *polygon = malloc(sizeof(struct VisibilityPolygon));
   if (!polygon)
     return NULL;
-  polygon->vertices = NULL;
+  polygon->xy = NULL;
   polygon->vertex_count = 0;
   polygon->capacity = 0;
+  polygon->band_count = 0;
+  polygon->band_start = NULL;
+  polygon->band_edges = NULL;
+  polygon->references = 1;
 
   Point2D source = {x, y};
 
-  int segment_capacity = (list_size(barriers) + 4) * 2;
+  // Every barrier and the 4 box sides, each possibly split at angle 0
+  arena_reset(arena);
+  int segment_capacity = (set->count + 4) * 2;
+  Segment *segments = arena_alloc(arena, sizeof(Segment) * segment_capacity);
+  Vertex *vertices = arena_alloc(arena, sizeof(Vertex) * segment_capacity * 2);
+  if (!segments || !vertices) {
+    free(polygon);
+    return NULL;
+  }
   int segment_count = 0;
-  Segment **segments = malloc(sizeof(Segment *) * segment_capacity);
 
   // Calculate bounding box based on passed parameters
   double box_min_x = min_x;
@@ -239,72 +755,69 @@ VisibilityPolygon visibility_calculate(double x, double y, List barriers,
   if (y + margin > box_max_y)
     box_max_y = y + margin;
 
+  // Nothing past the radius is kept, so the box need not reach further
+  bool bounded = is_bounded(max_radius);
+  if (bounded) {
+    box_min_x = fmax(box_min_x, x - max_radius);
+    box_max_x = fmin(box_max_x, x + max_radius);
+    box_min_y = fmax(box_min_y, y - max_radius);
+    box_max_y = fmin(box_max_y, y + max_radius);
+  }
+
   double box[4][2] = {{box_min_x, box_min_y},
                       {box_max_x, box_min_y},
                       {box_max_x, box_max_y},
                       {box_min_x, box_max_y}};
   for (int i = 0; i < 4; i++) {
-    Segment *s = malloc(sizeof(Segment));
+    Segment *s = &segments[segment_count++];
     s->p_initial = (Point2D){box[i][0], box[i][1]};
     s->p_final = (Point2D){box[(i + 1) % 4][0], box[(i + 1) % 4][1]};
     s->id = -(i + 1);
     s->helper = NULL;
-    segments[segment_count++] = s;
   }
 
-  int barrier_count = list_size(barriers);
-  for (int i = 0; i < barrier_count; i++) {
-    Shape shape = list_get(barriers, i);
-    if (!shape)
+  for (int i = 0; i < set->count; i++) {
+    const double *c = &set->coords[4 * i];
+    // Barriers entirely outside the radius cannot hide anything inside it
+    if (bounded &&
+        geometry_distance_point_segment(x, y, c[0], c[1], c[2], c[3]) >
+            max_radius)
       continue;
-    Line l = (Line)shape_get_shape(shape);
-    if (!l || !line_is_barrier(l))
-      continue;
-
-    Segment *s = malloc(sizeof(Segment));
-    s->p_initial = (Point2D){line_get_x1(l), line_get_y1(l)};
-    s->p_final = (Point2D){line_get_x2(l), line_get_y2(l)};
-    s->id = line_get_id(l);
+    Segment *s = &segments[segment_count++];
+    s->p_initial = (Point2D){c[0], c[1]};
+    s->p_final = (Point2D){c[2], c[3]};
+    s->id = set->ids[i];
     s->helper = NULL;
-    segments[segment_count++] = s;
   }
 
-  // Angle 0 splitting
+  // Angle 0 splitting (at most one extra piece per segment, so the segments
+  // allocated above are enough)
   int count_before_split = segment_count;
   for (int i = 0; i < count_before_split; i++) {
-    Segment *s = segments[i];
+    Segment *s = &segments[i];
     if ((s->p_initial.y > y && s->p_final.y < y) ||
         (s->p_initial.y < y && s->p_final.y > y)) {
       double t = (y - s->p_initial.y) / (s->p_final.y - s->p_initial.y);
       double ix = s->p_initial.x + t * (s->p_final.x - s->p_initial.x);
       if (ix > x) {
-        Segment *s_new = malloc(sizeof(Segment));
+        Segment *s_new = &segments[segment_count++];
         s_new->p_initial = (Point2D){ix, y};
         s_new->p_final = s->p_final;
         s_new->id = s->id;
         s_new->helper = NULL;
         s->p_final = (Point2D){ix, y};
-        if (segment_count >= segment_capacity) {
-          segment_capacity *= 2;
-          segments = realloc(segments, sizeof(Segment *) * segment_capacity);
-        }
-        segments[segment_count++] = s_new;
       }
     }
   }
 
-  Vertex *vertices = malloc(sizeof(Vertex) * segment_count * 2);
   int vertex_count = 0;
 
   for (int i = 0; i < segment_count; i++) {
-    Segment *s = segments[i];
+    Segment *s = &segments[i];
     double ang1 =
-        geometry_calculate_angle(s->p_initial.x, s->p_initial.y, x, y);
-    double ang2 = geometry_calculate_angle(s->p_final.x, s->p_final.y, x, y);
-    if (ang1 < 0)
-      ang1 += 2 * M_PI;
-    if (ang2 < 0)
-      ang2 += 2 * M_PI;
+        geometry_calculate_pseudo_angle(s->p_initial.x, s->p_initial.y, x, y);
+    double ang2 =
+        geometry_calculate_pseudo_angle(s->p_final.x, s->p_final.y, x, y);
 
     if (ang1 > ang2) {
       Point2D tmp = s->p_initial;
@@ -320,42 +833,77 @@ VisibilityPolygon visibility_calculate(double x, double y, List barriers,
     double d2 = sqrt((s->p_final.x - x) * (s->p_final.x - x) +
                      (s->p_final.y - y) * (s->p_final.y - y));
 
+    s->swept = ang2 - ang1 < 2 &&
+               geometry_distance_point_segment(x, y, s->p_initial.x,
+                                               s->p_initial.y, s->p_final.x,
+                                               s->p_final.y) > 1e-9;
     vertices[vertex_count++] = (Vertex){s->p_initial, EVENT_START, s, ang1, d1};
     vertices[vertex_count++] = (Vertex){s->p_final, EVENT_END, s, ang2, d2};
   }
 
-  sorting_sort(vertices, vertex_count, sizeof(Vertex), compare_vertices,
-               sort_type, sort_threshold);
-
-  SweepContext ctx = {source, 0};
-  BST active_segments = bst_create(compare_segments, &ctx);
+  // A NULL sort buffer only makes mergesort or radix sort allocate their own
+  void *sort_buffer = NULL;
+  if (sort_type == SORT_RADIX) {
+    sort_buffer = arena_alloc(
+        arena, SORTING_RADIX_BUFFER_SIZE(vertex_count, sizeof(Vertex)));
+    // The stable angle passes keep the first pass's order among equal
+    // angles, so only angles within the comparator's tolerance are left for
+    // the tie pass; the many events at angle 0 come out ordered
+    sorting_radixsort(vertices, vertex_count, sizeof(Vertex), vertex_tie_key,
+                      NULL, sort_buffer);
+    sorting_radixsort(vertices, vertex_count, sizeof(Vertex), vertex_key,
+                      compare_vertices, sort_buffer);
+  } else {
+    if (sort_type == SORT_MERGESORT)
+      sort_buffer = arena_alloc(
+          arena, SORTING_BUFFER_SIZE(vertex_count, sizeof(Vertex)));
+    sorting_sort_with_buffer(vertices, vertex_count, sizeof(Vertex),
+                             compare_vertices, sort_type, sort_threshold,
+                             sort_buffer);
+  }
+  arena_release(arena, sort_buffer);
+
+  SweepContext ctx = {source, 0, {1, 0}};
+  CrossingQueue crossings = {NULL, 0, 0, arena};
+  BST active_segments = bst_create_with_allocator(
+      compare_segments, &ctx, arena_alloc, arena_release, arena);
+  if (!active_segments) {
+    free(polygon);
+    return NULL;
+  }
 
   for (int i = 0; i < segment_count; i++) {
-    Segment *s = segments[i];
-    double dist = calc_ray_segment_distance(s, source, 1e-9);
-    if (dist < 1e17 && dist > 0) {
+    Segment *s = &segments[i];
+    // Just past angle 0: cos(1e-9) rounds to 1 and sin(1e-9) to 1e-9
+    double dist = calc_ray_segment_distance(s, source, (Point2D){1, 1e-9});
+    if (s->swept && dist < 1e17 && dist > 0) {
       s->helper = bst_insert(active_segments, s);
     }
   }
+  for (BSTNode node = bst_find_min_node(active_segments); node;
+       node = bst_node_next(node))
+    watch_crossing(&crossings, &ctx, node, bst_node_next(node));
 
   Segment *biombo = (Segment *)bst_find_min(active_segments);
   Point2D biombo_start = {0, 0};
 
   if (biombo) {
-    double dist = calc_ray_segment_distance(biombo, source, 0);
+    double dist = calc_ray_segment_distance(biombo, source, ctx.direction);
     biombo_start = (Point2D){source.x + dist, source.y};
     add_vertex(polygon, biombo_start.x, biombo_start.y);
   }
 
   for (int i = 0; i < vertex_count; i++) {
     Vertex *v = &vertices[i];
+    pass_crossings(&crossings, &ctx, v->angle);
     ctx.current_angle = v->angle;
+    ctx.direction = ray_direction(v->point, source, v->distance);
 
     if (v->type == EVENT_START) {
       Segment *s = v->segment;
 
       bool in_front =
-          is_in_front(v->point, v->distance, biombo, source, v->angle);
+          is_in_front(v->distance, biombo, source, ctx.direction);
 
       if (in_front) {
         // When a new segment starts in front, the OLD biombo is BEHIND it.
@@ -364,7 +912,7 @@ VisibilityPolygon visibility_calculate(double x, double y, List barriers,
         // through the new vertex to hit the old biombo behind it).
         if (biombo) {
           double biombo_dist =
-              calc_ray_segment_distance(biombo, source, v->angle);
+              calc_ray_segment_distance(biombo, source, ctx.direction);
           // Add intersection if biombo is valid at current angle
           // The old biombo will be FURTHER (behind), so don't check distance
           if (biombo_dist < 1e17 && biombo_dist > 1e-9) {
@@ -376,8 +924,8 @@ VisibilityPolygon visibility_calculate(double x, double y, List barriers,
         biombo = s;
         biombo_start = v->point;
       }
-      if (s->helper == NULL) {
-        s->helper = bst_insert(active_segments, s);
+      if (s->helper == NULL && s->swept) {
+        insert_active(active_segments, &ctx, &crossings, s);
       }
 
     } else {
@@ -387,17 +935,18 @@ VisibilityPolygon visibility_calculate(double x, double y, List barriers,
         add_vertex(polygon, v->point.x, v->point.y);
 
         if (s->helper) {
-          bst_remove_node(active_segments, s->helper);
-          s->helper = NULL;
+          remove_active(active_segments, &ctx, &crossings, s);
         }
 
-        // Use find_closest_at_angle to find the actual closest segment at
-        // current angle
-        Segment *next =
-            find_closest_at_angle(active_segments, source, v->angle);
+        // The next biombo is the closest remaining segment at this angle
+        Segment *next = find_closest_at_angle(active_segments, &ctx);
+#ifdef VISIBILITY_CHECK_SWEEP
+        check_closest(active_segments, &ctx, next);
+#endif
 
         if (next) {
-          double next_dist = calc_ray_segment_distance(next, source, v->angle);
+          double next_dist =
+              calc_ray_segment_distance(next, source, ctx.direction);
           // For bounding box segments (id < 0), always add intersection to
           // close polygon For barrier-to-barrier, only add if next is closer
           if (next->id < 0 || next_dist < v->distance - 1e-9) {
@@ -410,8 +959,7 @@ VisibilityPolygon visibility_calculate(double x, double y, List barriers,
 
       } else {
         if (s->helper) {
-          bst_remove_node(active_segments, s->helper);
-          s->helper = NULL;
+          remove_active(active_segments, &ctx, &crossings, s);
         }
       }
     }
@@ -420,26 +968,21 @@ VisibilityPolygon visibility_calculate(double x, double y, List barriers,
   // Close the polygon: connect last point back to first point through bounding
   // box
   if (polygon->vertex_count >= 2) {
-    Point first_pt = polygon->vertices[0];
-    Point last_pt = polygon->vertices[polygon->vertex_count - 1];
-    double first_x = geometry_point_get_x(first_pt);
-    double first_y = geometry_point_get_y(first_pt);
-    double last_x = geometry_point_get_x(last_pt);
-    double last_y = geometry_point_get_y(last_pt);
+    double first_x = polygon->xy[0];
+    double first_y = polygon->xy[1];
+    double last_x = polygon->xy[2 * (polygon->vertex_count - 1)];
+    double last_y = polygon->xy[2 * (polygon->vertex_count - 1) + 1];
 
     // If last and first are not the same, we need to close through the bounding
     // box
     if (fabs(first_x - last_x) > 1e-6 || fabs(first_y - last_y) > 1e-6) {
       // Calculate angles for first and last points
-      double first_angle = geometry_calculate_angle(first_x, first_y, x, y);
-      double last_angle = geometry_calculate_angle(last_x, last_y, x, y);
-      if (first_angle < 0)
-        first_angle += 2 * M_PI;
-      if (last_angle < 0)
-        last_angle += 2 * M_PI;
+      double first_angle =
+          geometry_calculate_pseudo_angle(first_x, first_y, x, y);
+      double last_angle = geometry_calculate_pseudo_angle(last_x, last_y, x, y);
 
       // Find bounding box corners between last_angle and first_angle (going
-      // through 2π→0) Bounding box corners and their angles
+      // through 4→0) Bounding box corners and their angles
       double corners[4][2] = {
           {box_max_x, box_min_y}, // bottom-right
           {box_max_x, box_max_y}, // top-right
@@ -448,14 +991,12 @@ VisibilityPolygon visibility_calculate(double x, double y, List barriers,
       };
       double corner_angles[4];
       for (int c = 0; c < 4; c++) {
-        corner_angles[c] =
-            geometry_calculate_angle(corners[c][0], corners[c][1], x, y);
-        if (corner_angles[c] < 0)
-          corner_angles[c] += 2 * M_PI;
+        corner_angles[c] = geometry_calculate_pseudo_angle(
+            corners[c][0], corners[c][1], x, y);
       }
 
       // Add corners that are between last_angle and first_angle (wrapping
-      // through 2π)
+      // through 4)
       for (int c = 0; c < 4; c++) {
         double ca = corner_angles[c];
         bool in_gap = false;
@@ -463,7 +1004,7 @@ VisibilityPolygon visibility_calculate(double x, double y, List barriers,
         // Check if corner angle is in the gap between last_angle and
         // first_angle
         if (last_angle > first_angle) {
-          // Gap wraps around 2π: corner is in gap if ca > last_angle OR ca <
+          // Gap wraps around 4: corner is in gap if ca > last_angle OR ca <
           // first_angle
           in_gap = (ca > last_angle + 1e-6) || (ca < first_angle - 1e-6);
         }
@@ -475,31 +1016,161 @@ VisibilityPolygon visibility_calculate(double x, double y, List barriers,
     }
   }
 
-  bst_destroy(active_segments, NULL);
-  free(vertices);
-  for (int i = 0; i < segment_count; i++)
-    free(segments[i]);
-  free(segments);
+  if (bounded)
+    clip_to_radius(polygon, source, max_radius, arena);
+
+  // The tree and its nodes are dropped with the arena's next reset
+  build_slabs(polygon, arena);
 
   return (VisibilityPolygon)polygon;
 }
 
+BarrierSet visibility_barrier_set_create(Sequence barriers) {
+  if (!barriers)
+    return NULL;
+
+  struct BarrierSet *set = malloc(sizeof(struct BarrierSet));
+  if (!set)
+    return NULL;
+
+  int capacity = sequence_size(barriers);
+  set->coords = malloc(sizeof(double) * 4 * (capacity > 0 ? capacity : 1));
+  set->ids = malloc(sizeof(int) * (capacity > 0 ? capacity : 1));
+  set->count = 0;
+  if (!set->coords || !set->ids) {
+    visibility_barrier_set_destroy((BarrierSet)set);
+    return NULL;
+  }
+
+  for (int i = 0; i < capacity; i++) {
+    Shape shape = sequence_get(barriers, i);
+    if (!shape)
+      continue;
+    Line l = (Line)shape_get_shape(shape);
+    if (!l || !line_is_barrier(l))
+      continue;
+
+    double *c = &set->coords[4 * set->count];
+    c[0] = line_get_x1(l);
+    c[1] = line_get_y1(l);
+    c[2] = line_get_x2(l);
+    c[3] = line_get_y2(l);
+    set->ids[set->count++] = line_get_id(l);
+  }
+
+  return (BarrierSet)set;
+}
+
+void visibility_barrier_set_destroy(BarrierSet set) {
+  if (!set)
+    return;
+  struct BarrierSet *impl = (struct BarrierSet *)set;
+  free(impl->coords);
+  free(impl->ids);
+  free(impl);
+}
+
+int visibility_barrier_set_size(BarrierSet set) {
+  if (!set)
+    return 0;
+  return ((struct BarrierSet *)set)->count;
+}
+
+VisibilityWorkspace visibility_workspace_create(void) {
+  return (VisibilityWorkspace)arena_create(WORKSPACE_BLOCK_SIZE);
+}
+
+void visibility_workspace_destroy(VisibilityWorkspace workspace) {
+  arena_destroy((Arena)workspace);
+}
+
+VisibilityPolygon visibility_calculate_with_set(
+    double x, double y, BarrierSet set, VisibilityWorkspace workspace,
+    double max_radius, SortType sort_type, int sort_threshold, double min_x,
+    double min_y, double max_x, double max_y) {
+  if (!set)
+    return NULL;
+
+  Arena arena =
+      workspace ? (Arena)workspace : arena_create(WORKSPACE_BLOCK_SIZE);
+  if (!arena)
+    return NULL;
+
+  VisibilityPolygon polygon =
+      sweep_polygon(arena, set, x, y, max_radius, sort_type, sort_threshold,
+                    min_x, min_y, max_x, max_y);
+  if (!workspace)
+    arena_destroy(arena);
+  return polygon;
+}
+
+int visibility_calculate_batch(const double *xs, const double *ys, int count,
+                               BarrierSet set, VisibilityWorkspace workspace,
+                               const double *radii, SortType sort_type,
+                               int sort_threshold, double min_x, double min_y,
+                               double max_x, double max_y,
+                               VisibilityPolygon *polygons) {
+  if (!xs || !ys || !set || !polygons || count <= 0)
+    return 0;
+
+  // The arena grows to fit the first sweep and is reused for every source
+  Arena arena =
+      workspace ? (Arena)workspace : arena_create(WORKSPACE_BLOCK_SIZE);
+  if (!arena)
+    return 0;
+
+  int computed = 0;
+  for (int i = 0; i < count; i++) {
+    double radius = radii ? radii[i] : VISIBILITY_UNBOUNDED;
+    polygons[i] =
+        sweep_polygon(arena, set, xs[i], ys[i], radius, sort_type,
+                      sort_threshold, min_x, min_y, max_x, max_y);
+    if (polygons[i])
+      computed++;
+  }
+  if (!workspace)
+    arena_destroy(arena);
+  return computed;
+}
+
+VisibilityPolygon visibility_calculate(double x, double y, Sequence barriers,
+                                       double max_radius, SortType sort_type,
+                                       int sort_threshold, double min_x,
+                                       double min_y, double max_x,
+                                       double max_y) {
+  BarrierSet set = visibility_barrier_set_create(barriers);
+  if (!set)
+    return NULL;
+
+  VisibilityPolygon polygon = visibility_calculate_with_set(
+      x, y, set, NULL, max_radius, sort_type, sort_threshold, min_x, min_y,
+      max_x, max_y);
+  visibility_barrier_set_destroy(set);
+  return polygon;
+}
+
+VisibilityPolygon visibility_polygon_retain(VisibilityPolygon polygon) {
+  if (polygon)
+    ((struct VisibilityPolygon *)polygon)->references++;
+  return polygon;
+}
+
 void visibility_polygon_destroy(VisibilityPolygon polygon) {
   if (!polygon)
     return;
   struct VisibilityPolygon *poly = (struct VisibilityPolygon *)polygon;
-  if (poly->vertices) {
-    for (int i = 0; i < poly->vertex_count; i++)
-      geometry_point_destroy(poly->vertices[i]);
-    free(poly->vertices);
-  }
+  if (--poly->references > 0)
+    return;
+  free(poly->xy);
+  free(poly->band_start);
+  free(poly->band_edges);
   free(poly);
 }
 
-Point *visibility_polygon_get_vertices(VisibilityPolygon polygon) {
+const double *visibility_polygon_get_coords(VisibilityPolygon polygon) {
   if (!polygon)
     return NULL;
-  return ((struct VisibilityPolygon *)polygon)->vertices;
+  return ((struct VisibilityPolygon *)polygon)->xy;
 }
 
 int visibility_polygon_get_vertex_count(VisibilityPolygon polygon) {
@@ -513,5 +1184,98 @@ bool visibility_polygon_contains_point(VisibilityPolygon polygon, double x,
   if (!polygon)
     return false;
   struct VisibilityPolygon *poly = (struct VisibilityPolygon *)polygon;
-  return geometry_point_in_polygon(x, y, poly->vertices, poly->vertex_count);
-}
\ No newline at end of file
+  if (poly->band_count == 0)
+    return geometry_point_in_polygon(x, y, poly->xy, poly->vertex_count);
+  if (poly->vertex_count < 3)
+    return false;
+
+  // A horizontal ray only crosses edges whose y range holds y, so points
+  // above, below or to the right of the bounding box are outside
+  if (y < poly->min_y || y >= poly->max_y ||
+      x > poly->max_x + CONTAINMENT_SLACK)
+    return false;
+
+  // Same ray casting as geometry_point_in_polygon(), restricted to the slab
+  // of y, which lists every edge that can cross the ray
+  int band = band_of(poly, y);
+  int first = poly->band_start[band];
+  int crossings =
+      geometry_count_crossings(x, y, poly->xy, poly->vertex_count,
+                               &poly->band_edges[first],
+                               poly->band_start[band + 1] - first);
+  return (crossings % 2) == 1;
+}
+
+bool visibility_polygon_get_bounds(VisibilityPolygon polygon, double *min_x,
+                                   double *min_y, double *max_x,
+                                   double *max_y) {
+  if (!polygon)
+    return false;
+  struct VisibilityPolygon *poly = (struct VisibilityPolygon *)polygon;
+  if (poly->vertex_count == 0)
+    return false;
+
+  *min_x = poly->min_x;
+  *min_y = poly->min_y;
+  *max_x = poly->max_x;
+  *max_y = poly->max_y;
+  return true;
+}
+
+VisibilityEdgeCursor visibility_polygon_edges_in_range(VisibilityPolygon polygon,
+                                                       double min_y,
+                                                       double max_y) {
+  VisibilityEdgeCursor cursor = {polygon, 0, 0, -1, 0, false};
+  struct VisibilityPolygon *poly = (struct VisibilityPolygon *)polygon;
+  if (!poly || poly->vertex_count == 0)
+    return cursor;
+
+  if (poly->band_count == 0) {
+    cursor.scan_all = true;
+    return cursor;
+  }
+
+  if (max_y < poly->min_y || min_y > poly->max_y || min_y > max_y)
+    return cursor;
+
+  cursor.first_band = band_of(poly, min_y);
+  cursor.last_band = band_of(poly, max_y);
+  cursor.band = cursor.first_band;
+  cursor.position = poly->band_start[cursor.band];
+  return cursor;
+}
+
+bool visibility_edge_cursor_next(VisibilityEdgeCursor *cursor, int *edge) {
+  if (!cursor || !cursor->polygon)
+    return false;
+  struct VisibilityPolygon *poly = (struct VisibilityPolygon *)cursor->polygon;
+
+  if (cursor->scan_all) {
+    if (cursor->position >= poly->vertex_count)
+      return false;
+    *edge = cursor->position++;
+    return true;
+  }
+
+  while (cursor->band <= cursor->last_band) {
+    while (cursor->position < poly->band_start[cursor->band + 1]) {
+      int i = poly->band_edges[cursor->position++];
+
+      // An edge spanning several slabs is only reported from the first slab
+      // it shares with the range
+      double low, high;
+      edge_y_range(poly, i, &low, &high);
+      int first = band_of(poly, low);
+      if (first < cursor->first_band)
+        first = cursor->first_band;
+      if (first == cursor->band) {
+        *edge = i;
+        return true;
+      }
+    }
+    cursor->band++;
+    if (cursor->band <= cursor->last_band)
+      cursor->position = poly->band_start[cursor->band];
+  }
+  return false;
+}
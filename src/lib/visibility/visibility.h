@@ -11,16 +11,96 @@
 #ifndef VISIBILITY_H
 #define VISIBILITY_H
 
-#include "../commons/list/list.h"
+#include "../commons/sequence/sequence.h"
 #include "../commons/sorting/sorting.h"
 #include "geometry.h"
+#include <math.h>
 #include <stdbool.h>
 
+/**
+ * @brief Radius for visibility that is only bounded by the scene box
+ */
+#define VISIBILITY_UNBOUNDED INFINITY
+
+/**
+ * @brief Number of segments a full circle is approximated with when a
+ * polygon is clipped to its radius
+ */
+#define VISIBILITY_ARC_SEGMENTS 64
+
 /**
  * @brief Opaque pointer type for VisibilityPolygon instances
  */
 typedef void *VisibilityPolygon;
 
+/**
+ * @brief Cursor over the edges of a visibility polygon near a y range
+ *
+ * Obtained from visibility_polygon_edges_in_range() and advanced with
+ * visibility_edge_cursor_next(). Fields are private to the visibility module.
+ */
+typedef struct {
+  VisibilityPolygon polygon; /**< Polygon being traversed */
+  int band;                  /**< Current slab */
+  int first_band;            /**< First slab of the range */
+  int last_band;             /**< Last slab of the range */
+  int position;              /**< Next slab entry (or edge when scanning all) */
+  bool scan_all;             /**< Polygon has no slabs: visit every edge */
+} VisibilityEdgeCursor;
+
+/**
+ * @brief Opaque pointer type for prepared barrier sets
+ *
+ * A barrier set holds the endpoints of every barrier line, extracted once so
+ * that many visibility calculations can share them. It is a snapshot: later
+ * changes to the barrier lines are not reflected.
+ */
+typedef void *BarrierSet;
+
+/**
+ * @brief Opaque pointer type for sweep workspaces
+ *
+ * A workspace holds the scratch memory of the angular sweep (segments, events,
+ * the active segment tree) in an arena that is reset, not freed, between
+ * sweeps. Once it has grown to fit the largest sweep, further sweeps allocate
+ * only the polygons they return. A workspace must not be used by two threads
+ * at once.
+ */
+typedef void *VisibilityWorkspace;
+
+/**
+ * @brief Creates an empty sweep workspace
+ * @return VisibilityWorkspace instance or NULL on error
+ */
+VisibilityWorkspace visibility_workspace_create(void);
+
+/**
+ * @brief Destroys a sweep workspace
+ * @param workspace VisibilityWorkspace instance to destroy
+ */
+void visibility_workspace_destroy(VisibilityWorkspace workspace);
+
+/**
+ * @brief Prepares a barrier set from a sequence of barrier lines
+ * @param barriers Sequence of Line shapes (lines not marked as barriers are
+ * skipped)
+ * @return BarrierSet instance or NULL on error
+ */
+BarrierSet visibility_barrier_set_create(Sequence barriers);
+
+/**
+ * @brief Destroys a barrier set
+ * @param set BarrierSet instance to destroy
+ */
+void visibility_barrier_set_destroy(BarrierSet set);
+
+/**
+ * @brief Gets the number of barriers in a set
+ * @param set BarrierSet instance
+ * @return Number of barrier segments
+ */
+int visibility_barrier_set_size(BarrierSet set);
+
 /**
  * @brief Calculates the visibility polygon from a point source
  *
@@ -28,32 +108,107 @@ typedef void *VisibilityPolygon;
  * from the source point (x, y), taking into account barrier segments that
  * block visibility.
  *
+ * With a positive, finite max_radius the region is also clipped to the circle
+ * of that radius around the source (as a polyline of
+ * VISIBILITY_ARC_SEGMENTS segments per turn), and barriers entirely outside
+ * the circle are dropped before the sweep, so its cost follows the number of
+ * barriers nearby.
+ *
  * @param x Source point X coordinate
  * @param y Source point Y coordinate
- * @param barriers List of Line instances marked as barriers (is_barrier = true)
- * @param max_radius Maximum visibility radius (use large value for unbounded)
- * @param sort_type Sorting algorithm to use (SORT_QSORT or SORT_MERGESORT)
+ * @param barriers Sequence of Line instances marked as barriers
+ * (is_barrier = true)
+ * @param max_radius Maximum visibility radius (VISIBILITY_UNBOUNDED, or any
+ * value that is not positive, for none)
+ * @param sort_type Sorting algorithm to use (SORT_QSORT, SORT_MERGESORT or
+ * SORT_RADIX)
  * @param sort_threshold Threshold for InsertionSort (only for SORT_MERGESORT)
  * @return Pointer to VisibilityPolygon or NULL on error
  */
-VisibilityPolygon visibility_calculate(double x, double y, List barriers,
+VisibilityPolygon visibility_calculate(double x, double y, Sequence barriers,
                                        double max_radius, SortType sort_type,
                                        int sort_threshold, double min_x,
                                        double min_y, double max_x,
                                        double max_y);
 
 /**
- * @brief Destroys a visibility polygon and frees all memory
+ * @brief Calculates the visibility polygon from a point source against a
+ * prepared barrier set
+ *
+ * Same as visibility_calculate, without re-reading the barrier lines.
+ *
+ * @param x Source point X coordinate
+ * @param y Source point Y coordinate
+ * @param set Prepared barrier set
+ * @param workspace Scratch memory for the sweep, or NULL to use a temporary
+ * one
+ * @param max_radius Maximum visibility radius (VISIBILITY_UNBOUNDED, or any
+ * value that is not positive, for none)
+ * @param sort_type Sorting algorithm to use (SORT_QSORT, SORT_MERGESORT or
+ * SORT_RADIX)
+ * @param sort_threshold Threshold for InsertionSort (only for SORT_MERGESORT)
+ * @return Pointer to VisibilityPolygon or NULL on error
+ */
+VisibilityPolygon visibility_calculate_with_set(
+    double x, double y, BarrierSet set, VisibilityWorkspace workspace,
+    double max_radius, SortType sort_type, int sort_threshold, double min_x,
+    double min_y, double max_x, double max_y);
+
+/**
+ * @brief Calculates the visibility polygons of several sources sharing one
+ * barrier set
+ *
+ * Every sweep of the batch reuses the same scratch memory.
+ *
+ * @param xs Source X coordinates
+ * @param ys Source Y coordinates
+ * @param count Number of sources
+ * @param set Prepared barrier set
+ * @param workspace Scratch memory for the sweeps, or NULL to use a temporary
+ * one
+ * @param radii Maximum visibility radius of each source (see
+ * visibility_calculate()), or NULL for none
+ * @param sort_type Sorting algorithm to use (SORT_QSORT, SORT_MERGESORT or
+ * SORT_RADIX)
+ * @param sort_threshold Threshold for InsertionSort (only for SORT_MERGESORT)
+ * @param polygons Output array of count polygons (NULL entries on error)
+ * @return Number of polygons successfully calculated
+ */
+int visibility_calculate_batch(const double *xs, const double *ys, int count,
+                               BarrierSet set, VisibilityWorkspace workspace,
+                               const double *radii, SortType sort_type,
+                               int sort_threshold, double min_x, double min_y,
+                               double max_x, double max_y,
+                               VisibilityPolygon *polygons);
+
+/**
+ * @brief Adds an owner to a visibility polygon
+ *
+ * Polygons never change once computed, so several owners may share one. Each
+ * owner gives its reference back with visibility_polygon_destroy(). Owners
+ * must all live on the same thread.
+ * @param polygon VisibilityPolygon instance (NULL is ignored)
+ * @return The same polygon
+ */
+VisibilityPolygon visibility_polygon_retain(VisibilityPolygon polygon);
+
+/**
+ * @brief Gives back one reference to a visibility polygon, freeing all its
+ * memory when it was the last one
  * @param polygon VisibilityPolygon instance to destroy
  */
 void visibility_polygon_destroy(VisibilityPolygon polygon);
 
 /**
- * @brief Gets the array of vertices forming the visibility polygon
+ * @brief Gets the vertex coordinates of the visibility polygon
+ *
+ * Coordinates are interleaved in one contiguous buffer: vertex i is at
+ * (coords[2 * i], coords[2 * i + 1]). The buffer is owned by the polygon.
  * @param polygon VisibilityPolygon instance
- * @return Array of Point instances (do not free individually)
+ * @return Array of 2 * vertex_count doubles, or NULL if the polygon is NULL or
+ * empty
  */
-Point *visibility_polygon_get_vertices(VisibilityPolygon polygon);
+const double *visibility_polygon_get_coords(VisibilityPolygon polygon);
 
 /**
  * @brief Gets the number of vertices in the visibility polygon
@@ -72,4 +227,51 @@ int visibility_polygon_get_vertex_count(VisibilityPolygon polygon);
 bool visibility_polygon_contains_point(VisibilityPolygon polygon, double x,
                                        double y);
 
+/**
+ * @brief Gets the axis-aligned bounding box of the visibility polygon
+ * @param polygon VisibilityPolygon instance
+ * @param min_x Pointer to store minimum X coordinate
+ * @param min_y Pointer to store minimum Y coordinate
+ * @param max_x Pointer to store maximum X coordinate
+ * @param max_y Pointer to store maximum Y coordinate
+ * @return true if the polygon has vertices, false otherwise
+ */
+bool visibility_polygon_get_bounds(VisibilityPolygon polygon, double *min_x,
+                                   double *min_y, double *max_x,
+                                   double *max_y);
+
+/**
+ * @brief Starts a visit of the edges whose y range may overlap [min_y, max_y]
+ *
+ * Edge i runs from vertex i to vertex i + 1 (the last edge closes the polygon
+ * back to vertex 0). Every edge overlapping the range is visited exactly once;
+ * a few edges outside it may be visited too, so callers still run their exact
+ * tests on each edge. Edges are looked up in horizontal slabs built with the
+ * polygon, so narrow ranges only touch the edges nearby.
+ * @param polygon VisibilityPolygon instance
+ * @param min_y Lower end of the range
+ * @param max_y Upper end of the range
+ * @return Cursor over the edges
+ */
+VisibilityEdgeCursor visibility_polygon_edges_in_range(VisibilityPolygon polygon,
+                                                       double min_y,
+                                                       double max_y);
+
+/**
+ * @brief Advances an edge cursor
+ * @param cursor Cursor to advance
+ * @param edge Pointer to store the index of the next edge
+ * @return true if an edge was read, false at the end of the range
+ */
+bool visibility_edge_cursor_next(VisibilityEdgeCursor *cursor, int *edge);
+
+#ifdef VISIBILITY_CHECK_SWEEP
+/**
+ * @brief Times the sweep picked a next biombo at a different distance than a
+ * full scan of the active segments would (only in builds defining
+ * VISIBILITY_CHECK_SWEEP, such as the module tests)
+ */
+extern long visibility_sweep_mismatches;
+#endif
+
 #endif // VISIBILITY_H
@@ -1,5 +1,5 @@
 #include "visibility.h"
-#include "../commons/list/list.h"
+#include "../commons/sequence/sequence.h"
 #include "../shapes/line/line.h"
 #include "../shapes/shapes.h"
 #include "../test_framework/test_framework.h"
@@ -7,6 +7,7 @@
 #include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -14,6 +15,12 @@
 
 #define EPSILON 0.0001
 
+// Scene bounds passed to visibility_calculate in these tests
+#define MIN_X -100.0
+#define MIN_Y -100.0
+#define MAX_X 100.0
+#define MAX_Y 100.0
+
 // Helper function to compare doubles
 static bool doubles_equal(double a, double b) { return fabs(a - b) < EPSILON; }
 
@@ -46,6 +53,27 @@ bool test_geometry_calculate_angle(void) {
   return true;
 }
 
+bool test_geometry_calculate_pseudo_angle(void) {
+  // One unit per quadrant along the axes, from 5 units away
+  ASSERT_EQUAL(geometry_calculate_pseudo_angle(7.0, 2.0, 2.0, 2.0), 0.0);
+  ASSERT_EQUAL(geometry_calculate_pseudo_angle(2.0, 7.0, 2.0, 2.0), 1.0);
+  ASSERT_EQUAL(geometry_calculate_pseudo_angle(-3.0, 2.0, 2.0, 2.0), 2.0);
+  ASSERT_EQUAL(geometry_calculate_pseudo_angle(2.0, -3.0, 2.0, 2.0), 3.0);
+  ASSERT_EQUAL(geometry_calculate_pseudo_angle(2.0, 2.0, 2.0, 2.0), 0.0);
+
+  // Directions around the circle come out in polar angle order
+  double previous = -1.0;
+  for (int i = 0; i < 360; i++) {
+    double theta = (i + 0.5) * M_PI / 180.0;
+    double pseudo = geometry_calculate_pseudo_angle(cos(theta), sin(theta),
+                                                    0.0, 0.0);
+    ASSERT_TRUE(pseudo > previous);
+    ASSERT_TRUE(pseudo < 4.0);
+    previous = pseudo;
+  }
+  return true;
+}
+
 bool test_geometry_distance(void) {
   double dist = geometry_distance(0.0, 0.0, 3.0, 4.0);
   ASSERT_TRUE(doubles_equal(5.0, dist));
@@ -90,23 +118,19 @@ bool test_geometry_segment_intersects_ray(void) {
 
 bool test_geometry_point_in_polygon(void) {
   // Create a square polygon: (0,0), (10,0), (10,10), (0,10)
-  Point vertices[4];
-  vertices[0] = geometry_point_create(0.0, 0.0);
-  vertices[1] = geometry_point_create(10.0, 0.0);
-  vertices[2] = geometry_point_create(10.0, 10.0);
-  vertices[3] = geometry_point_create(0.0, 10.0);
+  double xy[8] = {0.0, 0.0, 10.0, 0.0, 10.0, 10.0, 0.0, 10.0};
 
   // Point inside
-  bool inside = geometry_point_in_polygon(5.0, 5.0, vertices, 4);
+  bool inside = geometry_point_in_polygon(5.0, 5.0, xy, 4);
   ASSERT_TRUE(inside);
 
   // Point outside
-  inside = geometry_point_in_polygon(15.0, 5.0, vertices, 4);
+  inside = geometry_point_in_polygon(15.0, 5.0, xy, 4);
   ASSERT_FALSE(inside);
 
-  for (int i = 0; i < 4; i++) {
-    geometry_point_destroy(vertices[i]);
-  }
+  // Degenerate polygons contain nothing
+  ASSERT_FALSE(geometry_point_in_polygon(5.0, 5.0, xy, 2));
+  ASSERT_FALSE(geometry_point_in_polygon(5.0, 5.0, NULL, 4));
 
   return true;
 }
@@ -132,11 +156,13 @@ bool test_geometry_cross_product(void) {
 // ============================================================================
 
 bool test_visibility_no_barriers(void) {
-  List barriers = list_create();
+  Sequence barriers = sequence_create();
   ASSERT_NOT_NULL(barriers);
 
   // Calculate visibility from (0,0) with no barriers
-  VisibilityPolygon polygon = visibility_calculate(0.0, 0.0, barriers, 100.0);
+  VisibilityPolygon polygon =
+      visibility_calculate(0.0, 0.0, barriers, 100.0, SORT_QSORT, 10,
+                           MIN_X, MIN_Y, MAX_X, MAX_Y);
   ASSERT_NOT_NULL(polygon);
 
   int vertex_count = visibility_polygon_get_vertex_count(polygon);
@@ -144,14 +170,27 @@ bool test_visibility_no_barriers(void) {
 
   // With no barriers, should create a circular region
   ASSERT_TRUE(vertex_count >= 32);
+  ASSERT_TRUE(visibility_polygon_contains_point(polygon, 60.0, 60.0));
+  ASSERT_TRUE(visibility_polygon_contains_point(polygon, 0.0, -99.0));
+  ASSERT_FALSE(visibility_polygon_contains_point(polygon, 90.0, 90.0));
+  visibility_polygon_destroy(polygon);
+
+  // Unbounded, the region is the whole scene box
+  polygon = visibility_calculate(0.0, 0.0, barriers, VISIBILITY_UNBOUNDED,
+                                 SORT_QSORT, 10, MIN_X, MIN_Y, MAX_X, MAX_Y);
+  ASSERT_NOT_NULL(polygon);
+  vertex_count = visibility_polygon_get_vertex_count(polygon);
+  ASSERT_TRUE(vertex_count >= 4);
+  ASSERT_TRUE(visibility_polygon_contains_point(polygon, 90.0, 90.0));
+  ASSERT_TRUE(visibility_polygon_contains_point(polygon, -90.0, -90.0));
 
   visibility_polygon_destroy(polygon);
-  list_destroy(barriers);
+  sequence_destroy(barriers);
   return true;
 }
 
 bool test_visibility_single_barrier(void) {
-  List barriers = list_create();
+  Sequence barriers = sequence_create();
   ASSERT_NOT_NULL(barriers);
 
   // Create a vertical barrier from (5,0) to (5,10)
@@ -161,10 +200,12 @@ bool test_visibility_single_barrier(void) {
   Line segment = (Line)shape_get_shape(line_shape);
   line_set_barrier(segment, true);
 
-  list_insert_back(barriers, line_shape);
+  sequence_append(barriers, line_shape);
 
   // Calculate visibility from (0,5) with one barrier
-  VisibilityPolygon polygon = visibility_calculate(0.0, 5.0, barriers, 100.0);
+  VisibilityPolygon polygon =
+      visibility_calculate(0.0, 5.0, barriers, 100.0, SORT_QSORT, 10,
+                           MIN_X, MIN_Y, MAX_X, MAX_Y);
   ASSERT_NOT_NULL(polygon);
 
   int vertex_count = visibility_polygon_get_vertex_count(polygon);
@@ -172,12 +213,12 @@ bool test_visibility_single_barrier(void) {
 
   visibility_polygon_destroy(polygon);
   shape_destroy(line_shape);
-  list_destroy(barriers);
+  sequence_destroy(barriers);
   return true;
 }
 
 bool test_visibility_multiple_barriers(void) {
-  List barriers = list_create();
+  Sequence barriers = sequence_create();
   ASSERT_NOT_NULL(barriers);
 
   // Create a box of barriers around (50,50)
@@ -191,13 +232,15 @@ bool test_visibility_multiple_barriers(void) {
   line_set_barrier((Line)shape_get_shape(line3), true);
   line_set_barrier((Line)shape_get_shape(line4), true);
 
-  list_insert_back(barriers, line1);
-  list_insert_back(barriers, line2);
-  list_insert_back(barriers, line3);
-  list_insert_back(barriers, line4);
+  sequence_append(barriers, line1);
+  sequence_append(barriers, line2);
+  sequence_append(barriers, line3);
+  sequence_append(barriers, line4);
 
   // Calculate visibility from (0,0) - outside the box
-  VisibilityPolygon polygon = visibility_calculate(0.0, 0.0, barriers, 100.0);
+  VisibilityPolygon polygon =
+      visibility_calculate(0.0, 0.0, barriers, 100.0, SORT_QSORT, 10,
+                           MIN_X, MIN_Y, MAX_X, MAX_Y);
   ASSERT_NOT_NULL(polygon);
 
   int vertex_count = visibility_polygon_get_vertex_count(polygon);
@@ -212,32 +255,447 @@ bool test_visibility_multiple_barriers(void) {
   shape_destroy(line2);
   shape_destroy(line3);
   shape_destroy(line4);
-  list_destroy(barriers);
+  sequence_destroy(barriers);
+  return true;
+}
+
+bool test_visibility_crossing_barriers(void) {
+  Sequence barriers = sequence_create();
+  ASSERT_NOT_NULL(barriers);
+
+  // Two barriers crossing in an X in front of the source at (0,0)
+  Shape line1 = line_create(1, 20.0, -20.0, 30.0, 20.0, "black");
+  Shape line2 = line_create(2, 30.0, -20.0, 20.0, 20.0, "black");
+  line_set_barrier((Line)shape_get_shape(line1), true);
+  line_set_barrier((Line)shape_get_shape(line2), true);
+  sequence_append(barriers, line1);
+  sequence_append(barriers, line2);
+
+  VisibilityPolygon polygon =
+      visibility_calculate(0.0, 0.0, barriers, 100.0, SORT_QSORT, 10, MIN_X,
+                           MIN_Y, MAX_X, MAX_Y);
+  ASSERT_NOT_NULL(polygon);
+
+  // In front of both barriers is visible, behind the X is shadowed on both
+  // sides of the crossing point
+  ASSERT_TRUE(visibility_polygon_contains_point(polygon, 10.0, 0.0));
+  ASSERT_FALSE(visibility_polygon_contains_point(polygon, 60.0, 0.0));
+  ASSERT_FALSE(visibility_polygon_contains_point(polygon, 60.0, 20.0));
+  ASSERT_FALSE(visibility_polygon_contains_point(polygon, 60.0, -20.0));
+  // Outside the angular span of the barriers is visible
+  ASSERT_TRUE(visibility_polygon_contains_point(polygon, 0.0, 60.0));
+  // Next to the crossing point at (25, 0): in front of both barriers is
+  // visible, just behind it is shadowed
+  ASSERT_TRUE(visibility_polygon_contains_point(polygon, 22.5, 5.0));
+  ASSERT_TRUE(visibility_polygon_contains_point(polygon, 22.5, -5.0));
+  ASSERT_FALSE(visibility_polygon_contains_point(polygon, 26.0, 0.0));
+  ASSERT_FALSE(visibility_polygon_contains_point(polygon, 27.0, 5.0));
+
+  visibility_polygon_destroy(polygon);
+  shape_destroy(line1);
+  shape_destroy(line2);
+  sequence_destroy(barriers);
+  return true;
+}
+
+bool test_visibility_crossings_match_full_scan(void) {
+  srand(42);
+  visibility_sweep_mismatches = 0;
+
+  // Random long barriers cross each other many times around the sources.
+  // Every other scene snaps to a coarse grid, so barriers also share ends,
+  // end on each other and pass through the sources.
+  for (int scene = 0; scene < 80; scene++) {
+    bool grid = scene % 2 == 1;
+    Sequence barriers = sequence_create();
+    ASSERT_NOT_NULL(barriers);
+    Shape lines[32];
+    for (int i = 0; i < 32; i++) {
+      double coords[4];
+      for (int k = 0; k < 4; k++) {
+        coords[k] = grid ? (double)(rand() % 17) * 10.0 - 80.0
+                         : (double)(rand() % 1601) / 10.0 - 80.0;
+      }
+      lines[i] = line_create(i + 1, coords[0], coords[1], coords[2],
+                             coords[3], "black");
+      line_set_barrier((Line)shape_get_shape(lines[i]), true);
+      sequence_append(barriers, lines[i]);
+    }
+
+    for (int k = 0; k < 4; k++) {
+      double x = (double)(rand() % 121) - 60.0;
+      double y = (double)(rand() % 121) - 60.0;
+      if (grid) {
+        x = 10.0 * round(x / 10.0);
+        y = 10.0 * round(y / 10.0);
+      }
+      SortType sort_type = k % 2 ? SORT_RADIX : SORT_QSORT;
+      VisibilityPolygon polygon =
+          visibility_calculate(x, y, barriers, VISIBILITY_UNBOUNDED, sort_type,
+                               10, MIN_X, MIN_Y, MAX_X, MAX_Y);
+      ASSERT_NOT_NULL(polygon);
+      visibility_polygon_destroy(polygon);
+    }
+
+    for (int i = 0; i < 32; i++) {
+      shape_destroy(lines[i]);
+    }
+    sequence_destroy(barriers);
+  }
+
+  // A barrier through the source, with another one ending on it
+  Sequence barriers = sequence_create();
+  ASSERT_NOT_NULL(barriers);
+  Shape lines[3];
+  lines[0] = line_create(1, 20.0, 40.0, -60.0, 60.0, "black");
+  lines[1] = line_create(2, -70.0, 50.0, 60.0, 30.0, "black");
+  lines[2] = line_create(3, 20.0, 40.0, 80.0, -20.0, "black");
+  for (int i = 0; i < 3; i++) {
+    line_set_barrier((Line)shape_get_shape(lines[i]), true);
+    sequence_append(barriers, lines[i]);
+  }
+  VisibilityPolygon polygon =
+      visibility_calculate(-20.0, 50.0, barriers, VISIBILITY_UNBOUNDED,
+                           SORT_QSORT, 10, MIN_X, MIN_Y, MAX_X, MAX_Y);
+  ASSERT_NOT_NULL(polygon);
+  visibility_polygon_destroy(polygon);
+  for (int i = 0; i < 3; i++) {
+    shape_destroy(lines[i]);
+  }
+  sequence_destroy(barriers);
+
+  // Every next biombo the sweep took from the tree was the nearest segment
+  ASSERT_EQUAL(visibility_sweep_mismatches, 0);
+  return true;
+}
+
+bool test_visibility_radius_culls_far_barriers(void) {
+  Sequence barriers = sequence_create();
+  ASSERT_NOT_NULL(barriers);
+
+  // A wall at x = 5 casts a shadow, one at x = -50 is out of reach
+  Shape near = line_create(1, 5.0, -5.0, 5.0, 5.0, "black");
+  Shape far = line_create(2, -50.0, -80.0, -50.0, 80.0, "black");
+  line_set_barrier((Line)shape_get_shape(near), true);
+  line_set_barrier((Line)shape_get_shape(far), true);
+  sequence_append(barriers, near);
+  sequence_append(barriers, far);
+
+  VisibilityPolygon polygon =
+      visibility_calculate(0.0, 0.0, barriers, 20.0, SORT_QSORT, 10, MIN_X,
+                           MIN_Y, MAX_X, MAX_Y);
+  ASSERT_NOT_NULL(polygon);
+
+  // Shadowed, outside the circle and visible points
+  ASSERT_FALSE(visibility_polygon_contains_point(polygon, 10.0, 0.0));
+  ASSERT_FALSE(visibility_polygon_contains_point(polygon, -30.0, 0.0));
+  ASSERT_TRUE(visibility_polygon_contains_point(polygon, -15.0, 0.0));
+  ASSERT_TRUE(visibility_polygon_contains_point(polygon, 0.0, 15.0));
+
+  // Dropping the far wall should not change the polygon
+  Sequence near_only = sequence_create();
+  sequence_append(near_only, near);
+  VisibilityPolygon culled =
+      visibility_calculate(0.0, 0.0, near_only, 20.0, SORT_QSORT, 10, MIN_X,
+                           MIN_Y, MAX_X, MAX_Y);
+  ASSERT_NOT_NULL(culled);
+  int count = visibility_polygon_get_vertex_count(polygon);
+  int culled_count = visibility_polygon_get_vertex_count(culled);
+  ASSERT_EQUAL(count, culled_count);
+
+  visibility_polygon_destroy(culled);
+  visibility_polygon_destroy(polygon);
+  shape_destroy(near);
+  shape_destroy(far);
+  sequence_destroy(near_only);
+  sequence_destroy(barriers);
+  return true;
+}
+
+bool test_visibility_batch_matches_single(void) {
+  Sequence barriers = sequence_create();
+  ASSERT_NOT_NULL(barriers);
+
+  // A barrier set skips lines that are not marked as barriers
+  Shape line1 = line_create(1, 20.0, -20.0, 30.0, 20.0, "black");
+  Shape line2 = line_create(2, -40.0, 10.0, -10.0, 40.0, "black");
+  Shape plain = line_create(3, -50.0, -50.0, 50.0, -50.0, "black");
+  line_set_barrier((Line)shape_get_shape(line1), true);
+  line_set_barrier((Line)shape_get_shape(line2), true);
+  sequence_append(barriers, line1);
+  sequence_append(barriers, line2);
+  sequence_append(barriers, plain);
+
+  BarrierSet set = visibility_barrier_set_create(barriers);
+  ASSERT_NOT_NULL(set);
+  ASSERT_EQUAL(visibility_barrier_set_size(set), 2);
+
+  double xs[3] = {0.0, 50.0, -30.0};
+  double ys[3] = {0.0, 5.0, -10.0};
+  double radii[3] = {100.0, VISIBILITY_UNBOUNDED, 30.0};
+  VisibilityPolygon batch[3];
+  int computed = visibility_calculate_batch(xs, ys, 3, set, NULL, radii,
+                                            SORT_QSORT, 10, MIN_X, MIN_Y,
+                                            MAX_X, MAX_Y, batch);
+  ASSERT_EQUAL(computed, 3);
+
+  // Every batched polygon is identical to the one computed on its own
+  for (int i = 0; i < 3; i++) {
+    VisibilityPolygon single =
+        visibility_calculate(xs[i], ys[i], barriers, radii[i], SORT_QSORT, 10,
+                             MIN_X, MIN_Y, MAX_X, MAX_Y);
+    ASSERT_NOT_NULL(single);
+    int count = visibility_polygon_get_vertex_count(single);
+    ASSERT_EQUAL(visibility_polygon_get_vertex_count(batch[i]), count);
+
+    const double *expected = visibility_polygon_get_coords(single);
+    const double *actual = visibility_polygon_get_coords(batch[i]);
+    for (int j = 0; j < 2 * count; j++) {
+      ASSERT_TRUE(doubles_equal(expected[j], actual[j]));
+    }
+    visibility_polygon_destroy(single);
+    visibility_polygon_destroy(batch[i]);
+  }
+
+  visibility_barrier_set_destroy(set);
+  shape_destroy(line1);
+  shape_destroy(line2);
+  shape_destroy(plain);
+  sequence_destroy(barriers);
+  return true;
+}
+
+bool test_visibility_workspace_reuse(void) {
+  Sequence barriers = sequence_create();
+  ASSERT_NOT_NULL(barriers);
+  Shape lines[6];
+  for (int i = 0; i < 6; i++) {
+    double offset = 12.0 * i - 36.0;
+    lines[i] = line_create(i + 1, offset, -50.0 + 7.0 * i, offset + 20.0,
+                           40.0 - 9.0 * i, "black");
+    line_set_barrier((Line)shape_get_shape(lines[i]), true);
+    sequence_append(barriers, lines[i]);
+  }
+  BarrierSet set = visibility_barrier_set_create(barriers);
+  ASSERT_NOT_NULL(set);
+  VisibilityWorkspace workspace = visibility_workspace_create();
+  ASSERT_NOT_NULL(workspace);
+
+  // Sweeps sharing one workspace match sweeps with fresh scratch memory, for
+  // every sorting algorithm
+  for (int i = 0; i < 20; i++) {
+    double x = -45.0 + 4.5 * i;
+    double y = 30.0 - 3.0 * i;
+    SortType sort_type = (SortType)(i % 3);
+    VisibilityPolygon reused = visibility_calculate_with_set(
+        x, y, set, workspace, 100.0, sort_type, 4, MIN_X, MIN_Y, MAX_X, MAX_Y);
+    VisibilityPolygon fresh = visibility_calculate(
+        x, y, barriers, 100.0, sort_type, 4, MIN_X, MIN_Y, MAX_X, MAX_Y);
+    ASSERT_NOT_NULL(reused);
+    ASSERT_NOT_NULL(fresh);
+
+    int count = visibility_polygon_get_vertex_count(fresh);
+    ASSERT_EQUAL(visibility_polygon_get_vertex_count(reused), count);
+    const double *expected = visibility_polygon_get_coords(fresh);
+    const double *actual = visibility_polygon_get_coords(reused);
+    for (int j = 0; j < 2 * count; j++) {
+      ASSERT_EQUAL(expected[j], actual[j]);
+    }
+    visibility_polygon_destroy(reused);
+    visibility_polygon_destroy(fresh);
+  }
+
+  visibility_workspace_destroy(workspace);
+  visibility_barrier_set_destroy(set);
+  for (int i = 0; i < 6; i++) {
+    shape_destroy(lines[i]);
+  }
+  sequence_destroy(barriers);
+  return true;
+}
+
+bool test_visibility_radix_matches_qsort(void) {
+  Sequence barriers = sequence_create();
+  ASSERT_NOT_NULL(barriers);
+
+  // A zig-zag chain sharing endpoints, so that START and END events meet at
+  // the same angles, crossed by one long barrier
+  Shape lines[9];
+  for (int i = 0; i < 8; i++) {
+    double x1 = -40.0 + 10.0 * i;
+    double y1 = i % 2 ? 30.0 : 20.0;
+    double y2 = i % 2 ? 20.0 : 30.0;
+    lines[i] = line_create(i + 1, x1, y1, x1 + 10.0, y2, "black");
+  }
+  lines[8] = line_create(9, -45.0, 35.0, 45.0, 15.0, "black");
+  for (int i = 0; i < 9; i++) {
+    line_set_barrier((Line)shape_get_shape(lines[i]), true);
+    sequence_append(barriers, lines[i]);
+  }
+
+  double xs[4] = {0.0, -40.0, 25.0, 0.0};
+  double ys[4] = {0.0, -10.0, 40.0, 25.0};
+  for (int i = 0; i < 4; i++) {
+    VisibilityPolygon radix =
+        visibility_calculate(xs[i], ys[i], barriers, 100.0, SORT_RADIX, 10,
+                             MIN_X, MIN_Y, MAX_X, MAX_Y);
+    VisibilityPolygon sorted =
+        visibility_calculate(xs[i], ys[i], barriers, 100.0, SORT_QSORT, 10,
+                             MIN_X, MIN_Y, MAX_X, MAX_Y);
+    ASSERT_NOT_NULL(radix);
+    ASSERT_NOT_NULL(sorted);
+
+    int count = visibility_polygon_get_vertex_count(sorted);
+    ASSERT_EQUAL(visibility_polygon_get_vertex_count(radix), count);
+    const double *expected = visibility_polygon_get_coords(sorted);
+    const double *actual = visibility_polygon_get_coords(radix);
+    for (int j = 0; j < 2 * count; j++) {
+      ASSERT_EQUAL(expected[j], actual[j]);
+    }
+    visibility_polygon_destroy(radix);
+    visibility_polygon_destroy(sorted);
+  }
+
+  for (int i = 0; i < 9; i++) {
+    shape_destroy(lines[i]);
+  }
+  sequence_destroy(barriers);
+  return true;
+}
+
+bool test_visibility_slabs_match_linear_scan(void) {
+  Sequence barriers = sequence_create();
+  ASSERT_NOT_NULL(barriers);
+
+  // A few barriers give a polygon with long and short edges at many heights
+  Shape lines[4];
+  lines[0] = line_create(1, 20.0, -20.0, 30.0, 20.0, "black");
+  lines[1] = line_create(2, -40.0, 10.0, -10.0, 40.0, "black");
+  lines[2] = line_create(3, -60.0, -30.0, -20.0, -35.0, "black");
+  lines[3] = line_create(4, 10.0, 60.0, 70.0, 55.0, "black");
+  for (int i = 0; i < 4; i++) {
+    line_set_barrier((Line)shape_get_shape(lines[i]), true);
+    sequence_append(barriers, lines[i]);
+  }
+
+  VisibilityPolygon polygon = visibility_calculate(
+      5.0, 3.0, barriers, 100.0, SORT_QSORT, 10, MIN_X, MIN_Y, MAX_X, MAX_Y);
+  ASSERT_NOT_NULL(polygon);
+  const double *xy = visibility_polygon_get_coords(polygon);
+  int count = visibility_polygon_get_vertex_count(polygon);
+  ASSERT_TRUE(count >= 3 && count <= 256);
+
+  // Slab containment agrees with the plain ray cast everywhere, including
+  // outside the polygon and exactly on vertex heights
+  for (double y = -110.0; y <= 110.0; y += 1.7) {
+    for (double x = -110.0; x <= 110.0; x += 1.3) {
+      ASSERT_EQUAL(visibility_polygon_contains_point(polygon, x, y),
+                   geometry_point_in_polygon(x, y, xy, count));
+    }
+  }
+  for (int i = 0; i < count; i++) {
+    ASSERT_EQUAL(
+        visibility_polygon_contains_point(polygon, 0.0, xy[2 * i + 1]),
+        geometry_point_in_polygon(0.0, xy[2 * i + 1], xy, count));
+  }
+
+  // Edge ranges visit each overlapping edge exactly once
+  double ranges[4][2] = {{-5.0, 5.0}, {-200.0, 200.0}, {40.0, 40.0},
+                         {150.0, 160.0}};
+  for (int r = 0; r < 4; r++) {
+    int visits[256] = {0};
+    VisibilityEdgeCursor cursor = visibility_polygon_edges_in_range(
+        polygon, ranges[r][0], ranges[r][1]);
+    int edge;
+    while (visibility_edge_cursor_next(&cursor, &edge)) {
+      ASSERT_TRUE(edge >= 0 && edge < count);
+      visits[edge]++;
+    }
+    for (int i = 0; i < count; i++) {
+      int j = (i + 1) % count;
+      double low = fmin(xy[2 * i + 1], xy[2 * j + 1]);
+      double high = fmax(xy[2 * i + 1], xy[2 * j + 1]);
+      ASSERT_TRUE(visits[i] <= 1);
+      if (low <= ranges[r][1] && high >= ranges[r][0]) {
+        ASSERT_EQUAL(visits[i], 1);
+      }
+    }
+  }
+
+  visibility_polygon_destroy(polygon);
+  for (int i = 0; i < 4; i++) {
+    shape_destroy(lines[i]);
+  }
+  sequence_destroy(barriers);
+  return true;
+}
+
+bool test_visibility_source_on_barrier_end(void) {
+  Sequence barriers = sequence_create();
+  ASSERT_NOT_NULL(barriers);
+
+  // The source sits on the end of one barrier and on another one
+  Shape lines[2];
+  lines[0] = line_create(1, -70.0, 0.0, -60.0, -30.0, "black");
+  lines[1] = line_create(2, -70.0, -30.0, 50.0, -30.0, "black");
+  for (int i = 0; i < 2; i++) {
+    line_set_barrier((Line)shape_get_shape(lines[i]), true);
+    sequence_append(barriers, lines[i]);
+  }
+
+  VisibilityPolygon polygon =
+      visibility_calculate(-60.0, -30.0, barriers, VISIBILITY_UNBOUNDED,
+                           SORT_QSORT, 10, MIN_X, MIN_Y, MAX_X, MAX_Y);
+  ASSERT_NOT_NULL(polygon);
+  int count = visibility_polygon_get_vertex_count(polygon);
+  ASSERT_TRUE(count >= 3 && count <= 256);
+
+  // Degenerate vertices must not make the slabs overflow or repeat edges
+  int visits[256] = {0};
+  VisibilityEdgeCursor cursor =
+      visibility_polygon_edges_in_range(polygon, -200.0, 200.0);
+  int edge;
+  while (visibility_edge_cursor_next(&cursor, &edge)) {
+    ASSERT_TRUE(edge >= 0 && edge < count);
+    visits[edge]++;
+    ASSERT_TRUE(visits[edge] == 1);
+  }
+  visibility_polygon_contains_point(polygon, 0.0, 0.0);
+
+  visibility_polygon_destroy(polygon);
+  for (int i = 0; i < 2; i++) {
+    shape_destroy(lines[i]);
+  }
+  sequence_destroy(barriers);
   return true;
 }
 
 bool test_visibility_polygon_memory_management(void) {
-  List barriers = list_create();
+  Sequence barriers = sequence_create();
   ASSERT_NOT_NULL(barriers);
 
   // Create and destroy multiple polygons to test memory management
   for (int i = 0; i < 10; i++) {
-    VisibilityPolygon polygon = visibility_calculate(0.0, 0.0, barriers, 50.0);
+    VisibilityPolygon polygon =
+        visibility_calculate(0.0, 0.0, barriers, 50.0, SORT_QSORT, 10,
+                             MIN_X, MIN_Y, MAX_X, MAX_Y);
     ASSERT_NOT_NULL(polygon);
     visibility_polygon_destroy(polygon);
   }
 
-  list_destroy(barriers);
+  sequence_destroy(barriers);
   return true;
 }
 
 bool test_visibility_null_inputs(void) {
   // Test with NULL barriers list
-  VisibilityPolygon polygon = visibility_calculate(0.0, 0.0, NULL, 100.0);
+  VisibilityPolygon polygon =
+      visibility_calculate(0.0, 0.0, NULL, 100.0, SORT_QSORT, 10,
+                           MIN_X, MIN_Y, MAX_X, MAX_Y);
   ASSERT_NULL(polygon);
 
   // Test polygon operations with NULL
-  ASSERT_NULL(visibility_polygon_get_vertices(NULL));
+  ASSERT_NULL(visibility_polygon_get_coords(NULL));
   ASSERT_EQUAL(visibility_polygon_get_vertex_count(NULL), 0);
   ASSERT_FALSE(visibility_polygon_contains_point(NULL, 0.0, 0.0));
 
@@ -260,6 +718,8 @@ int main(void) {
   test_register("test_geometry_point_create_and_destroy",
                 test_geometry_point_create_and_destroy);
   test_register("test_geometry_calculate_angle", test_geometry_calculate_angle);
+  test_register("test_geometry_calculate_pseudo_angle",
+                test_geometry_calculate_pseudo_angle);
   test_register("test_geometry_distance", test_geometry_distance);
   test_register("test_geometry_segment_intersects_ray",
                 test_geometry_segment_intersects_ray);
@@ -274,6 +734,22 @@ int main(void) {
                 test_visibility_single_barrier);
   test_register("test_visibility_multiple_barriers",
                 test_visibility_multiple_barriers);
+  test_register("test_visibility_crossing_barriers",
+                test_visibility_crossing_barriers);
+  test_register("test_visibility_crossings_match_full_scan",
+                test_visibility_crossings_match_full_scan);
+  test_register("test_visibility_radius_culls_far_barriers",
+                test_visibility_radius_culls_far_barriers);
+  test_register("test_visibility_batch_matches_single",
+                test_visibility_batch_matches_single);
+  test_register("test_visibility_workspace_reuse",
+                test_visibility_workspace_reuse);
+  test_register("test_visibility_radix_matches_qsort",
+                test_visibility_radix_matches_qsort);
+  test_register("test_visibility_slabs_match_linear_scan",
+                test_visibility_slabs_match_linear_scan);
+  test_register("test_visibility_source_on_barrier_end",
+                test_visibility_source_on_barrier_end);
   test_register("test_visibility_polygon_memory_management",
                 test_visibility_polygon_memory_management);
   test_register("test_visibility_null_inputs", test_visibility_null_inputs);
@@ -0,0 +1,245 @@
+#include "visibility_cache.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// No entry (end of a chain or of the recency list)
+#define NO_ENTRY -1
+
+// Cached polygon. Entries are chained per hash bucket and linked from the
+// most to the least recently used.
+typedef struct {
+  VisibilityCacheKey key;
+  VisibilityPolygon polygon;
+  int next_in_bucket; // Next entry with the same bucket
+  int newer;          // Entry used just after this one
+  int older;          // Entry used just before this one
+} CacheEntry;
+
+// Internal cache structure
+typedef struct {
+  CacheEntry *entries; // capacity entries, the first count in use
+  int capacity;
+  int count;
+  int *buckets;     // First entry of each bucket
+  int bucket_count; // Power of two, at least twice the capacity
+  int newest;       // Most recently used entry
+  int oldest;       // Least recently used entry
+  long hits;
+  long misses;
+} VisibilityCacheImpl;
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+// Mixes the bits of one key field into a hash. Both zeros hash alike, since
+// they compare equal.
+static uint64_t mix_double(uint64_t hash, double value) {
+  if (value == 0) {
+    value = 0;
+  }
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  hash ^= bits;
+  hash *= 0x100000001b3ull;
+  return hash ^ (hash >> 29);
+}
+
+// Hashes a key to a bucket
+static int bucket_of(const VisibilityCacheImpl *impl,
+                     const VisibilityCacheKey *key) {
+  uint64_t hash = 0xcbf29ce484222325ull ^ key->barrier_version;
+  hash = mix_double(hash, key->x);
+  hash = mix_double(hash, key->y);
+  hash = mix_double(hash, key->radius);
+  hash = mix_double(hash, key->min_x);
+  hash = mix_double(hash, key->min_y);
+  hash = mix_double(hash, key->max_x);
+  hash = mix_double(hash, key->max_y);
+  return (int)(hash & (uint64_t)(impl->bucket_count - 1));
+}
+
+// Compares two keys field by field
+static bool keys_equal(const VisibilityCacheKey *a,
+                       const VisibilityCacheKey *b) {
+  return a->x == b->x && a->y == b->y && a->radius == b->radius &&
+         a->barrier_version == b->barrier_version && a->min_x == b->min_x &&
+         a->min_y == b->min_y && a->max_x == b->max_x && a->max_y == b->max_y;
+}
+
+// Finds the entry of a key, or NO_ENTRY
+static int find_entry(const VisibilityCacheImpl *impl,
+                      const VisibilityCacheKey *key) {
+  int i = impl->buckets[bucket_of(impl, key)];
+  while (i != NO_ENTRY && !keys_equal(&impl->entries[i].key, key)) {
+    i = impl->entries[i].next_in_bucket;
+  }
+  return i;
+}
+
+// Takes an entry out of the recency list
+static void unlink_recency(VisibilityCacheImpl *impl, int i) {
+  CacheEntry *entry = &impl->entries[i];
+  if (entry->newer != NO_ENTRY) {
+    impl->entries[entry->newer].older = entry->older;
+  } else {
+    impl->newest = entry->older;
+  }
+  if (entry->older != NO_ENTRY) {
+    impl->entries[entry->older].newer = entry->newer;
+  } else {
+    impl->oldest = entry->newer;
+  }
+}
+
+// Puts an entry at the most recently used end of the recency list
+static void link_newest(VisibilityCacheImpl *impl, int i) {
+  CacheEntry *entry = &impl->entries[i];
+  entry->newer = NO_ENTRY;
+  entry->older = impl->newest;
+  if (impl->newest != NO_ENTRY) {
+    impl->entries[impl->newest].newer = i;
+  } else {
+    impl->oldest = i;
+  }
+  impl->newest = i;
+}
+
+// Takes an entry out of its bucket chain
+static void unlink_bucket(VisibilityCacheImpl *impl, int i) {
+  int *link = &impl->buckets[bucket_of(impl, &impl->entries[i].key)];
+  while (*link != i) {
+    link = &impl->entries[*link].next_in_bucket;
+  }
+  *link = impl->entries[i].next_in_bucket;
+}
+
+// ============================================================================
+// Public Functions
+// ============================================================================
+
+VisibilityCache visibility_cache_create(int capacity) {
+  if (capacity < 1) {
+    capacity = 1;
+  }
+
+  VisibilityCacheImpl *impl = malloc(sizeof(VisibilityCacheImpl));
+  if (impl == NULL) {
+    printf("Error: Failed to allocate memory for VisibilityCache\n");
+    return NULL;
+  }
+
+  impl->bucket_count = 1;
+  while (impl->bucket_count < 2 * capacity) {
+    impl->bucket_count *= 2;
+  }
+  impl->entries = malloc(sizeof(CacheEntry) * capacity);
+  impl->buckets = malloc(sizeof(int) * impl->bucket_count);
+  if (impl->entries == NULL || impl->buckets == NULL) {
+    printf("Error: Failed to allocate memory for visibility cache entries\n");
+    free(impl->entries);
+    free(impl->buckets);
+    free(impl);
+    return NULL;
+  }
+
+  for (int b = 0; b < impl->bucket_count; b++) {
+    impl->buckets[b] = NO_ENTRY;
+  }
+  impl->capacity = capacity;
+  impl->count = 0;
+  impl->newest = NO_ENTRY;
+  impl->oldest = NO_ENTRY;
+  impl->hits = 0;
+  impl->misses = 0;
+
+  return (VisibilityCache)impl;
+}
+
+void visibility_cache_destroy(VisibilityCache cache) {
+  if (cache == NULL) {
+    return;
+  }
+
+  VisibilityCacheImpl *impl = (VisibilityCacheImpl *)cache;
+  for (int i = 0; i < impl->count; i++) {
+    visibility_polygon_destroy(impl->entries[i].polygon);
+  }
+  free(impl->entries);
+  free(impl->buckets);
+  free(impl);
+}
+
+VisibilityPolygon visibility_cache_get(VisibilityCache cache,
+                                       const VisibilityCacheKey *key) {
+  if (cache == NULL || key == NULL) {
+    return NULL;
+  }
+
+  VisibilityCacheImpl *impl = (VisibilityCacheImpl *)cache;
+  int i = find_entry(impl, key);
+  if (i == NO_ENTRY) {
+    impl->misses++;
+    return NULL;
+  }
+
+  impl->hits++;
+  unlink_recency(impl, i);
+  link_newest(impl, i);
+  return visibility_polygon_retain(impl->entries[i].polygon);
+}
+
+bool visibility_cache_contains(VisibilityCache cache,
+                               const VisibilityCacheKey *key) {
+  if (cache == NULL || key == NULL) {
+    return false;
+  }
+  return find_entry((VisibilityCacheImpl *)cache, key) != NO_ENTRY;
+}
+
+void visibility_cache_put(VisibilityCache cache, const VisibilityCacheKey *key,
+                          VisibilityPolygon polygon) {
+  if (cache == NULL || key == NULL || polygon == NULL) {
+    return;
+  }
+
+  VisibilityCacheImpl *impl = (VisibilityCacheImpl *)cache;
+  if (find_entry(impl, key) != NO_ENTRY) {
+    return;
+  }
+
+  // Reuse the least recently used entry once every entry is taken
+  int i;
+  if (impl->count < impl->capacity) {
+    i = impl->count++;
+  } else {
+    i = impl->oldest;
+    unlink_recency(impl, i);
+    unlink_bucket(impl, i);
+    visibility_polygon_destroy(impl->entries[i].polygon);
+  }
+
+  CacheEntry *entry = &impl->entries[i];
+  entry->key = *key;
+  entry->polygon = visibility_polygon_retain(polygon);
+  int bucket = bucket_of(impl, key);
+  entry->next_in_bucket = impl->buckets[bucket];
+  impl->buckets[bucket] = i;
+  link_newest(impl, i);
+}
+
+long visibility_cache_get_hits(VisibilityCache cache) {
+  if (cache == NULL) {
+    return 0;
+  }
+  return ((VisibilityCacheImpl *)cache)->hits;
+}
+
+long visibility_cache_get_misses(VisibilityCache cache) {
+  if (cache == NULL) {
+    return 0;
+  }
+  return ((VisibilityCacheImpl *)cache)->misses;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file visibility_cache.h
+ * @brief Least recently used cache of visibility polygons
+ *
+ * Query files often drop many bombs on the same spots while the barriers stay
+ * put. The cache remembers the polygons of recent sources so such bombs share
+ * one polygon instead of sweeping again. A polygon only depends on its key, so
+ * a hit gives exactly what a new sweep would.
+ *
+ * Cached polygons are shared through visibility_polygon_retain(): the cache
+ * holds one reference and every lookup hands out another, which the caller
+ * gives back with visibility_polygon_destroy().
+ */
+
+#ifndef VISIBILITY_CACHE_H
+#define VISIBILITY_CACHE_H
+
+#include "visibility.h"
+#include <stdbool.h>
+
+/**
+ * @brief Opaque pointer type for visibility cache instances
+ */
+typedef void *VisibilityCache;
+
+/**
+ * @brief Everything a visibility polygon depends on
+ */
+typedef struct {
+  double x, y;              /**< Source point */
+  double radius;            /**< Radius the polygon is clipped to */
+  unsigned barrier_version; /**< Version of the barriers swept */
+  double min_x, min_y;      /**< Scene box corner */
+  double max_x, max_y;      /**< Opposite scene box corner */
+} VisibilityCacheKey;
+
+/**
+ * @brief Creates an empty cache
+ * @param capacity Polygons kept before the least recently used one is
+ * dropped (at least 1)
+ * @return VisibilityCache instance or NULL on error
+ */
+VisibilityCache visibility_cache_create(int capacity);
+
+/**
+ * @brief Destroys the cache, giving back its reference to every polygon
+ * @param cache VisibilityCache instance to destroy
+ */
+void visibility_cache_destroy(VisibilityCache cache);
+
+/**
+ * @brief Looks up the polygon of a key, counting a hit or a miss
+ * @param cache VisibilityCache instance
+ * @param key Key to look up
+ * @return New reference to the cached polygon, or NULL on a miss
+ */
+VisibilityPolygon visibility_cache_get(VisibilityCache cache,
+                                       const VisibilityCacheKey *key);
+
+/**
+ * @brief Checks whether a key is cached, without counting it or refreshing
+ * its entry
+ * @param cache VisibilityCache instance
+ * @param key Key to look for
+ * @return true if a polygon is cached for the key
+ */
+bool visibility_cache_contains(VisibilityCache cache,
+                               const VisibilityCacheKey *key);
+
+/**
+ * @brief Caches the polygon of a key, dropping the least recently used entry
+ * when full
+ *
+ * The cache takes its own reference, so the caller keeps its own. A key that
+ * is already cached keeps its polygon.
+ * @param cache VisibilityCache instance
+ * @param key Key the polygon was computed for
+ * @param polygon Polygon to cache (NULL is ignored)
+ */
+void visibility_cache_put(VisibilityCache cache, const VisibilityCacheKey *key,
+                          VisibilityPolygon polygon);
+
+/**
+ * @brief Gets the number of lookups that found their polygon
+ * @param cache VisibilityCache instance
+ * @return Hit count
+ */
+long visibility_cache_get_hits(VisibilityCache cache);
+
+/**
+ * @brief Gets the number of lookups that did not find their polygon
+ * @param cache VisibilityCache instance
+ * @return Miss count
+ */
+long visibility_cache_get_misses(VisibilityCache cache);
+
+#endif // VISIBILITY_CACHE_H
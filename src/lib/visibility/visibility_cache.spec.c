@@ -0,0 +1,194 @@
+/**
+ * @file visibility_cache.spec.c
+ * @brief Unit tests for the visibility polygon cache
+ *
+ * Unit tests for the least recently used cache defined in visibility_cache.h
+ */
+
+#include "./visibility_cache.h"
+#include "../test_framework/test_framework.h"
+
+#include <stdlib.h>
+
+// ============================================================================
+// Test Helpers
+// ============================================================================
+
+// Key of a source in the default test scene
+static VisibilityCacheKey make_key(double x, double y) {
+  VisibilityCacheKey key;
+  key.x = x;
+  key.y = y;
+  key.radius = VISIBILITY_UNBOUNDED;
+  key.barrier_version = 1;
+  key.min_x = -100.0;
+  key.min_y = -100.0;
+  key.max_x = 100.0;
+  key.max_y = 100.0;
+  return key;
+}
+
+// Computes the polygon of a key with no barriers
+static VisibilityPolygon compute(const VisibilityCacheKey *key) {
+  Sequence barriers = sequence_create();
+  VisibilityPolygon polygon = visibility_calculate(
+      key->x, key->y, barriers, key->radius, SORT_QSORT, 10, key->min_x,
+      key->min_y, key->max_x, key->max_y);
+  sequence_destroy(barriers);
+  return polygon;
+}
+
+// Computes the polygon of a key and caches it, keeping no reference
+static void cache_new(VisibilityCache cache, const VisibilityCacheKey *key) {
+  VisibilityPolygon polygon = compute(key);
+  visibility_cache_put(cache, key, polygon);
+  visibility_polygon_destroy(polygon);
+}
+
+// ============================================================================
+// Tests for visibility_cache_get() / visibility_cache_put()
+// ============================================================================
+
+/**
+ * Test: a cached polygon should be handed out shared and outlive its creator
+ */
+bool test_visibility_cache_hit_shares_polygon(void) {
+  VisibilityCache cache = visibility_cache_create(4);
+  ASSERT_NOT_NULL(cache);
+
+  VisibilityCacheKey key = make_key(10.0, 20.0);
+  VisibilityPolygon missing = visibility_cache_get(cache, &key);
+  ASSERT_NULL(missing);
+
+  VisibilityPolygon polygon = compute(&key);
+  ASSERT_NOT_NULL(polygon);
+  int vertex_count = visibility_polygon_get_vertex_count(polygon);
+  visibility_cache_put(cache, &key, polygon);
+  visibility_polygon_destroy(polygon);
+
+  VisibilityPolygon first = visibility_cache_get(cache, &key);
+  VisibilityPolygon second = visibility_cache_get(cache, &key);
+  ASSERT_TRUE(first == polygon);
+  ASSERT_TRUE(second == polygon);
+  ASSERT_EQUAL(visibility_cache_get_hits(cache), 2);
+  ASSERT_EQUAL(visibility_cache_get_misses(cache), 1);
+
+  // The lookups still own the polygon once the cache is gone
+  visibility_polygon_destroy(first);
+  visibility_cache_destroy(cache);
+  int shared_count = visibility_polygon_get_vertex_count(second);
+  ASSERT_EQUAL(shared_count, vertex_count);
+  visibility_polygon_destroy(second);
+  return true;
+}
+
+/**
+ * Test: every key field should take part in the lookup
+ */
+bool test_visibility_cache_key_fields(void) {
+  VisibilityCache cache = visibility_cache_create(4);
+  ASSERT_NOT_NULL(cache);
+
+  VisibilityCacheKey key = make_key(0.0, 0.0);
+  cache_new(cache, &key);
+
+  VisibilityCacheKey other[6];
+  for (int i = 0; i < 6; i++) {
+    other[i] = key;
+  }
+  other[0].x = 1.0;
+  other[1].y = 1.0;
+  other[2].radius = 50.0;
+  other[3].barrier_version = 2;
+  other[4].min_x = -99.0;
+  other[5].max_y = 101.0;
+  for (int i = 0; i < 6; i++) {
+    ASSERT_FALSE(visibility_cache_contains(cache, &other[i]));
+  }
+
+  // Both zeros are the same source
+  VisibilityCacheKey negative_zero = make_key(-0.0, 0.0);
+  ASSERT_TRUE(visibility_cache_contains(cache, &negative_zero));
+
+  // Checking does not count as a lookup
+  ASSERT_EQUAL(visibility_cache_get_hits(cache), 0);
+  ASSERT_EQUAL(visibility_cache_get_misses(cache), 0);
+
+  visibility_cache_destroy(cache);
+  return true;
+}
+
+/**
+ * Test: a full cache should drop the least recently used polygon
+ */
+bool test_visibility_cache_evicts_least_recent(void) {
+  VisibilityCache cache = visibility_cache_create(2);
+  ASSERT_NOT_NULL(cache);
+
+  VisibilityCacheKey a = make_key(1.0, 1.0);
+  VisibilityCacheKey b = make_key(2.0, 2.0);
+  VisibilityCacheKey c = make_key(3.0, 3.0);
+  cache_new(cache, &a);
+  cache_new(cache, &b);
+
+  // Using a makes b the oldest
+  VisibilityPolygon used = visibility_cache_get(cache, &a);
+  ASSERT_NOT_NULL(used);
+  visibility_polygon_destroy(used);
+
+  cache_new(cache, &c);
+  ASSERT_TRUE(visibility_cache_contains(cache, &a));
+  ASSERT_FALSE(visibility_cache_contains(cache, &b));
+  ASSERT_TRUE(visibility_cache_contains(cache, &c));
+
+  // Putting a cached key again changes nothing
+  cache_new(cache, &a);
+  ASSERT_TRUE(visibility_cache_contains(cache, &c));
+
+  visibility_cache_destroy(cache);
+  return true;
+}
+
+/**
+ * Test: NULL inputs should be handled
+ */
+bool test_visibility_cache_null_inputs(void) {
+  VisibilityCacheKey key = make_key(0.0, 0.0);
+  ASSERT_NULL(visibility_cache_get(NULL, &key));
+  ASSERT_FALSE(visibility_cache_contains(NULL, &key));
+  ASSERT_EQUAL(visibility_cache_get_hits(NULL), 0);
+  visibility_cache_put(NULL, &key, NULL);
+  visibility_cache_destroy(NULL);
+
+  VisibilityCache cache = visibility_cache_create(0);
+  ASSERT_NOT_NULL(cache);
+  visibility_cache_put(cache, &key, NULL);
+  ASSERT_FALSE(visibility_cache_contains(cache, &key));
+  ASSERT_NULL(visibility_polygon_retain(NULL));
+  visibility_cache_destroy(cache);
+  return true;
+}
+
+// ============================================================================
+// Main Test Runner
+// ============================================================================
+
+int main(void) {
+  test_framework_init();
+
+  test_print_section("Testing visibility_cache_get() / visibility_cache_put()");
+  test_register("test_visibility_cache_hit_shares_polygon",
+                test_visibility_cache_hit_shares_polygon);
+  test_register("test_visibility_cache_key_fields",
+                test_visibility_cache_key_fields);
+  test_register("test_visibility_cache_evicts_least_recent",
+                test_visibility_cache_evicts_least_recent);
+  test_register("test_visibility_cache_null_inputs",
+                test_visibility_cache_null_inputs);
+
+  int result = test_run_all();
+
+  test_framework_cleanup();
+
+  return result;
+}
@@ -9,8 +9,8 @@
 #include <string.h>
 
 int main(int argc, char *argv[]) {
-  if (argc >
-      14) { // program -e path -f .geo -o output -q .qry -to timeout -i input
+  // program -e path -f .geo -o output -q .qry -to type -i input -j threads
+  if (argc > 16) {
     printf("Error: Too many arguments\n");
     exit(1);
   }
@@ -22,6 +22,7 @@ int main(int argc, char *argv[]) {
   const char *qry_input_path = get_option_value(argc, argv, "q");
   const char *ordenation_type = get_option_value(argc, argv, "to");
   char *min_insertionsort_size = get_option_value(argc, argv, "i");
+  const char *thread_count_str = get_option_value(argc, argv, "j");
 
   // Apply default value for -in if not provided
   if (min_insertionsort_size == NULL) {
@@ -33,9 +34,21 @@ int main(int argc, char *argv[]) {
   SortType sort_type = SORT_QSORT; // Default to qsort
   if (ordenation_type != NULL && ordenation_type[0] == 'm') {
     sort_type = SORT_MERGESORT;
+  } else if (ordenation_type != NULL && ordenation_type[0] == 'r') {
+    sort_type = SORT_RADIX;
   }
   int sort_threshold = atoi(min_insertionsort_size);
 
+  // Parse thread count (serial by default)
+  int thread_count = 1;
+  if (thread_count_str != NULL) {
+    thread_count = atoi(thread_count_str);
+    if (thread_count < 1) {
+      printf("Error: -j requires a positive number of threads\n");
+      exit(1);
+    }
+  }
+
   // Apply prefix_path if it exists (only to -f and -q)
   char *full_geo_path = NULL;
   char *full_qry_path = NULL;
@@ -74,15 +87,15 @@ int main(int argc, char *argv[]) {
   }
 
   // Read .geo file
-  FileData geo_file_data = file_data_create(geo_input_path);
+  FileData geo_file_data = file_data_create_mapped(geo_input_path);
   if (geo_file_data == NULL) {
     printf("Error: Failed to read .geo file: %s\n", geo_input_path);
     exit(1);
   }
 
   // Create city from .geo file
-  City city =
-      geo_handler_create_city_from_file(geo_file_data, output_path, NULL);
+  City city = geo_handler_create_city_from_file(geo_file_data, output_path,
+                                                NULL, thread_count);
   if (city == NULL) {
     printf("Error: Failed to create city from .geo file\n");
     file_data_destroy(geo_file_data);
@@ -90,8 +103,9 @@ int main(int argc, char *argv[]) {
   }
 
   // Process .qry file if provided
+  int exit_code = 0;
   if (qry_input_path != NULL) {
-    FileData qry_file_data = file_data_create(qry_input_path);
+    FileData qry_file_data = file_data_create_stream(qry_input_path);
     if (qry_file_data == NULL) {
       printf("Error: Failed to read .qry file: %s\n", qry_input_path);
       city_destroy(city);
@@ -100,10 +114,20 @@ int main(int argc, char *argv[]) {
     }
 
     // Process query commands
-    qry_handler_process_file(city, geo_file_data, qry_file_data, output_path,
-                             sort_type, sort_threshold);
+    QryStats stats;
+    bool completed = qry_handler_process_file(
+        city, geo_file_data, qry_file_data, output_path, sort_type,
+        sort_threshold, thread_count, &stats);
+    // Run statistics go to stderr, so stdout carries only what the
+    // assignment asks for
+    fprintf(stderr, "Visibility cache: %ld hits, %ld misses\n",
+            stats.visibility_cache_hits, stats.visibility_cache_misses);
 
     file_data_destroy(qry_file_data);
+    if (!completed) {
+      printf("Error: Failed to process .qry file: %s\n", qry_input_path);
+      exit_code = 1;
+    }
   }
 
   // Clean up
@@ -122,5 +146,5 @@ int main(int argc, char *argv[]) {
     free(min_insertionsort_size);
   }
 
-  return 0;
+  return exit_code;
 }
\ No newline at end of file